@@ -27,11 +27,13 @@
 #include "libcsvsqldb/base/global_configuration.h"
 #include "libcsvsqldb/base/logging.h"
 #include "libcsvsqldb/base/lua_configuration.h"
+#include "libcsvsqldb/base/read_ahead.h"
 #include "libcsvsqldb/base/signalhandler.h"
 #include "libcsvsqldb/base/string_helper.h"
 #include "libcsvsqldb/base/time_measurement.h"
 
 #include "libcsvsqldb/execution_engine.h"
+#include "libcsvsqldb/base/trace.h"
 #include "libcsvsqldb/version.h"
 
 #include <boost/program_options.hpp>
@@ -56,11 +58,22 @@ namespace po = boost::program_options;
 class CsvDB
 {
 public:
-    CsvDB(csvsqldb::Database& database, bool showHeaderLine, bool verbose, csvsqldb::StringVector files)
+    CsvDB(csvsqldb::Database& database,
+          bool showHeaderLine,
+          bool verbose,
+          csvsqldb::StringVector files,
+          uint16_t threads,
+          uint16_t scanThreads,
+          size_t hashJoinBlockLimit,
+          const csvsqldb::ReadAheadOptions& readAhead)
     : _database(database)
     , _showHeaderLine(showHeaderLine)
     , _verbose(verbose)
     , _files(files)
+    , _threads(threads)
+    , _scanThreads(scanThreads)
+    , _hashJoinBlockLimit(hashJoinBlockLimit)
+    , _readAhead(readAhead)
     {
     }
 
@@ -70,6 +83,10 @@ public:
             csvsqldb::ExecutionContext context(_database);
             context._files = _files;
             context._showHeaderLine = _showHeaderLine;
+            context._numberOfThreads = _threads;
+            context._maxParallelScans = _scanThreads;
+            context._hashJoinBlockLimit = _hashJoinBlockLimit;
+            context._readAhead = _readAhead;
 
             csvsqldb::ExecutionEngine<csvsqldb::OperatorNodeFactory> engine(context);
             csvsqldb::ExecutionStatistics statistics;
@@ -77,14 +94,8 @@ public:
             int64_t rowCount = engine.execute(sql, statistics, std::cout);
             while(rowCount >= 0) {
                 OUT("\n[" << rowCount << (rowCount > 1 || rowCount == 0 ? " rows]" : " row]"));
-
-                OUT("\nParsing elapsed time " << statistics._endParsing - statistics._startParsing);
-                OUT("Preprocessing elapsed time " << statistics._endPreprocessing - statistics._startPreprocessing);
-                OUT("Execution elapsed time " << statistics._endExecution - statistics._startExecution);
-                OUT("Total elapsed time " << statistics._endExecution - statistics._startParsing);
-                OUT("\nUsed max " << statistics._maxUsedBlocks << " blocks with a total of " << statistics._maxUsedCapacity
-                                  << " MiB");
-                OUT("Total blocks used " << statistics._totalBlocks);
+                // one line of json, so the statistics can be collected with tools like grep or jq
+                OUT(statistics.asJson());
 
                 rowCount = engine.execute(statistics, std::cout);
             }
@@ -130,6 +141,10 @@ private:
     bool _showHeaderLine;
     bool _verbose;
     csvsqldb::StringVector _files;
+    uint16_t _threads;
+    uint16_t _scanThreads;
+    size_t _hashJoinBlockLimit;
+    csvsqldb::ReadAheadOptions _readAhead;
 };
 
 
@@ -154,6 +169,9 @@ public:
     , _showHeaderLine(true)
     , _verbose(false)
     , _interactive(false)
+    , _threads(csvsqldb::ExecutionContext::_defaultNumberOfThreads)
+    , _scanThreads(csvsqldb::OperatorContext::_defaultMaxParallelScans)
+    , _hashJoinBlockLimit(csvsqldb::OperatorContext::_defaultHashJoinBlockLimit)
     {
         csvsqldb::GlobalConfiguration::create<CSVDBGlobalConfiguration>();
         try {
@@ -184,6 +202,7 @@ private:
     virtual bool setUp(int argc, char** argv)
     {
         std::string showHeader("on");
+        size_t readAheadMiB = _readAhead._blockSize / (1024 * 1024);
 
         // clang-format off
         po::options_description desc("Options");
@@ -193,11 +212,17 @@ private:
         ("interactive,i", "opens an interactive sql shell")
         ("verbose,v", "output verbose statistics")
         ("show-header-line", po::value<std::string>(&showHeader), "if set to 'on' outputs a header line")
+        ("threads,t", po::value<uint16_t>(&_threads), "number of threads used by parallel operators like the hash join")
+        ("scan-threads", po::value<uint16_t>(&_scanThreads), ("maximum number of csv files of one table read in parallel, defaults to " + std::to_string(csvsqldb::OperatorContext::_defaultMaxParallelScans)).c_str())
+        ("hash-join-blocks", po::value<size_t>(&_hashJoinBlockLimit), "maximum number of blocks of a hash join build side kept in memory before it is spilled to disk, defaults to 250")
+        ("trace-file", po::value<std::string>(&_traceFile), "writes a chrome trace of the execution timeline to this file")
+        ("read-ahead", po::value<size_t>(&readAheadMiB), "size of the reads of csv files in MiB, defaults to 4")
+        ("direct-io", "reads csv files bypassing the page cache, useful for large files that are read only once")
         ("datbase-path,p", po::value<std::string>(&_databasePath), "path to the database")
         ("command-file,c", po::value<std::string>(&_commandFile), "command file with sql commands to process")
         ("sql,s", po::value<std::string>(&_sql), "sql commands to call")
         ("mapping,m", po::value<csvsqldb::StringVector>()->composing(), "mapping from csv file to table")
-        ("files,f", po::value<std::vector<std::string>>(&_files), "csv files to process, can use expansion patterns like ~ or *");
+        ("files,f", po::value<std::vector<std::string>>(&_files), "csv files or directories to process, can use expansion patterns like ~ or *");
         // clang-format on
 
         po::positional_options_description p;
@@ -234,6 +259,26 @@ private:
         if(vm.count("verbose")) {
             _verbose = true;
         }
+        if(vm.count("trace-file")) {
+#ifdef CSVSQLDB_TRACING
+            csvsqldb::trace::Tracer::enable(true);
+            csvsqldb::trace::Tracer::setThreadName("main");
+#else
+            CSVSQLDB_THROW(csvsqldb::BadoptionException, "'trace-file' needs a build with tracing enabled");
+#endif
+        }
+        if(vm.count("read-ahead")) {
+            if(readAheadMiB == 0) {
+                CSVSQLDB_THROW(csvsqldb::BadoptionException, "'read-ahead' has to be at least 1 MiB");
+            }
+            _readAhead._blockSize = readAheadMiB * 1024 * 1024;
+        }
+        if(vm.count("scan-threads") && _scanThreads == 0) {
+            CSVSQLDB_THROW(csvsqldb::BadoptionException, "'scan-threads' has to be at least 1");
+        }
+        if(vm.count("direct-io")) {
+            _readAhead._directIO = true;
+        }
         if(vm.count("show-header-line")) {
             _showHeaderLine = csvsqldb::toupper_copy(vm["show-header-line"].as<std::string>()) == "ON";
         }
@@ -284,7 +329,7 @@ private:
 
         OUT("");
 
-        CsvDB csvDB(database, _showHeaderLine, _verbose, _files);
+        CsvDB csvDB(database, _showHeaderLine, _verbose, _files, _threads, _scanThreads, _hashJoinBlockLimit, _readAhead);
 
         if(!_sql.empty()) {
             csvDB.executeSql(_sql);
@@ -441,13 +486,30 @@ private:
         return 0;
     }
 
+    virtual void tearDown()
+    {
+        if(!_traceFile.empty()) {
+            csvsqldb::trace::Tracer::enable(false);
+            std::ofstream stream(_traceFile);
+            if(!stream) {
+                CSVSQLDB_THROW(csvsqldb::FilesystemException, "trace file '" << _traceFile << "' could not be written");
+            }
+            csvsqldb::trace::Tracer::writeChromeTrace(stream);
+        }
+    }
+
     std::string _databasePath;
     std::string _commandFile;
     std::string _sql;
+    std::string _traceFile;
     csvsqldb::FileMapping _mapping;
     bool _showHeaderLine;
     bool _verbose;
     bool _interactive;
+    uint16_t _threads;
+    uint16_t _scanThreads;
+    size_t _hashJoinBlockLimit;
+    csvsqldb::ReadAheadOptions _readAhead;
     csvsqldb::StringVector _files;
 };
 
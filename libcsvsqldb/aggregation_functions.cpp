@@ -37,8 +37,11 @@
 namespace csvsqldb
 {
 
-    AggregationFunctionPtr AggregationFunction::create(eAggregateFunction aggrFunc, eType type)
+    AggregationFunctionPtr AggregationFunction::create(eAggregateFunction aggrFunc, eType type, eQuantifier quantifier)
     {
+        if(quantifier == DISTINCT && aggrFunc != COUNT_STAR) {
+            return std::make_shared<DistinctAggregationFunction>(aggrFunc, type);
+        }
         switch(aggrFunc) {
             case COUNT:
                 return std::make_shared<CountAggregationFunction>();
@@ -304,4 +307,47 @@ namespace csvsqldb
     {
         return _value;
     }
+
+
+    DistinctAggregationFunction::DistinctAggregationFunction(eAggregateFunction aggrFunc, eType type)
+    : _aggrFunc(aggrFunc)
+    , _type(type)
+    , _function(create(aggrFunc, type))
+    {
+    }
+
+    AggregationFunction* DistinctAggregationFunction::clone(BlockPtr block) const
+    {
+        if(!block->hasSizeFor(sizeof(DistinctAggregationFunction))) {
+            return nullptr;
+        }
+        AggregationFunction* tmp = new(block->getRawBuffer()) DistinctAggregationFunction(_aggrFunc, _type);
+        block->moveOffset(sizeof(DistinctAggregationFunction));
+        return tmp;
+    }
+
+    void DistinctAggregationFunction::doInit()
+    {
+        _values.clear();
+        _function->init();
+    }
+
+    void DistinctAggregationFunction::doStep(const Variant& value)
+    {
+        if(value.isNull()) {
+            _function->step(value);
+            return;
+        }
+        if(_values.find(value) == _values.end()) {
+            Variant distinctValue(value);
+            distinctValue.disconnect();
+            _values.insert(distinctValue);
+            _function->step(value);
+        }
+    }
+
+    const Variant& DistinctAggregationFunction::doFinalize()
+    {
+        return _function->finalize();
+    }
 }
@@ -38,6 +38,8 @@
 
 #include "block.h"
 
+#include <unordered_set>
+
 
 namespace csvsqldb
 {
@@ -78,7 +80,7 @@ namespace csvsqldb
 
         virtual AggregationFunction* clone(BlockPtr block) const = 0;
 
-        static AggregationFunctionPtr create(eAggregateFunction aggrFunc, eType type);
+        static AggregationFunctionPtr create(eAggregateFunction aggrFunc, eType type, eQuantifier quantifier = ALL);
 
     protected:
         AggregationFunction()
@@ -296,6 +298,34 @@ namespace csvsqldb
 
         Variant _value;
     };
+
+
+    /**
+     * Passes each distinct non-null value only once to the wrapped aggregation function. The seen values are kept in a
+     * hash set per group.
+     */
+    class CSVSQLDB_EXPORT DistinctAggregationFunction : public AggregationFunction
+    {
+    public:
+        DistinctAggregationFunction(eAggregateFunction aggrFunc, eType type);
+
+        virtual AggregationFunction* clone(BlockPtr block) const;
+
+        virtual std::string toString() const
+        {
+            return "DISTINCT " + _function->toString();
+        }
+
+    private:
+        virtual void doInit();
+        virtual void doStep(const Variant& value);
+        virtual const Variant& doFinalize();
+
+        eAggregateFunction _aggrFunc;
+        eType _type;
+        AggregationFunctionPtr _function;
+        std::unordered_set<Variant> _values;
+    };
 }
 
 #endif
@@ -34,6 +34,9 @@
 #include "csv_parser.h"
 
 #include "exception.h"
+#include "metrics.h"
+#include "read_ahead.h"
+#include "time_measurement.h"
 #include "time_helper.h"
 
 
@@ -49,13 +52,20 @@ namespace csvsqldb
         , _callback(callback)
         , _state(INIT)
         , _typeIterator(_types.begin())
+        , _lineRejected(false)
         , _lineCount(1)
+        , _readAhead(dynamic_cast<ReadAheadStreamBuf*>(stream.rdbuf()))
+        , _data(nullptr)
         , _stringBufferSize(256)
         , _n(0)
         , _count(0)
         , _stringParser(_stringBuffer, _stringBufferSize, std::bind(&CSVParser::readNextChar, this, std::placeholders::_1))
+        , _errorLimiter(10, std::chrono::seconds(1))
         {
-            _buffer.resize(_bufferLength);
+            if(!_readAhead) {
+                _buffer.resize(_bufferLength);
+                _data = &_buffer[0];
+            }
             _stringBuffer.resize(_stringBufferSize);
             readBuffer();
             if(_context._skipFirstLine) {
@@ -64,16 +74,29 @@ namespace csvsqldb
             }
         }
 
+        CSVParser::~CSVParser()
+        {
+            const uint64_t suppressed = _errorLimiter.takeSuppressed();
+            if(suppressed) {
+                CSVSQLDB_ERRORLOG("skipped " << suppressed << " further erroneous lines");
+            }
+        }
+
         bool CSVParser::parseLine()
         {
+            if(!checkBuffer()) {
+                // no more lines, e.g. an empty file or a file only containing the header line
+                return false;
+            }
             if(_state == LINESTART) {
                 _state = FIELDSTART;
                 _typeIterator = _types.begin();
+                _lineRejected = false;
             }
 
             while(_count > 0) {
                 try {
-                    switch(*_typeIterator) {
+                    switch(_lineRejected ? SKIP : *_typeIterator) {
                         case LONG:
                             parseLong();
                             break;
@@ -95,6 +118,9 @@ namespace csvsqldb
                         case BOOLEAN:
                             parseBool();
                             break;
+                        case SKIP:
+                            skipField();
+                            break;
                     }
                     ++_typeIterator;
                     if(_typeIterator == _types.end() && (_state != LINESTART && _state != END)) {
@@ -103,7 +129,18 @@ namespace csvsqldb
                         CSVSQLDB_THROW(csvsqldb::Exception, "too few fields found in line " << _lineCount);
                     }
                 } catch(const csvsqldb::Exception& ex) {
-                    std::cerr << "ERROR: skipping line " << _lineCount << ": " << ex.what() << "\n";
+                    metrics::Metrics::add(metrics::PARSE_ERRORS);
+                    // dirty files would otherwise spend most of the scan writing error messages, with an asynchronous
+                    // log device the scan does not wait for the output at all
+                    uint64_t suppressed = 0;
+                    if(_errorLimiter.admit(suppressed)) {
+                        if(suppressed) {
+                            CSVSQLDB_ERRORLOG("skipping line " << _lineCount << ": " << ex.what() << " (" << suppressed
+                                                               << " further erroneous lines skipped)");
+                        } else {
+                            CSVSQLDB_ERRORLOG("skipping line " << _lineCount << ": " << ex.what());
+                        }
+                    }
                 }
 
                 if(_n == static_cast<size_t>(_count) && _state == LINESTART) {
@@ -304,10 +341,15 @@ namespace csvsqldb
             }
         }
 
+        void CSVParser::skipField()
+        {
+            _stringParser.skip();
+        }
+
         void CSVParser::findEndOfLine()
         {
             readNextChar();
-            while(_state != LINESTART) {
+            while(_state != LINESTART && _state != END) {
                 readNextChar();
             }
         }
@@ -318,10 +360,10 @@ namespace csvsqldb
                 _state = END;
                 return '\0';
             }
-            if(!ignoreDelimiter && _buffer[_n] == _context._delimiter) {
+            if(!ignoreDelimiter && _data[_n] == _context._delimiter) {
                 _state = FIELDSTART;
                 ++_n;
-                while(_buffer[_n] == ' ') {
+                while(checkBuffer() && _data[_n] == ' ') {
                     ++_n;
                     if(!checkBuffer()) {
                         _state = END;
@@ -330,17 +372,17 @@ namespace csvsqldb
                 }
                 return '\0';
             }
-            if(_buffer[_n] == '\n' || _buffer[_n] == '\r') {
+            if(_data[_n] == '\n' || _data[_n] == '\r') {
                 _state = LINESTART;
                 ++_n;
                 if(checkBuffer()) {
-                    if(_buffer[_n] == '\n') {
+                    if(_data[_n] == '\n') {
                         ++_n;
                     }
                 }
                 return '\0';
             }
-            return _buffer[_n++];
+            return _data[_n++];
         }
 
         bool CSVParser::checkBuffer()
@@ -355,9 +397,19 @@ namespace csvsqldb
 
         bool CSVParser::readBuffer()
         {
-            _stream.read(&_buffer[0], _bufferLength);
-            _count = _stream.gcount();
+            if(_readAhead) {
+                // parse the blocks of the read ahead stream in place, it measures the time waiting for them itself
+                std::pair<const char*, size_t> block = _readAhead->nextBlock();
+                _data = block.first;
+                _count = static_cast<std::streamsize>(block.second);
+            } else {
+                const int64_t start = chrono::MonotonicClock::now();
+                _stream.read(&_buffer[0], _bufferLength);
+                _count = _stream.gcount();
+                metrics::Metrics::add(metrics::IO_WAIT_TIME, static_cast<uint64_t>(chrono::MonotonicClock::now() - start));
+            }
             _n = 0;
+            metrics::Metrics::add(metrics::BYTES_READ, static_cast<uint64_t>(_count));
             return _count > 0;
         }
     }
@@ -38,6 +38,7 @@
 
 #include "csv_string_parser.h"
 #include "date.h"
+#include "logging.h"
 #include "time.h"
 #include "timestamp.h"
 #include "types.h"
@@ -48,6 +49,8 @@
 
 namespace csvsqldb
 {
+    class ReadAheadStreamBuf;
+
     /**
      * CSV related implementations
      */
@@ -84,7 +87,8 @@ namespace csvsqldb
             virtual void onBoolean(bool boolean, bool isNull) = 0;
         };
 
-        enum CsvTypes { LONG, DOUBLE, STRING, DATE, TIME, TIMESTAMP, BOOLEAN };
+        /// SKIP fields are read over without conversion and without calling the callback
+        enum CsvTypes { LONG, DOUBLE, STRING, DATE, TIME, TIMESTAMP, BOOLEAN, SKIP };
         typedef std::vector<CsvTypes> Types;
 
         /**
@@ -102,6 +106,11 @@ namespace csvsqldb
              */
             CSVParser(CSVParserContext context, std::istream& stream, Types types, CSVParserCallback& callback);
 
+            /**
+             * Reports the number of erroneous lines that were skipped without an error message.
+             */
+            ~CSVParser();
+
             /**
              * Parses one line of input and calls the corresponding type method callbacks. Skips the first line of input, if
              * specified
@@ -110,6 +119,15 @@ namespace csvsqldb
              */
             bool parseLine();
 
+            /**
+             * Rejects the line currently parsed. Can be called from within the callback methods. All remaining fields of the
+             * line are read over without conversion and without calling the callback.
+             */
+            void rejectLine()
+            {
+                _lineRejected = true;
+            }
+
             /**
              * Returns the current count of lines excluding skipped lines.
              * @return The current line count starting with one.
@@ -131,6 +149,7 @@ namespace csvsqldb
             void parseDate();
             void parseTime();
             void parseTimestamp();
+            void skipField();
 
             void findEndOfLine();
             char readNextChar(bool ignoreDelimiter = false);
@@ -144,13 +163,17 @@ namespace csvsqldb
 
             State _state;
             Types::const_iterator _typeIterator;
+            bool _lineRejected;
             size_t _lineCount;
+            ReadAheadStreamBuf* _readAhead; //!< set if the blocks of the stream can be parsed without copying them
             BufferType _buffer;
+            const char* _data; //!< either the buffer or a block of the read ahead stream
             BufferType _stringBuffer;
             size_t _stringBufferSize;
             size_t _n;
             std::streamsize _count;
             CSVStringParser _stringParser;
+            LogRateLimiter _errorLimiter;
             static const std::streamsize _bufferLength = 8192;
         };
     }
@@ -79,6 +79,21 @@ namespace csvsqldb
             return pos;
         }
 
+        void CSVStringParser::skip()
+        {
+            _currentState = START;
+            const auto* newState = &_transitionTable[NO_QUOTE_STRING][OTHER];
+            char c = _readFunction(false);
+            while(c) {
+                newState = &_transitionTable[_currentState][charCategory(c)];
+                _currentState = newState->_state;
+                c = _readFunction(newState->_ignoreDelimiter);
+            }
+            if(_currentState == ERROR || !newState->_final) {
+                throw Exception("wrong delimiters in string");
+            }
+        }
+
         void CSVStringParser::initializeTransitionTable()
         {
             // clang-format off
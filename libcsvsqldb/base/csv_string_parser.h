@@ -83,6 +83,11 @@ namespace csvsqldb
              */
             size_t parseToBuffer();
 
+            /**
+             * Reads over the next CSV string returned by the readFunction without copying it into the buffer.
+             */
+            void skip();
+
         private:
             /// The states of the internal state machine for parsing CSV strings
             enum eState {
@@ -0,0 +1,521 @@
+//
+//  read_ahead.cpp
+//  csvsqldb
+//
+//  BSD 3-Clause License
+//  Copyright (c) 2015, Lars-Christian Fürstenberg
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification, are permitted
+//  provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or other materials provided
+//  with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors may be used to
+//  endorse or promote products derived from this software without specific prior written
+//  permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+//  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+//  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+//  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "base/read_ahead.h"
+
+#include "base/exception.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(CSVSQLDB_HAVE_IO_URING)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+
+namespace csvsqldb
+{
+    namespace detail
+    {
+        namespace
+        {
+            const size_t s_alignment = 4096;
+
+            /**
+             * Keeps depth blocks of the file in flight. Block n of the file is always read into slot n % depth, a slot is
+             * submitted again as soon as the consumer has moved on to the next block.
+             */
+            class PosixReadAheadReader : public ReadAheadReader
+            {
+            public:
+                PosixReadAheadReader(int fd, const std::string& path, const ReadAheadOptions& options)
+                : _fd(fd)
+                , _blockSize(options._blockSize)
+                , _path(path)
+                , _depth(std::max<uint16_t>(options._depth, 2))
+                , _fileSize(0)
+                , _blocks(0)
+                , _current(0)
+                , _submitted(0)
+                {
+                    struct stat st;
+                    if(::fstat(_fd, &st) != 0) {
+                        ::close(_fd);
+                        CSVSQLDB_THROW(FilesystemException, "could not stat file '" << _path << "': " << errnoText());
+                    }
+                    _fileSize = static_cast<uint64_t>(st.st_size);
+                    _blocks = (_fileSize + _blockSize - 1) / _blockSize;
+                    for(uint16_t n = 0; n < _depth; ++n) {
+                        void* buffer = nullptr;
+                        if(::posix_memalign(&buffer, s_alignment, _blockSize) != 0) {
+                            freeBuffers();
+                            ::close(_fd);
+                            CSVSQLDB_THROW(FilesystemException, "could not allocate read ahead buffer for '" << _path << "'");
+                        }
+                        _buffers.push_back(static_cast<char*>(buffer));
+                    }
+                }
+
+                ~PosixReadAheadReader()
+                {
+                    freeBuffers();
+                    ::close(_fd);
+                }
+
+                virtual std::pair<const char*, size_t> next()
+                {
+                    if(_current == 0) {
+                        for(uint64_t block = 0; block < std::min<uint64_t>(_depth, _blocks); ++block) {
+                            submit(slot(block), offset(block));
+                            _submitted = block + 1;
+                        }
+                    } else if(_current - 1 + _depth < _blocks) {
+                        // the consumer is done with the previous block, so its slot can be refilled
+                        submit(slot(_current - 1), offset(_current - 1 + _depth));
+                        _submitted = _current + _depth;
+                    }
+                    if(_current >= _blocks) {
+                        return std::make_pair(nullptr, 0);
+                    }
+
+                    const uint64_t block = _current++;
+                    const size_t expected = static_cast<size_t>(std::min<uint64_t>(_blockSize, _fileSize - offset(block)));
+                    ssize_t result = wait(slot(block));
+                    if(result < 0) {
+                        CSVSQLDB_THROW(FilesystemException,
+                                       "could not read file '" << _path << "': " << std::strerror(static_cast<int>(-result)));
+                    }
+                    size_t size = static_cast<size_t>(result);
+                    if(size < expected && size > 0) {
+                        size = readRemainder(slot(block), offset(block), size, expected);
+                    }
+                    if(size < expected) {
+                        // the file was truncated while reading
+                        _blocks = _current;
+                    }
+                    return std::make_pair(_buffers[slot(block)], size);
+                }
+
+            protected:
+                /**
+                 * Starts reading a whole block at the given offset into the slot.
+                 */
+                virtual void submit(size_t slot, uint64_t offset) = 0;
+
+                /**
+                 * Waits for the read of the slot. Returns the number of bytes read or the negative error number.
+                 */
+                virtual ssize_t wait(size_t slot) = 0;
+
+                /**
+                 * Waits for all submitted reads, needs to be called by the destructors of subclasses before the buffers are
+                 * freed.
+                 */
+                void waitForAll()
+                {
+                    for(uint64_t block = _current; block < _submitted; ++block) {
+                        wait(slot(block));
+                    }
+                }
+
+                char* buffer(size_t slot) const
+                {
+                    return _buffers[slot];
+                }
+
+                int _fd;
+                const size_t _blockSize;
+
+            private:
+                size_t slot(uint64_t block) const
+                {
+                    return static_cast<size_t>(block % _depth);
+                }
+
+                uint64_t offset(uint64_t block) const
+                {
+                    return block * _blockSize;
+                }
+
+                /**
+                 * Reads the rest of a block after a short read. Files opened for direct I/O can only be read at aligned
+                 * offsets with aligned lengths into aligned buffers, so the read starts at the aligned position before the
+                 * end of the bytes read so far and reads these bytes again. Returns the new size of the block.
+                 */
+                size_t readRemainder(size_t slot, uint64_t offset, size_t size, size_t expected)
+                {
+                    while(size < expected) {
+                        const size_t position = size - size % s_alignment;
+                        const size_t length = (expected - position + s_alignment - 1) / s_alignment * s_alignment;
+                        ssize_t result = ::pread(_fd, _buffers[slot] + position, length, static_cast<off_t>(offset + position));
+                        if(result < 0 && errno == EINTR) {
+                            continue;
+                        } else if(result < 0) {
+                            CSVSQLDB_THROW(FilesystemException, "could not read file '" << _path << "': " << errnoText());
+                        } else if(position + static_cast<size_t>(result) <= size) {
+                            break;
+                        }
+                        size = std::min(expected, position + static_cast<size_t>(result));
+                    }
+                    return size;
+                }
+
+                void freeBuffers()
+                {
+                    for(auto buffer : _buffers) {
+                        std::free(buffer);
+                    }
+                    _buffers.clear();
+                }
+
+                std::string _path;
+                const uint16_t _depth;
+                uint64_t _fileSize;
+                uint64_t _blocks;
+                uint64_t _current;
+                uint64_t _submitted;
+                std::vector<char*> _buffers;
+            };
+
+            /**
+             * Reads the blocks with pread from a small number of background threads.
+             */
+            class PreadReadAheadReader : public PosixReadAheadReader
+            {
+            public:
+                PreadReadAheadReader(int fd, const std::string& path, const ReadAheadOptions& options)
+                : PosixReadAheadReader(fd, path, options)
+                , _results(std::max<uint16_t>(options._depth, 2), 0)
+                , _done(_results.size(), true)
+                , _stop(false)
+                {
+                    for(size_t n = 0; n < _results.size(); ++n) {
+                        _threads.push_back(std::thread(&PreadReadAheadReader::run, this));
+                    }
+                }
+
+                ~PreadReadAheadReader()
+                {
+                    {
+                        std::unique_lock<std::mutex> lock(_mutex);
+                        _stop = true;
+                    }
+                    _submitted.notify_all();
+                    for(auto& thread : _threads) {
+                        thread.join();
+                    }
+                }
+
+                virtual const char* engine() const
+                {
+                    return "pread";
+                }
+
+            private:
+                virtual void submit(size_t slot, uint64_t offset)
+                {
+                    {
+                        std::unique_lock<std::mutex> lock(_mutex);
+                        _done[slot] = false;
+                        _requests.push_back(std::make_pair(slot, offset));
+                    }
+                    _submitted.notify_one();
+                }
+
+                virtual ssize_t wait(size_t slot)
+                {
+                    std::unique_lock<std::mutex> lock(_mutex);
+                    _completed.wait(lock, [&]() { return _done[slot]; });
+                    return _results[slot];
+                }
+
+                void run()
+                {
+                    std::unique_lock<std::mutex> lock(_mutex);
+                    while(true) {
+                        _submitted.wait(lock, [this]() { return _stop || !_requests.empty(); });
+                        if(_requests.empty()) {
+                            // pending requests are read even when stopping, as their buffers are still in use
+                            return;
+                        }
+                        std::pair<size_t, uint64_t> request = _requests.front();
+                        _requests.pop_front();
+
+                        lock.unlock();
+                        ssize_t result = 0;
+                        do {
+                            result = ::pread(_fd, buffer(request.first), _blockSize, static_cast<off_t>(request.second));
+                        } while(result < 0 && errno == EINTR);
+                        if(result < 0) {
+                            result = -errno;
+                        }
+                        lock.lock();
+
+                        _results[request.first] = result;
+                        _done[request.first] = true;
+                        _completed.notify_all();
+                    }
+                }
+
+                std::vector<ssize_t> _results;
+                std::vector<bool> _done;
+                std::deque<std::pair<size_t, uint64_t>> _requests;
+                bool _stop;
+                std::mutex _mutex;
+                std::condition_variable _submitted;
+                std::condition_variable _completed;
+                std::vector<std::thread> _threads;
+            };
+
+#if defined(CSVSQLDB_HAVE_IO_URING) && defined(__NR_io_uring_setup)
+            /**
+             * Submits the reads to an io_uring of its own. The ring is driven directly by the system calls, so no
+             * additional library is needed.
+             */
+            class IoUringReadAheadReader : public PosixReadAheadReader
+            {
+            public:
+                IoUringReadAheadReader(int fd,
+                                       int ring,
+                                       const io_uring_params& params,
+                                       const std::string& path,
+                                       const ReadAheadOptions& options)
+                : PosixReadAheadReader(fd, path, options)
+                , _ring(ring)
+                , _params(params)
+                , _sqRing(MAP_FAILED)
+                , _cqRing(MAP_FAILED)
+                , _sqes(MAP_FAILED)
+                , _iovecs(std::max<uint16_t>(options._depth, 2))
+                , _results(_iovecs.size(), 0)
+                , _done(_iovecs.size(), true)
+                {
+                    _sqRingSize = _params.sq_off.array + _params.sq_entries * sizeof(unsigned);
+                    _cqRingSize = _params.cq_off.cqes + _params.cq_entries * sizeof(io_uring_cqe);
+                    _sqesSize = _params.sq_entries * sizeof(io_uring_sqe);
+                    _sqRing = map(_sqRingSize, IORING_OFF_SQ_RING);
+                    _cqRing = map(_cqRingSize, IORING_OFF_CQ_RING);
+                    _sqes = map(_sqesSize, IORING_OFF_SQES);
+                    if(_sqRing == MAP_FAILED || _cqRing == MAP_FAILED || _sqes == MAP_FAILED) {
+                        unmap();
+                        CSVSQLDB_THROW(FilesystemException, "could not map io_uring: " << errnoText());
+                    }
+                }
+
+                ~IoUringReadAheadReader()
+                {
+                    try {
+                        waitForAll();
+                    } catch(const std::exception&) {
+                        // the ring is not usable anymore, nothing left to wait for
+                    }
+                    unmap();
+                    ::close(_ring);
+                }
+
+                virtual const char* engine() const
+                {
+                    return "io_uring";
+                }
+
+                /**
+                 * Creates the ring. Returns -1 if io_uring is not available, e.g. because of an old kernel or a seccomp
+                 * filter.
+                 */
+                static int setup(uint16_t depth, io_uring_params& params)
+                {
+                    std::memset(&params, 0, sizeof(params));
+                    return static_cast<int>(::syscall(__NR_io_uring_setup, static_cast<unsigned>(depth), &params));
+                }
+
+            private:
+                virtual void submit(size_t slot, uint64_t offset)
+                {
+                    unsigned* tail = ringPointer<unsigned>(_sqRing, _params.sq_off.tail);
+                    const unsigned mask = *ringPointer<unsigned>(_sqRing, _params.sq_off.ring_mask);
+                    const unsigned index = *tail & mask;
+
+                    _iovecs[slot].iov_base = buffer(slot);
+                    _iovecs[slot].iov_len = _blockSize;
+                    io_uring_sqe* sqe = static_cast<io_uring_sqe*>(_sqes) + index;
+                    std::memset(sqe, 0, sizeof(io_uring_sqe));
+                    sqe->opcode = IORING_OP_READV;
+                    sqe->fd = _fd;
+                    sqe->addr = reinterpret_cast<uint64_t>(&_iovecs[slot]);
+                    sqe->len = 1;
+                    sqe->off = offset;
+                    sqe->user_data = slot;
+                    ringPointer<unsigned>(_sqRing, _params.sq_off.array)[index] = index;
+                    __atomic_store_n(tail, *tail + 1, __ATOMIC_RELEASE);
+                    _done[slot] = false;
+
+                    while(enter(1, 0, 0) < 0) {
+                        if(errno != EINTR && errno != EAGAIN) {
+                            CSVSQLDB_THROW(FilesystemException, "could not submit read to io_uring: " << errnoText());
+                        }
+                    }
+                }
+
+                virtual ssize_t wait(size_t slot)
+                {
+                    reap();
+                    while(!_done[slot]) {
+                        if(enter(0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+                            CSVSQLDB_THROW(FilesystemException, "could not wait for io_uring: " << errnoText());
+                        }
+                        reap();
+                    }
+                    return _results[slot];
+                }
+
+                void reap()
+                {
+                    unsigned* head = ringPointer<unsigned>(_cqRing, _params.cq_off.head);
+                    const unsigned* tailPointer = ringPointer<unsigned>(_cqRing, _params.cq_off.tail);
+                    const unsigned tail = __atomic_load_n(tailPointer, __ATOMIC_ACQUIRE);
+                    const unsigned mask = *ringPointer<unsigned>(_cqRing, _params.cq_off.ring_mask);
+                    io_uring_cqe* cqes = ringPointer<io_uring_cqe>(_cqRing, _params.cq_off.cqes);
+                    unsigned current = *head;
+                    for(; current != tail; ++current) {
+                        const io_uring_cqe& cqe = cqes[current & mask];
+                        _results[cqe.user_data] = cqe.res;
+                        _done[cqe.user_data] = true;
+                    }
+                    __atomic_store_n(head, current, __ATOMIC_RELEASE);
+                }
+
+                int enter(unsigned toSubmit, unsigned minComplete, unsigned flags)
+                {
+                    return static_cast<int>(::syscall(__NR_io_uring_enter, _ring, toSubmit, minComplete, flags, nullptr, 0));
+                }
+
+                void* map(size_t size, off_t offset)
+                {
+                    return ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ring, offset);
+                }
+
+                template <typename T>
+                static T* ringPointer(void* ring, uint32_t offset)
+                {
+                    return reinterpret_cast<T*>(static_cast<char*>(ring) + offset);
+                }
+
+                void unmap()
+                {
+                    if(_sqes != MAP_FAILED) {
+                        ::munmap(_sqes, _sqesSize);
+                    }
+                    if(_cqRing != MAP_FAILED) {
+                        ::munmap(_cqRing, _cqRingSize);
+                    }
+                    if(_sqRing != MAP_FAILED) {
+                        ::munmap(_sqRing, _sqRingSize);
+                    }
+                }
+
+                int _ring;
+                io_uring_params _params;
+                void* _sqRing;
+                void* _cqRing;
+                void* _sqes;
+                size_t _sqRingSize;
+                size_t _cqRingSize;
+                size_t _sqesSize;
+                std::vector<iovec> _iovecs;
+                std::vector<ssize_t> _results;
+                std::vector<bool> _done;
+            };
+#endif
+
+            int openFile(const std::string& path, bool directIO)
+            {
+                int fd = -1;
+#if defined(O_DIRECT)
+                if(directIO) {
+                    // not all file systems support direct I/O, those are read through the page cache
+                    fd = ::open(path.c_str(), O_RDONLY | O_DIRECT);
+                }
+#endif
+                if(fd < 0) {
+                    fd = ::open(path.c_str(), O_RDONLY);
+                    if(fd < 0) {
+                        CSVSQLDB_THROW(FilesystemException, "could not open file '" << path << "': " << errnoText());
+                    }
+#if defined(F_NOCACHE)
+                    if(directIO) {
+                        ::fcntl(fd, F_NOCACHE, 1);
+                    }
+#endif
+#if defined(POSIX_FADV_SEQUENTIAL)
+                    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+                }
+                return fd;
+            }
+        }
+
+        std::unique_ptr<ReadAheadReader> createReadAheadReader(const std::string& path, const ReadAheadOptions& options)
+        {
+            if(options._blockSize == 0 || options._blockSize % s_alignment != 0) {
+                CSVSQLDB_THROW(FilesystemException, "read ahead block size has to be a multiple of " << s_alignment);
+            }
+            const int fd = openFile(path, options._directIO);
+#if defined(CSVSQLDB_HAVE_IO_URING) && defined(__NR_io_uring_setup)
+            io_uring_params params;
+            const int ring = IoUringReadAheadReader::setup(std::max<uint16_t>(options._depth, 2), params);
+            if(ring >= 0) {
+                try {
+                    return std::unique_ptr<ReadAheadReader>(new IoUringReadAheadReader(fd, ring, params, path, options));
+                } catch(const std::exception&) {
+                    ::close(ring);
+                    throw;
+                }
+            }
+#endif
+            return std::unique_ptr<ReadAheadReader>(new PreadReadAheadReader(fd, path, options));
+        }
+    }
+}
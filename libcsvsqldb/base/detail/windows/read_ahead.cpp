@@ -0,0 +1,88 @@
+//
+//  read_ahead.cpp
+//  csvsqldb
+//
+//  BSD 3-Clause License
+//  Copyright (c) 2015, Lars-Christian Fürstenberg
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification, are permitted
+//  provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or other materials provided
+//  with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors may be used to
+//  endorse or promote products derived from this software without specific prior written
+//  permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+//  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+//  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+//  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "base/read_ahead.h"
+
+#include "base/exception.h"
+
+#include <fstream>
+#include <vector>
+
+
+namespace csvsqldb
+{
+    namespace detail
+    {
+        namespace
+        {
+            /**
+             * Reads the blocks synchronously, the consumer still gets the large blocks without copying.
+             */
+            class StreamReadAheadReader : public ReadAheadReader
+            {
+            public:
+                StreamReadAheadReader(const std::string& path, const ReadAheadOptions& options)
+                : _stream(path, std::ios::in | std::ios::binary)
+                , _buffer(options._blockSize)
+                {
+                    if(!_stream) {
+                        CSVSQLDB_THROW(FilesystemException, "could not open file '" << path << "'");
+                    }
+                }
+
+                virtual const char* engine() const
+                {
+                    return "stream";
+                }
+
+                virtual std::pair<const char*, size_t> next()
+                {
+                    _stream.read(&_buffer[0], static_cast<std::streamsize>(_buffer.size()));
+                    return std::make_pair(&_buffer[0], static_cast<size_t>(_stream.gcount()));
+                }
+
+            private:
+                std::ifstream _stream;
+                std::vector<char> _buffer;
+            };
+        }
+
+        std::unique_ptr<ReadAheadReader> createReadAheadReader(const std::string& path, const ReadAheadOptions& options)
+        {
+            if(options._blockSize == 0) {
+                CSVSQLDB_THROW(FilesystemException, "read ahead block size must not be zero");
+            }
+            return std::unique_ptr<ReadAheadReader>(new StreamReadAheadReader(path, options));
+        }
+    }
+}
@@ -45,6 +45,8 @@ namespace csvsqldb
         logging.device = _configuration->get("logging.device", "None");
         logging.separator = " " + _configuration->get("logging.separator", "|") + " ";
         logging.escape_newline = _configuration->get("logging.escape_newline", false);
+        logging.async = _configuration->get("logging.async", false);
+        logging.queue_size = _configuration->get("logging.queue_size", 8192);
 
         debug.global_level = _configuration->get("debug.global_level", 0);
         if(_configuration->hasProperty("debug.level")) {
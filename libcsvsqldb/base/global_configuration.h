@@ -80,6 +80,8 @@ namespace csvsqldb
             std::string device;
             std::string separator;
             bool escape_newline;
+            bool async;
+            int32_t queue_size;
         };
 
         /**
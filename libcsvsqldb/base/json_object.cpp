@@ -87,6 +87,11 @@ namespace csvsqldb
             CSVSQLDB_THROW(csvsqldb::JsonException, "object with name '" << name << "' not found");
         }
 
+        bool JsonObject::hasMember(const std::string& name) const
+        {
+            return _type == Object && _objects.find(name) != _objects.end();
+        }
+
         JsonObjectCallback::JsonObjectCallback()
         {
         }
@@ -75,6 +75,13 @@ namespace csvsqldb
              */
             const JsonObject& operator[](const std::string& name) const;
 
+            /**
+             * Checks if this instance is an object with a JsonObject for the given name.
+             * @param name The name to lookup
+             * @return true if there is a JsonObject for the name, otherwise false
+             */
+            bool hasMember(const std::string& name) const;
+
             /**
              * Returns an JsonObject array if this instance is an array. Will throw a JsonException if this instance is not an
              * array.
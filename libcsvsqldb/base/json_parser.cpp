@@ -185,40 +185,41 @@ namespace csvsqldb
                             safeNextChar();
                         }
                         if(_currentChar == '0') {
-                            lex._number = 0.0;
+                            // a leading zero cannot be followed by further digits, but by a fraction or exponent
+                            ss << _currentChar;
                             safeNextChar();
                         } else {
                             while(std::isdigit(_currentChar)) {
                                 ss << _currentChar;
                                 safeNextChar();
                             }
-                            if(_currentChar == '.') {
+                        }
+                        if(_currentChar == '.') {
+                            ss << _currentChar;
+                            safeNextChar();
+                            if(!std::isdigit(_currentChar)) {
+                                CSVSQLDB_THROW(JsonException, "bad number format");
+                            }
+                            ss << _currentChar;
+                            safeNextChar();
+                            while(std::isdigit(_currentChar)) {
                                 ss << _currentChar;
                                 safeNextChar();
-                                if(!std::isdigit(_currentChar)) {
-                                    CSVSQLDB_THROW(JsonException, "bad number format");
-                                }
+                            }
+                        }
+                        if(_currentChar == 'e' || _currentChar == 'E') {
+                            ss << _currentChar;
+                            safeNextChar();
+                            if(_currentChar == '+' || _currentChar == '-') {
                                 ss << _currentChar;
                                 safeNextChar();
-                                while(std::isdigit(_currentChar)) {
-                                    ss << _currentChar;
-                                    safeNextChar();
-                                }
                             }
-                            if(_currentChar == 'e' || _currentChar == 'E') {
+                            while(std::isdigit(_currentChar)) {
                                 ss << _currentChar;
                                 safeNextChar();
-                                if(_currentChar == '+' || _currentChar == '-') {
-                                    ss << _currentChar;
-                                    safeNextChar();
-                                }
-                                while(std::isdigit(_currentChar)) {
-                                    ss << _currentChar;
-                                    safeNextChar();
-                                }
                             }
-                            lex._number = std::stod(ss.str());
                         }
+                        lex._number = std::stod(ss.str());
                     } else if(lex._token == FALSE) {
                         if(safeNextChar() != 'a' || safeNextChar() != 'l' || safeNextChar() != 's' || safeNextChar() != 'e') {
                             CSVSQLDB_THROW(JsonException, "illegal token '" << _currentChar << "' found, false expected");
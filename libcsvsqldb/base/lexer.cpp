@@ -72,7 +72,8 @@ namespace csvsqldb
                 boost::smatch match;
 
                 for(const auto& r : _tokenDefinitions) {
-                    if(regex_search(_pos, _end, match, r._rx)) {
+                    // only look for a match at the current position, otherwise each token would scan the rest of the input
+                    if(regex_search(_pos, _end, match, r._rx, boost::match_continuous)) {
                         if(_pos == _pos + match.position()) {
                             Token token;
                             token._name = r._name;
@@ -84,6 +85,7 @@ namespace csvsqldb
                             }
                             token._lineCount = _lineCount;
                             token._charCount = static_cast<uint16_t>(std::distance(_lineStart, _pos)) + 1;
+                            token._position = static_cast<size_t>(std::distance(_input.cbegin(), _pos));
 
                             _pos = _pos + match.length();
 
@@ -115,6 +117,7 @@ namespace csvsqldb
             } else {
                 Token ret;
                 ret._token = EOI;
+                ret._position = _input.size();
                 return ret;
             }
             // didn't find any matching regex
@@ -73,6 +73,7 @@ namespace csvsqldb
             : _token(UNDEFINED)
             , _lineCount(0)
             , _charCount(0)
+            , _position(0)
             {
             }
 
@@ -81,6 +82,7 @@ namespace csvsqldb
             std::string _value;     //!< The corresponding string value of the token
             uint32_t _lineCount;    //!< The starting line of the token
             uint16_t _charCount;    //!< The starting column position of the token
+            size_t _position;       //!< The offset of the token from the start of the input
         };
 
         /**
@@ -0,0 +1,115 @@
+//
+//  like_matcher.cpp
+//  csvsqldb
+//
+//  BSD 3-Clause License
+//  Copyright (c) 2015, Lars-Christian Fürstenberg
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification, are permitted
+//  provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or other materials provided
+//  with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors may be used to
+//  endorse or promote products derived from this software without specific prior written
+//  permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+//  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+//  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+//  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "like_matcher.h"
+
+#include <cstring>
+
+
+namespace csvsqldb
+{
+    namespace
+    {
+        bool isMetaCharacter(char c)
+        {
+            return c == '.' || c == '*' || c == '+' || c == '?' || c == '|' || c == '(' || c == ')' || c == '[' || c == '\\';
+        }
+    }
+
+
+    LikeMatcher::LikeMatcher(const std::string& pattern)
+    : _type(EXACT)
+    {
+        bool leadingWildcard = false;
+        bool trailingWildcard = false;
+        bool literal = true;
+
+        size_t n = 0;
+        while(pattern.compare(n, 2, ".*") == 0) {
+            leadingWildcard = true;
+            n += 2;
+        }
+        while(n < pattern.length()) {
+            if(pattern.compare(n, 2, ".*") == 0) {
+                while(pattern.compare(n, 2, ".*") == 0) {
+                    n += 2;
+                }
+                if(n < pattern.length()) {
+                    // a wildcard in the middle of the pattern
+                    literal = false;
+                }
+                trailingWildcard = true;
+            } else if(pattern[n] == '\\' && n + 1 < pattern.length() && pattern[n + 1] != 'w' && pattern[n + 1] != 'd'
+                      && pattern[n + 1] != 's') {
+                _literal += pattern[n + 1];
+                n += 2;
+            } else if(isMetaCharacter(pattern[n])) {
+                literal = false;
+                break;
+            } else {
+                _literal += pattern[n++];
+            }
+        }
+
+        if(!literal) {
+            _type = REGEXP;
+            _literal.clear();
+            _regexp.reset(new RegExp(pattern));
+        } else if(leadingWildcard && trailingWildcard) {
+            _type = SUBSTRING;
+        } else if(leadingWildcard) {
+            _type = SUFFIX;
+        } else if(trailingWildcard) {
+            _type = PREFIX;
+        }
+    }
+
+    bool LikeMatcher::match(const char* s) const
+    {
+        switch(_type) {
+            case EXACT:
+                return _literal == s;
+            case PREFIX:
+                return ::strncmp(s, _literal.c_str(), _literal.length()) == 0;
+            case SUFFIX: {
+                size_t len = ::strlen(s);
+                return len >= _literal.length() && ::memcmp(s + len - _literal.length(), _literal.c_str(), _literal.length()) == 0;
+            }
+            case SUBSTRING:
+                return ::strstr(s, _literal.c_str()) != nullptr;
+            case REGEXP:
+                return _regexp->match(s);
+        }
+        return false;
+    }
+}
@@ -0,0 +1,90 @@
+//
+//  like_matcher.h
+//  csvsqldb
+//
+//  BSD 3-Clause License
+//  Copyright (c) 2015, Lars-Christian Fürstenberg
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification, are permitted
+//  provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or other materials provided
+//  with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors may be used to
+//  endorse or promote products derived from this software without specific prior written
+//  permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+//  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+//  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+//  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef csvsqldb_like_matcher_h
+#define csvsqldb_like_matcher_h
+
+#include "libcsvsqldb/inc.h"
+
+#include "regexp.h"
+
+#include <memory>
+#include <string>
+
+
+namespace csvsqldb
+{
+    /**
+     * Matches strings against a LIKE pattern. The pattern is expected in the regular expression form the SQL parser
+     * translates LIKE patterns into. Patterns that consist of literal characters with optional leading and trailing
+     * wildcards are matched with plain string operations, all other patterns are matched with RegExp.
+     */
+    class CSVSQLDB_EXPORT LikeMatcher
+    {
+    public:
+        enum eMatchType { EXACT, PREFIX, SUFFIX, SUBSTRING, REGEXP };
+
+        /**
+         * Classifies the pattern and prepares the matching.
+         * @param pattern The translated LIKE pattern. Will throw a RegExpException if it needs RegExp and is invalid.
+         */
+        explicit LikeMatcher(const std::string& pattern);
+
+        /**
+         * Matches the whole string against the pattern.
+         * @param s String to match
+         * @return true if the string matches, otherwise false
+         */
+        bool match(const char* s) const;
+
+        eMatchType type() const
+        {
+            return _type;
+        }
+
+        /**
+         * Returns the literal part of the pattern. Empty for REGEXP patterns.
+         */
+        const std::string& literal() const
+        {
+            return _literal;
+        }
+
+    private:
+        eMatchType _type;
+        std::string _literal;
+        std::unique_ptr<RegExp> _regexp;
+    };
+}
+
+#endif
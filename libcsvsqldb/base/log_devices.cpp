@@ -33,6 +33,9 @@
 
 #include "log_devices.h"
 
+#include "metrics.h"
+
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 
@@ -68,4 +71,171 @@ namespace csvsqldb
     {
         std::cerr.flush();
     }
+
+
+    AsyncLogDevice::AsyncLogDevice(const std::shared_ptr<LogDevice>& target,
+                                   size_t capacity,
+                                   std::chrono::milliseconds flushInterval)
+    : _target(target)
+    , _capacity(capacity)
+    , _wakeupSize(std::max(capacity / 2, size_t(1)))
+    , _flushInterval(flushInterval)
+    , _head(&_stub)
+    , _tail(&_stub)
+    , _size(0)
+    , _enqueued(0)
+    , _dropped(0)
+    , _written(0)
+    , _stop(false)
+    , _flushRequested(false)
+    {
+        _stub._next.store(nullptr, std::memory_order_relaxed);
+        _writer = std::thread(&AsyncLogDevice::run, this);
+    }
+
+    AsyncLogDevice::~AsyncLogDevice()
+    {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _wakeup.notify_one();
+        _writer.join();
+    }
+
+    const std::string& AsyncLogDevice::name() const
+    {
+        static std::string name("AsyncLogDevice");
+        return name;
+    }
+
+    bool AsyncLogDevice::isConcurrent() const
+    {
+        return true;
+    }
+
+    void AsyncLogDevice::doLog(std::ostringstream& stream)
+    {
+        const size_t size = _size.fetch_add(1, std::memory_order_relaxed);
+        if(size >= _capacity) {
+            _size.fetch_sub(1, std::memory_order_relaxed);
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            metrics::Metrics::add(metrics::DROPPED_LOG_EVENTS);
+            return;
+        }
+
+        Node* node = new Node;
+        node->_line = stream.str();
+        push(node);
+        _enqueued.fetch_add(1, std::memory_order_release);
+
+        // wake up the writer early if the queue fills up, otherwise it writes once per flush interval; the lock makes sure
+        // the writer either sees the size in its wait predicate or gets the notification
+        if(size + 1 == _wakeupSize) {
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+            }
+            _wakeup.notify_one();
+        }
+    }
+
+    bool AsyncLogDevice::doOpen()
+    {
+        return true;
+    }
+
+    void AsyncLogDevice::doClose()
+    {
+    }
+
+    void AsyncLogDevice::doFlush()
+    {
+        const uint64_t enqueued = _enqueued.load(std::memory_order_acquire);
+        std::unique_lock<std::mutex> lock(_mutex);
+        if(_stop) {
+            return;
+        }
+        _flushRequested = true;
+        _wakeup.notify_one();
+        _drained.wait(lock, [&]() { return _written >= enqueued; });
+    }
+
+    void AsyncLogDevice::push(Node* node)
+    {
+        node->_next.store(nullptr, std::memory_order_relaxed);
+        Node* prev = _head.exchange(node, std::memory_order_acq_rel);
+        prev->_next.store(node, std::memory_order_release);
+    }
+
+    AsyncLogDevice::Node* AsyncLogDevice::pop()
+    {
+        Node* tail = _tail;
+        Node* next = tail->_next.load(std::memory_order_acquire);
+        if(tail == &_stub) {
+            if(!next) {
+                return nullptr;
+            }
+            _tail = next;
+            tail = next;
+            next = next->_next.load(std::memory_order_acquire);
+        }
+        if(next) {
+            _tail = next;
+            return tail;
+        }
+        // a producer has exchanged the head but not linked its node yet, it will be seen with the next batch
+        if(tail != _head.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        push(&_stub);
+        next = tail->_next.load(std::memory_order_acquire);
+        if(next) {
+            _tail = next;
+            return tail;
+        }
+        return nullptr;
+    }
+
+    size_t AsyncLogDevice::writeBatch()
+    {
+        std::ostringstream batch;
+        size_t count = 0;
+        Node* node = nullptr;
+        while(count < _capacity && (node = pop())) {
+            batch << node->_line;
+            delete node;
+            ++count;
+        }
+        if(count) {
+            _size.fetch_sub(count, std::memory_order_relaxed);
+            _target->doLog(batch);
+            _target->doFlush();
+
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _written += count;
+            }
+            _drained.notify_all();
+        }
+        return count;
+    }
+
+    void AsyncLogDevice::run()
+    {
+        bool stop = false;
+        size_t count = 0;
+        while(!stop) {
+            if(count < _capacity) {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _wakeup.wait_for(lock, _flushInterval, [this]() {
+                    return _stop || _flushRequested || _size.load(std::memory_order_relaxed) >= _wakeupSize;
+                });
+                stop = _stop;
+                _flushRequested = false;
+            }
+            count = writeBatch();
+        }
+        while(writeBatch()) {
+        }
+    }
 }
@@ -38,6 +38,13 @@
 
 #include "logging.h"
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
 
 namespace csvsqldb
 {
@@ -58,6 +65,79 @@ namespace csvsqldb
         virtual void doClose();
         virtual void doFlush();
     };
+
+    /**
+     * Log device that moves the writing of another log device into a background thread. The formatted events are handed
+     * over through a lock-free multiple producer single consumer queue, the writer thread writes them in batches and
+     * flushes the target device once per batch. The queue is bounded; events logged into a full queue are dropped and
+     * counted.
+     */
+    class CSVSQLDB_EXPORT AsyncLogDevice : public LogDevice
+    {
+    public:
+        /**
+         * Constructs an asynchronous log device and starts the writer thread.
+         * @param target The device the events are written to
+         * @param capacity Maximal number of queued events
+         * @param flushInterval Maximal time an event waits in the queue before it gets written
+         */
+        AsyncLogDevice(const std::shared_ptr<LogDevice>& target,
+                       size_t capacity,
+                       std::chrono::milliseconds flushInterval = std::chrono::milliseconds(50));
+
+        /**
+         * Writes all queued events and stops the writer thread.
+         */
+        ~AsyncLogDevice();
+
+        virtual const std::string& name() const;
+
+        virtual bool isConcurrent() const;
+
+        /**
+         * Returns the number of events dropped because the queue was full.
+         * @return The number of dropped events.
+         */
+        uint64_t dropped() const
+        {
+            return _dropped.load(std::memory_order_relaxed);
+        }
+
+    private:
+        struct Node {
+            std::atomic<Node*> _next;
+            std::string _line;
+        };
+
+        virtual void doLog(std::ostringstream& stream);
+
+        virtual bool doOpen();
+        virtual void doClose();
+        virtual void doFlush();
+
+        void push(Node* node);
+        Node* pop();
+        size_t writeBatch();
+        void run();
+
+        std::shared_ptr<LogDevice> _target;
+        const size_t _capacity;
+        const size_t _wakeupSize;
+        const std::chrono::milliseconds _flushInterval;
+        Node _stub;
+        std::atomic<Node*> _head;
+        Node* _tail;
+        std::atomic<size_t> _size;
+        std::atomic<uint64_t> _enqueued;
+        std::atomic<uint64_t> _dropped;
+        uint64_t _written;
+        bool _stop;
+        bool _flushRequested;
+        std::mutex _mutex;
+        std::condition_variable _wakeup;
+        std::condition_variable _drained;
+        std::thread _writer;
+    };
 }
 
 #endif
@@ -34,7 +34,9 @@
 #include "global_configuration.h"
 #include "log_devices.h"
 #include "logging.h"
+#include "metrics.h"
 #include "string_helper.h"
+#include "time_measurement.h"
 
 #include <boost/regex.hpp>
 
@@ -76,16 +78,31 @@ namespace csvsqldb
         doLog(os);
     }
 
+    void LogDevice::flush()
+    {
+        doFlush();
+    }
+
+    bool LogDevice::isConcurrent() const
+    {
+        return false;
+    }
+
     struct LogDeviceFactory {
-        LogDevicePtr create(const std::string& device) const
+        LogDevicePtr create(const std::string& device, bool async, size_t queueSize) const
         {
+            LogDevicePtr logDevice;
             if(device == "Console") {
-                return std::make_shared<ConsoleLogDevice>();
+                logDevice = std::make_shared<ConsoleLogDevice>();
             } else if(device == "None") {
                 return LogDevicePtr();
             } else {
                 throw Exception("unknown log device " + device);
             }
+            if(async) {
+                return std::make_shared<AsyncLogDevice>(logDevice, queueSize);
+            }
+            return logDevice;
         }
     };
 
@@ -93,7 +110,8 @@ namespace csvsqldb
 
     void Logging::init()
     {
-        s_logDevice = LogDeviceFactory().create(config<GlobalConfiguration>()->logging.device);
+        const GlobalConfiguration::Logging& logging = config<GlobalConfiguration>()->logging;
+        s_logDevice = LogDeviceFactory().create(logging.device, logging.async, static_cast<size_t>(logging.queue_size));
     }
 
     void Logging::log(const LogEvent& event)
@@ -101,8 +119,50 @@ namespace csvsqldb
         static std::mutex _serializeLog;
 
         if(s_logDevice) {
-            std::unique_lock<std::mutex> guard(_serializeLog);
-            s_logDevice->log(event);
+            if(s_logDevice->isConcurrent()) {
+                s_logDevice->log(event);
+            } else {
+                std::unique_lock<std::mutex> guard(_serializeLog);
+                s_logDevice->log(event);
+            }
+        }
+    }
+
+    void Logging::flush()
+    {
+        if(s_logDevice) {
+            s_logDevice->flush();
         }
     }
+
+
+    LogRateLimiter::LogRateLimiter(uint32_t burst, std::chrono::milliseconds interval)
+    : _burst(burst)
+    , _interval(std::chrono::duration_cast<std::chrono::nanoseconds>(interval).count())
+    , _windowStart(chrono::MonotonicClock::now())
+    , _count(0)
+    , _suppressed(0)
+    {
+    }
+
+    bool LogRateLimiter::admit(uint64_t& suppressed)
+    {
+        const int64_t now = chrono::MonotonicClock::now();
+        int64_t windowStart = _windowStart.load(std::memory_order_relaxed);
+        if(now - windowStart >= _interval && _windowStart.compare_exchange_strong(windowStart, now, std::memory_order_relaxed)) {
+            _count.store(0, std::memory_order_relaxed);
+        }
+        if(_count.fetch_add(1, std::memory_order_relaxed) < _burst) {
+            suppressed = takeSuppressed();
+            return true;
+        }
+        _suppressed.fetch_add(1, std::memory_order_relaxed);
+        metrics::Metrics::add(metrics::SUPPRESSED_LOG_EVENTS);
+        return false;
+    }
+
+    uint64_t LogRateLimiter::takeSuppressed()
+    {
+        return _suppressed.exchange(0, std::memory_order_relaxed);
+    }
 }
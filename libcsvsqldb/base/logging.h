@@ -39,6 +39,8 @@
 #include "global_configuration.h"
 #include "types.h"
 
+#include <atomic>
+#include <chrono>
 #include <mutex>
 #include <sstream>
 #include <string>
@@ -80,7 +82,20 @@ namespace csvsqldb
          */
         void log(const LogEvent& event);
 
+        /**
+         * Flushes the device. Calls doFlush.
+         */
+        void flush();
+
+        /**
+         * Returns if the device can be called from several threads at once. Otherwise the calls are serialized by Logging.
+         * @return true if the device handles concurrent calls itself, otherwise false.
+         */
+        virtual bool isConcurrent() const;
+
     private:
+        friend class AsyncLogDevice;
+
         /**
          * Template method to do the actual logging to the specific log device.
          * @param stream The stream contains the foprmatted event information
@@ -121,6 +136,11 @@ namespace csvsqldb
          */
         static void log(const LogEvent& event);
 
+        /**
+         * Flushes the log device. For asynchronous devices it waits until all events logged so far are written.
+         */
+        static void flush();
+
     private:
         /**
          * As the Logging class is a singleton, the constructor is private and deleted.
@@ -128,6 +148,41 @@ namespace csvsqldb
         Logging();
     };
 
+    /**
+     * Limits the number of events logged from one site. At most burst events per interval are admitted, the others are
+     * counted as suppressed. Thread safe.
+     */
+    class CSVSQLDB_EXPORT LogRateLimiter
+    {
+    public:
+        /**
+         * Constructs a rate limiter.
+         * @param burst Maximal number of events admitted per interval
+         * @param interval Length of the interval
+         */
+        LogRateLimiter(uint32_t burst, std::chrono::milliseconds interval);
+
+        /**
+         * Checks if the next event shall be logged.
+         * @param suppressed Returns the number of events suppressed since the last admitted event
+         * @return true if the event shall be logged, otherwise false.
+         */
+        bool admit(uint64_t& suppressed);
+
+        /**
+         * Returns the number of suppressed events not yet reported by admit and resets it.
+         * @return The number of pending suppressed events.
+         */
+        uint64_t takeSuppressed();
+
+    private:
+        const uint32_t _burst;
+        const int64_t _interval;
+        std::atomic<int64_t> _windowStart;
+        std::atomic<uint32_t> _count;
+        std::atomic<uint64_t> _suppressed;
+    };
+
 
 /**
  * Logs events with the categorie INFO.
@@ -200,6 +255,26 @@ namespace csvsqldb
         event._message = ss.str();                                                                                               \
         csvsqldb::Logging::log(event);                                                                                           \
     } while(0)
+
+/**
+ * Logs events with the categorie ERROR, but at most burst events per interval from this site. The number of suppressed
+ * events is appended to the next logged message.
+ * @param burst Maximal number of events logged per interval
+ * @param interval Length of the interval in milliseconds
+ * @param arg An output stream object
+ */
+#define CSVSQLDB_RATELIMITED_ERRORLOG(burst, interval, arg)                                                                      \
+    do {                                                                                                                         \
+        static csvsqldb::LogRateLimiter XX_limiter__(burst, std::chrono::milliseconds(interval));                                \
+        uint64_t XX_suppressed__ = 0;                                                                                            \
+        if(XX_limiter__.admit(XX_suppressed__)) {                                                                                \
+            if(XX_suppressed__) {                                                                                                \
+                CSVSQLDB_ERRORLOG(arg << " (" << XX_suppressed__ << " similar messages suppressed)");                            \
+            } else {                                                                                                             \
+                CSVSQLDB_ERRORLOG(arg);                                                                                          \
+            }                                                                                                                    \
+        }                                                                                                                        \
+    } while(0)
 }
 
 #endif
@@ -0,0 +1,370 @@
+//
+//  metrics.cpp
+//  csvsqldb
+//
+//  BSD 3-Clause License
+//  Copyright (c) 2015, Lars-Christian Fürstenberg
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification, are permitted
+//  provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or other materials provided
+//  with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors may be used to
+//  endorse or promote products derived from this software without specific prior written
+//  permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+//  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+//  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+//  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "metrics.h"
+
+#include "exception.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <set>
+
+#ifndef _MSC_VER
+#include <sys/resource.h>
+#endif
+
+
+namespace csvsqldb
+{
+    namespace metrics
+    {
+        namespace
+        {
+            typedef std::atomic<uint64_t> AtomicValue;
+
+            // only the owning thread writes into a slot, so there is no need for an atomic read-modify-write
+            void increment(AtomicValue& value, uint64_t delta)
+            {
+                value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+            }
+
+            size_t bucketOf(uint64_t value)
+            {
+                // bucket 0 holds the 0, bucket n the values from 2^(n-1) to 2^n - 1
+                size_t bucket = 0;
+                while(value) {
+                    ++bucket;
+                    value >>= 1;
+                }
+                return bucket;
+            }
+
+            struct HistogramSlot {
+                HistogramSlot()
+                : _count(0)
+                , _sum(0)
+                , _max(0)
+                {
+                    for(auto& bucket : _buckets) {
+                        bucket.store(0, std::memory_order_relaxed);
+                    }
+                }
+
+                void record(uint64_t value)
+                {
+                    increment(_count, 1);
+                    increment(_sum, value);
+                    increment(_buckets[bucketOf(value)], 1);
+                    if(value > _max.load(std::memory_order_relaxed)) {
+                        _max.store(value, std::memory_order_relaxed);
+                    }
+                }
+
+                void addTo(HistogramSnapshot& snapshot) const
+                {
+                    snapshot._count += _count.load(std::memory_order_relaxed);
+                    snapshot._sum += _sum.load(std::memory_order_relaxed);
+                    snapshot._max = std::max(snapshot._max, _max.load(std::memory_order_relaxed));
+                    for(size_t n = 0; n < HistogramSnapshot::BucketCount; ++n) {
+                        snapshot._buckets[n] += _buckets[n].load(std::memory_order_relaxed);
+                    }
+                }
+
+                void foldInto(HistogramSlot& slot) const
+                {
+                    increment(slot._count, _count.load(std::memory_order_relaxed));
+                    increment(slot._sum, _sum.load(std::memory_order_relaxed));
+                    slot._max.store(std::max(slot._max.load(std::memory_order_relaxed), _max.load(std::memory_order_relaxed)),
+                                    std::memory_order_relaxed);
+                    for(size_t n = 0; n < HistogramSnapshot::BucketCount; ++n) {
+                        increment(slot._buckets[n], _buckets[n].load(std::memory_order_relaxed));
+                    }
+                }
+
+                AtomicValue _count;
+                AtomicValue _sum;
+                AtomicValue _max;
+                std::array<AtomicValue, HistogramSnapshot::BucketCount> _buckets;
+            };
+
+            struct Slot {
+                Slot()
+                {
+                    for(auto& counter : _counters) {
+                        counter.store(0, std::memory_order_relaxed);
+                    }
+                }
+
+                void foldInto(Slot& slot) const
+                {
+                    for(size_t n = 0; n < COUNTER_COUNT; ++n) {
+                        increment(slot._counters[n], _counters[n].load(std::memory_order_relaxed));
+                    }
+                    for(size_t n = 0; n < HISTOGRAM_COUNT; ++n) {
+                        _histograms[n].foldInto(slot._histograms[n]);
+                    }
+                }
+
+                std::array<AtomicValue, COUNTER_COUNT> _counters;
+                std::array<HistogramSlot, HISTOGRAM_COUNT> _histograms;
+            };
+
+            struct Registry {
+                std::mutex _mutex;
+                std::set<const Slot*> _slots;
+                Slot _retired;  //!< the sum of all slots of finished threads, only written with the mutex held
+            };
+
+            Registry& registry()
+            {
+                static Registry registry;
+                return registry;
+            }
+
+            struct SlotHolder {
+                SlotHolder()
+                : _slot(new Slot)
+                {
+                    Registry& reg = registry();
+                    std::lock_guard<std::mutex> guard(reg._mutex);
+                    reg._slots.insert(_slot.get());
+                }
+
+                ~SlotHolder()
+                {
+                    Registry& reg = registry();
+                    std::lock_guard<std::mutex> guard(reg._mutex);
+                    _slot->foldInto(reg._retired);
+                    reg._slots.erase(_slot.get());
+                }
+
+                std::unique_ptr<Slot> _slot;
+            };
+
+            Slot& threadSlot()
+            {
+                thread_local SlotHolder holder;
+                return *holder._slot;
+            }
+
+            struct QueryLogState {
+                QueryLogState()
+                : _capacity(QueryLog::DefaultCapacity)
+                , _nextId(1)
+                {
+                }
+
+                std::mutex _mutex;
+                std::deque<QueryInfo> _queries;
+                size_t _capacity;
+                uint64_t _nextId;
+            };
+
+            QueryLogState& queryLog()
+            {
+                static QueryLogState state;
+                return state;
+            }
+        }
+
+
+        HistogramSnapshot::HistogramSnapshot()
+        : _count(0)
+        , _sum(0)
+        , _max(0)
+        {
+            _buckets.fill(0);
+        }
+
+        uint64_t HistogramSnapshot::percentile(double p) const
+        {
+            if(!_count) {
+                return 0;
+            }
+            const uint64_t rank = std::max(static_cast<uint64_t>(std::ceil(p * static_cast<double>(_count))), uint64_t(1));
+            uint64_t seen = 0;
+            for(size_t n = 0; n < BucketCount; ++n) {
+                seen += _buckets[n];
+                if(seen >= rank) {
+                    const uint64_t upperBound = n == 0 ? 0 : (n >= 64 ? UINT64_MAX : (uint64_t(1) << n) - 1);
+                    return std::min(upperBound, _max);
+                }
+            }
+            return _max;
+        }
+
+
+        void Metrics::add(eCounter counter, uint64_t value)
+        {
+            increment(threadSlot()._counters[counter], value);
+        }
+
+        void Metrics::record(eHistogram histogram, uint64_t value)
+        {
+            threadSlot()._histograms[histogram].record(value);
+        }
+
+        uint64_t Metrics::value(eCounter counter)
+        {
+            Registry& reg = registry();
+            std::lock_guard<std::mutex> guard(reg._mutex);
+            uint64_t sum = reg._retired._counters[counter].load(std::memory_order_relaxed);
+            for(const auto slot : reg._slots) {
+                sum += slot->_counters[counter].load(std::memory_order_relaxed);
+            }
+            return sum;
+        }
+
+        HistogramSnapshot Metrics::snapshot(eHistogram histogram)
+        {
+            HistogramSnapshot snapshot;
+            Registry& reg = registry();
+            std::lock_guard<std::mutex> guard(reg._mutex);
+            reg._retired._histograms[histogram].addTo(snapshot);
+            for(const auto slot : reg._slots) {
+                slot->_histograms[histogram].addTo(snapshot);
+            }
+            return snapshot;
+        }
+
+        const char* Metrics::name(eCounter counter)
+        {
+            switch(counter) {
+                case BYTES_READ:
+                    return "bytes_read";
+                case LINES_PARSED:
+                    return "lines_parsed";
+                case PARSE_ERRORS:
+                    return "parse_errors";
+                case BLOCKS_ALLOCATED:
+                    return "blocks_allocated";
+                case SPILLED_ROWS:
+                    return "spilled_rows";
+                case SPILLED_BYTES:
+                    return "spilled_bytes";
+                case HASH_PROBES:
+                    return "hash_probes";
+                case SORT_COMPARISONS:
+                    return "sort_comparisons";
+                case QUERIES:
+                    return "queries";
+                case FAILED_QUERIES:
+                    return "failed_queries";
+                case READER_CPU_TIME:
+                    return "reader_cpu_ns";
+                case WORKER_CPU_TIME:
+                    return "worker_cpu_ns";
+                case IO_WAIT_TIME:
+                    return "io_wait_ns";
+                case DROPPED_LOG_EVENTS:
+                    return "dropped_log_events";
+                case SUPPRESSED_LOG_EVENTS:
+                    return "suppressed_log_events";
+                case COUNTER_COUNT:
+                    break;
+            }
+            CSVSQLDB_THROW(csvsqldb::Exception, "unknown counter " << static_cast<int>(counter));
+        }
+
+        const char* Metrics::name(eHistogram histogram)
+        {
+            switch(histogram) {
+                case QUERY_LATENCY:
+                    return "query_latency_us";
+                case HISTOGRAM_COUNT:
+                    break;
+            }
+            CSVSQLDB_THROW(csvsqldb::Exception, "unknown histogram " << static_cast<int>(histogram));
+        }
+
+
+        uint64_t peakResidentBytes()
+        {
+#ifndef _MSC_VER
+            rusage usage;
+            if(::getrusage(RUSAGE_SELF, &usage) != 0) {
+                return 0;
+            }
+#ifdef __APPLE__
+            return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+            return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+#else
+            return 0;
+#endif
+        }
+
+
+        QueryInfo::QueryInfo()
+        : _id(0)
+        , _duration(0)
+        , _rows(0)
+        , _success(true)
+        {
+        }
+
+
+        void QueryLog::add(QueryInfo info)
+        {
+            QueryLogState& state = queryLog();
+            std::lock_guard<std::mutex> guard(state._mutex);
+            info._id = state._nextId++;
+            state._queries.push_back(std::move(info));
+            while(state._queries.size() > state._capacity) {
+                state._queries.pop_front();
+            }
+        }
+
+        QueryLog::QueryInfos QueryLog::queries()
+        {
+            QueryLogState& state = queryLog();
+            std::lock_guard<std::mutex> guard(state._mutex);
+            return QueryInfos(state._queries.begin(), state._queries.end());
+        }
+
+        void QueryLog::setCapacity(size_t capacity)
+        {
+            QueryLogState& state = queryLog();
+            std::lock_guard<std::mutex> guard(state._mutex);
+            state._capacity = capacity;
+            while(state._queries.size() > state._capacity) {
+                state._queries.pop_front();
+            }
+        }
+    }
+}
@@ -0,0 +1,149 @@
+//
+//  metrics.h
+//  csvsqldb
+//
+//  BSD 3-Clause License
+//  Copyright (c) 2015, Lars-Christian Fürstenberg
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification, are permitted
+//  provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or other materials provided
+//  with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors may be used to
+//  endorse or promote products derived from this software without specific prior written
+//  permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+//  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+//  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+//  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef csvsqldb_metrics_h
+#define csvsqldb_metrics_h
+
+#include "libcsvsqldb/inc.h"
+
+#include "timestamp.h"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+namespace csvsqldb
+{
+    /**
+     * Process wide engine counters and histograms. Each thread writes into its own slot without any synchronization
+     * besides relaxed atomics, readers sum up all slots. The slots of finished threads are folded into a common total.
+     * Counters only increase, consumers have to compute the deltas themselves.
+     */
+    namespace metrics
+    {
+        enum eCounter {
+            BYTES_READ,
+            LINES_PARSED,
+            PARSE_ERRORS,
+            BLOCKS_ALLOCATED,
+            SPILLED_ROWS,
+            SPILLED_BYTES,
+            HASH_PROBES,
+            SORT_COMPARISONS,
+            QUERIES,
+            FAILED_QUERIES,
+            READER_CPU_TIME,
+            WORKER_CPU_TIME,
+            IO_WAIT_TIME,
+            DROPPED_LOG_EVENTS,
+            SUPPRESSED_LOG_EVENTS,
+            COUNTER_COUNT
+        };
+
+        enum eHistogram { QUERY_LATENCY, HISTOGRAM_COUNT };
+
+        /**
+         * The state of a histogram at one point in time. Values are collected in power of two buckets, so percentiles are
+         * estimated with the upper bound of the bucket.
+         */
+        struct CSVSQLDB_EXPORT HistogramSnapshot {
+            static const size_t BucketCount = 65;
+
+            HistogramSnapshot();
+
+            uint64_t percentile(double p) const;
+
+            uint64_t _count;
+            uint64_t _sum;
+            uint64_t _max;
+            std::array<uint64_t, BucketCount> _buckets;
+        };
+
+        class CSVSQLDB_EXPORT Metrics
+        {
+        public:
+            static void add(eCounter counter, uint64_t value = 1);
+
+            static void record(eHistogram histogram, uint64_t value);
+
+            static uint64_t value(eCounter counter);
+
+            static HistogramSnapshot snapshot(eHistogram histogram);
+
+            static const char* name(eCounter counter);
+
+            static const char* name(eHistogram histogram);
+        };
+
+        /**
+         * Returns the peak resident memory of the process in bytes or 0 if it is not available.
+         */
+        CSVSQLDB_EXPORT uint64_t peakResidentBytes();
+
+        struct CSVSQLDB_EXPORT QueryInfo {
+            QueryInfo();
+
+            uint64_t _id;
+            std::string _statement;
+            csvsqldb::Timestamp _start;
+            uint64_t _duration;  //!< in microseconds
+            int64_t _rows;
+            bool _success;
+            std::string _error;
+        };
+
+        /**
+         * Keeps the most recently executed statements.
+         */
+        class CSVSQLDB_EXPORT QueryLog
+        {
+        public:
+            typedef std::vector<QueryInfo> QueryInfos;
+
+            static const size_t DefaultCapacity = 1000;
+
+            /**
+             * Adds the query and assigns it the next query id. If the log is full, the oldest query is dropped.
+             */
+            static void add(QueryInfo info);
+
+            static QueryInfos queries();
+
+            static void setCapacity(size_t capacity);
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,111 @@
+//
+//  read_ahead.cpp
+//  csvsqldb
+//
+//  BSD 3-Clause License
+//  Copyright (c) 2015, Lars-Christian Fürstenberg
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification, are permitted
+//  provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or other materials provided
+//  with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors may be used to
+//  endorse or promote products derived from this software without specific prior written
+//  permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+//  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+//  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+//  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "read_ahead.h"
+
+#include "metrics.h"
+#include "time_measurement.h"
+
+
+namespace csvsqldb
+{
+    ReadAheadOptions::ReadAheadOptions()
+    : _blockSize(4 * 1024 * 1024)
+    , _depth(3)
+    , _directIO(false)
+    {
+    }
+
+
+    ReadAheadStreamBuf::ReadAheadStreamBuf(const std::string& path, const ReadAheadOptions& options)
+    : _reader(detail::createReadAheadReader(path, options))
+    {
+    }
+
+    ReadAheadStreamBuf::~ReadAheadStreamBuf()
+    {
+    }
+
+    const char* ReadAheadStreamBuf::engine() const
+    {
+        return _reader->engine();
+    }
+
+    ReadAheadStreamBuf::int_type ReadAheadStreamBuf::underflow()
+    {
+        if(gptr() < egptr()) {
+            return traits_type::to_int_type(*gptr());
+        }
+        std::pair<const char*, size_t> block = readBlock();
+        if(!block.second) {
+            return traits_type::eof();
+        }
+        // the get area is only read, the cast is needed by the streambuf interface
+        char* data = const_cast<char*>(block.first);
+        setg(data, data, data + block.second);
+        return traits_type::to_int_type(*gptr());
+    }
+
+    std::pair<const char*, size_t> ReadAheadStreamBuf::nextBlock()
+    {
+        std::pair<const char*, size_t> block;
+        if(gptr() < egptr()) {
+            block = std::make_pair(gptr(), static_cast<size_t>(egptr() - gptr()));
+        } else {
+            block = readBlock();
+            if(!block.second) {
+                return block;
+            }
+        }
+        char* end = const_cast<char*>(block.first + block.second);
+        setg(end, end, end);
+        return block;
+    }
+
+    std::pair<const char*, size_t> ReadAheadStreamBuf::readBlock()
+    {
+        // only waiting for the reads counts, the blocks are not copied
+        const int64_t start = chrono::MonotonicClock::now();
+        std::pair<const char*, size_t> block = _reader->next();
+        metrics::Metrics::add(metrics::IO_WAIT_TIME, static_cast<uint64_t>(chrono::MonotonicClock::now() - start));
+        return block;
+    }
+
+
+    ReadAheadStream::ReadAheadStream(const std::string& path, const ReadAheadOptions& options)
+    : std::istream(nullptr)
+    , _buffer(path, options)
+    {
+        rdbuf(&_buffer);
+    }
+}
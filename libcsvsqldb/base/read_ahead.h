@@ -0,0 +1,155 @@
+//
+//  read_ahead.h
+//  csvsqldb
+//
+//  BSD 3-Clause License
+//  Copyright (c) 2015, Lars-Christian Fürstenberg
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification, are permitted
+//  provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or other materials provided
+//  with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors may be used to
+//  endorse or promote products derived from this software without specific prior written
+//  permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+//  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+//  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+//  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef csvsqldb_read_ahead_h
+#define csvsqldb_read_ahead_h
+
+#include "libcsvsqldb/inc.h"
+
+#include "types.h"
+
+#include <istream>
+#include <memory>
+#include <streambuf>
+#include <string>
+#include <utility>
+
+
+namespace csvsqldb
+{
+    /**
+     * Parameters for reading files ahead of their consumer.
+     */
+    struct CSVSQLDB_EXPORT ReadAheadOptions {
+        ReadAheadOptions();
+
+        size_t _blockSize; //!< size of one read in bytes, a multiple of 4096
+        uint16_t _depth;   //!< number of blocks read ahead, at least two in order to overlap reading and parsing
+        bool _directIO;    //!< bypass the page cache, if the platform and the file system support it
+    };
+
+    namespace detail
+    {
+        /**
+         * Platform specific reader of the blocks of a file.
+         */
+        class ReadAheadReader
+        {
+        public:
+            virtual ~ReadAheadReader()
+            {
+            }
+
+            /**
+             * Returns the name of the used I/O mechanism.
+             */
+            virtual const char* engine() const = 0;
+
+            /**
+             * Returns the next block of the file. The block stays valid until the next call. An empty block marks the end
+             * of the file.
+             * @return Pointer to the data and size of the block
+             */
+            virtual std::pair<const char*, size_t> next() = 0;
+        };
+
+        /**
+         * Creates the best reader available on this platform. Will throw a FilesystemException if the file cannot be
+         * opened.
+         */
+        std::unique_ptr<ReadAheadReader> createReadAheadReader(const std::string& path, const ReadAheadOptions& options);
+    }
+
+    /**
+     * Stream buffer that keeps several large reads of a file in flight while the consumer works on the current block.
+     * On Linux the reads are submitted with io_uring if available, otherwise background threads read with pread. Reading
+     * through the stream interface copies the data out of the blocks, consumers that can work on whole blocks should use
+     * nextBlock() instead.
+     */
+    class CSVSQLDB_EXPORT ReadAheadStreamBuf : public std::streambuf, public noncopyable
+    {
+    public:
+        /**
+         * Opens the file and starts reading ahead. Will throw a FilesystemException if the file cannot be opened.
+         * @param path Path of the file to read
+         * @param options The read ahead parameters
+         */
+        ReadAheadStreamBuf(const std::string& path, const ReadAheadOptions& options);
+
+        ~ReadAheadStreamBuf();
+
+        /**
+         * Returns the name of the used I/O mechanism, e.g. "io_uring" or "pread".
+         */
+        const char* engine() const;
+
+        /**
+         * Hands the rest of the current block or the next block to the caller without copying and consumes it. The data
+         * stays valid until the next call or the next read from the stream.
+         * @return Pointer to the data and size of the block, an empty block marks the end of the file
+         */
+        std::pair<const char*, size_t> nextBlock();
+
+    protected:
+        virtual int_type underflow();
+
+    private:
+        std::pair<const char*, size_t> readBlock();
+
+        std::unique_ptr<detail::ReadAheadReader> _reader;
+    };
+
+    /**
+     * Input stream reading a file with a ReadAheadStreamBuf.
+     */
+    class CSVSQLDB_EXPORT ReadAheadStream : public std::istream
+    {
+    public:
+        /**
+         * Opens the file and starts reading ahead. Will throw a FilesystemException if the file cannot be opened.
+         * @param path Path of the file to read
+         * @param options The read ahead parameters
+         */
+        ReadAheadStream(const std::string& path, const ReadAheadOptions& options);
+
+        const char* engine() const
+        {
+            return _buffer.engine();
+        }
+
+    private:
+        ReadAheadStreamBuf _buffer;
+    };
+}
+
+#endif
@@ -34,8 +34,15 @@
 #include "regexp.h"
 #include "exception.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <cstring>
 #include <list>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 
@@ -315,6 +322,16 @@ namespace csvsqldb
             return _tran._type == Transition::Epsilon;
         }
 
+        bool literal() const
+        {
+            return _tran._type == Transition::Char;
+        }
+
+        char character() const
+        {
+            return _tran._c;
+        }
+
         bool match(char c) const
         {
             switch(_tran._type) {
@@ -389,11 +406,54 @@ namespace csvsqldb
     const std::string State::groupS = " \t\r\n";
 
 
+    typedef std::vector<State*> StateSet;
+
+    static void addClosure(StateSet& states, State* state)
+    {
+        if(state && state->epsilon()) {
+            if(state->_out1->epsilon()) {
+                addClosure(states, state->_out1);
+            } else {
+                states.push_back(state->_out1);
+            }
+            if(state->_out2 && state->_out2->epsilon()) {
+                addClosure(states, state->_out2);
+            } else if(state->_out2) {
+                states.push_back(state->_out2);
+            }
+        } else if(state) {
+            states.push_back(state);
+        }
+    }
+
+    static void normalize(StateSet& states)
+    {
+        std::sort(states.begin(), states.end());
+        states.erase(std::unique(states.begin(), states.end()), states.end());
+    }
+
+    static void step(const StateSet& from, char c, StateSet& to)
+    {
+        to.clear();
+        for(const auto state : from) {
+            if(state->accept() && state->match(c)) {
+                addClosure(to, state->_out1);
+                addClosure(to, state->_out2);
+            }
+        }
+        normalize(to);
+    }
+
+    static bool containsFinal(const StateSet& states)
+    {
+        return std::any_of(states.begin(), states.end(), [](const State* state) { return state->final(); });
+    }
+
+
     class Parser
     {
     public:
         typedef std::list<State> States;
-        typedef std::vector<State*> WorkStates;
 
         Parser(const std::string& s)
         : _lexer(s)
@@ -406,69 +466,17 @@ namespace csvsqldb
             _start = expression();
         }
 
-        bool match(const char* s) const
+        bool empty() const
         {
-            if(_states.empty()) {
-                return ::strlen(s) == 0;
-            }
-
-            WorkStates workStates;
-            eClosure(workStates, _start);
-
-            WorkStates tmpStates;
-            while(*s) {
-                while(!workStates.empty()) {
-                    State* current = workStates.back();
-                    workStates.pop_back();
-
-                    if(current->accept() && current->match(*s)) {
-                        eClosure(tmpStates, current->_out1);
-                        eClosure(tmpStates, current->_out2);
-                    } else if(current->epsilon()) {
-                        eClosure(workStates, current);
-                    }
-                }
-                std::swap(workStates, tmpStates);
-                ++s;
-            }
-            while(!workStates.empty()) {
-                State* current = workStates.back();
-                workStates.pop_back();
-
-                if(current->final()) {
-                    return true;
-                }
-            }
-
-            return false;
+            return _states.empty();
         }
 
-        bool match(const std::string& s) const
+        State* start() const
         {
-            return match(s.c_str());
+            return _start;
         }
 
     private:
-        void eClosure(WorkStates& states, State* state) const
-        {
-            if(state && state->epsilon()) {
-                if(state->_out1->epsilon()) {
-                    eClosure(states, state->_out1);
-                } else {
-                    states.emplace(states.end(), state->_out1);
-                }
-                if(state->_out2 && state->_out2->epsilon()) {
-                    eClosure(states, state->_out2);
-                } else if(state->_out2) {
-                    states.emplace(states.end(), state->_out2);
-                }
-            } else if(state) {
-                if(state) {
-                    states.emplace(states.end(), state);
-                }
-            }
-        }
-
         State* expression()
         {
             State* state = factor();
@@ -623,6 +631,187 @@ namespace csvsqldb
     };
 
 
+    /**
+     * Lazily built DFA on top of the parsed state graph. DFA states are sets of graph states and are created on first
+     * use. Input bytes are mapped to classes of bytes that no transition can tell apart, so that each DFA state only
+     * needs one transition per class. A literal prefix every match has to start with is compared up front. The DFA is
+     * shared by all threads: known transitions are followed without locking, only adding a transition takes the lock.
+     * If the state cache is full, the graph is simulated directly instead.
+     */
+    class DFA
+    {
+    public:
+        DFA()
+        : _classCount(0)
+        , _dstates(new std::unique_ptr<DState>[maxStates])
+        , _stateCount(0)
+        {
+        }
+
+        void compile(State* start)
+        {
+            StateSet states;
+            addClosure(states, start);
+            normalize(states);
+            while(states.size() == 1 && states[0]->accept() && states[0]->literal()) {
+                State* state = states[0];
+                _prefix += state->character();
+                states.clear();
+                addClosure(states, state->_out1);
+                addClosure(states, state->_out2);
+                normalize(states);
+            }
+
+            computeByteClasses(start);
+            addState(states);
+        }
+
+        bool match(const char* s) const
+        {
+            if(!_prefix.empty()) {
+                if(::strncmp(s, _prefix.c_str(), _prefix.size()) != 0) {
+                    return false;
+                }
+                s += _prefix.size();
+            }
+
+            const DState* current = _dstates[0].get();
+            while(*s) {
+                const size_t byteClass = _byteClasses[static_cast<unsigned char>(*s)];
+                int32_t next = current->_next[byteClass].load(std::memory_order_acquire);
+                if(next == Unknown) {
+                    next = addTransition(*current, byteClass, *s);
+                    if(next == Unknown) {
+                        StateSet states;
+                        step(current->_states, *s, states);
+                        return simulate(states, s + 1);
+                    }
+                }
+                if(next == Dead) {
+                    return false;
+                }
+                current = _dstates[next].get();
+                ++s;
+            }
+
+            return current->_final;
+        }
+
+    private:
+        enum { Unknown = -1, Dead = -2 };
+
+        static const size_t maxStates = 1024;
+
+        struct DState {
+            DState(const StateSet& states, size_t classCount)
+            : _states(states)
+            , _final(containsFinal(states))
+            , _next(new std::atomic<int32_t>[classCount])
+            {
+                for(size_t n = 0; n < classCount; ++n) {
+                    _next[n].store(Unknown, std::memory_order_relaxed);
+                }
+            }
+
+            const StateSet _states;
+            const bool _final;
+            std::unique_ptr<std::atomic<int32_t>[]> _next;
+        };
+
+        void computeByteClasses(State* start)
+        {
+            _byteClasses.fill(0);
+            _classCount = 1;
+
+            std::vector<State*> pending{start};
+            std::vector<const State*> visited;
+            while(!pending.empty()) {
+                State* state = pending.back();
+                pending.pop_back();
+                if(!state || std::find(visited.begin(), visited.end(), state) != visited.end()) {
+                    continue;
+                }
+                visited.push_back(state);
+                pending.push_back(state->_out1);
+                pending.push_back(state->_out2);
+
+                if(!state->accept() || state->epsilon()) {
+                    continue;
+                }
+                std::array<int16_t, 512> remap;
+                remap.fill(-1);
+                size_t count = 0;
+                for(size_t n = 0; n < 256; ++n) {
+                    const size_t key = _byteClasses[n] * 2 + (state->match(static_cast<char>(n)) ? 1 : 0);
+                    if(remap[key] == -1) {
+                        remap[key] = static_cast<int16_t>(count++);
+                    }
+                    _byteClasses[n] = static_cast<uint8_t>(remap[key]);
+                }
+                _classCount = count;
+            }
+        }
+
+        /**
+         * Adds the transition of the state for the byte and returns its target. Returns Unknown if the target would need
+         * a new state, but the state cache is full.
+         */
+        int32_t addTransition(const DState& from, size_t byteClass, char c) const
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            // another thread may have added the transition in the meantime
+            int32_t next = from._next[byteClass].load(std::memory_order_relaxed);
+            if(next != Unknown) {
+                return next;
+            }
+            StateSet states;
+            step(from._states, c, states);
+            if(states.empty()) {
+                next = Dead;
+            } else {
+                const auto iter = _index.find(states);
+                if(iter != _index.end()) {
+                    next = iter->second;
+                } else if(_stateCount < maxStates) {
+                    next = addState(states);
+                } else {
+                    return Unknown;
+                }
+            }
+            // publishes the new state together with the transition to the threads following it without the lock
+            from._next[byteClass].store(next, std::memory_order_release);
+            return next;
+        }
+
+        int32_t addState(const StateSet& states) const
+        {
+            const int32_t index = static_cast<int32_t>(_stateCount++);
+            _dstates[index].reset(new DState(states, _classCount));
+            _index.emplace(states, index);
+            return index;
+        }
+
+        static bool simulate(StateSet states, const char* s)
+        {
+            StateSet next;
+            while(*s && !states.empty()) {
+                step(states, *s, next);
+                std::swap(states, next);
+                ++s;
+            }
+            return containsFinal(states);
+        }
+
+        std::string _prefix;
+        std::array<uint8_t, 256> _byteClasses;
+        size_t _classCount;
+        std::unique_ptr<std::unique_ptr<DState>[]> _dstates; //!< fixed size, so that adding states never moves them
+        mutable size_t _stateCount;                           //!< guarded by _mutex after compile
+        mutable std::map<StateSet, int32_t> _index;           //!< guarded by _mutex after compile
+        mutable std::mutex _mutex;
+    };
+
+
     struct RegExp::Private {
         Private(const std::string& s)
         : _parser(s)
@@ -630,14 +819,31 @@ namespace csvsqldb
         {
         }
 
+        void compile()
+        {
+            _parser.parse();
+            if(!_parser.empty()) {
+                _dfa.compile(_parser.start());
+            }
+        }
+
+        bool match(const char* s) const
+        {
+            if(_parser.empty()) {
+                return *s == '\0';
+            }
+            return _dfa.match(s);
+        }
+
         Parser _parser;
         std::string _regex;
+        DFA _dfa;
     };
 
     RegExp::RegExp()
     : _m(new Private(""))
     {
-        _m->_parser.parse();
+        _m->compile();
     }
 
     RegExp::~RegExp()
@@ -647,29 +853,29 @@ namespace csvsqldb
     RegExp::RegExp(const std::string& s)
     : _m(new Private(s))
     {
-        _m->_parser.parse();
+        _m->compile();
     }
 
     RegExp::RegExp(const RegExp& e)
     : _m(new Private(e._m->_regex))
     {
-        _m->_parser.parse();
+        _m->compile();
     }
 
     RegExp& RegExp::operator=(const std::string& s)
     {
         _m.reset(new Private(s));
-        _m->_parser.parse();
+        _m->compile();
         return *this;
     }
 
     bool RegExp::match(const std::string& s) const
     {
-        return _m->_parser.match(s);
+        return _m->match(s.c_str());
     }
 
     bool RegExp::match(const char* s) const
     {
-        return _m->_parser.match(s);
+        return _m->match(s);
     }
 }
@@ -33,8 +33,13 @@
 
 #include "thread_pool.h"
 #include "exception.h"
+#include "metrics.h"
+#include "time_measurement.h"
+#include "trace.h"
 
 #include <algorithm>
+#include <future>
+#include <memory>
 
 namespace csvsqldb
 {
@@ -85,8 +90,28 @@ namespace csvsqldb
         _taskQueueCondition.notify_one();
     }
 
+    void ThreadPool::executeTasks(const std::vector<Callback>& tasks)
+    {
+        std::vector<std::future<void>> results;
+        results.reserve(tasks.size());
+
+        for(const auto& task : tasks) {
+            std::shared_ptr<std::packaged_task<void()>> packagedTask = std::make_shared<std::packaged_task<void()>>(task);
+            results.push_back(packagedTask->get_future());
+            enqueueTask([packagedTask]() { (*packagedTask)(); });
+        }
+
+        for(auto& result : results) {
+            result.wait();
+        }
+        for(auto& result : results) {
+            result.get();
+        }
+    }
+
     void ThreadPool::run()
     {
+        CSVSQLDB_TRACE_THREAD_NAME("thread pool");
         while(!_quit.load()) {
             Callback task;
 
@@ -103,7 +128,10 @@ namespace csvsqldb
             }
 
             if(task) {
+                CSVSQLDB_TRACE_SCOPE("thread pool", "task");
+                const int64_t cpuStart = chrono::ThreadCpuClock::now();
                 task();
+                metrics::Metrics::add(metrics::WORKER_CPU_TIME, static_cast<uint64_t>(chrono::ThreadCpuClock::now() - cpuStart));
             }
         }
     }
@@ -95,6 +95,15 @@ namespace csvsqldb
             return _quit.load();
         }
 
+        /**
+         * Returns the number of threads of the thread pool.
+         * @return The number of threads
+         */
+        uint16_t numberOfThreads() const
+        {
+            return _numberOfThreads;
+        }
+
         /**
          * Enqueues a ThreadPool::Callback handler for execution. Will throw InvalidOperationException if the thread pool was
          * already stopped.
@@ -111,6 +120,14 @@ namespace csvsqldb
          */
         void enqueueTask(Callback task);
 
+        /**
+         * Enqueues all tasks for execution and waits for their completion. If a task throws an exception, the first exception
+         * will be rethrown in the calling thread after all tasks have finished. Will throw InvalidOperationException if the
+         * thread pool was already stopped.
+         * @param tasks The ThreadPool::Callback handlers to execute
+         */
+        void executeTasks(const std::vector<Callback>& tasks);
+
     private:
         typedef std::vector<std::thread> ThreadGroup;
         typedef std::queue<Callback> CallbackQueue;
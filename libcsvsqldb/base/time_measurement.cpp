@@ -33,6 +33,10 @@
 
 #include "time_measurement.h"
 
+#ifndef _MSC_VER
+#include <sys/resource.h>
+#endif
+
 
 namespace std
 {
@@ -82,5 +86,37 @@ namespace csvsqldb
 #endif
             return timePoint;
         }
+
+        int64_t ProcessCpuClock::now()
+        {
+#ifndef _MSC_VER
+            rusage usage;
+            if(::getrusage(RUSAGE_SELF, &usage) != 0) {
+                CSVSQLDB_THROW(ChronoException, "chrono internal error");
+            }
+            return (static_cast<int64_t>(usage.ru_utime.tv_sec) + static_cast<int64_t>(usage.ru_stime.tv_sec)) * 1000000000
+                   + (static_cast<int64_t>(usage.ru_utime.tv_usec) + static_cast<int64_t>(usage.ru_stime.tv_usec)) * 1000;
+#else
+            return static_cast<int64_t>(std::clock()) * (1000000000 / CLOCKS_PER_SEC);
+#endif
+        }
+
+        int64_t ThreadCpuClock::now()
+        {
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+            timespec ts;
+            if(::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+                CSVSQLDB_THROW(ChronoException, "chrono internal error");
+            }
+            return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#else
+            return static_cast<int64_t>(std::clock()) * (1000000000 / CLOCKS_PER_SEC);
+#endif
+        }
+
+        int64_t MonotonicClock::now()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
     }
 }
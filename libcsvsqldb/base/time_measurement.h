@@ -102,6 +102,41 @@ namespace csvsqldb
             // TODO LCF: move implementation to detail
             static ProcessTimePoint now();
         };
+
+        /**
+         * A clock for the CPU time used by all threads of the process.
+         */
+        class CSVSQLDB_EXPORT ProcessCpuClock : noncopyable
+        {
+        public:
+            /**
+             * Returns the user and system CPU time the process used so far in nanoseconds.
+             */
+            static int64_t now();
+        };
+
+        /**
+         * A clock for the CPU time used by the calling thread.
+         */
+        class CSVSQLDB_EXPORT ThreadCpuClock : noncopyable
+        {
+        public:
+            /**
+             * Returns the CPU time the calling thread used so far in nanoseconds. Uses the CPU time of the process on
+             * systems without a thread CPU clock.
+             */
+            static int64_t now();
+        };
+
+        /**
+         * A monotonic wall clock with nanosecond resolution. Used for the timestamps of measurements that have to be
+         * comparable between threads.
+         */
+        class CSVSQLDB_EXPORT MonotonicClock : noncopyable
+        {
+        public:
+            static int64_t now();
+        };
     }
 }
 
@@ -0,0 +1,241 @@
+//
+//  trace.cpp
+//  csvsqldb
+//
+//  BSD 3-Clause License
+//  Copyright (c) 2015, Lars-Christian Fürstenberg
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification, are permitted
+//  provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or other materials provided
+//  with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors may be used to
+//  endorse or promote products derived from this software without specific prior written
+//  permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+//  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+//  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+//  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "trace.h"
+
+#include "time_measurement.h"
+
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+
+namespace csvsqldb
+{
+    namespace trace
+    {
+        namespace
+        {
+            struct Event {
+                const char* _category;
+                const char* _name;
+                int64_t _start;
+                int64_t _end;
+            };
+
+            struct ThreadBuffer {
+                ThreadBuffer(uint32_t id, size_t capacity)
+                : _id(id)
+                , _capacity(capacity)
+                , _next(0)
+                {
+                }
+
+                void add(const Event& event)
+                {
+                    std::lock_guard<std::mutex> guard(_mutex);
+                    if(_events.size() < _capacity) {
+                        _events.push_back(event);
+                    } else {
+                        _events[_next] = event;
+                        _next = (_next + 1) % _capacity;
+                    }
+                }
+
+                void clear()
+                {
+                    std::lock_guard<std::mutex> guard(_mutex);
+                    _events.clear();
+                    _next = 0;
+                }
+
+                const uint32_t _id;
+                std::string _name;
+                std::mutex _mutex;
+                size_t _capacity;
+                std::vector<Event> _events;
+                size_t _next;
+            };
+
+            typedef std::shared_ptr<ThreadBuffer> ThreadBufferPtr;
+
+            struct Registry {
+                Registry()
+                : _enabled(false)
+                , _capacity(65536)
+                , _nextId(1)
+                , _origin(chrono::MonotonicClock::now())
+                {
+                }
+
+                std::atomic<bool> _enabled;
+                std::mutex _mutex;
+                std::vector<ThreadBufferPtr> _buffers;
+                size_t _capacity;
+                uint32_t _nextId;
+                int64_t _origin;
+            };
+
+            Registry& registry()
+            {
+                static Registry registry;
+                return registry;
+            }
+
+            ThreadBuffer& threadBuffer()
+            {
+                // the registry shares ownership, so the events of finished threads survive until the trace is written
+                thread_local ThreadBufferPtr buffer;
+                if(!buffer) {
+                    Registry& reg = registry();
+                    std::lock_guard<std::mutex> guard(reg._mutex);
+                    buffer = std::make_shared<ThreadBuffer>(reg._nextId++, reg._capacity);
+                    reg._buffers.push_back(buffer);
+                }
+                return *buffer;
+            }
+
+            void writeString(std::ostream& stream, const std::string& s)
+            {
+                stream << '"';
+                for(const auto c : s) {
+                    if(c == '"' || c == '\\') {
+                        stream << '\\';
+                    }
+                    stream << c;
+                }
+                stream << '"';
+            }
+
+            void writeMicros(std::ostream& stream, int64_t nanos)
+            {
+                nanos = std::max(nanos, int64_t(0));
+                stream << nanos / 1000 << '.' << std::setw(3) << std::setfill('0') << nanos % 1000 << std::setfill(' ');
+            }
+        }
+
+
+        void Tracer::enable(bool enabled)
+        {
+            if(enabled) {
+                clear();
+                registry()._origin = chrono::MonotonicClock::now();
+            }
+            registry()._enabled = enabled;
+        }
+
+        bool Tracer::isEnabled()
+        {
+            return registry()._enabled.load(std::memory_order_relaxed);
+        }
+
+        void Tracer::setBufferCapacity(size_t capacity)
+        {
+            Registry& reg = registry();
+            std::lock_guard<std::mutex> guard(reg._mutex);
+            reg._capacity = std::max(capacity, size_t(1));
+        }
+
+        void Tracer::setThreadName(const std::string& name)
+        {
+            if(isEnabled()) {
+                ThreadBuffer& buffer = threadBuffer();
+                std::lock_guard<std::mutex> guard(buffer._mutex);
+                buffer._name = name;
+            }
+        }
+
+        int64_t Tracer::startEvent()
+        {
+            return isEnabled() ? chrono::MonotonicClock::now() : 0;
+        }
+
+        void Tracer::endEvent(const char* category, const char* name, int64_t start)
+        {
+            if(isEnabled()) {
+                threadBuffer().add({ category, name, start, chrono::MonotonicClock::now() });
+            }
+        }
+
+        void Tracer::clear()
+        {
+            Registry& reg = registry();
+            std::lock_guard<std::mutex> guard(reg._mutex);
+            std::vector<ThreadBufferPtr> buffers;
+            for(auto& buffer : reg._buffers) {
+                // buffers only referenced by the registry belong to finished threads
+                if(buffer.use_count() > 1) {
+                    buffer->clear();
+                    buffers.push_back(buffer);
+                }
+            }
+            reg._buffers.swap(buffers);
+        }
+
+        void Tracer::writeChromeTrace(std::ostream& stream)
+        {
+            Registry& reg = registry();
+            std::lock_guard<std::mutex> guard(reg._mutex);
+
+            stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+            bool first = true;
+            for(const auto& buffer : reg._buffers) {
+                std::lock_guard<std::mutex> bufferGuard(buffer->_mutex);
+                if(!buffer->_name.empty()) {
+                    stream << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->_id
+                           << ",\"args\":{\"name\":";
+                    writeString(stream, buffer->_name);
+                    stream << "}}";
+                    first = false;
+                }
+                for(size_t n = 0; n < buffer->_events.size(); ++n) {
+                    const Event& event = buffer->_events[(buffer->_next + n) % buffer->_events.size()];
+                    stream << (first ? "" : ",") << "\n{\"name\":";
+                    writeString(stream, event._name);
+                    stream << ",\"cat\":";
+                    writeString(stream, event._category);
+                    stream << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->_id << ",\"ts\":";
+                    writeMicros(stream, event._start - reg._origin);
+                    stream << ",\"dur\":";
+                    writeMicros(stream, event._end - event._start);
+                    stream << "}";
+                    first = false;
+                }
+            }
+            stream << "\n]}\n";
+        }
+    }
+}
@@ -0,0 +1,138 @@
+//
+//  trace.h
+//  csvsqldb
+//
+//  BSD 3-Clause License
+//  Copyright (c) 2015, Lars-Christian Fürstenberg
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification, are permitted
+//  provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or other materials provided
+//  with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors may be used to
+//  endorse or promote products derived from this software without specific prior written
+//  permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+//  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+//  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+//  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef csvsqldb_trace_h
+#define csvsqldb_trace_h
+
+#include "libcsvsqldb/inc.h"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+
+namespace csvsqldb
+{
+    /**
+     * Timeline tracing of the query execution. Events are recorded into per thread ring buffers and can be written as
+     * Chrome trace json (chrome://tracing or Perfetto). The trace macros compile to nothing, if CSVSQLDB_TRACING is not
+     * defined.
+     */
+    namespace trace
+    {
+        class CSVSQLDB_EXPORT Tracer
+        {
+        public:
+            /**
+             * Enables or disables the recording of events. Enabling clears all previously recorded events.
+             */
+            static void enable(bool enabled);
+
+            static bool isEnabled();
+
+            /**
+             * Sets the number of events kept per thread. If a thread records more events, the oldest ones are overwritten.
+             */
+            static void setBufferCapacity(size_t capacity);
+
+            /**
+             * Names the calling thread in the trace.
+             */
+            static void setThreadName(const std::string& name);
+
+            /**
+             * Returns the start time for an event, or 0 if tracing is disabled.
+             */
+            static int64_t startEvent();
+
+            /**
+             * Records an event from start until now for the calling thread. The strings have to be literals, as only the
+             * pointers are stored.
+             */
+            static void endEvent(const char* category, const char* name, int64_t start);
+
+            static void clear();
+
+            /**
+             * Writes all recorded events in the Chrome trace event format.
+             */
+            static void writeChromeTrace(std::ostream& stream);
+        };
+
+        class CSVSQLDB_EXPORT ScopedEvent
+        {
+        public:
+            ScopedEvent(const char* category, const char* name)
+            : _category(category)
+            , _name(name)
+            , _start(Tracer::startEvent())
+            {
+            }
+
+            ~ScopedEvent()
+            {
+                if(_start) {
+                    Tracer::endEvent(_category, _name, _start);
+                }
+            }
+
+        private:
+            const char* _category;
+            const char* _name;
+            int64_t _start;
+        };
+    }
+}
+
+#define CSVSQLDB_TRACE_CONCAT_IMPL(a, b) a##b
+#define CSVSQLDB_TRACE_CONCAT(a, b) CSVSQLDB_TRACE_CONCAT_IMPL(a, b)
+
+#ifdef CSVSQLDB_TRACING
+#define CSVSQLDB_TRACE_SCOPE(category, name)                                                                                     \
+    csvsqldb::trace::ScopedEvent CSVSQLDB_TRACE_CONCAT(csvsqldb_trace_event_, __LINE__)(category, name)
+#define CSVSQLDB_TRACE_START(start) start = csvsqldb::trace::Tracer::startEvent()
+#define CSVSQLDB_TRACE_END(category, name, start)                                                                                \
+    do {                                                                                                                         \
+        if(start) {                                                                                                              \
+            csvsqldb::trace::Tracer::endEvent(category, name, start);                                                            \
+        }                                                                                                                        \
+    } while(0)
+#define CSVSQLDB_TRACE_THREAD_NAME(name) csvsqldb::trace::Tracer::setThreadName(name)
+#else
+#define CSVSQLDB_TRACE_SCOPE(category, name)
+#define CSVSQLDB_TRACE_START(start)
+#define CSVSQLDB_TRACE_END(category, name, start)
+#define CSVSQLDB_TRACE_THREAD_NAME(name)
+#endif
+
+#endif
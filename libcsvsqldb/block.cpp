@@ -33,6 +33,8 @@
 
 #include "block.h"
 
+#include "base/metrics.h"
+
 #include <algorithm>
 
 
@@ -52,6 +54,7 @@ namespace csvsqldb
 
     BlockPtr BlockManager::createBlock()
     {
+        std::lock_guard<std::mutex> guard(_mutex);
         ++_activeBlocks;
         ++_totalBlocks;
         _maxCountActiveBlocks = std::max(_activeBlocks, _maxCountActiveBlocks);
@@ -60,12 +63,14 @@ namespace csvsqldb
         }
         BlockPtr block = new Block(++sBlockNumber, _blockCapacity);
         _blocks.push_back(block);
+        metrics::Metrics::add(metrics::BLOCKS_ALLOCATED);
 
         return block;
     }
 
     BlockPtr BlockManager::getBlock(size_t blockNumber) const
     {
+        std::lock_guard<std::mutex> guard(_mutex);
         Blocks::const_iterator iter =
         std::find_if(_blocks.begin(), _blocks.end(), [&](const BlockPtr block) { return blockNumber == block->getBlockNumber(); });
         if(iter == _blocks.end()) {
@@ -77,6 +82,7 @@ namespace csvsqldb
     void BlockManager::release(BlockPtr& block)
     {
         if(block) {
+            std::lock_guard<std::mutex> guard(_mutex);
             --_activeBlocks;
             if(_blocks.size()) {
                 csvsqldb::remove(_blocks, block);
@@ -111,6 +117,12 @@ namespace csvsqldb
         return _maxCountActiveBlocks;
     }
 
+    void BlockManager::resetMaxUsedBlocks()
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        _maxCountActiveBlocks = _activeBlocks;
+    }
+
     size_t BlockManager::getBlockCapacity() const
     {
         return _blockCapacity;
@@ -320,7 +332,7 @@ namespace csvsqldb
                 }
                 break;
             case STRING: {
-                size_t len = ::strlen(value.asString());
+                size_t len = value.isNull() ? 0 : ::strlen(value.asString());
                 if(hasSizeFor(ValString::baseSize() + len + 1)) {
                     markValue();
                     if(!value.isNull()) {
@@ -429,4 +441,12 @@ namespace csvsqldb
         *(&_store[0] + _offset) = static_cast<char>(0xDD);
         ++_offset;
     }
+
+    void Block::continueBlocks()
+    {
+        if(!_offset || *(&_store[0] + _offset - 1) != static_cast<char>(0xDD)) {
+            CSVSQLDB_THROW(csvsqldb::Exception, "block has no end marker");
+        }
+        *(&_store[0] + _offset - 1) = static_cast<char>(0xCC);
+    }
 }
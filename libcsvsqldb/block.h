@@ -41,6 +41,7 @@
 #include "variant.h"
 
 #include <memory>
+#include <mutex>
 #include <vector>
 
 
@@ -74,6 +75,11 @@ namespace csvsqldb
         size_t getActiveBlocks() const;
         size_t getMaxActiveBlocks() const;
         size_t getMaxUsedBlocks() const;
+
+        /**
+         * Starts a new measurement of the maximum number of used blocks with the currently active blocks.
+         */
+        void resetMaxUsedBlocks();
         size_t getBlockCapacity() const;
         size_t getTotalBlocks() const;
 
@@ -84,6 +90,7 @@ namespace csvsqldb
         size_t _activeBlocks;
         size_t _maxCountActiveBlocks;
         size_t _totalBlocks;
+        mutable std::mutex _mutex;
 
         static size_t sBlockNumber;
     };
@@ -127,6 +134,17 @@ namespace csvsqldb
 
         void markNextBlock();
 
+        /**
+         * Turns the end marker written by endBlocks into a next block marker, so that the blocks of another producer can
+         * follow this block.
+         */
+        void continueBlocks();
+
+        void reset()
+        {
+            _offset = 0;
+        }
+
         size_t getBlockNumber() const
         {
             return _blockNumber;
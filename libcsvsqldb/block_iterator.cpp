@@ -33,6 +33,8 @@
 
 #include "block_iterator.h"
 #include "base/hash_helper.h"
+#include "base/metrics.h"
+#include "base/trace.h"
 
 #include <algorithm>
 
@@ -73,13 +75,8 @@ namespace csvsqldb
             ++_offset;
             _typeOffset = _types.begin();
         }
-        if(*(&(_block->_store)[0] + _offset) == static_cast<char>(0xDD)) {
-            // no more rows left
-            return nullptr;
-        }
-
-        // look for next block marker
-        if(*(&(_block->_store)[0] + _offset) == static_cast<char>(0xCC)) {
+        // look for next block marker, the next block might be empty and only carry a marker itself
+        while(*(&(_block->_store)[0] + _offset) == static_cast<char>(0xCC)) {
             _blockManager.release(_previousBlock);
             _previousBlock = _block;
             _block = _blockProvider.getNextBlock();
@@ -87,6 +84,11 @@ namespace csvsqldb
             _endOffset = _block->_offset;
         }
 
+        if(*(&(_block->_store)[0] + _offset) == static_cast<char>(0xDD)) {
+            // no more rows left
+            return nullptr;
+        }
+
         if(_offset == _endOffset) {
             CSVSQLDB_THROW(csvsqldb::Exception, "should have found the end marker in the first place");
         }
@@ -282,10 +284,11 @@ namespace csvsqldb
 
 
     struct SortOperation {
-        SortOperation(const Types& types, const SortingBlockIterator::SortOrders& sortOrders, const Blocks& blocks)
+        SortOperation(const Types& types, const SortingBlockIterator::SortOrders& sortOrders, const Blocks& blocks, uint64_t& comparisons)
         : _types(types)
         , _sortOrders(sortOrders)
         , _blocks(blocks)
+        , _comparisons(comparisons)
         , _offset(0)
         , _endOffset(0)
         , _currentBlock(0)
@@ -296,6 +299,7 @@ namespace csvsqldb
 
         bool operator()(const BlockPosition& left, const BlockPosition& right)
         {
+            ++_comparisons;
             _currentBlock = left._block;
             _offset = left._offset;
             _endOffset = _blocks[_currentBlock]->_offset;
@@ -406,6 +410,7 @@ namespace csvsqldb
         Types::const_iterator _typeOffset;
         const SortingBlockIterator::SortOrders& _sortOrders;
         const Blocks& _blocks;
+        uint64_t& _comparisons;  //!< shared by all copies std::sort makes
         size_t _offset;
         size_t _endOffset;
         size_t _currentBlock;
@@ -442,6 +447,7 @@ namespace csvsqldb
         }
         const Values* row = nullptr;
         if(_initialize) {
+            CSVSQLDB_TRACE_SCOPE("sort", "sort input");
             do {
                 row = _rowProvider.getNextRow();
                 if(row) {
@@ -469,7 +475,10 @@ namespace csvsqldb
             } while(row);
             _initialize = false;
             // here we have to sort the thing
-            std::sort(_rows.begin(), _rows.end(), SortOperation(_types, _sortOrders, _blocks));
+            CSVSQLDB_TRACE_SCOPE("sort", "sort rows");
+            uint64_t comparisons = 0;
+            std::sort(_rows.begin(), _rows.end(), SortOperation(_types, _sortOrders, _blocks, comparisons));
+            metrics::Metrics::add(metrics::SORT_COMPARISONS, comparisons);
             _rowIter = _rows.begin();
         }
 
@@ -595,6 +604,22 @@ namespace csvsqldb
     }
 
 
+    HashKey::HashKey()
+    : _hash(0)
+    {
+    }
+
+    void HashKey::computeHash()
+    {
+        _hash = _key.getHash();
+    }
+
+    bool HashKey::operator==(const HashKey& rhs) const
+    {
+        return _hash == rhs._hash && _key == rhs._key;
+    }
+
+
     GroupingBlockIterator::GroupingBlockIterator(const Types& types,
                                                  const csvsqldb::IndexVector groupingIndices,
                                                  const csvsqldb::IndexVector outputIndices,
@@ -618,6 +643,12 @@ namespace csvsqldb
 
     GroupingBlockIterator::~GroupingBlockIterator()
     {
+        // the aggregation functions are constructed inside the blocks, so they have to be destroyed explicitly
+        for(auto& group : _groupMap) {
+            for(auto* aggrFunc : group.second) {
+                aggrFunc->~AggregationFunction();
+            }
+        }
         for(auto& block : _blocks) {
             _blockManager.release(block);
         }
@@ -634,7 +665,9 @@ namespace csvsqldb
         }
         const Values* row = nullptr;
         if(!_useCache) {
+            CSVSQLDB_TRACE_SCOPE("group", "group input");
             size_t currentAggrFuncBlock = 0;
+            uint64_t probes = 0;
             _aggrFuncBlocks.push_back(_blockManager.createBlock());
             do {
                 row = _rowProvider.getNextRow();
@@ -646,6 +679,7 @@ namespace csvsqldb
                     }
 
                     GroupMap::iterator iter = _groupMap.find(element);
+                    ++probes;
                     if(iter == _groupMap.end()) {
                         // group currently not contained - add new group
                         AggregationFunctionPtrs groupValues;
@@ -675,8 +709,10 @@ namespace csvsqldb
                     }
                 }
             } while(row);
+            metrics::Metrics::add(metrics::HASH_PROBES, probes);
 
             // TODO LCF: build new blocks, should be optimized to build only one block at a time
+            CSVSQLDB_TRACE_SCOPE("group", "build groups");
             getNextBlock();
             _currentBlock = 0;
             for(auto& groupElement : _groupMap) {
@@ -789,7 +825,12 @@ namespace csvsqldb
     }
 
 
-    HashingBlockIterator::HashingBlockIterator(const Types& types, RowProvider& rowProvider, BlockManager& blockManager, size_t hashTableKeyPosition)
+    HashingBlockIterator::HashingBlockIterator(const Types& types,
+                                               RowProvider& rowProvider,
+                                               BlockManager& blockManager,
+                                               const IndexVector& hashTableKeyPositions,
+                                               size_t maxBlocks,
+                                               ThreadPool* threadPool)
     : _rowProvider(rowProvider)
     , _blockManager(blockManager)
     , _types(types)
@@ -797,36 +838,189 @@ namespace csvsqldb
     , _offset(0)
     , _endOffset(0)
     , _useCache(false)
-    , _hashTableKeyPosition(hashTableKeyPosition)
+    , _hashTables(threadPool ? threadPool->numberOfThreads() * _partitionsPerThread : 1)
+    , _partitionMutexes(threadPool ? _hashTables.size() : 0)
+    , _rowCount(0)
+    , _hashTableKeyPositions(hashTableKeyPositions)
     , _typeOffset(_types.begin())
+    , _maxBlocks(maxBlocks)
+    , _threadPool(threadPool)
+    , _probes(0)
     {
         _row.resize(_types.size());
-        _context._it = _hashTable.end();
-        _context._end = _hashTable.end();
+        _keyValues.resize(_types.size());
+        _context._it = _hashTables[0].end();
+        _context._end = _hashTables[0].end();
     }
 
     HashingBlockIterator::~HashingBlockIterator()
     {
+        addProbesToMetrics();
         for(auto& block : _blocks) {
             _blockManager.release(block);
         }
     }
 
-    void HashingBlockIterator::setContextForKeyValue(const Value& keyValue)
+    void HashingBlockIterator::setContextForKeyValue(const HashKey& key)
     {
-        std::pair<HashTable::const_iterator, HashTable::const_iterator> range = _hashTable.equal_range(valueToVariant(keyValue));
+        std::pair<HashTable::const_iterator, HashTable::const_iterator> range = _hashTables[getPartition(key)].equal_range(key);
+        ++_probes;
         _context._it = range.first;
         _context._end = range.second;
     }
 
+    void HashingBlockIterator::findKeyValueRows(const HashKey& key, BlockPositions& positions) const
+    {
+        std::pair<HashTable::const_iterator, HashTable::const_iterator> range = _hashTables[getPartition(key)].equal_range(key);
+        for(HashTable::const_iterator it = range.first; it != range.second; ++it) {
+            positions.push_back(it->second);
+        }
+    }
+
+    void HashingBlockIterator::getRowAt(const BlockPosition& position, Values& row) const
+    {
+        BlockPosition current = position;
+        row.resize(_types.size());
+        readRow(current, row);
+    }
+
+    bool HashingBlockIterator::readRow(BlockPosition& position, Values& row) const
+    {
+        for(size_t n = 0; n < _types.size(); ++n) {
+            const char* store = _blocks[position._block]->_store;
+            // look for next block marker
+            if(store[position._offset] == static_cast<char>(0xCC)) {
+                store = _blocks[++position._block]->_store;
+                position._offset = 0;
+            }
+            if(n == 0 && store[position._offset] == static_cast<char>(0xDD)) {
+                return false;
+            }
+            if(store[position._offset] != static_cast<char>(0xAA)) {
+                CSVSQLDB_THROW(csvsqldb::Exception, "missing value separator");
+            }
+            ++position._offset;
+            const Value* val = reinterpret_cast<const Value*>(store + position._offset);
+            position._offset += val->size();
+            row[n] = val;
+        }
+        if(_blocks[position._block]->_store[position._offset] != static_cast<char>(0xBB)) {
+            CSVSQLDB_THROW(csvsqldb::Exception, "should be at row delimiter");
+        }
+        ++position._offset;
+        return true;
+    }
+
+    size_t HashingBlockIterator::getPartition(const HashKey& key) const
+    {
+        return _hashTables.size() == 1 ? 0 : key._hash % _hashTables.size();
+    }
+
+    bool HashingBlockIterator::makeKey(const Values& row, HashKey& key) const
+    {
+        // the key has to refer to the cached values, as the values of the row provider are only valid until the next row is
+        // requested; null keys will never match, so there is no need to hash them
+        key._key._groupingValues.clear();
+        key._key._groupingValues.reserve(_hashTableKeyPositions.size());
+        for(const auto& keyPosition : _hashTableKeyPositions) {
+            if(row[keyPosition]->isNull()) {
+                return false;
+            }
+            key._key._groupingValues.push_back(valueToVariant(*row[keyPosition]));
+        }
+        key.computeHash();
+        return true;
+    }
+
+    void HashingBlockIterator::addToHashTable(const BlockPosition& position)
+    {
+        if(_threadPool) {
+            // the blocks are hashed concurrently after all rows are read, one morsel per block
+            if(_morselStarts.empty() || _morselStarts.back()._block != position._block) {
+                _morselStarts.push_back(position);
+            }
+            return;
+        }
+        HashKey key;
+        if(makeKey(_keyValues, key)) {
+            _hashTables[0].emplace(std::move(key), position);
+        }
+    }
+
+    void HashingBlockIterator::hashMorsel(size_t morsel)
+    {
+        const BlockPosition* end = morsel + 1 < _morselStarts.size() ? &_morselStarts[morsel + 1] : nullptr;
+        BlockPosition position = _morselStarts[morsel];
+        Values row(_types.size());
+        HashKey key;
+        for(;;) {
+            if(end && position._block == end->_block && position._offset == end->_offset) {
+                break;
+            }
+            const BlockPosition rowPosition = position;
+            if(!readRow(position, row)) {
+                break;
+            }
+            if(makeKey(row, key)) {
+                const size_t partition = getPartition(key);
+                std::lock_guard<std::mutex> lock(_partitionMutexes[partition]);
+                _hashTables[partition].emplace(std::move(key), rowPosition);
+            }
+        }
+    }
+
+    void HashingBlockIterator::buildPartitions()
+    {
+        // several partitions per thread keep the workers from waiting for each other on the partition locks
+        for(auto& hashTable : _hashTables) {
+            hashTable.reserve(_rowCount / _hashTables.size() + 1);
+        }
+        std::vector<ThreadPool::Callback> tasks;
+        for(size_t n = 0; n < _morselStarts.size(); ++n) {
+            tasks.push_back([this, n]() { hashMorsel(n); });
+        }
+        _threadPool->executeTasks(tasks);
+    }
+
+    size_t HashingBlockIterator::getHashTableSize() const
+    {
+        size_t size = 0;
+        for(const auto& hashTable : _hashTables) {
+            size += hashTable.size();
+        }
+        return size;
+    }
+
+    bool HashingBlockIterator::buildHashTable()
+    {
+        CSVSQLDB_TRACE_SCOPE("join", "build hash table");
+        while(getNextRow()) {
+            if(_blocks.size() > _maxBlocks) {
+                _blocks[_currentBlock]->endBlocks();
+                return false;
+            }
+        }
+        if(_threadPool) {
+            buildPartitions();
+        }
+        _useCache = true;
+        return true;
+    }
+
+    void HashingBlockIterator::rewind()
+    {
+        _useCache = true;
+        _currentBlock = 0;
+        _offset = 0;
+        _endOffset = _blocks.empty() ? 0 : _blocks[_currentBlock]->_offset;
+        _typeOffset = _types.begin();
+    }
+
     const Values* HashingBlockIterator::getNextKeyValueRow()
     {
-        if(_hashTable.empty()) {
+        if(!_useCache) {
             // fill the cache and hash table
-            while(getNextRow()) {
-                // empty
-            }
-            _useCache = true;
+            buildHashTable();
         }
         if(_context._it != _context._end) {
             _currentBlock = _context._it->second._block;
@@ -864,16 +1058,16 @@ namespace csvsqldb
 
                 size_t n = 0;
                 for(const auto& value : *row) {
-                    if(_hashTableKeyPosition == n) {
-                        _hashTable.emplace(std::make_pair(valueToVariant(*value), pos));
-                    }
-                    if(!_blocks[_currentBlock]->addValue(*value)) {
+                    const Value* storedValue = _blocks[_currentBlock]->addValue(*value);
+                    if(!storedValue) {
                         _blocks[_currentBlock]->markNextBlock();
                         getNextBlock();
-                        _blocks[_currentBlock]->addValue(*value);
+                        storedValue = _blocks[_currentBlock]->addValue(*value);
                     }
-                    ++n;
+                    _keyValues[n++] = storedValue;
                 }
+                addToHashTable(pos);
+                ++_rowCount;
                 _blocks[_currentBlock]->nextRow();
             } else {
                 _blocks[_currentBlock]->endBlocks();
@@ -956,16 +1150,28 @@ namespace csvsqldb
 
     void HashingBlockIterator::reset()
     {
+        addProbesToMetrics();
         _useCache = false;
         _currentBlock = 0;
         _offset = 0;
         _endOffset = 0;
-        _context._it = _hashTable.end();
-        _context._end = _hashTable.end();
+        _context._it = _hashTables[0].end();
+        _context._end = _hashTables[0].end();
         for(auto& block : _blocks) {
             _blockManager.release(block);
         }
-        _hashTable.clear();
+        _blocks.clear();
+        for(auto& hashTable : _hashTables) {
+            hashTable.clear();
+        }
+        _morselStarts.clear();
+        _rowCount = 0;
+    }
+
+    void HashingBlockIterator::addProbesToMetrics()
+    {
+        metrics::Metrics::add(metrics::HASH_PROBES, _probes);
+        _probes = 0;
     }
 
     void HashingBlockIterator::getNextBlock()
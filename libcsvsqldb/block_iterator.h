@@ -39,6 +39,10 @@
 #include "aggregation_functions.h"
 #include "block.h"
 
+#include "base/thread_pool.h"
+
+#include <limits>
+#include <mutex>
 #include <unordered_map>
 
 
@@ -55,6 +59,20 @@ namespace csvsqldb
 
         Variants _groupingValues;
     };
+
+    /**
+     * The key of the join hash table. The hash is computed once and reused for the choice of the partition, the hash table
+     * lookup and the comparison of keys.
+     */
+    struct CSVSQLDB_EXPORT HashKey {
+        HashKey();
+
+        void computeHash();
+        bool operator==(const HashKey& rhs) const;
+
+        GroupingElement _key;
+        size_t _hash;
+    };
 }
 
 namespace std
@@ -66,6 +84,14 @@ namespace std
             return element.getHash();
         }
     };
+
+    template <>
+    struct hash<csvsqldb::HashKey> {
+        size_t operator()(csvsqldb::HashKey const& key) const
+        {
+            return key._hash;
+        }
+    };
 }
 
 namespace csvsqldb
@@ -91,7 +117,10 @@ namespace csvsqldb
         size_t _offset;
     };
 
-    typedef std::unordered_multimap<Variant, BlockPosition> HashTable;
+    typedef std::vector<BlockPosition> BlockPositions;
+
+    typedef std::unordered_multimap<HashKey, BlockPosition> HashTable;
+    typedef std::vector<HashTable> HashTables;
 
     struct CSVSQLDB_EXPORT HashingBlockIteratorContext {
         HashTable::const_iterator _it;
@@ -205,6 +234,11 @@ namespace csvsqldb
 
         virtual const Values* getNextRow();
 
+        size_t getGroupCount() const
+        {
+            return _groupMap.size();
+        }
+
     private:
         typedef std::vector<AggregationFunction*> AggregationFunctionPtrs;
         typedef std::unordered_map<GroupingElement, AggregationFunctionPtrs> GroupMap;
@@ -233,20 +267,74 @@ namespace csvsqldb
     class CSVSQLDB_EXPORT HashingBlockIterator
     {
     public:
-        HashingBlockIterator(const Types& types, RowProvider& rowProvider, BlockManager& blockManager, size_t hashTableKeyPosition);
+        /**
+         * Constructs a hashing iterator over the rows of the row provider.
+         * @param hashTableKeyPositions Positions of the columns that form the hash key, rows with a null key column are not hashed
+         * @param maxBlocks Maximum number of blocks the cached rows may use, see buildHashTable()
+         * @param threadPool If given, the hash table is split into several partitions per thread and the cached blocks are
+         * hashed concurrently on the thread pool
+         */
+        HashingBlockIterator(const Types& types,
+                             RowProvider& rowProvider,
+                             BlockManager& blockManager,
+                             const IndexVector& hashTableKeyPositions,
+                             size_t maxBlocks = std::numeric_limits<size_t>::max(),
+                             ThreadPool* threadPool = nullptr);
 
         virtual ~HashingBlockIterator();
 
         virtual const Values* getNextRow();
 
-        void setContextForKeyValue(const Value& keyValue);
+        /**
+         * Reads all rows from the row provider into the cache and the hash table.
+         * @return false if the rows needed more than maxBlocks blocks. In this case the rows read so far can be retrieved
+         * again with rewind() and getNextRow() and the remaining rows are still available from the row provider.
+         */
+        bool buildHashTable();
+
+        /**
+         * Positions the iterator at the first cached row.
+         */
+        void rewind();
+
+        void setContextForKeyValue(const HashKey& key);
         const Values* getNextKeyValueRow();
 
+        /**
+         * Retrieves the positions of all cached rows with the given key. As it does not change the state of the iterator, it
+         * can be called concurrently once the hash table is built. The probe is not counted in the HASH_PROBES metric, the
+         * caller has to add it.
+         * @param key The key to look up, its hash has to be computed already
+         * @param positions The found row positions are appended here
+         */
+        void findKeyValueRows(const HashKey& key, BlockPositions& positions) const;
+
+        /**
+         * Returns the number of entries of the hash table.
+         */
+        size_t getHashTableSize() const;
+
+        /**
+         * Retrieves the cached row at the given position. Can be called concurrently once the hash table is built.
+         * @param position A position returned by findKeyValueRows()
+         * @param row Will be filled with the values of the row
+         */
+        void getRowAt(const BlockPosition& position, Values& row) const;
+
         void reset();
 
     private:
         Value* getNextValue();
         void getNextBlock();
+        size_t getPartition(const HashKey& key) const;
+        bool makeKey(const Values& row, HashKey& key) const;
+        void addToHashTable(const BlockPosition& position);
+        bool readRow(BlockPosition& position, Values& row) const;
+        void hashMorsel(size_t morsel);
+        void buildPartitions();
+        void addProbesToMetrics();
+
+        static const size_t _partitionsPerThread = 4;
 
         RowProvider& _rowProvider;
         BlockManager& _blockManager;
@@ -257,10 +345,17 @@ namespace csvsqldb
         size_t _offset;
         size_t _endOffset;
         bool _useCache;
-        HashTable _hashTable;
-        size_t _hashTableKeyPosition;
+        HashTables _hashTables;
+        std::vector<std::mutex> _partitionMutexes;
+        BlockPositions _morselStarts; //!< position of the first row of each cached block, a block is hashed as one morsel
+        size_t _rowCount;
+        const IndexVector _hashTableKeyPositions;
+        Values _keyValues;
         HashingBlockIteratorContext _context;
         Types::iterator _typeOffset;
+        size_t _maxBlocks;
+        ThreadPool* _threadPool;
+        uint64_t _probes; //!< probes of setContextForKeyValue() not yet added to the metrics
     };
 }
 
@@ -36,12 +36,36 @@
 
 #include "base/string_helper.h"
 
+#include <cctype>
 #include <cmath>
 
 
 namespace csvsqldb
 {
 
+    template<bool upper>
+    static Variant convertCase(const char* s)
+    {
+        const size_t len = ::strlen(s);
+        char* result = new char[len + 1];
+        const unsigned char first = upper ? 'a' : 'A';
+        unsigned char bits = 0;
+        // branch free ASCII conversion, which the compiler can vectorize
+        for(size_t n = 0; n < len; ++n) {
+            const unsigned char ch = static_cast<unsigned char>(s[n]);
+            result[n] = static_cast<char>(ch ^ (static_cast<unsigned char>(ch - first) < 26 ? 0x20 : 0));
+            bits |= ch;
+        }
+        if(bits & 0x80) {
+            for(size_t n = 0; n < len; ++n) {
+                const int ch = static_cast<unsigned char>(s[n]);
+                result[n] = static_cast<char>(upper ? ::toupper(ch) : ::tolower(ch));
+            }
+        }
+        result[len] = '\0';
+        return Variant(result, true);
+    }
+
     void initBuildInFunctions(FunctionRegistry& registry)
     {
         registry.registerFunction(std::make_shared<CurrentDateFunction>());
@@ -94,7 +118,7 @@ namespace csvsqldb
 
 
     DateFormatFunction::DateFormatFunction()
-    : Function("DATE_FORMAT", STRING, Types({DATE, STRING}))
+    : Function("DATE_FORMAT", STRING, Types({DATE, STRING}), true)
     {
     }
 
@@ -103,9 +127,16 @@ namespace csvsqldb
         return Variant(parameter[0].asDate().format(parameter[1].asString()));
     }
 
+    void DateFormatFunction::doCallBatch(size_t rows, const Columns& parameter, Variants& result) const
+    {
+        callRows(rows, parameter, result, [&](size_t row) {
+            return Variant(parameter[0][row].asDate().format(parameter[1][row].asString()));
+        });
+    }
+
 
     TimeFormatFunction::TimeFormatFunction()
-    : Function("TIME_FORMAT", STRING, Types({TIME, STRING}))
+    : Function("TIME_FORMAT", STRING, Types({TIME, STRING}), true)
     {
     }
 
@@ -114,8 +145,15 @@ namespace csvsqldb
         return Variant(parameter[0].asTime().format(parameter[1].asString()));
     }
 
+    void TimeFormatFunction::doCallBatch(size_t rows, const Columns& parameter, Variants& result) const
+    {
+        callRows(rows, parameter, result, [&](size_t row) {
+            return Variant(parameter[0][row].asTime().format(parameter[1][row].asString()));
+        });
+    }
+
     TimestampFormatFunction::TimestampFormatFunction()
-    : Function("TIMESTAMP_FORMAT", STRING, Types({TIMESTAMP, STRING}))
+    : Function("TIMESTAMP_FORMAT", STRING, Types({TIMESTAMP, STRING}), true)
     {
     }
 
@@ -124,6 +162,13 @@ namespace csvsqldb
         return Variant(parameter[0].asTimestamp().format(parameter[1].asString()));
     }
 
+    void TimestampFormatFunction::doCallBatch(size_t rows, const Columns& parameter, Variants& result) const
+    {
+        callRows(rows, parameter, result, [&](size_t row) {
+            return Variant(parameter[0][row].asTimestamp().format(parameter[1][row].asString()));
+        });
+    }
+
 
     const int64_t sSecond = 1;
     const int64_t sMinute = 2;
@@ -133,43 +178,45 @@ namespace csvsqldb
     const int64_t sYear = 6;
 
     ExtractFunction::ExtractFunction()
-    : Function("EXTRACT", INT, Types({INT, TIMESTAMP}))
+    : Function("EXTRACT", INT, Types({INT, TIMESTAMP}), true)
     {
     }
 
-    const Variant ExtractFunction::doCall(const Variants& parameter) const
+    static int64_t extract(int64_t part, const Timestamp& timestamp)
     {
-        int64_t result = 0;
-
-        switch(parameter[0].asInt()) {
+        switch(part) {
             case sSecond:
-                result = parameter[1].asTimestamp().second();
-                break;
+                return timestamp.second();
             case sMinute:
-                result = parameter[1].asTimestamp().minute();
-                break;
+                return timestamp.minute();
             case sHour:
-                result = parameter[1].asTimestamp().hour();
-                break;
+                return timestamp.hour();
             case sDay:
-                result = parameter[1].asTimestamp().day();
-                break;
+                return timestamp.day();
             case sMonth:
-                result = parameter[1].asTimestamp().month();
-                break;
+                return timestamp.month();
             case sYear:
-                result = parameter[1].asTimestamp().year();
-                break;
+                return timestamp.year();
             default:
                 CSVSQLDB_THROW(csvsqldb::Exception, "unknown extract part");
         }
+    }
 
-        return Variant(result);
+    const Variant ExtractFunction::doCall(const Variants& parameter) const
+    {
+        return Variant(extract(parameter[0].asInt(), parameter[1].asTimestamp()));
+    }
+
+    void ExtractFunction::doCallBatch(size_t rows, const Columns& parameter, Variants& result) const
+    {
+        callRows(rows, parameter, result, [&](size_t row) {
+            return Variant(extract(parameter[0][row].asInt(), parameter[1][row].asTimestamp()));
+        });
     }
 
 
     PowerFunction::PowerFunction()
-    : Function("POW", REAL, Types({REAL, REAL}))
+    : Function("POW", REAL, Types({REAL, REAL}), true)
     {
     }
 
@@ -183,33 +230,52 @@ namespace csvsqldb
         return Variant(result);
     }
 
+    void PowerFunction::doCallBatch(size_t rows, const Columns& parameter, Variants& result) const
+    {
+        callRows(rows, parameter, result, [&](size_t row) {
+            return Variant(std::pow(parameter[0][row].asDouble(), parameter[1][row].asDouble()));
+        });
+    }
+
 
     UpperFunction::UpperFunction()
-    : Function("UPPER", STRING, Types({STRING}))
+    : Function("UPPER", STRING, Types({STRING}), true)
     {
     }
 
     const Variant UpperFunction::doCall(const Variants& parameter) const
     {
-        const Variant s = parameter[0];
-        return Variant(csvsqldb::toupper_copy(s.asString()));
+        return convertCase<true>(parameter[0].asString());
+    }
+
+    void UpperFunction::doCallBatch(size_t rows, const Columns& parameter, Variants& result) const
+    {
+        callRows(rows, parameter, result, [&](size_t row) {
+            return convertCase<true>(parameter[0][row].asString());
+        });
     }
 
 
     LowerFunction::LowerFunction()
-    : Function("LOWER", STRING, Types({STRING}))
+    : Function("LOWER", STRING, Types({STRING}), true)
     {
     }
 
     const Variant LowerFunction::doCall(const Variants& parameter) const
     {
-        const Variant s = parameter[0];
-        return Variant(csvsqldb::tolower_copy(s.asString()));
+        return convertCase<false>(parameter[0].asString());
+    }
+
+    void LowerFunction::doCallBatch(size_t rows, const Columns& parameter, Variants& result) const
+    {
+        callRows(rows, parameter, result, [&](size_t row) {
+            return convertCase<false>(parameter[0][row].asString());
+        });
     }
 
 
     CharLengthFunction::CharLengthFunction(const std::string& name)
-    : Function(name, INT, Types({STRING}))
+    : Function(name, INT, Types({STRING}), true)
     {
     }
 
@@ -219,9 +285,16 @@ namespace csvsqldb
         return Variant(::strlen(s.asString()));
     }
 
+    void CharLengthFunction::doCallBatch(size_t rows, const Columns& parameter, Variants& result) const
+    {
+        callRows(rows, parameter, result, [&](size_t row) {
+            return Variant(::strlen(parameter[0][row].asString()));
+        });
+    }
+
 
     VersionFunction::VersionFunction()
-    : Function("VERSION", STRING, Types())
+    : Function("VERSION", STRING, Types(), true)
     {
     }
 
@@ -82,6 +82,7 @@ namespace csvsqldb
 
     private:
         virtual const Variant doCall(const Variants& parameter) const;
+        virtual void doCallBatch(size_t rows, const Columns& parameter, Variants& result) const;
     };
 
 
@@ -92,6 +93,7 @@ namespace csvsqldb
 
     private:
         virtual const Variant doCall(const Variants& parameter) const;
+        virtual void doCallBatch(size_t rows, const Columns& parameter, Variants& result) const;
     };
 
 
@@ -102,6 +104,7 @@ namespace csvsqldb
 
     private:
         virtual const Variant doCall(const Variants& parameter) const;
+        virtual void doCallBatch(size_t rows, const Columns& parameter, Variants& result) const;
     };
 
 
@@ -112,6 +115,7 @@ namespace csvsqldb
 
     private:
         virtual const Variant doCall(const Variants& parameter) const;
+        virtual void doCallBatch(size_t rows, const Columns& parameter, Variants& result) const;
     };
 
 
@@ -122,6 +126,7 @@ namespace csvsqldb
 
     private:
         virtual const Variant doCall(const Variants& parameter) const;
+        virtual void doCallBatch(size_t rows, const Columns& parameter, Variants& result) const;
     };
 
 
@@ -132,6 +137,7 @@ namespace csvsqldb
 
     private:
         virtual const Variant doCall(const Variants& parameter) const;
+        virtual void doCallBatch(size_t rows, const Columns& parameter, Variants& result) const;
     };
 
 
@@ -142,6 +148,7 @@ namespace csvsqldb
 
     private:
         virtual const Variant doCall(const Variants& parameter) const;
+        virtual void doCallBatch(size_t rows, const Columns& parameter, Variants& result) const;
     };
 
     class CSVSQLDB_EXPORT CharLengthFunction : public Function
@@ -151,6 +158,7 @@ namespace csvsqldb
 
     private:
         virtual const Variant doCall(const Variants& parameter) const;
+        virtual void doCallBatch(size_t rows, const Columns& parameter, Variants& result) const;
     };
 
     class CSVSQLDB_EXPORT VersionFunction : public Function
@@ -78,6 +78,21 @@ namespace csvsqldb
         TableData tabledata("SYSTEM_DUAL");
         tabledata.addColumn("x", BOOLEAN, false, false, false, csvsqldb::Any(), ASTExprNodePtr(), 0);
         addTable(tabledata);
+
+        TableData statistics("SYSTEM_STATISTICS");
+        statistics.addColumn("NAME", STRING, true, false, true, csvsqldb::Any(), ASTExprNodePtr(), 0);
+        statistics.addColumn("VALUE", INT, false, false, true, csvsqldb::Any(), ASTExprNodePtr(), 0);
+        addTable(statistics);
+
+        TableData queries("SYSTEM_QUERIES");
+        queries.addColumn("QUERY_ID", INT, true, false, true, csvsqldb::Any(), ASTExprNodePtr(), 0);
+        queries.addColumn("STATEMENT", STRING, false, false, true, csvsqldb::Any(), ASTExprNodePtr(), 0);
+        queries.addColumn("START_TIME", TIMESTAMP, false, false, true, csvsqldb::Any(), ASTExprNodePtr(), 0);
+        queries.addColumn("DURATION_US", INT, false, false, true, csvsqldb::Any(), ASTExprNodePtr(), 0);
+        queries.addColumn("ROW_COUNT", INT, false, false, true, csvsqldb::Any(), ASTExprNodePtr(), 0);
+        queries.addColumn("SUCCESS", BOOLEAN, false, false, true, csvsqldb::Any(), ASTExprNodePtr(), 0);
+        queries.addColumn("ERROR", STRING, false, false, false, csvsqldb::Any(), ASTExprNodePtr(), 0);
+        addTable(queries);
     }
 
     void Database::readTablesFromPath()
@@ -33,6 +33,9 @@
 
 #include "execution_engine.h"
 
+#include <iomanip>
+#include <sstream>
+
 
 namespace csvsqldb
 {
@@ -40,6 +43,70 @@ namespace csvsqldb
     ExecutionContext::ExecutionContext(Database& database)
     : _database(database)
     , _showHeaderLine(true)
+    , _hashJoinBlockLimit(OperatorContext::_defaultHashJoinBlockLimit)
+    , _numberOfThreads(_defaultNumberOfThreads)
+    , _minRowsForJoinReordering(_defaultMinRowsForJoinReordering)
+    , _maxParallelScans(OperatorContext::_defaultMaxParallelScans)
+    {
+    }
+
+
+    namespace
+    {
+        double toMilliseconds(int64_t nanoseconds)
+        {
+            return static_cast<double>(nanoseconds) / 1000000.0;
+        }
+    }
+
+    ExecutionStatistics::ExecutionStatistics()
+    : _startParsing()
+    , _endParsing()
+    , _startPreprocessing()
+    , _endPreprocessing()
+    , _startExecution()
+    , _endExecution()
+    , _maxUsedBlocks(0)
+    , _totalBlocks(0)
+    , _maxUsedCapacity(0)
+    , _wallTime(0)
+    , _cpuTime(0)
+    , _mainCpuTime(0)
+    , _readerCpuTime(0)
+    , _workerCpuTime(0)
+    , _ioWaitTime(0)
+    , _inputBytes(0)
+    , _inputRows(0)
+    , _outputRows(0)
+    , _processPeakResidentBytes(0)
+    {
+    }
+
+    double ExecutionStatistics::bytesPerSecond() const
+    {
+        return _wallTime > 0 ? static_cast<double>(_inputBytes) * 1000000000.0 / static_cast<double>(_wallTime) : 0.0;
+    }
+
+    double ExecutionStatistics::rowsPerSecond() const
+    {
+        return _wallTime > 0 ? static_cast<double>(_inputRows) * 1000000000.0 / static_cast<double>(_wallTime) : 0.0;
+    }
+
+    std::string ExecutionStatistics::asJson() const
     {
+        std::ostringstream json;
+        json << std::fixed << std::setprecision(3);
+        json << "{\"parsing_ms\":" << (_endParsing._real - _startParsing._real)
+             << ",\"preprocessing_ms\":" << (_endPreprocessing._real - _startPreprocessing._real)
+             << ",\"execution_ms\":" << (_endExecution._real - _startExecution._real)
+             << ",\"wall_ms\":" << toMilliseconds(_wallTime) << ",\"cpu_ms\":" << toMilliseconds(_cpuTime)
+             << ",\"thread_cpu_ms\":{\"main\":" << toMilliseconds(_mainCpuTime)
+             << ",\"readers\":" << toMilliseconds(_readerCpuTime) << ",\"workers\":" << toMilliseconds(_workerCpuTime)
+             << "},\"io_wait_ms\":" << toMilliseconds(_ioWaitTime) << ",\"input_bytes\":" << _inputBytes
+             << ",\"input_rows\":" << _inputRows << ",\"output_rows\":" << _outputRows
+             << ",\"mb_per_s\":" << bytesPerSecond() / (1024.0 * 1024.0) << ",\"rows_per_s\":" << rowsPerSecond()
+             << ",\"process_peak_rss_bytes\":" << _processPeakResidentBytes << ",\"max_used_blocks\":" << _maxUsedBlocks
+             << ",\"max_used_mib\":" << _maxUsedCapacity << ",\"total_blocks\":" << _totalBlocks << "}";
+        return json.str();
     }
 }
@@ -44,7 +44,13 @@
 #include "sql_parser.h"
 #include "validation_visitor.h"
 
+#include "base/metrics.h"
+#include "base/thread_pool.h"
 #include "base/time_measurement.h"
+#include "base/trace.h"
+
+#include <exception>
+#include <memory>
 
 
 namespace csvsqldb
@@ -56,9 +62,39 @@ namespace csvsqldb
         Database& _database;
         csvsqldb::StringVector _files;
         bool _showHeaderLine;
+        size_t _hashJoinBlockLimit;
+        uint16_t _numberOfThreads;          //!< number of threads of the parallel operators, 1 to run single threaded
+        uint64_t _minRowsForJoinReordering; //!< joins are only reordered if an input is estimated to have this many rows
+        ReadAheadOptions _readAhead;
+        uint16_t _maxParallelScans;
+
+        static const uint16_t _defaultNumberOfThreads = 1;
+        static const uint64_t _defaultMinRowsForJoinReordering = 10000;
     };
 
+    /**
+     * Statistics of the last executed statement. Besides the process times of the phases, the wall clock time, the CPU
+     * time and the input are measured. The CPU times of the reader and worker threads and the input figures are taken
+     * from the process wide metrics, so they include the work of statements executed concurrently by other engines.
+     */
     struct CSVSQLDB_EXPORT ExecutionStatistics {
+        ExecutionStatistics();
+
+        /**
+         * Returns the input bytes per second of wall clock time.
+         */
+        double bytesPerSecond() const;
+
+        /**
+         * Returns the input rows per second of wall clock time.
+         */
+        double rowsPerSecond() const;
+
+        /**
+         * Returns all statistics as a json object on one line.
+         */
+        std::string asJson() const;
+
         csvsqldb::chrono::ProcessTimePoint _startParsing;
         csvsqldb::chrono::ProcessTimePoint _endParsing;
         csvsqldb::chrono::ProcessTimePoint _startPreprocessing;
@@ -69,6 +105,17 @@ namespace csvsqldb
         size_t _maxUsedBlocks;
         size_t _totalBlocks;
         size_t _maxUsedCapacity;
+
+        int64_t _wallTime;           //!< in nanoseconds
+        int64_t _cpuTime;            //!< CPU time of all threads of the process in nanoseconds
+        int64_t _mainCpuTime;        //!< CPU time of the thread calling the engine in nanoseconds
+        int64_t _readerCpuTime;      //!< CPU time of the block reader threads in nanoseconds
+        int64_t _workerCpuTime;      //!< CPU time of the thread pool workers in nanoseconds
+        int64_t _ioWaitTime;         //!< time the readers waited for input in nanoseconds
+        uint64_t _inputBytes;
+        uint64_t _inputRows;
+        int64_t _outputRows;
+        uint64_t _processPeakResidentBytes; //!< peak resident memory of the process so far, not of the statement alone
     };
 
     template <typename OperatorNodeFactory>
@@ -89,13 +136,83 @@ namespace csvsqldb
             return execute(statistics, stream);
         }
 
+        /**
+         * Executes the next statement of the input. Each executed statement is counted in the metrics and added to the
+         * query log.
+         * @return The number of affected rows or -1 if there are no more statements.
+         */
         int64_t execute(ExecutionStatistics& statistics, std::ostream& stream)
+        {
+            metrics::QueryInfo info;
+            info._start = csvsqldb::Timestamp::now();
+            const int64_t start = csvsqldb::chrono::MonotonicClock::now();
+            const int64_t cpuStart = csvsqldb::chrono::ProcessCpuClock::now();
+            const int64_t mainCpuStart = csvsqldb::chrono::ThreadCpuClock::now();
+            const uint64_t readerCpuStart = metrics::Metrics::value(metrics::READER_CPU_TIME);
+            const uint64_t workerCpuStart = metrics::Metrics::value(metrics::WORKER_CPU_TIME);
+            const uint64_t ioWaitStart = metrics::Metrics::value(metrics::IO_WAIT_TIME);
+            const uint64_t bytesStart = metrics::Metrics::value(metrics::BYTES_READ);
+            const uint64_t rowsStart = metrics::Metrics::value(metrics::LINES_PARSED);
+            std::exception_ptr error;
+            try {
+                info._rows = executeStatement(statistics, stream);
+            } catch(const std::exception& ex) {
+                error = std::current_exception();
+                info._success = false;
+                info._error = ex.what();
+            }
+            if(info._success && info._rows < 0) {
+                return info._rows;
+            }
+
+            statistics._wallTime = csvsqldb::chrono::MonotonicClock::now() - start;
+            statistics._cpuTime = csvsqldb::chrono::ProcessCpuClock::now() - cpuStart;
+            statistics._mainCpuTime = csvsqldb::chrono::ThreadCpuClock::now() - mainCpuStart;
+            statistics._readerCpuTime = static_cast<int64_t>(metrics::Metrics::value(metrics::READER_CPU_TIME) - readerCpuStart);
+            statistics._workerCpuTime = static_cast<int64_t>(metrics::Metrics::value(metrics::WORKER_CPU_TIME) - workerCpuStart);
+            statistics._ioWaitTime = static_cast<int64_t>(metrics::Metrics::value(metrics::IO_WAIT_TIME) - ioWaitStart);
+            statistics._inputBytes = metrics::Metrics::value(metrics::BYTES_READ) - bytesStart;
+            statistics._inputRows = metrics::Metrics::value(metrics::LINES_PARSED) - rowsStart;
+            statistics._outputRows = info._rows;
+            statistics._processPeakResidentBytes = metrics::peakResidentBytes();
+
+            info._duration = static_cast<uint64_t>(statistics._wallTime) / 1000;
+            info._statement = _parser.statement();
+            metrics::Metrics::add(metrics::QUERIES);
+            if(error) {
+                metrics::Metrics::add(metrics::FAILED_QUERIES);
+            }
+            metrics::Metrics::record(metrics::QUERY_LATENCY, info._duration);
+            const int64_t rowCount = info._rows;
+            metrics::QueryLog::add(std::move(info));
+
+            if(error) {
+                std::rethrow_exception(error);
+            }
+            return rowCount;
+        }
+
+    private:
+        int64_t executeStatement(ExecutionStatistics& statistics, std::ostream& stream)
         {
             OperatorContext context(_execContext._database, _functions, _blockManager, _execContext._files);
             context._showHeaderLine = _execContext._showHeaderLine;
+            context._hashJoinBlockLimit = _execContext._hashJoinBlockLimit;
+            if(_execContext._numberOfThreads > 1 && !_threadPool) {
+                _threadPool.reset(new ThreadPool(_execContext._numberOfThreads));
+                _threadPool->start();
+            }
+            context._threadPool = _threadPool.get();
+            context._minRowsForJoinReordering = _execContext._minRowsForJoinReordering;
+            context._readAhead = _execContext._readAhead;
+            context._maxParallelScans = _execContext._maxParallelScans;
 
             statistics._startParsing = csvsqldb::chrono::ProcessTimeClock::now();
-            ASTNodePtr astnode = _parser.parse();
+            ASTNodePtr astnode;
+            {
+                CSVSQLDB_TRACE_SCOPE("query", "parse");
+                astnode = _parser.parse();
+            }
             statistics._endParsing = csvsqldb::chrono::ProcessTimeClock::now();
 
             if(!astnode) {
@@ -104,16 +221,23 @@ namespace csvsqldb
             }
 
             statistics._startPreprocessing = csvsqldb::chrono::ProcessTimeClock::now();
-            ASTValidationVisitor validationVisitor(context._database);
-            astnode->accept(validationVisitor);
-
             ExecutionPlan execPlan;
-            ExecutionPlanVisitor<OperatorNodeFactory> execVisitor(context, execPlan, stream);
-            astnode->accept(execVisitor);
+            {
+                CSVSQLDB_TRACE_SCOPE("query", "plan");
+                ASTValidationVisitor validationVisitor(context._database);
+                astnode->accept(validationVisitor);
+
+                ExecutionPlanVisitor<OperatorNodeFactory> execVisitor(context, execPlan, stream);
+                astnode->accept(execVisitor);
+            }
             statistics._endPreprocessing = csvsqldb::chrono::ProcessTimeClock::now();
 
             statistics._startExecution = csvsqldb::chrono::ProcessTimeClock::now();
-            int64_t rowCount = execPlan.execute();
+            int64_t rowCount = 0;
+            {
+                CSVSQLDB_TRACE_SCOPE("query", "execute");
+                rowCount = execPlan.execute();
+            }
             statistics._endExecution = csvsqldb::chrono::ProcessTimeClock::now();
 
             statistics._maxUsedBlocks = _blockManager.getMaxUsedBlocks();
@@ -123,11 +247,11 @@ namespace csvsqldb
             return rowCount;
         }
 
-    private:
         ExecutionContext _execContext;
         FunctionRegistry _functions;
         SQLParser _parser;
         BlockManager _blockManager;
+        std::unique_ptr<ThreadPool> _threadPool;
     };
 }
 
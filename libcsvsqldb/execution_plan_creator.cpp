@@ -32,8 +32,6 @@
 //
 
 #include "execution_plan_creator.h"
-#include "operatornode_factory.h"
-#include "validation_visitor.h"
 
 
 namespace csvsqldb
@@ -63,40 +61,4 @@ namespace csvsqldb
     {
         _queryOperationRoot->dump(stream);
     }
-
-
-    ExplainExecutionNode::ExplainExecutionNode(OperatorContext& context, eDescriptionType descType, const ASTQueryNodePtr& query)
-    : _context(context)
-    , _descType(descType)
-    , _query(query)
-    {
-    }
-
-    int64_t ExplainExecutionNode::execute()
-    {
-        switch(_descType) {
-            case AST: {
-                ASTNodeDumpVisitor visitor;
-                _query->accept(visitor);
-                std::cout << std::endl;
-                break;
-            }
-            case EXEC: {
-                std::stringstream ss;
-                ExecutionPlan execPlan;
-                ASTValidationVisitor validationVisitor(_context._database);
-                _query->accept(validationVisitor);
-                ExecutionPlanVisitor<OperatorNodeFactory> execVisitor(_context, execPlan, ss);
-                _query->accept(execVisitor);
-                execPlan.dump(std::cout);
-                break;
-            }
-        }
-
-        return 0;
-    }
-
-    void ExplainExecutionNode::dump(std::ostream& stream) const
-    {
-    }
 }
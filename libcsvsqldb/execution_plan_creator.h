@@ -40,6 +40,13 @@
 #include "sql_astdump.h"
 #include "table_executions.h"
 #include "operatornode.h"
+#include "validation_visitor.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <map>
+#include <sstream>
 
 
 namespace csvsqldb
@@ -63,19 +70,82 @@ namespace csvsqldb
         RootOperatorNodePtr _queryOperationRoot;
     };
 
-    class CSVSQLDB_EXPORT ExplainExecutionNode : public ExecutionNode
+    template <typename OperatorFactory>
+    class ExecutionPlanVisitor;
+
+    /**
+     * Executes an EXPLAIN statement. The plan is built with the same operator factory as the queries, so that it shows the
+     * operators that would be executed.
+     */
+    template <typename OperatorFactory>
+    class ExplainExecutionNode : public ExecutionNode
     {
     public:
-        ExplainExecutionNode(OperatorContext& context, eDescriptionType descType, const ASTQueryNodePtr& query);
+        ExplainExecutionNode(OperatorContext& context, eDescriptionType descType, const ASTQueryNodePtr& query, std::ostream& stream)
+        : _context(context)
+        , _descType(descType)
+        , _query(query)
+        , _stream(stream)
+        {
+        }
 
-        virtual int64_t execute();
+        virtual int64_t execute()
+        {
+            switch(_descType) {
+                case AST: {
+                    ASTNodeDumpVisitor visitor;
+                    _query->accept(visitor);
+                    std::cout << std::endl;
+                    break;
+                }
+                case EXEC: {
+                    std::stringstream ss;
+                    ExecutionPlan execPlan;
+                    ASTValidationVisitor validationVisitor(_context._database);
+                    _query->accept(validationVisitor);
+                    ExecutionPlanVisitor<OperatorFactory> execVisitor(_context, execPlan, ss);
+                    _query->accept(execVisitor);
+                    execPlan.dump(_stream);
+                    break;
+                }
+                case ANALYZE: {
+                    // the query is executed, but its rows are discarded
+                    std::ostream discard(nullptr);
+                    const size_t totalBlocks = _context._blockManager.getTotalBlocks();
+                    ExecutionPlan execPlan;
+                    ASTValidationVisitor validationVisitor(_context._database);
+                    _query->accept(validationVisitor);
+                    ExecutionPlanVisitor<OperatorFactory> execVisitor(_context, execPlan, discard, true);
+                    _query->accept(execVisitor);
+
+                    // the peak has to be the one of this query, not of all queries using the block manager so far
+                    _context._blockManager.resetMaxUsedBlocks();
+                    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                    const int64_t rows = execPlan.execute();
+                    const std::chrono::duration<double, std::milli> wallTime = std::chrono::steady_clock::now() - start;
+
+                    std::stringstream summary;
+                    summary << rows << " rows in " << std::fixed << std::setprecision(3) << wallTime.count() << "ms, "
+                            << (_context._blockManager.getTotalBlocks() - totalBlocks) << " blocks allocated, "
+                            << _context._blockManager.getMaxUsedBlocks() << " blocks at peak";
+                    execPlan.dump(_stream);
+                    _stream << "\n" << summary.str() << std::endl;
+                    break;
+                }
+            }
 
-        virtual void dump(std::ostream& stream) const;
+            return 0;
+        }
+
+        virtual void dump(std::ostream& stream) const
+        {
+        }
 
     private:
         OperatorContext& _context;
         eDescriptionType _descType;
         ASTQueryNodePtr _query;
+        std::ostream& _stream;
     };
 
 
@@ -83,10 +153,15 @@ namespace csvsqldb
     class ExecutionPlanVisitor : public ASTNodeVisitor
     {
     public:
-        ExecutionPlanVisitor(OperatorContext& context, ExecutionPlan& executionPlan, std::ostream& outputStream)
+        /**
+         * Constructs the visitor.
+         * @param analyze If true, the operators are measured for EXPLAIN ANALYZE, see AnalyzingOperatorNode
+         */
+        ExecutionPlanVisitor(OperatorContext& context, ExecutionPlan& executionPlan, std::ostream& outputStream, bool analyze = false)
         : _context(context)
         , _executionPlan(executionPlan)
         , _outputStream(outputStream)
+        , _analyze(analyze)
         {
         }
 
@@ -125,7 +200,7 @@ namespace csvsqldb
 
         virtual void visit(ASTExplainNode& node)
         {
-            ExecutionNode::UniquePtr execNode(new ExplainExecutionNode(_context, node._descType, node._query));
+            ExecutionNode::UniquePtr execNode(new ExplainExecutionNode<OperatorFactory>(_context, node._descType, node._query, _outputStream));
             _executionPlan.addExecutionNode(execNode);
         }
 
@@ -135,7 +210,7 @@ namespace csvsqldb
             node._query->accept(*this);
 
             RootOperatorNodePtr output = OperatorFactory::createOutputRowOperatorNode(_context, node._query->symbolTable(), _outputStream);
-            output->connect(_currentRowOperator);
+            connectInput(*output, _currentRowOperator);
 
             execNode->setRootOperatorNode(output);
 
@@ -147,16 +222,19 @@ namespace csvsqldb
         {
             RowOperatorNodePtr unionop = OperatorFactory::createUnionOperatorNode(_context, node._rhs->symbolTable());
             node._rhs->accept(*this);
-            unionop->connect(_currentRowOperator);
+            connectInput(*unionop, _currentRowOperator);
 
             node._lhs->accept(*this);
-            unionop->connect(_currentRowOperator);
+            connectInput(*unionop, _currentRowOperator);
             _currentRowOperator = unionop;
         }
 
         virtual void visit(ASTQuerySpecificationNode& node)
         {
+            _scanPushdowns.push_back(collectScanPushdown(node));
             node._tableExpression->accept(*this);
+            ScanOperatorNodePtr limitableScan = _scanPushdowns.back()._limitableScan;
+            _scanPushdowns.pop_back();
 
             RowOperatorNodePtr projection;
 
@@ -177,15 +255,31 @@ namespace csvsqldb
                 projection = OperatorFactory::createExtendedProjectionOperatorNode(_context, node._nodes[0]->symbolTable(), node._nodes);
             }
 
-            projection->connect(_currentRowOperator);
+            connectInput(*projection, _currentRowOperator);
             _currentRowOperator = projection;
 
+            if(node._quantifier == DISTINCT) {
+                RowOperatorNodePtr distinct = OperatorFactory::createDistinctOperatorNode(_context, node._nodes[0]->symbolTable());
+                connectInput(*distinct, _currentRowOperator);
+                _currentRowOperator = distinct;
+            }
+
             if(node._tableExpression->_order) {
                 node._tableExpression->_order->accept(*this);
             }
 
             if(node._tableExpression->_limit) {
                 node._tableExpression->_limit->accept(*this);
+                std::shared_ptr<LimitOperatorNode> limit = std::dynamic_pointer_cast<LimitOperatorNode>(_currentRowOperator);
+                if(limitableScan && limit) {
+                    limitableScan->setRowLimit(limit->requiredInputRows());
+                }
+                // the projection outputs a row for each input row, so it can stop reading, if the limit follows it directly
+                std::shared_ptr<ExtendedProjectionOperatorNode> extendedProjection =
+                std::dynamic_pointer_cast<ExtendedProjectionOperatorNode>(projection);
+                if(extendedProjection && limit && node._quantifier == ALL && !node._tableExpression->_order) {
+                    extendedProjection->setRowLimit(limit->requiredInputRows());
+                }
             }
         }
 
@@ -251,6 +345,20 @@ namespace csvsqldb
                 scan = std::make_shared<SystemTableScanOperatorNode>(_context, node.symbolTable(), *node._factor->_info);
             } else {
                 scan = OperatorFactory::createScanOperatorNode(_context, node.symbolTable(), *node._factor->_info);
+                ScanOperatorNodePtr tableScan = std::dynamic_pointer_cast<ScanOperatorNode>(scan);
+                if(tableScan && !_scanPushdowns.empty()) {
+                    ScanPushdown& pushdown = _scanPushdowns.back();
+                    if(!pushdown._allColumns) {
+                        tableScan->setReferencedColumns(pushdown._identifiers);
+                    }
+                    bool conditionPushed = true;
+                    if(pushdown._condition) {
+                        conditionPushed = tableScan->pushDownPredicates(pushdown._condition);
+                    }
+                    if(pushdown._limitable && conditionPushed) {
+                        pushdown._limitableScan = tableScan;
+                    }
+                }
             }
             _currentRowOperator = scan;
         }
@@ -266,10 +374,10 @@ namespace csvsqldb
         {
             RowOperatorNodePtr join = OperatorFactory::createCrossJoinOperatorNode(_context, node._factor->symbolTable());
             node._tableReference->accept(*this);
-            join->connect(_currentRowOperator);
+            connectInput(*join, _currentRowOperator);
 
             node._factor->accept(*this);
-            join->connect(_currentRowOperator);
+            connectInput(*join, _currentRowOperator);
             _currentRowOperator = join;
         }
 
@@ -279,23 +387,14 @@ namespace csvsqldb
 
         virtual void visit(ASTInnerJoinNode& node)
         {
-            RowOperatorNodePtr join;
-
-            ASTBinaryNodePtr binaryExpression = std::dynamic_pointer_cast<ASTBinaryNode>(node._expression);
-            if(binaryExpression && binaryExpression->_op == OP_EQ && std::dynamic_pointer_cast<ASTIdentifier>(binaryExpression->_lhs)
-               && std::dynamic_pointer_cast<ASTIdentifier>(binaryExpression->_rhs)) {
-                // only equi joins can be performed as hash joins
-                join = OperatorFactory::createInnerHashJoinOperatorNode(_context, node._factor->symbolTable(), node._expression);
-            } else {
-                join = OperatorFactory::createInnerJoinOperatorNode(_context, node._factor->symbolTable(), node._expression);
+            if(createJoinChain(node)) {
+                return;
             }
 
             node._tableReference->accept(*this);
-            join->connect(_currentRowOperator);
-
+            RowOperatorNodePtr lhs = _currentRowOperator;
             node._factor->accept(*this);
-            join->connect(_currentRowOperator);
-            _currentRowOperator = join;
+            _currentRowOperator = createInnerJoin(node, lhs, _currentRowOperator);
         }
 
         virtual void visit(ASTLeftJoinNode& node)
@@ -313,7 +412,7 @@ namespace csvsqldb
         virtual void visit(ASTWhereNode& node)
         {
             RowOperatorNodePtr select = OperatorFactory::createSelectOperatorNode(_context, node.symbolTable(), node._exp);
-            select->connect(_currentRowOperator);
+            connectInput(*select, _currentRowOperator);
             _currentRowOperator = select;
         }
 
@@ -328,22 +427,372 @@ namespace csvsqldb
         virtual void visit(ASTOrderByNode& node)
         {
             RowOperatorNodePtr sort = OperatorFactory::createSortOperatorNode(_context, node.symbolTable(), node._orderExpressions);
-            sort->connect(_currentRowOperator);
+            connectInput(*sort, _currentRowOperator);
             _currentRowOperator = sort;
         }
 
         virtual void visit(ASTLimitNode& node)
         {
             RowOperatorNodePtr limit = OperatorFactory::createLimitOperatorNode(_context, node.symbolTable(), node._limit, node._offset);
-            limit->connect(_currentRowOperator);
+            connectInput(*limit, _currentRowOperator);
             _currentRowOperator = limit;
         }
 
     private:
+        struct ScanPushdown {
+            bool _allColumns;
+            StringSet _identifiers;
+            ASTExprNodePtr _condition;
+            bool _limitable;
+            ScanOperatorNodePtr _limitableScan;
+        };
+
+        struct JoinRelation {
+            RowOperatorNodePtr _operator;
+            SymbolInfos _symbols;
+            uint64_t _estimatedRows;
+        };
+
+        struct JoinCondition {
+            const ASTInnerJoinNode* _join;
+            IndexVector _relations; //!< the relations the columns of the condition belong to
+        };
+
+        static bool collectJoinColumns(const ASTTableReferenceNodePtr& reference, ASTReferencedVariableVisitor& visitor)
+        {
+            if(std::dynamic_pointer_cast<ASTNaturalJoinNode>(reference)) {
+                // the join columns of natural joins are implicit
+                return false;
+            }
+            ASTJoinWithConditionPtr joinWithCondition = std::dynamic_pointer_cast<ASTJoinWithCondition>(reference);
+            if(joinWithCondition) {
+                joinWithCondition->_expression->accept(visitor);
+                return collectJoinColumns(joinWithCondition->_tableReference, visitor)
+                       && collectJoinColumns(joinWithCondition->_factor, visitor);
+            }
+            ASTCrossJoinNodePtr crossJoin = std::dynamic_pointer_cast<ASTCrossJoinNode>(reference);
+            if(crossJoin) {
+                return collectJoinColumns(crossJoin->_tableReference, visitor) && collectJoinColumns(crossJoin->_factor, visitor);
+            }
+            return true;
+        }
+
+        static ScanPushdown collectScanPushdown(ASTQuerySpecificationNode& node)
+        {
+            ScanPushdown pushdown;
+            pushdown._allColumns = true;
+            // the limit can be applied to the scan, if every scanned row that passes the scan predicates is output
+            const ASTTableExpressionNodePtr& tableExpression = node._tableExpression;
+            pushdown._limitable = tableExpression->_limit && !tableExpression->_group && !tableExpression->_having
+                                  && !tableExpression->_order && node._quantifier == ALL
+                                  && tableExpression->_from->_tableReferences.size() == 1
+                                  && std::dynamic_pointer_cast<ASTTableIdentifierNode>(tableExpression->_from->_tableReferences[0])
+                                  && std::none_of(node._nodes.begin(), node._nodes.end(), [](const ASTExprNodePtr& exp) {
+                                         return std::dynamic_pointer_cast<ASTAggregateFunctionNode>(exp) != nullptr;
+                                     });
+            if(node._tableExpression->_where) {
+                // only inner and cross joins are supported, so the conditions can be applied to the scans directly
+                pushdown._condition = node._tableExpression->_where->_exp;
+            }
+
+            IdentifierSet identifiers;
+            ASTReferencedVariableVisitor visitor(identifiers);
+            for(const auto& exp : node._nodes) {
+                if(std::dynamic_pointer_cast<ASTQualifiedAsterisk>(exp)) {
+                    return pushdown;
+                }
+                exp->accept(visitor);
+            }
+            for(const auto& reference : node._tableExpression->_from->_tableReferences) {
+                if(!collectJoinColumns(reference, visitor)) {
+                    return pushdown;
+                }
+            }
+            if(node._tableExpression->_where) {
+                node._tableExpression->_where->_exp->accept(visitor);
+            }
+            if(node._tableExpression->_group) {
+                for(const auto& identifier : node._tableExpression->_group->_identifiers) {
+                    identifier->accept(visitor);
+                }
+            }
+            if(node._tableExpression->_having) {
+                node._tableExpression->_having->_exp->accept(visitor);
+            }
+            if(node._tableExpression->_order) {
+                for(const auto& orderExpression : node._tableExpression->_order->_orderExpressions) {
+                    orderExpression.first->accept(visitor);
+                }
+            }
+
+            for(const auto& identifier : identifiers) {
+                if(!identifier._info) {
+                    return pushdown;
+                }
+                pushdown._identifiers.insert(identifier._info->_qualifiedIdentifier);
+                if(identifier._prefix.empty()) {
+                    pushdown._identifiers.insert(identifier._identifier);
+                }
+            }
+            pushdown._allColumns = false;
+
+            return pushdown;
+        }
+
+        /**
+         * Finds the relations the columns of the join condition belong to.
+         * @return The sorted indices of the relations or an empty vector, if a column is not found or is ambiguous
+         */
+        static IndexVector findRelations(const std::vector<JoinRelation>& relations, const ASTExprNodePtr& expression)
+        {
+            IdentifierSet variables;
+            ASTExpressionVariableVisitor visitor(variables);
+            expression->accept(visitor);
+
+            IndexVector found;
+            for(const auto& variable : variables) {
+                size_t relation = relations.size();
+                for(size_t n = 0; n < relations.size(); ++n) {
+                    for(const auto& info : relations[n]._symbols) {
+                        if(info->_name == variable._info->_name) {
+                            if(relation != relations.size() && relation != n) {
+                                // ambiguous column
+                                return IndexVector();
+                            }
+                            relation = n;
+                        }
+                    }
+                }
+                if(relation == relations.size()) {
+                    return IndexVector();
+                }
+                found.push_back(relation);
+            }
+            std::sort(found.begin(), found.end());
+            found.erase(std::unique(found.begin(), found.end()), found.end());
+            return found;
+        }
+
+        /**
+         * Finds the conditions, that can be applied when the candidate is joined to the already joined relations. The
+         * first of them has to have hash keys between the joined relations and the candidate, it becomes the condition of
+         * the hash join. The others are applied as filter.
+         * @return The indices of the conditions or an empty vector, if the candidate cannot be hash joined
+         */
+        static IndexVector findStepConditions(const std::vector<JoinRelation>& relations,
+                                              const std::vector<JoinCondition>& conditions,
+                                              const std::vector<bool>& joined,
+                                              const std::vector<bool>& applied,
+                                              const SymbolInfos& joinedSymbols,
+                                              size_t candidate)
+        {
+            IndexVector stepConditions;
+            bool hashable = false;
+            for(size_t n = 0; n < conditions.size(); ++n) {
+                const IndexVector& conditionRelations = conditions[n]._relations;
+                if(applied[n] || std::any_of(conditionRelations.begin(), conditionRelations.end(), [&](size_t relation) {
+                       return relation != candidate && !joined[relation];
+                   })) {
+                    continue;
+                }
+                if(!hashable
+                   && InnerHashJoinOperatorNode::hasHashKeys(conditions[n]._join->_expression, joinedSymbols, relations[candidate]._symbols)) {
+                    hashable = true;
+                    stepConditions.insert(stepConditions.begin(), n);
+                } else {
+                    stepConditions.push_back(n);
+                }
+            }
+            return hashable ? stepConditions : IndexVector();
+        }
+
+        /**
+         * Orders the relations greedily: the smallest relation is joined first and then always the smallest relation, that
+         * can be hash joined to the already joined relations.
+         * @return false if the relations cannot be joined by hash joins only in any such order
+         */
+        static bool findJoinOrder(const std::vector<JoinRelation>& relations,
+                                  const std::vector<JoinCondition>& conditions,
+                                  IndexVector& order,
+                                  std::vector<IndexVector>& orderConditions)
+        {
+            std::vector<bool> joined(relations.size(), false);
+            std::vector<bool> applied(conditions.size(), false);
+            SymbolInfos joinedSymbols;
+
+            size_t next = 0;
+            for(size_t n = 1; n < relations.size(); ++n) {
+                if(relations[n]._estimatedRows < relations[next]._estimatedRows) {
+                    next = n;
+                }
+            }
+            IndexVector nextConditions;
+            while(next != relations.size()) {
+                joined[next] = true;
+                joinedSymbols.insert(joinedSymbols.end(), relations[next]._symbols.begin(), relations[next]._symbols.end());
+                for(size_t condition : nextConditions) {
+                    applied[condition] = true;
+                }
+                order.push_back(next);
+                orderConditions.push_back(nextConditions);
+
+                next = relations.size();
+                for(size_t candidate = 0; candidate < relations.size(); ++candidate) {
+                    if(joined[candidate]
+                       || (next != relations.size() && relations[candidate]._estimatedRows >= relations[next]._estimatedRows)) {
+                        continue;
+                    }
+                    IndexVector candidateConditions = findStepConditions(relations, conditions, joined, applied, joinedSymbols, candidate);
+                    if(!candidateConditions.empty()) {
+                        next = candidate;
+                        nextConditions = candidateConditions;
+                    }
+                }
+            }
+            return order.size() == relations.size();
+        }
+
+        /**
+         * Creates the operator of an inner join. Joins with an equality between both inputs are performed as hash joins,
+         * range joins by sorting and merging both inputs and all other joins by comparing all pairs of rows.
+         */
+        RowOperatorNodePtr createInnerJoin(const ASTInnerJoinNode& node, const RowOperatorNodePtr& lhs, const RowOperatorNodePtr& rhs)
+        {
+            SymbolInfos lhsSymbols;
+            SymbolInfos rhsSymbols;
+            lhs->getColumnInfos(lhsSymbols);
+            rhs->getColumnInfos(rhsSymbols);
+
+            RowOperatorNodePtr join;
+            if(InnerHashJoinOperatorNode::hasHashKeys(node._expression, lhsSymbols, rhsSymbols)) {
+                join = OperatorFactory::createInnerHashJoinOperatorNode(_context, node._factor->symbolTable(), node._expression);
+            } else if(SortMergeJoinOperatorNode::hasMergeKeys(node._expression, lhsSymbols, rhsSymbols)) {
+                join = OperatorFactory::createSortMergeJoinOperatorNode(_context, node._factor->symbolTable(), node._expression);
+            } else {
+                join = OperatorFactory::createInnerJoinOperatorNode(_context, node._factor->symbolTable(), node._expression);
+            }
+
+            connectInput(*join, lhs);
+            connectInput(*join, rhs);
+            return join;
+        }
+
+        /**
+         * Creates the operators for a chain of at least two inner joins like 'a JOIN b ON a.x = b.x JOIN c ON b.y = c.y'.
+         * If the inputs are large enough and can be joined by hash joins, the joins are reordered greedily, see
+         * findJoinOrder(). Which conditions can be hash joined is decided by InnerHashJoinOperatorNode::hasHashKeys, so
+         * composite and computed keys are reordered as well. The column order of the result stays the written one.
+         * @return false if the join is no such chain
+         */
+        bool createJoinChain(ASTInnerJoinNode& node)
+        {
+            std::vector<const ASTInnerJoinNode*> joins;
+            for(const ASTInnerJoinNode* join = &node; join; join = dynamic_cast<const ASTInnerJoinNode*>(join->_tableReference.get())) {
+                joins.insert(joins.begin(), join);
+            }
+            if(joins.size() < 2) {
+                return false;
+            }
+
+            std::vector<JoinRelation> relations(joins.size() + 1);
+            joins.front()->_tableReference->accept(*this);
+            relations[0]._operator = _currentRowOperator;
+            for(size_t n = 0; n < joins.size(); ++n) {
+                joins[n]->_factor->accept(*this);
+                relations[n + 1]._operator = _currentRowOperator;
+            }
+
+            SymbolInfos writtenOrder;
+            uint64_t maxEstimatedRows = 0;
+            bool reorder = true;
+            for(auto& relation : relations) {
+                relation._operator->getColumnInfos(relation._symbols);
+                relation._estimatedRows = relation._operator->estimateRowCount();
+                writtenOrder.insert(writtenOrder.end(), relation._symbols.begin(), relation._symbols.end());
+                if(relation._estimatedRows == RowOperatorNode::_unknownRowCount) {
+                    reorder = false;
+                } else {
+                    maxEstimatedRows = std::max(maxEstimatedRows, relation._estimatedRows);
+                }
+            }
+            reorder = reorder && maxEstimatedRows >= _context._minRowsForJoinReordering;
+
+            std::vector<JoinCondition> conditions;
+            for(const auto& join : joins) {
+                JoinCondition condition{ join, findRelations(relations, join->_expression) };
+                if(condition._relations.size() < 2) {
+                    // conditions on a single input or on unknown columns are not moved
+                    reorder = false;
+                }
+                conditions.push_back(condition);
+            }
+
+            IndexVector order;
+            std::vector<IndexVector> orderConditions;
+            if(!reorder || !findJoinOrder(relations, conditions, order, orderConditions)) {
+                // the written order joins relation n + 1 with condition n
+                _currentRowOperator = relations[0]._operator;
+                for(size_t n = 0; n < joins.size(); ++n) {
+                    _currentRowOperator = createInnerJoin(*joins[n], _currentRowOperator, relations[n + 1]._operator);
+                }
+                return true;
+            }
+
+            _currentRowOperator = relations[order[0]]._operator;
+            for(size_t n = 1; n < order.size(); ++n) {
+                const IndexVector& stepConditions = orderConditions[n];
+                const ASTInnerJoinNode* join = conditions[stepConditions[0]]._join;
+                RowOperatorNodePtr joinOperator =
+                OperatorFactory::createInnerHashJoinOperatorNode(_context, join->_factor->symbolTable(), join->_expression);
+                connectInput(*joinOperator, _currentRowOperator);
+                connectInput(*joinOperator, relations[order[n]]._operator);
+
+                if(n == order.size() - 1) {
+                    SymbolInfos joinedOrder;
+                    joinOperator->getColumnInfos(joinedOrder);
+                    if(joinedOrder != writtenOrder) {
+                        std::shared_ptr<InnerHashJoinOperatorNode> hashJoin = std::dynamic_pointer_cast<InnerHashJoinOperatorNode>(joinOperator);
+                        if(!hashJoin) {
+                            CSVSQLDB_THROW(csvsqldb::Exception, "cannot restore the column order of reordered joins");
+                        }
+                        hashJoin->setOutputOrder(writtenOrder);
+                    }
+                }
+                _currentRowOperator = joinOperator;
+
+                // further conditions between already joined inputs are applied as filter
+                for(size_t m = 1; m < stepConditions.size(); ++m) {
+                    const ASTInnerJoinNode* filterJoin = conditions[stepConditions[m]]._join;
+                    RowOperatorNodePtr select =
+                    OperatorFactory::createSelectOperatorNode(_context, filterJoin->symbolTable(), filterJoin->_expression);
+                    connectInput(*select, _currentRowOperator);
+                    _currentRowOperator = select;
+                }
+            }
+
+            return true;
+        }
+
+        void connectInput(OperatorBaseNode& node, const RowOperatorNodePtr& input)
+        {
+            if(!_analyze) {
+                node.connect(input);
+                return;
+            }
+            AnalyzingOperatorNodePtr analyzingInput = std::make_shared<AnalyzingOperatorNode>(_context, input, _analyzedInputs[input.get()]);
+            _analyzedInputs.erase(input.get());
+            _analyzedInputs[&node].push_back(analyzingInput);
+            node.connect(analyzingInput);
+        }
+
         OperatorContext& _context;
         ExecutionPlan& _executionPlan;
         RowOperatorNodePtr _currentRowOperator;
         std::ostream& _outputStream;
+        std::vector<ScanPushdown> _scanPushdowns;
+        bool _analyze;
+        /// the measuring nodes of the inputs connected to each operator
+        std::map<const OperatorBaseNode*, AnalyzingOperatorNodes> _analyzedInputs;
     };
 }
 
@@ -37,6 +37,33 @@
 namespace csvsqldb
 {
 
+    const Variant Function::callRow(size_t row, const Columns& parameter) const
+    {
+        Variants values;
+        values.reserve(parameter.size());
+        for(const auto& column : parameter) {
+            values.push_back(column[row]);
+        }
+        return doCall(values);
+    }
+
+    bool Function::isNullRow(size_t row, const Columns& parameter)
+    {
+        for(const auto& column : parameter) {
+            if(column[row].isNull()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void Function::doCallBatch(size_t rows, const Columns& parameter, Variants& result) const
+    {
+        for(size_t row = 0; row < rows; ++row) {
+            result.push_back(callRow(row, parameter));
+        }
+    }
+
     void FunctionRegistry::registerFunction(const Function::Ptr& function)
     {
         _functions.emplace(function->getName(), function);
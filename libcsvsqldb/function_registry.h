@@ -50,11 +50,21 @@ namespace csvsqldb
     {
     public:
         typedef std::shared_ptr<Function> Ptr;
-
-        Function(std::string name, eType retType, const Types parameterTypes)
+        typedef std::vector<Variants> Columns;
+
+        /**
+         * Constructs a function.
+         * @param name The name of the function
+         * @param retType The type of the return value
+         * @param parameterTypes The types of the parameters
+         * @param deterministic true, if the function always returns the same value for the same parameters. Calls of
+         * deterministic functions with constant parameters are evaluated only once when the query is planned.
+         */
+        Function(std::string name, eType retType, const Types parameterTypes, bool deterministic = false)
         : _name(name)
         , _retType(retType)
         , _parameterTypes(parameterTypes)
+        , _deterministic(deterministic)
         {
         }
 
@@ -63,6 +73,19 @@ namespace csvsqldb
             return doCall(parameter);
         }
 
+        /**
+         * Calls the function for a batch of rows.
+         * @param rows The number of rows
+         * @param parameter One column for each parameter with the values of all rows
+         * @param result Receives the results of all rows. Former content is discarded.
+         */
+        void callBatch(size_t rows, const Columns& parameter, Variants& result) const
+        {
+            result.clear();
+            result.reserve(rows);
+            doCallBatch(rows, parameter, result);
+        }
+
         const std::string& getName() const
         {
             return _name;
@@ -75,13 +98,45 @@ namespace csvsqldb
         {
             return _parameterTypes;
         }
+        bool isDeterministic() const
+        {
+            return _deterministic;
+        }
+
+    protected:
+        const Variant callRow(size_t row, const Columns& parameter) const;
+
+        static bool isNullRow(size_t row, const Columns& parameter);
+
+        /**
+         * Appends the results of a batch of rows. Rows with a null parameter are evaluated by doCall, all other rows by the
+         * operation.
+         * @param operation Called with the index of a row, returns the result of the row
+         */
+        template <typename Operation>
+        void callRows(size_t rows, const Columns& parameter, Variants& result, Operation operation) const
+        {
+            for(size_t row = 0; row < rows; ++row) {
+                if(isNullRow(row, parameter)) {
+                    result.push_back(callRow(row, parameter));
+                } else {
+                    result.push_back(operation(row));
+                }
+            }
+        }
 
     private:
         virtual const Variant doCall(const Variants& parameter) const = 0;
 
+        /**
+         * Appends the results of a batch of rows. The default implementation calls doCall for each row.
+         */
+        virtual void doCallBatch(size_t rows, const Columns& parameter, Variants& result) const;
+
         std::string _name;
         eType _retType;
         const Types _parameterTypes;
+        bool _deterministic;
     };
 
 
@@ -32,16 +32,63 @@
 //
 
 #include "operatornode.h"
+#include "sql_astdump.h"
 #include "sql_astexpressionvisitor.h"
 
+#include "base/metrics.h"
+#include "base/string_helper.h"
+#include "base/time_measurement.h"
+#include "base/trace.h"
+
 #include <boost/regex.hpp>
 
+#include <cctype>
+#include <chrono>
 #include <fstream>
+#include <iomanip>
+#include <set>
+#include <sstream>
 
 
 namespace csvsqldb
 {
 
+    OperatorBaseNode::StackMachineType OperatorBaseNode::compileExpression(const ASTExprNodePtr& exp, const SymbolInfos& symbols)
+    {
+        StackMachine sm;
+        IdentifierSet expressionVariables;
+
+        StackMachine::VariableMapping mapping;
+        {
+            ASTInstructionStackVisitor visitor(sm, mapping);
+            exp->accept(visitor);
+        }
+
+        {
+            ASTExpressionVariableVisitor visitor(expressionVariables);
+            exp->accept(visitor);
+        }
+
+        VariableMapping variableMapping;
+        for(const auto& variable : expressionVariables) {
+            bool found = false;
+            for(size_t n = 0; !found && n < symbols.size(); ++n) {
+                const SymbolInfoPtr& info = symbols[n];
+
+                if(variable._info->_name == info->_name) {
+                    variableMapping.push_back(std::make_pair(getMapping(variable.getQualifiedIdentifier(), mapping), n));
+                    found = true;
+                }
+            }
+            if(!found) {
+                CSVSQLDB_THROW(csvsqldb::Exception, "variable '" << variable.getQualifiedIdentifier() << "' not found in context");
+            }
+        }
+
+        return StackMachineType(sm, variableMapping);
+    }
+
+
     OutputRowOperatorNode::OutputRowOperatorNode(const OperatorContext& context, const SymbolTablePtr& symbolTable, std::ostream& stream)
     : RootOperatorNode(context, symbolTable)
     , _stream(stream)
@@ -51,6 +98,7 @@ namespace csvsqldb
 
     int64_t OutputRowOperatorNode::process()
     {
+        CSVSQLDB_TRACE_SCOPE("output", "process");
         if(_firstCall && _context._showHeaderLine) {
             _outputBuffer << "#";
 
@@ -92,6 +140,7 @@ namespace csvsqldb
             ++count;
             _outputBuffer << "\n";
             if(count % 1000 == 0) {
+                CSVSQLDB_TRACE_SCOPE("output", "write");
                 _stream << _outputBuffer.str();
                 _outputBuffer.str(std::string());
             }
@@ -196,6 +245,90 @@ namespace csvsqldb
     }
 
 
+    DistinctOperatorNode::DistinctOperatorNode(const OperatorContext& context, const SymbolTablePtr& symbolTable)
+    : RowOperatorNode(context, symbolTable)
+    {
+    }
+
+    bool DistinctOperatorNode::RowEqual::operator()(const GroupingElement& lhs, const GroupingElement& rhs) const
+    {
+        for(size_t n = 0; n < lhs._groupingValues.size(); ++n) {
+            const Variant& lhsValue = lhs._groupingValues[n];
+            const Variant& rhsValue = rhs._groupingValues[n];
+            if(lhsValue.isNull() || rhsValue.isNull()) {
+                if(lhsValue.isNull() != rhsValue.isNull()) {
+                    return false;
+                }
+            } else if(!(lhsValue == rhsValue)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const Values* DistinctOperatorNode::getNextRow()
+    {
+        const Values* row = _input->getNextRow();
+        while(row) {
+            GroupingElement element;
+            element._groupingValues.reserve(row->size());
+            for(const auto* value : *row) {
+                element._groupingValues.push_back(valueToVariant(*value));
+            }
+            if(_rows.find(element) == _rows.end()) {
+                element.disconnect();
+                _rows.insert(element);
+                return row;
+            }
+            row = _input->getNextRow();
+        }
+        return nullptr;
+    }
+
+    bool DistinctOperatorNode::connect(const RowOperatorNodePtr& input)
+    {
+        _input = input;
+        return true;
+    }
+
+    void DistinctOperatorNode::getColumnInfos(SymbolInfos& outputSymbols)
+    {
+        remapOutputSymbols(outputSymbols);
+        _input->getColumnInfos(outputSymbols);
+    }
+
+    void DistinctOperatorNode::dump(std::ostream& stream) const
+    {
+        stream << "DistinctOperator\n-->";
+        _input->dump(stream);
+    }
+
+    uint64_t DistinctOperatorNode::estimateRowCount()
+    {
+        return _input->estimateRowCount();
+    }
+
+    OperatorCounters DistinctOperatorNode::getCounters() const
+    {
+        OperatorCounters counters;
+        counters._hashTableEntries = _rows.size();
+        return counters;
+    }
+
+    uint64_t LimitOperatorNode::estimateRowCount()
+    {
+        const uint64_t inputRows = _input->estimateRowCount();
+        // the limit is stored including the first row
+        const uint64_t limit = static_cast<uint64_t>(_limit - 1);
+        return inputRows == _unknownRowCount ? limit : std::min(inputRows, limit);
+    }
+
+    uint64_t LimitOperatorNode::requiredInputRows() const
+    {
+        return static_cast<uint64_t>(_limit - 1 + _offset);
+    }
+
+
     SortOperatorNode::SortOperatorNode(const OperatorContext& context, const SymbolTablePtr& symbolTable, OrderExpressions orderExpressions)
     : RowOperatorNode(context, symbolTable)
     , _orderExpressions(orderExpressions)
@@ -269,6 +402,11 @@ namespace csvsqldb
         _input->dump(stream);
     }
 
+    uint64_t SortOperatorNode::estimateRowCount()
+    {
+        return _input->estimateRowCount();
+    }
+
 
     GroupingOperatorNode::GroupingOperatorNode(const OperatorContext& context,
                                                const SymbolTablePtr& symbolTable,
@@ -313,6 +451,15 @@ namespace csvsqldb
         }
     }
 
+    OperatorCounters GroupingOperatorNode::getCounters() const
+    {
+        OperatorCounters counters;
+        if(_iterator) {
+            counters._hashTableEntries = _iterator->getGroupCount();
+        }
+        return counters;
+    }
+
     bool GroupingOperatorNode::connect(const RowOperatorNodePtr& input)
     {
         _input = input;
@@ -364,7 +511,7 @@ namespace csvsqldb
                     }
                 }
 
-                _aggregateFunctions.push_back(AggregationFunction::create(aggr->_aggregateFunction, type));
+                _aggregateFunctions.push_back(AggregationFunction::create(aggr->_aggregateFunction, type, aggr->_quantifier));
                 if(aggr->_aggregateFunction == COUNT || aggr->_aggregateFunction == COUNT_STAR) {
                     type = INT;
                 }
@@ -427,6 +574,11 @@ namespace csvsqldb
         _input->dump(stream);
     }
 
+    uint64_t GroupingOperatorNode::estimateRowCount()
+    {
+        return _input->estimateRowCount();
+    }
+
 
     AggregationOperatorNode::AggregationOperatorNode(const OperatorContext& context, const SymbolTablePtr& symbolTable, const Expressions& nodes)
     : RowOperatorNode(context, symbolTable)
@@ -505,7 +657,7 @@ namespace csvsqldb
                     _sms.push_back(StackMachineType(sm, varMapping));
                 }
 
-                _aggregateFunctions.push_back(AggregationFunction::create(aggr->_aggregateFunction, type));
+                _aggregateFunctions.push_back(AggregationFunction::create(aggr->_aggregateFunction, type, aggr->_quantifier));
                 if(aggr->_aggregateFunction == COUNT || aggr->_aggregateFunction == COUNT_STAR) {
                     type = INT;
                 }
@@ -574,6 +726,11 @@ namespace csvsqldb
         _input->dump(stream);
     }
 
+    uint64_t AggregationOperatorNode::estimateRowCount()
+    {
+        return 1;
+    }
+
 
     ExtendedProjectionOperatorNode::ExtendedProjectionOperatorNode(const OperatorContext& context,
                                                                    const SymbolTablePtr& symbolTable,
@@ -581,11 +738,18 @@ namespace csvsqldb
     : RowOperatorNode(context, symbolTable)
     , _nodes(nodes)
     , _block(nullptr)
+    , _batchRowCount(0)
+    , _batchRow(0)
+    , _rowLimit(std::numeric_limits<uint64_t>::max())
+    , _inputRows(0)
+    , _endOfInput(false)
     {
+        _batchBlocks._next = 0;
     }
 
     ExtendedProjectionOperatorNode::~ExtendedProjectionOperatorNode()
     {
+        releaseBatchBlocks();
     }
 
     const Values* ExtendedProjectionOperatorNode::getNextRow()
@@ -613,6 +777,8 @@ namespace csvsqldb
                         _outputSymbols.push_back(ident->_info);
                         _types.push_back(ident->_info->_type);
                         _outputInputMapping.insert(std::make_pair(index, n));
+                        _columnBatchCalls.push_back(std::numeric_limits<size_t>::max());
+                        _batchTypes.push_back(ident->_info->_type);
                         found = true;
                     }
                 }
@@ -647,11 +813,15 @@ namespace csvsqldb
                         }
                         _outputSymbols.push_back(*result);
                         _types.push_back(info->_type);
+                        _columnBatchCalls.push_back(std::numeric_limits<size_t>::max());
+                        _batchTypes.push_back(info->_type);
                     }
                 } else {
                     for(const auto& info : _inputSymbols) {
                         _outputSymbols.push_back(info);
                         _types.push_back(info->_type);
+                        _columnBatchCalls.push_back(std::numeric_limits<size_t>::max());
+                        _batchTypes.push_back(info->_type);
                     }
                 }
             } else {
@@ -659,43 +829,79 @@ namespace csvsqldb
                 _outputSymbols.push_back(outputInfo);
                 _types.push_back(outputInfo->_type);
 
-                StackMachine sm;
-                IdentifierSet expressionVariables;
-
-                StackMachine::VariableMapping mapping;
-                {
-                    ASTInstructionStackVisitor visitor(sm, mapping);
-                    exp->accept(visitor);
+                if(compileBatchCall(exp)) {
+                    _outputBatchCallMapping.insert(std::make_pair(index, _batchCalls.size() - 1));
+                    _columnBatchCalls.push_back(_batchCalls.size() - 1);
+                } else {
+                    _sms.push_back(compileExpression(exp, _inputSymbols));
+                    _columnBatchCalls.push_back(std::numeric_limits<size_t>::max());
+                    _batchTypes.push_back(outputInfo->_type);
                 }
+            }
+            ++index;
+        }
 
-                {
-                    ASTExpressionVariableVisitor visitor(expressionVariables);
-                    exp->accept(visitor);
-                }
+        _block = _context._blockManager.createBlock();
+        _iterator = std::make_shared<BlockIterator>(_types, *this, getBlockManager());
 
-                VariableMapping varMapping;
-                for(const auto& variable : expressionVariables) {
-                    bool found = false;
-                    for(size_t n = 0; !found && n < _inputSymbols.size(); ++n) {
-                        const SymbolInfoPtr& info = _inputSymbols[n];
+        return true;
+    }
 
-                        if(variable._info->_name == info->_name) {
-                            varMapping.push_back(std::make_pair(getMapping(variable.getQualifiedIdentifier(), mapping), n));
-                            found = true;
-                        }
+    bool ExtendedProjectionOperatorNode::compileBatchCall(const ASTExprNodePtr& exp)
+    {
+        ASTFunctionNodePtr call = std::dynamic_pointer_cast<ASTFunctionNode>(exp);
+        if(!call || call->_parameters.size() != call->_function->getParameterTypes().size()) {
+            return false;
+        }
+
+        BatchCall batchCall;
+        batchCall._function = call->_function;
+        bool hasColumn = false;
+        for(size_t n = 0; n < call->_parameters.size(); ++n) {
+            const eType type = call->_function->getParameterTypes()[n];
+            BatchParameter parameter;
+            parameter._input = std::numeric_limits<size_t>::max();
+            parameter._cast = NONE;
+
+            ASTIdentifierPtr ident = std::dynamic_pointer_cast<ASTIdentifier>(call->_parameters[n]._exp);
+            ASTValueNodePtr value = std::dynamic_pointer_cast<ASTValueNode>(call->_parameters[n]._exp);
+            if(ident && ident->_info) {
+                for(size_t column = 0; column < _inputSymbols.size(); ++column) {
+                    if(ident->_info->_name == _inputSymbols[column]->_name) {
+                        parameter._input = column;
+                        parameter._cast = _inputSymbols[column]->_type != type ? type : NONE;
+                        break;
                     }
-                    if(!found) {
-                        CSVSQLDB_THROW(csvsqldb::Exception, "variable '" << variable.getQualifiedIdentifier() << "' not found");
+                }
+                if(parameter._input == std::numeric_limits<size_t>::max()) {
+                    return false;
+                }
+                hasColumn = true;
+            } else if(value && value->_value._type != NONE) {
+                parameter._constant = typedValueToVariant(value->_value);
+                if(parameter._constant.getType() != type) {
+                    try {
+                        parameter._constant = unaryOperation(OP_CAST, type, parameter._constant);
+                    } catch(const std::exception&) {
+                        // the stack machine reports the error when the call is evaluated
+                        return false;
                     }
                 }
-                _sms.push_back(StackMachineType(sm, varMapping));
+            } else {
+                return false;
             }
-            ++index;
+            batchCall._parameters.push_back(parameter);
+        }
+        // calls of constants only are folded by the stack machine
+        if(!hasColumn) {
+            return false;
         }
 
-        _block = _context._blockManager.createBlock();
-        _iterator = std::make_shared<BlockIterator>(_types, *this, getBlockManager());
-
+        batchCall._columns.resize(batchCall._parameters.size());
+        for(auto& column : batchCall._columns) {
+            column.reserve(_batchSize);
+        }
+        _batchCalls.push_back(batchCall);
         return true;
     }
 
@@ -711,87 +917,183 @@ namespace csvsqldb
         return previousBlock ? previousBlock : _block;
     }
 
+    const Values* ExtendedProjectionOperatorNode::getNextInputRow()
+    {
+        // the input must not be asked again, once it returned its last row
+        if(_endOfInput || _inputRows == _rowLimit) {
+            return nullptr;
+        }
+        const Values* row = _input->getNextRow();
+        if(row) {
+            ++_inputRows;
+        } else {
+            _endOfInput = true;
+        }
+        return row;
+    }
+
     BlockPtr ExtendedProjectionOperatorNode::prepareNextBuffer()
     {
+        if(!_batchCalls.empty()) {
+            return prepareNextBatchBuffer();
+        }
+
         const Values* row = nullptr;
         BlockPtr previousBlock = nullptr;
 
-        while(!previousBlock && (row = _input->getNextRow())) {
-            size_t smIndex = 0;
-            size_t index = 0;
-            for(const auto& exp : _nodes) {
-                if(std::dynamic_pointer_cast<ASTIdentifier>(exp)) {
-                    OutputInputMapping::const_iterator iter = _outputInputMapping.find(index);
-                    if(iter == _outputInputMapping.end()) {
-                        CSVSQLDB_THROW(csvsqldb::Exception,
-                                       "selection expression no. " << index << " not found in output input mappings");
-                    }
-                    const Values& rrow = *row;
-                    if(!_block->addValue(*(rrow[iter->second]))) {
-                        _block->markNextBlock();
-                        previousBlock = _block;
-                        _block = _context._blockManager.createBlock();
-                        _block->addValue(*(rrow[iter->second]));
-                    }
-                } else if(std::dynamic_pointer_cast<ASTQualifiedAsterisk>(exp)) {
-                    std::string prefixName = std::dynamic_pointer_cast<ASTQualifiedAsterisk>(exp)->_prefix;
+        while(!previousBlock && (row = getNextInputRow())) {
+            previousBlock = addRow(*row, _block);
+        }
+        if(!row) {
+            _block->endBlocks();
+        }
+
+        return previousBlock;
+    }
+
+    BlockPtr ExtendedProjectionOperatorNode::addRow(const Values& row, BlockPtr& block)
+    {
+        BlockPtr previousBlock = nullptr;
+        size_t smIndex = 0;
+        size_t index = 0;
+        for(const auto& exp : _nodes) {
+            OutputInputMapping::const_iterator batchCall = _outputBatchCallMapping.find(index);
+            if(batchCall != _outputBatchCallMapping.end()) {
+                addBatchParameters(_batchCalls[batchCall->second], row);
+            } else if(std::dynamic_pointer_cast<ASTIdentifier>(exp)) {
+                OutputInputMapping::const_iterator iter = _outputInputMapping.find(index);
+                if(iter == _outputInputMapping.end()) {
+                    CSVSQLDB_THROW(csvsqldb::Exception, "selection expression no. " << index << " not found in output input mappings");
+                }
+                addValue(block, *(row[iter->second]), previousBlock);
+            } else if(std::dynamic_pointer_cast<ASTQualifiedAsterisk>(exp)) {
+                std::string prefixName = std::dynamic_pointer_cast<ASTQualifiedAsterisk>(exp)->_prefix;
+
+                SymbolInfoPtr table;
+                if(!prefixName.empty() && getSymbolTable().hasTableSymbol(prefixName)) {
+                    table = getSymbolTable().findTableSymbol(prefixName);
+                }
 
-                    SymbolInfoPtr table;
-                    if(!prefixName.empty() && getSymbolTable().hasTableSymbol(prefixName)) {
-                        table = getSymbolTable().findTableSymbol(prefixName);
+                if(table) {
+                    if(!_context._database.hasTable(table->_identifier)) {
+                        CSVSQLDB_THROW(csvsqldb::Exception, "cannot find table '" << table->_identifier << "'");
                     }
+                    // TODO LCF: this is not quite ok, as we could have a different sorting, so better so go through the
+                    // _inputSymbols and find the right
+                    // table symbols
+                    const TableData& tableData = _context._database.getTable(table->_identifier);
 
-                    if(table) {
-                        if(!_context._database.hasTable(table->_identifier)) {
-                            CSVSQLDB_THROW(csvsqldb::Exception, "cannot find table '" << table->_identifier << "'");
-                        }
-                        // TODO LCF: this is not quite ok, as we could have a different sorting, so better so go through the
-                        // _inputSymbols and find the right
-                        // table symbols
-                        const TableData& tableData = _context._database.getTable(table->_identifier);
-
-                        const Values& rrow = *row;
-                        for(size_t n = 0; n < tableData.columnCount(); ++n) {
-                            if(!_block->addValue(*(rrow[n]))) {
-                                _block->markNextBlock();
-                                previousBlock = _block;
-                                _block = _context._blockManager.createBlock();
-                                _block->addValue(*(rrow[n]));
-                            }
-                        }
-                    } else {
-                        const Values& rrow = *row;
-                        for(size_t n = 0; n < _inputSymbols.size(); ++n) {
-                            if(!_block->addValue(*(rrow[n]))) {
-                                _block->markNextBlock();
-                                previousBlock = _block;
-                                _block = _context._blockManager.createBlock();
-                                _block->addValue(*(rrow[n]));
-                            }
-                        }
+                    for(size_t n = 0; n < tableData.columnCount(); ++n) {
+                        addValue(block, *(row[n]), previousBlock);
                     }
                 } else {
-                    fillVariableStore(_sms[smIndex]._store, _sms[smIndex]._variableMappings, *row);
-
-                    if(!_block->addValue(_sms[smIndex]._sm.evaluate(_sms[smIndex]._store, _context._functions))) {
-                        _block->markNextBlock();
-                        previousBlock = _block;
-                        _block = _context._blockManager.createBlock();
-                        _block->addValue(_sms[smIndex]._sm.evaluate(_sms[smIndex]._store, _context._functions));
+                    for(size_t n = 0; n < _inputSymbols.size(); ++n) {
+                        addValue(block, *(row[n]), previousBlock);
                     }
-                    ++smIndex;
                 }
-                ++index;
+            } else {
+                fillVariableStore(_sms[smIndex]._store, _sms[smIndex]._variableMappings, row);
+                addValue(block, _sms[smIndex]._sm.evaluate(_sms[smIndex]._store, _context._functions), previousBlock);
+                ++smIndex;
             }
-            _block->nextRow();
+            ++index;
         }
-        if(!row) {
-            _block->endBlocks();
+        block->nextRow();
+
+        return previousBlock;
+    }
+
+    BlockPtr ExtendedProjectionOperatorNode::prepareNextBatchBuffer()
+    {
+        BlockPtr previousBlock = nullptr;
+
+        while(!previousBlock) {
+            if(_batchRow == _batchRowCount && !readBatch()) {
+                _block->endBlocks();
+                break;
+            }
+            // the rows without the results of the calls were added to the batch blocks by the first pass
+            const Values* row = _batchTypes.empty() ? nullptr : _batchIterator->getNextRow();
+            size_t column = 0;
+            for(size_t call : _columnBatchCalls) {
+                if(call != std::numeric_limits<size_t>::max()) {
+                    addValue(_block, _batchCalls[call]._results[_batchRow], previousBlock);
+                } else {
+                    addValue(_block, *((*row)[column++]), previousBlock);
+                }
+            }
+            _block->nextRow();
+            ++_batchRow;
         }
 
         return previousBlock;
     }
 
+    bool ExtendedProjectionOperatorNode::readBatch()
+    {
+        releaseBatchBlocks();
+        _batchIterator.reset();
+        _batchRowCount = 0;
+        _batchRow = 0;
+        for(auto& call : _batchCalls) {
+            for(auto& column : call._columns) {
+                column.clear();
+            }
+        }
+
+        BlockPtr block = _context._blockManager.createBlock();
+        _batchBlocks._blocks.push_back(block);
+        const Values* row = nullptr;
+        while(_batchRowCount < _batchSize && (row = getNextInputRow())) {
+            if(addRow(*row, block)) {
+                _batchBlocks._blocks.push_back(block);
+            }
+            ++_batchRowCount;
+        }
+        block->endBlocks();
+        _batchIterator = std::make_shared<BlockIterator>(_batchTypes, _batchBlocks, getBlockManager());
+        if(!_batchRowCount) {
+            return false;
+        }
+
+        for(auto& call : _batchCalls) {
+            call._function->callBatch(_batchRowCount, call._columns, call._results);
+        }
+        return true;
+    }
+
+    void ExtendedProjectionOperatorNode::releaseBatchBlocks()
+    {
+        // the blocks handed out to the batch iterator are released by the iterator
+        for(size_t n = _batchBlocks._next; n < _batchBlocks._blocks.size(); ++n) {
+            _context._blockManager.release(_batchBlocks._blocks[n]);
+        }
+        _batchBlocks._blocks.clear();
+        _batchBlocks._next = 0;
+    }
+
+    void ExtendedProjectionOperatorNode::addBatchParameters(BatchCall& call, const Values& row)
+    {
+        for(size_t n = 0; n < call._parameters.size(); ++n) {
+            const BatchParameter& parameter = call._parameters[n];
+            if(parameter._input == std::numeric_limits<size_t>::max()) {
+                call._columns[n].push_back(parameter._constant);
+                continue;
+            }
+            Variant value = valueToVariant(*row[parameter._input]);
+            if(parameter._cast != NONE) {
+                try {
+                    value = unaryOperation(OP_CAST, parameter._cast, value);
+                } catch(const std::exception&) {
+                    CSVSQLDB_THROW(csvsqldb::Exception,
+                                   "calling function '" << call._function->getName() << "' with wrong parameter");
+                }
+            }
+            value.disconnect();
+            call._columns[n].push_back(value);
+        }
+    }
+
     void ExtendedProjectionOperatorNode::dump(std::ostream& stream) const
     {
         stream << "ExtendedProjectionOperator (";
@@ -808,6 +1110,21 @@ namespace csvsqldb
         _input->dump(stream);
     }
 
+    uint64_t ExtendedProjectionOperatorNode::estimateRowCount()
+    {
+        return std::min(_input->estimateRowCount(), _rowLimit);
+    }
+
+    void ExtendedProjectionOperatorNode::setRowLimit(uint64_t rowLimit)
+    {
+        _rowLimit = rowLimit;
+    }
+
+    BlockPtr ExtendedProjectionOperatorNode::BatchBlockProvider::getNextBlock()
+    {
+        return _blocks[_next++];
+    }
+
 
     CrossJoinOperatorNode::CrossJoinOperatorNode(const OperatorContext& context, const SymbolTablePtr& symbolTable)
     : RowOperatorNode(context, symbolTable)
@@ -888,6 +1205,19 @@ namespace csvsqldb
         _rhsInput->dump(stream);
     }
 
+    uint64_t CrossJoinOperatorNode::estimateRowCount()
+    {
+        const uint64_t lhsRows = _lhsInput->estimateRowCount();
+        const uint64_t rhsRows = _rhsInput->estimateRowCount();
+        if(lhsRows == _unknownRowCount || rhsRows == _unknownRowCount) {
+            return _unknownRowCount;
+        }
+        if(lhsRows && rhsRows > (_unknownRowCount - 1) / lhsRows) {
+            return _unknownRowCount - 1;
+        }
+        return lhsRows * rhsRows;
+    }
+
 
     InnerJoinOperatorNode::InnerJoinOperatorNode(const OperatorContext& context, const SymbolTablePtr& symbolTable, const ASTExprNodePtr& exp)
     : CrossJoinOperatorNode(context, symbolTable)
@@ -919,38 +1249,7 @@ namespace csvsqldb
             SymbolInfos outputSymbols;
             CrossJoinOperatorNode::getColumnInfos(outputSymbols);
 
-            StackMachine sm;
-            IdentifierSet expressionVariables;
-
-            StackMachine::VariableMapping mapping;
-            {
-                ASTInstructionStackVisitor visitor(sm, mapping);
-                _exp->accept(visitor);
-            }
-
-            {
-                ASTExpressionVariableVisitor visitor(expressionVariables);
-                _exp->accept(visitor);
-            }
-
-            VariableMapping variableMapping;
-            for(const auto& variable : expressionVariables) {
-                bool found = false;
-                for(size_t n = 0; !found && n < outputSymbols.size(); ++n) {
-                    const SymbolInfoPtr& info = outputSymbols[n];
-
-                    if(variable._info->_name == info->_name) {
-                        variableMapping.push_back(std::make_pair(getMapping(variable.getQualifiedIdentifier(), mapping), n));
-                        found = true;
-                    }
-                }
-                if(!found) {
-                    CSVSQLDB_THROW(csvsqldb::Exception,
-                                   "variable '" << variable.getQualifiedIdentifier() << "' not found in context");
-                }
-            }
-
-            _sm = StackMachineType(sm, variableMapping);
+            _sm = compileExpression(_exp, outputSymbols);
         }
 
         return true;
@@ -968,112 +1267,810 @@ namespace csvsqldb
     }
 
 
-    InnerHashJoinOperatorNode::InnerHashJoinOperatorNode(const OperatorContext& context, const SymbolTablePtr& symbolTable, const ASTExprNodePtr& exp)
-    : RowOperatorNode(context, symbolTable)
-    , _currentLhs(nullptr)
-    , _exp(exp)
-    , _hashTableKeyPosition(0)
+    namespace
     {
-    }
+        struct JoinKey {
+            ASTExprNodePtr _lhs;
+            ASTExprNodePtr _rhs;
+            eType _type;
+        };
+        typedef std::vector<JoinKey> JoinKeys;
 
-    const Values* InnerHashJoinOperatorNode::getNextRow()
-    {
-        const Values* row = nullptr;
+        enum eJoinSide { NO_SIDE, LEFT_SIDE, RIGHT_SIDE, BOTH_SIDES };
 
-        do {
-            row = _rhsIterator->getNextKeyValueRow();
-            if(!row) {
-                _currentLhs = _lhsInput->getNextRow();
-                if(!_currentLhs) {
-                    // free all resources, as we have delivered the last row
-                    _rhsIterator->reset();
-                    return nullptr;
-                }
-                for(size_t n = 0; n < _inputLhsSymbols.size(); ++n) {
-                    const Values& values = *(_currentLhs);
-                    _row[n] = values[n];
-                }
-                _rhsIterator->setContextForKeyValue(*_row[_hashTableKeyPosition]);
+        void collectConjunctions(const ASTExprNodePtr& exp, Expressions& terms)
+        {
+            ASTBinaryNodePtr binaryExpression = std::dynamic_pointer_cast<ASTBinaryNode>(exp);
+            if(binaryExpression && binaryExpression->_op == OP_AND) {
+                collectConjunctions(binaryExpression->_lhs, terms);
+                collectConjunctions(binaryExpression->_rhs, terms);
+            } else {
+                terms.push_back(exp);
             }
-        } while(!row);
+        }
 
-        size_t m = 0;
-        for(size_t n = _inputLhsSymbols.size(); n < _inputRhsSymbols.size() + _inputLhsSymbols.size(); ++n, ++m) {
-            const Values& values = *(row);
-            _row[n] = values[m];
+        bool containsVariable(const SymbolInfos& symbols, const ASTIdentifier& variable)
+        {
+            return std::find_if(symbols.begin(), symbols.end(), [&](const SymbolInfoPtr& info) {
+                       return variable._info->_name == info->_name;
+                   }) != symbols.end();
+        }
+
+        eJoinSide getJoinSide(const ASTExprNodePtr& exp, const SymbolInfos& lhsSymbols, const SymbolInfos& rhsSymbols)
+        {
+            IdentifierSet expressionVariables;
+            ASTExpressionVariableVisitor visitor(expressionVariables);
+            exp->accept(visitor);
+
+            eJoinSide side = NO_SIDE;
+            for(const auto& variable : expressionVariables) {
+                bool inLhs = containsVariable(lhsSymbols, variable);
+                bool inRhs = containsVariable(rhsSymbols, variable);
+                if(inLhs == inRhs) {
+                    return BOTH_SIDES;
+                }
+                eJoinSide variableSide = inLhs ? LEFT_SIDE : RIGHT_SIDE;
+                if(side != NO_SIDE && side != variableSide) {
+                    return BOTH_SIDES;
+                }
+                side = variableSide;
+            }
+            return side;
+        }
+
+        eType getJoinKeyType(eType lhs, eType rhs)
+        {
+            if(lhs == rhs) {
+                return lhs;
+            }
+            if((lhs == INT && rhs == REAL) || (lhs == REAL && rhs == INT)) {
+                return REAL;
+            }
+            return NONE;
+        }
+
+        void splitJoinCondition(const ASTExprNodePtr& exp,
+                                const SymbolInfos& lhsSymbols,
+                                const SymbolInfos& rhsSymbols,
+                                JoinKeys& keys,
+                                Expressions& residuals)
+        {
+            Expressions terms;
+            collectConjunctions(exp, terms);
+
+            for(const auto& term : terms) {
+                ASTBinaryNodePtr binaryExpression = std::dynamic_pointer_cast<ASTBinaryNode>(term);
+                if(binaryExpression && binaryExpression->_op == OP_EQ) {
+                    eJoinSide lhsSide = getJoinSide(binaryExpression->_lhs, lhsSymbols, rhsSymbols);
+                    eJoinSide rhsSide = getJoinSide(binaryExpression->_rhs, lhsSymbols, rhsSymbols);
+                    JoinKey key = { binaryExpression->_lhs,
+                                    binaryExpression->_rhs,
+                                    getJoinKeyType(binaryExpression->_lhs->type(), binaryExpression->_rhs->type()) };
+                    if(lhsSide == RIGHT_SIDE && rhsSide == LEFT_SIDE) {
+                        std::swap(key._lhs, key._rhs);
+                        std::swap(lhsSide, rhsSide);
+                    }
+                    if(lhsSide == LEFT_SIDE && rhsSide == RIGHT_SIDE && key._type != NONE) {
+                        keys.push_back(key);
+                        continue;
+                    }
+                }
+                residuals.push_back(term);
+            }
         }
+
+        template <typename Side>
+        void setupJoinKeyInput(OperatorBaseNode& node,
+                               const OperatorContext& context,
+                               Side& side,
+                               const Expressions& keys,
+                               const Types& keyTypes,
+                               bool skipNullKeys)
+        {
+            OperatorBaseNode::StackMachines keyMachines;
+            Types computedTypes;
+            for(size_t n = 0; n < keys.size(); ++n) {
+                ASTIdentifierPtr identifier = std::dynamic_pointer_cast<ASTIdentifier>(keys[n]);
+                if(identifier && identifier->type() == keyTypes[n]) {
+                    auto result = std::find_if(side._symbols.begin(), side._symbols.end(), [&](const SymbolInfoPtr& info) {
+                        return identifier->_info->_name == info->_name;
+                    });
+                    side._keyPositions.push_back(static_cast<size_t>(result - side._symbols.begin()));
+                } else {
+                    // the key has to be computed or converted to the key type of the other side
+                    keyMachines.push_back(node.compileExpression(keys[n], side._symbols));
+                    computedTypes.push_back(keyTypes[n]);
+                    side._keyPositions.push_back(side._types.size());
+                    side._types.push_back(keyTypes[n]);
+                }
+            }
+            if(!keyMachines.empty() || skipNullKeys) {
+                side._keyInput = std::make_shared<JoinKeyRowProvider>(context, *side._input, keyMachines, computedTypes, side._keyPositions);
+            }
+        }
+
+        bool makeJoinKey(const Values& row, const IndexVector& keyPositions, GroupingElement& key)
+        {
+            key._groupingValues.clear();
+            for(const auto& keyPosition : keyPositions) {
+                const Value& value = *row[keyPosition];
+                if(value.isNull()) {
+                    // null keys will never match in an inner join
+                    return false;
+                }
+                key._groupingValues.push_back(valueToVariant(value));
+            }
+            return true;
+        }
+
+        bool makeJoinKey(const Values& row, const IndexVector& keyPositions, HashKey& key)
+        {
+            if(!makeJoinKey(row, keyPositions, key._key)) {
+                return false;
+            }
+            key.computeHash();
+            return true;
+        }
+
+        size_t partitionOfKey(const GroupingElement& key, size_t level, size_t partitionCount)
+        {
+            // mix the hash with the partition level, so that a re-partitioning distributes the keys differently
+            uint64_t hash = static_cast<uint64_t>(key.getHash()) + 0x9e3779b97f4a7c15ULL * (level + 1);
+            hash ^= hash >> 33;
+            hash *= 0xff51afd7ed558ccdULL;
+            hash ^= hash >> 33;
+            hash *= 0xc4ceb9fe1a85ec53ULL;
+            hash ^= hash >> 33;
+            return static_cast<size_t>(hash % partitionCount);
+        }
+
+        template <typename Input>
+        void spillRows(Input& input, const Types& types, const IndexVector& keyPositions, size_t level, SpillFiles& files)
+        {
+            GroupingElement key;
+            const Values* row = nullptr;
+            while((row = input.getNextRow())) {
+                if(!makeJoinKey(*row, keyPositions, key)) {
+                    continue;
+                }
+                SpillFilePtr& file = files[partitionOfKey(key, level, files.size())];
+                if(!file) {
+                    file = std::make_shared<SpillFile>(types);
+                }
+                file->writeRow(*row);
+            }
+        }
+    }
+
+
+    JoinKeyRowProvider::JoinKeyRowProvider(const OperatorContext& context,
+                                           RowProvider& input,
+                                           const OperatorBaseNode::StackMachines& keyMachines,
+                                           const Types& keyTypes,
+                                           const IndexVector& keyPositions)
+    : _context(context)
+    , _input(input)
+    , _keyMachines(keyMachines)
+    , _keyTypes(keyTypes)
+    , _keyPositions(keyPositions)
+    , _block(context._blockManager.createBlock())
+    {
+    }
+
+    JoinKeyRowProvider::~JoinKeyRowProvider()
+    {
+        _context._blockManager.release(_block);
+    }
+
+    const Values* JoinKeyRowProvider::getNextRow()
+    {
+        const Values* row = nullptr;
+        do {
+            row = _input.getNextRow();
+            if(!row) {
+                return nullptr;
+            }
+            _row.assign(row->begin(), row->end());
+            _block->reset();
+            for(size_t n = 0; n < _keyMachines.size(); ++n) {
+                OperatorBaseNode::StackMachineType& sm = _keyMachines[n];
+                for(const auto& mapping : sm._variableMappings) {
+                    sm._store.addVariable(mapping.first, valueToVariant(*(*row)[mapping.second]));
+                }
+                Variant key = sm._sm.evaluate(sm._store, _context._functions);
+                // both sides of the join have to deliver the key in the same type, otherwise the keys will not match
+                if(key.isNull()) {
+                    key = Variant(_keyTypes[n]);
+                } else if(key.getType() != _keyTypes[n]) {
+                    key = unaryOperation(OP_CAST, _keyTypes[n], key);
+                }
+                const Value* value = _block->addValue(key);
+                if(!value) {
+                    CSVSQLDB_THROW(csvsqldb::Exception, "join key does not fit into a block");
+                }
+                _row.push_back(value);
+            }
+        } while(std::any_of(_keyPositions.begin(), _keyPositions.end(), [this](size_t n) { return _row[n]->isNull(); }));
+
         return &_row;
     }
 
+
+    InnerHashJoinOperatorNode::InnerHashJoinOperatorNode(const OperatorContext& context, const SymbolTablePtr& symbolTable, const ASTExprNodePtr& exp)
+    : RowOperatorNode(context, symbolTable)
+    , _currentProbe(nullptr)
+    , _exp(exp)
+    , _build(&_rhs)
+    , _probe(&_lhs)
+    , _buildStarted(false)
+    , _probeInput(nullptr)
+    {
+        _morsel._rowCount = 0;
+        _morsel._currentRow = 0;
+        _morsel._currentMatch = 0;
+        _morsel._inputExhausted = false;
+    }
+
+    InnerHashJoinOperatorNode::~InnerHashJoinOperatorNode()
+    {
+        releaseProbeMorsel();
+    }
+
+    const Values* InnerHashJoinOperatorNode::getNextRow()
+    {
+        if(_context._threadPool) {
+            return getNextParallelRow();
+        }
+
+        for(;;) {
+            if(!_buildIterator && !buildNextHashTable()) {
+                return nullptr;
+            }
+            const Values* row = _buildIterator->getNextKeyValueRow();
+            if(row) {
+                copyToOutput(*_build, *row);
+                if(matchesResidual()) {
+                    return &_row;
+                }
+                continue;
+            }
+            _currentProbe = _probeInput->getNextRow();
+            if(!_currentProbe) {
+                // free all resources of the current hash table, as we have delivered its last row
+                _buildIterator->reset();
+                _buildIterator.reset();
+                continue;
+            }
+            if(makeJoinKey(*_currentProbe, _probe->_keyPositions, _probeKey)) {
+                copyToOutput(*_probe, *_currentProbe);
+                _buildIterator->setContextForKeyValue(_probeKey);
+            }
+        }
+    }
+
+    const Values* InnerHashJoinOperatorNode::getNextParallelRow()
+    {
+        for(;;) {
+            if(_morsel._currentRow < _morsel._rowCount) {
+                const BlockPositions& matches = _morsel._matches[_morsel._currentRow];
+                if(_morsel._currentMatch < matches.size()) {
+                    copyToOutput(*_probe, _morsel._rows[_morsel._currentRow]);
+                    _buildIterator->getRowAt(matches[_morsel._currentMatch++], _buildRow);
+                    copyToOutput(*_build, _buildRow);
+                    if(matchesResidual()) {
+                        return &_row;
+                    }
+                    continue;
+                }
+                ++_morsel._currentRow;
+                _morsel._currentMatch = 0;
+                continue;
+            }
+            if(!_buildIterator && !buildNextHashTable()) {
+                return nullptr;
+            }
+            if(!fillProbeMorsel()) {
+                // free all resources of the current hash table, as we have delivered its last row
+                _buildIterator->reset();
+                _buildIterator.reset();
+            }
+        }
+    }
+
+    void InnerHashJoinOperatorNode::copyToOutput(const JoinSide& side, const Values& values)
+    {
+        for(size_t n = 0; n < side._outputPositions.size(); ++n) {
+            _row[side._outputPositions[n]] = values[n];
+        }
+    }
+
+    bool InnerHashJoinOperatorNode::matchesResidual()
+    {
+        for(auto& sm : _residuals) {
+            fillVariableStore(sm._store, sm._variableMappings, _row);
+            if(!sm._sm.evaluate(sm._store, _context._functions).asBool()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool InnerHashJoinOperatorNode::fillProbeMorsel()
+    {
+        releaseProbeMorsel();
+        if(_morsel._inputExhausted) {
+            return false;
+        }
+
+        // the rows of the probe input are only valid until the next row is requested, so they have to be copied
+        const Values* row = nullptr;
+        while(_morsel._rowCount < _probeMorselSize) {
+            row = _probeInput->getNextRow();
+            if(!row) {
+                _morsel._inputExhausted = true;
+                break;
+            }
+            if(_morsel._rows.size() == _morsel._rowCount) {
+                _morsel._rows.emplace_back();
+            }
+            Values& storedRow = _morsel._rows[_morsel._rowCount++];
+            storedRow.clear();
+            for(const auto& value : *row) {
+                const Value* storedValue = _morsel._blocks.empty() ? nullptr : _morsel._blocks.back()->addValue(*value);
+                if(!storedValue) {
+                    _morsel._blocks.push_back(getBlockManager().createBlock());
+                    storedValue = _morsel._blocks.back()->addValue(*value);
+                }
+                storedRow.push_back(storedValue);
+            }
+        }
+        if(!_morsel._rowCount) {
+            return false;
+        }
+
+        if(_morsel._matches.size() < _morsel._rowCount) {
+            _morsel._matches.resize(_morsel._rowCount);
+        }
+        const size_t threads = _context._threadPool->numberOfThreads();
+        const size_t share = (_morsel._rowCount + threads - 1) / threads;
+        std::vector<ThreadPool::Callback> tasks;
+        for(size_t begin = 0; begin < _morsel._rowCount; begin += share) {
+            const size_t end = std::min(begin + share, _morsel._rowCount);
+            tasks.push_back([this, begin, end]() { probeMorselRows(begin, end); });
+        }
+        _context._threadPool->executeTasks(tasks);
+
+        return true;
+    }
+
+    void InnerHashJoinOperatorNode::probeMorselRows(size_t begin, size_t end)
+    {
+        HashKey key;
+        uint64_t probes = 0;
+        for(size_t n = begin; n < end; ++n) {
+            BlockPositions& matches = _morsel._matches[n];
+            matches.clear();
+            if(makeJoinKey(_morsel._rows[n], _probe->_keyPositions, key)) {
+                _buildIterator->findKeyValueRows(key, matches);
+                ++probes;
+            }
+        }
+        metrics::Metrics::add(metrics::HASH_PROBES, probes);
+    }
+
+    void InnerHashJoinOperatorNode::releaseProbeMorsel()
+    {
+        for(auto& block : _morsel._blocks) {
+            getBlockManager().release(block);
+        }
+        _morsel._blocks.clear();
+        _morsel._rowCount = 0;
+        _morsel._currentRow = 0;
+        _morsel._currentMatch = 0;
+    }
+
+    void InnerHashJoinOperatorNode::chooseBuildSide()
+    {
+        // hash the smaller input; small inputs are cheap to hash either way, so keep the written order for them
+        const uint64_t lhsRows = _lhs._input->estimateRowCount();
+        const uint64_t rhsRows = _rhs._input->estimateRowCount();
+        if(lhsRows != _unknownRowCount && rhsRows != _unknownRowCount && lhsRows < rhsRows
+           && rhsRows >= _context._minRowsForJoinReordering) {
+            _build = &_lhs;
+            _probe = &_rhs;
+        }
+    }
+
+    bool InnerHashJoinOperatorNode::buildNextHashTable()
+    {
+        if(!_buildStarted) {
+            _buildStarted = true;
+            _buildIterator = std::make_shared<HashingBlockIterator>(_build->_types, _build->getInput(), getBlockManager(),
+                                                                    _build->_keyPositions, _context._hashJoinBlockLimit,
+                                                                    _context._threadPool);
+            if(_buildIterator->buildHashTable()) {
+                _counters._hashTableEntries += _buildIterator->getHashTableSize();
+                _probeInput = &_probe->getInput();
+                _morsel._inputExhausted = false;
+                return true;
+            }
+            // the build side exceeds its block limit, so partition both inputs to disk and join the partitions pairwise
+            spillPartitions(_build->getInput(), _probe->getInput(), 0);
+        }
+
+        while(!_partitions.empty()) {
+            _currentPartition = _partitions.front();
+            _partitions.pop_front();
+
+            if(!_currentPartition._probe || !_currentPartition._build) {
+                // one side of the partition is empty, thus there is nothing to join
+                continue;
+            }
+
+            size_t blockLimit =
+              _currentPartition._level < _maxPartitionLevel ? _context._hashJoinBlockLimit : std::numeric_limits<size_t>::max();
+            _currentPartition._build->rewind();
+            _buildIterator = std::make_shared<HashingBlockIterator>(_build->_types, *_currentPartition._build, getBlockManager(),
+                                                                    _build->_keyPositions, blockLimit, _context._threadPool);
+            _currentPartition._probe->rewind();
+            if(_buildIterator->buildHashTable()) {
+                _counters._hashTableEntries += _buildIterator->getHashTableSize();
+                _probeInput = _currentPartition._probe.get();
+                _morsel._inputExhausted = false;
+                return true;
+            }
+            // the partition is still too large, split it up again with a different hash distribution
+            spillPartitions(*_currentPartition._build, *_currentPartition._probe, _currentPartition._level + 1);
+        }
+
+        _currentPartition = JoinPartition();
+        _probeInput = nullptr;
+        return false;
+    }
+
+    void InnerHashJoinOperatorNode::spillPartitions(RowProvider& buildInput, RowProvider& probeInput, size_t level)
+    {
+        SpillFiles buildFiles(_partitionCount);
+        SpillFiles probeFiles(_partitionCount);
+
+        // first spill the rows already cached by the hash table, then the remaining rows of the build side
+        _buildIterator->rewind();
+        spillRows(*_buildIterator, _build->_types, _build->_keyPositions, level, buildFiles);
+        _buildIterator->reset();
+        _buildIterator.reset();
+        spillRows(buildInput, _build->_types, _build->_keyPositions, level, buildFiles);
+        spillRows(probeInput, _probe->_types, _probe->_keyPositions, level, probeFiles);
+
+        const OperatorCounters spilledBefore = _counters;
+        size_t nonEmptyPartitions = 0;
+        for(const auto& file : buildFiles) {
+            if(file) {
+                ++nonEmptyPartitions;
+                _counters._spilledRows += file->getRowCount();
+                _counters._spilledBytes += file->getByteCount();
+            }
+        }
+        for(const auto& file : probeFiles) {
+            if(file) {
+                _counters._spilledRows += file->getRowCount();
+                _counters._spilledBytes += file->getByteCount();
+            }
+        }
+        metrics::Metrics::add(metrics::SPILLED_ROWS, _counters._spilledRows - spilledBefore._spilledRows);
+        metrics::Metrics::add(metrics::SPILLED_BYTES, _counters._spilledBytes - spilledBefore._spilledBytes);
+        // if all rows ended up in one partition, they most probably share the same key and splitting them up again is futile
+        size_t nextLevel = nonEmptyPartitions > 1 ? level : _maxPartitionLevel;
+
+        for(size_t n = _partitionCount; n > 0; --n) {
+            _partitions.push_front({ probeFiles[n - 1], buildFiles[n - 1], nextLevel });
+        }
+    }
+
+    OperatorCounters InnerHashJoinOperatorNode::getCounters() const
+    {
+        return _counters;
+    }
+
     bool InnerHashJoinOperatorNode::connect(const RowOperatorNodePtr& input)
     {
-        if(!_lhsInput) {
-            _lhsInput = input;
-            _lhsInput->getColumnInfos(_inputLhsSymbols);
-            _outputSymbols.insert(_outputSymbols.end(), _inputLhsSymbols.begin(), _inputLhsSymbols.end());
+        if(!_lhs._input) {
+            _lhs._input = input;
+            _lhs._input->getColumnInfos(_lhs._symbols);
+            _outputSymbols.insert(_outputSymbols.end(), _lhs._symbols.begin(), _lhs._symbols.end());
             return false;
-        } else if(!_rhsInput) {
-            _rhsInput = input;
-            _rhsInput->getColumnInfos(_inputRhsSymbols);
-            _outputSymbols.insert(_outputSymbols.end(), _inputRhsSymbols.begin(), _inputRhsSymbols.end());
-            Types types;
-            for(const auto& info : _inputRhsSymbols) {
-                types.push_back(info->_type);
+        } else if(!_rhs._input) {
+            _rhs._input = input;
+            _rhs._input->getColumnInfos(_rhs._symbols);
+            _outputSymbols.insert(_outputSymbols.end(), _rhs._symbols.begin(), _rhs._symbols.end());
+            for(size_t n = 0; n < _lhs._symbols.size(); ++n) {
+                _lhs._types.push_back(_lhs._symbols[n]->_type);
+                _lhs._outputPositions.push_back(n);
+            }
+            for(size_t n = 0; n < _rhs._symbols.size(); ++n) {
+                _rhs._types.push_back(_rhs._symbols[n]->_type);
+                _rhs._outputPositions.push_back(_lhs._symbols.size() + n);
             }
 
-            StackMachine sm;
-            IdentifierSet expressionVariables;
+            setupKeys();
+            // the build side is decided once while planning, so that the plan dump shows the side that is executed
+            chooseBuildSide();
 
-            StackMachine::VariableMapping mapping;
-            {
-                ASTInstructionStackVisitor visitor(sm, mapping);
-                _exp->accept(visitor);
+            _row.resize(_outputSymbols.size());
+        } else {
+            CSVSQLDB_THROW(csvsqldb::Exception, "all inputs already set");
+        }
+
+        return true;
+    }
+
+    void InnerHashJoinOperatorNode::setupKeys()
+    {
+        JoinKeys keys;
+        Expressions residuals;
+        splitJoinCondition(_exp, _lhs._symbols, _rhs._symbols, keys, residuals);
+        if(keys.empty()) {
+            CSVSQLDB_THROW(csvsqldb::Exception, "join condition contains no equality between the inputs usable as hash key");
+        }
+
+        Expressions lhsKeys;
+        Expressions rhsKeys;
+        Types keyTypes;
+        for(const auto& key : keys) {
+            lhsKeys.push_back(key._lhs);
+            rhsKeys.push_back(key._rhs);
+            keyTypes.push_back(key._type);
+        }
+        // null keys are skipped while hashing and probing anyway
+        setupJoinKeyInput(*this, _context, _lhs, lhsKeys, keyTypes, false);
+        setupJoinKeyInput(*this, _context, _rhs, rhsKeys, keyTypes, false);
+
+        for(const auto& residual : residuals) {
+            _residuals.push_back(compileExpression(residual, _outputSymbols));
+        }
+    }
+
+    bool InnerHashJoinOperatorNode::hasHashKeys(const ASTExprNodePtr& exp, const SymbolInfos& lhsSymbols, const SymbolInfos& rhsSymbols)
+    {
+        JoinKeys keys;
+        Expressions residuals;
+        splitJoinCondition(exp, lhsSymbols, rhsSymbols, keys, residuals);
+        return !keys.empty();
+    }
+
+    void InnerHashJoinOperatorNode::setOutputOrder(const SymbolInfos& outputSymbols)
+    {
+        if(outputSymbols.size() != _outputSymbols.size()) {
+            CSVSQLDB_THROW(csvsqldb::Exception, "output order has to contain all columns of the join");
+        }
+        for(JoinSide* side : { &_lhs, &_rhs }) {
+            for(size_t n = 0; n < side->_symbols.size(); ++n) {
+                auto result = std::find(outputSymbols.begin(), outputSymbols.end(), side->_symbols[n]);
+                if(result == outputSymbols.end()) {
+                    CSVSQLDB_THROW(csvsqldb::Exception, "column '" << side->_symbols[n]->_name << "' missing in output order");
+                }
+                side->_outputPositions[n] = static_cast<size_t>(result - outputSymbols.begin());
+            }
+        }
+        for(auto& sm : _residuals) {
+            for(auto& mapping : sm._variableMappings) {
+                const SymbolInfoPtr& info = _outputSymbols[mapping.second];
+                mapping.second = static_cast<size_t>(std::find(outputSymbols.begin(), outputSymbols.end(), info) - outputSymbols.begin());
+            }
+        }
+        _outputSymbols = outputSymbols;
+    }
+
+    void InnerHashJoinOperatorNode::getColumnInfos(SymbolInfos& outputSymbols)
+    {
+        outputSymbols = _outputSymbols;
+    }
+
+    void InnerHashJoinOperatorNode::dump(std::ostream& stream) const
+    {
+        stream << "InnerHashJoinOperator (build side: " << (_build == &_lhs ? "left" : "right") << ")\n";
+        stream << "-->";
+        _lhs._input->dump(stream);
+        stream << "-->";
+        _rhs._input->dump(stream);
+    }
+
+    uint64_t InnerHashJoinOperatorNode::estimateRowCount()
+    {
+        // assume a foreign key join, where each row of the larger input matches one row of the smaller input
+        const uint64_t lhsRows = _lhs._input->estimateRowCount();
+        const uint64_t rhsRows = _rhs._input->estimateRowCount();
+        if(lhsRows == _unknownRowCount || rhsRows == _unknownRowCount) {
+            return _unknownRowCount;
+        }
+        return std::max(lhsRows, rhsRows);
+    }
+
+
+    namespace
+    {
+        struct MergeKey {
+            eJoinSide _pointSide;
+            ASTExprNodePtr _point;
+            ASTExprNodePtr _lower;
+            ASTExprNodePtr _upper;
+            eType _type;
+        };
+
+        struct MergeBound {
+            eJoinSide _pointSide;
+            ASTExprNodePtr _point;
+            ASTExprNodePtr _bound;
+            bool _isLower;
+        };
+
+        std::string expressionToString(const ASTExprNodePtr& exp)
+        {
+            ASTNodeSQLPrintVisitor visitor;
+            try {
+                exp->accept(visitor);
+            } catch(const SqlException&) {
+                return std::string();
             }
+            return visitor.toString();
+        }
 
-            {
-                ASTExpressionVariableVisitor visitor(expressionVariables);
-                _exp->accept(visitor);
+        void addMergeBound(std::vector<MergeBound>& bounds,
+                           const ASTExprNodePtr& point,
+                           const ASTExprNodePtr& bound,
+                           bool isLower,
+                           const SymbolInfos& lhsSymbols,
+                           const SymbolInfos& rhsSymbols)
+        {
+            eJoinSide pointSide = getJoinSide(point, lhsSymbols, rhsSymbols);
+            eJoinSide boundSide = getJoinSide(bound, lhsSymbols, rhsSymbols);
+            if((pointSide == LEFT_SIDE && boundSide == RIGHT_SIDE) || (pointSide == RIGHT_SIDE && boundSide == LEFT_SIDE)) {
+                bounds.push_back({ pointSide, point, bound, isLower });
             }
+        }
 
-            VariableMapping variableMapping;
-            size_t hashTableKeyPosition = 0;
-            for(const auto& variable : expressionVariables) {
-                bool found = false;
-                for(size_t n = 0; !found && n < _outputSymbols.size(); ++n) {
-                    const SymbolInfoPtr& info = _outputSymbols[n];
+        bool findMergeKey(const ASTExprNodePtr& exp, const SymbolInfos& lhsSymbols, const SymbolInfos& rhsSymbols, MergeKey& key)
+        {
+            // equalities are not looked for, joins with an equality between both inputs are hash joins
+            Expressions terms;
+            collectConjunctions(exp, terms);
+
+            std::vector<MergeBound> bounds;
+            for(const auto& term : terms) {
+                ASTBetweenNodePtr between = std::dynamic_pointer_cast<ASTBetweenNode>(term);
+                if(between) {
+                    addMergeBound(bounds, between->_lhs, between->_from, true, lhsSymbols, rhsSymbols);
+                    addMergeBound(bounds, between->_lhs, between->_to, false, lhsSymbols, rhsSymbols);
+                    continue;
+                }
+                ASTBinaryNodePtr binaryExpression = std::dynamic_pointer_cast<ASTBinaryNode>(term);
+                if(binaryExpression && (binaryExpression->_op == OP_GT || binaryExpression->_op == OP_GE
+                                        || binaryExpression->_op == OP_LT || binaryExpression->_op == OP_LE)) {
+                    // 'x >= y' makes y a lower bound of x and x an upper bound of y
+                    bool lhsIsGreater = binaryExpression->_op == OP_GT || binaryExpression->_op == OP_GE;
+                    addMergeBound(bounds, binaryExpression->_lhs, binaryExpression->_rhs, lhsIsGreater, lhsSymbols, rhsSymbols);
+                    addMergeBound(bounds, binaryExpression->_rhs, binaryExpression->_lhs, !lhsIsGreater, lhsSymbols, rhsSymbols);
+                }
+            }
+
+            for(const auto& lower : bounds) {
+                if(!lower._isLower) {
+                    continue;
+                }
+                std::string point = expressionToString(lower._point);
+                for(const auto& upper : bounds) {
+                    if(upper._isLower || upper._pointSide != lower._pointSide || point.empty()
+                       || point != expressionToString(upper._point)) {
+                        continue;
+                    }
+                    eType type = getJoinKeyType(getJoinKeyType(lower._point->type(), lower._bound->type()), upper._bound->type());
+                    if(type != NONE) {
+                        key = { lower._pointSide, lower._point, lower._bound, upper._bound, type };
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+    }
+
+
+    SortMergeJoinOperatorNode::SortMergeJoinOperatorNode(const OperatorContext& context, const SymbolTablePtr& symbolTable, const ASTExprNodePtr& exp)
+    : RowOperatorNode(context, symbolTable)
+    , _points(&_lhs)
+    , _ranges(&_rhs)
+    , _exp(exp)
+    , _initialized(false)
+    , _nextRange(nullptr)
+    , _currentRange(0)
+    {
+    }
+
+    const Values* SortMergeJoinOperatorNode::getNextRow()
+    {
+        if(!_initialized) {
+            _initialized = true;
+            // the points are sorted by their key, the ranges by their lower bound
+            _points->_iterator = std::make_shared<SortingBlockIterator>(
+            _points->_types, SortingBlockIterator::SortOrders{ { _points->_keyPositions[0], ASC } }, _points->getInput(), getBlockManager());
+            _ranges->_iterator = std::make_shared<SortingBlockIterator>(
+            _ranges->_types, SortingBlockIterator::SortOrders{ { _ranges->_keyPositions[0], ASC } }, _ranges->getInput(), getBlockManager());
+            _nextRange = _ranges->_iterator->getNextRow();
+        }
 
-                    if(variable._info->_name == info->_name) {
-                        variableMapping.push_back(std::make_pair(getMapping(variable.getQualifiedIdentifier(), mapping), n));
-                        found = true;
-                    }
-                }
-                if(!found) {
-                    CSVSQLDB_THROW(csvsqldb::Exception,
-                                   "variable '" << variable.getQualifiedIdentifier() << "' not found in context");
+        for(;;) {
+            while(_currentRange < _activeRanges.size()) {
+                copyToOutput(*_ranges, _activeRanges[_currentRange++]);
+                // the ranges only guarantee inclusive bounds, the complete condition decides
+                fillVariableStore(_condition._store, _condition._variableMappings, _row);
+                if(_condition._sm.evaluate(_condition._store, _context._functions).asBool()) {
+                    return &_row;
                 }
-                // find the rhs expresion variable for the hash table key
-                found = false;
-                for(size_t n = 0; !found && n < _inputRhsSymbols.size(); ++n) {
-                    const SymbolInfoPtr& info = _inputRhsSymbols[n];
+            }
+            if(!nextPoint()) {
+                return nullptr;
+            }
+        }
+    }
 
-                    if(variable._info->_name == info->_name) {
-                        hashTableKeyPosition = n;
-                        found = true;
-                    }
-                }
-                // find the lhs expresion variable for the hash table key
-                found = false;
-                for(size_t n = 0; !found && n < _inputLhsSymbols.size(); ++n) {
-                    const SymbolInfoPtr& info = _inputLhsSymbols[n];
+    bool SortMergeJoinOperatorNode::nextPoint()
+    {
+        if(!_nextRange && _activeRanges.empty()) {
+            // no range left to match
+            return false;
+        }
+        const Values* point = _points->_iterator->getNextRow();
+        if(!point) {
+            return false;
+        }
+        // the sorting iterator keeps all its rows, so the values stay valid
+        _currentPoint = *point;
+        copyToOutput(*_points, _currentPoint);
+
+        const Value& key = *_currentPoint[_points->_keyPositions[0]];
+        while(_nextRange && !(key < *(*_nextRange)[_ranges->_keyPositions[0]])) {
+            _activeRanges.push_back(*_nextRange);
+            _nextRange = _ranges->_iterator->getNextRow();
+        }
+        // as the keys are ascending, ranges ending before the current key will never match again
+        const size_t upperPosition = _ranges->_keyPositions[1];
+        _activeRanges.erase(std::remove_if(_activeRanges.begin(),
+                                           _activeRanges.end(),
+                                           [&](const Values& range) { return *range[upperPosition] < key; }),
+                            _activeRanges.end());
+        _currentRange = 0;
+        return true;
+    }
 
-                    if(variable._info->_name == info->_name) {
-                        _hashTableKeyPosition = n;
-                        found = true;
-                    }
-                }
+    void SortMergeJoinOperatorNode::copyToOutput(const MergeSide& side, const Values& values)
+    {
+        for(size_t n = 0; n < side._outputPositions.size(); ++n) {
+            _row[side._outputPositions[n]] = values[n];
+        }
+    }
+
+    bool SortMergeJoinOperatorNode::connect(const RowOperatorNodePtr& input)
+    {
+        if(!_lhs._input) {
+            _lhs._input = input;
+            _lhs._input->getColumnInfos(_lhs._symbols);
+            _outputSymbols.insert(_outputSymbols.end(), _lhs._symbols.begin(), _lhs._symbols.end());
+            return false;
+        } else if(!_rhs._input) {
+            _rhs._input = input;
+            _rhs._input->getColumnInfos(_rhs._symbols);
+            _outputSymbols.insert(_outputSymbols.end(), _rhs._symbols.begin(), _rhs._symbols.end());
+            for(size_t n = 0; n < _lhs._symbols.size(); ++n) {
+                _lhs._types.push_back(_lhs._symbols[n]->_type);
+                _lhs._outputPositions.push_back(n);
             }
+            for(size_t n = 0; n < _rhs._symbols.size(); ++n) {
+                _rhs._types.push_back(_rhs._symbols[n]->_type);
+                _rhs._outputPositions.push_back(_lhs._symbols.size() + n);
+            }
+
+            setupKeys();
 
-            _rhsIterator = std::make_shared<HashingBlockIterator>(types, *_rhsInput, getBlockManager(), hashTableKeyPosition);
+            _condition = compileExpression(_exp, _outputSymbols);
             _row.resize(_outputSymbols.size());
         } else {
             CSVSQLDB_THROW(csvsqldb::Exception, "all inputs already set");
@@ -1082,18 +2079,50 @@ namespace csvsqldb
         return true;
     }
 
-    void InnerHashJoinOperatorNode::getColumnInfos(SymbolInfos& outputSymbols)
+    void SortMergeJoinOperatorNode::setupKeys()
+    {
+        MergeKey key;
+        if(!findMergeKey(_exp, _lhs._symbols, _rhs._symbols, key)) {
+            CSVSQLDB_THROW(csvsqldb::Exception, "join condition contains no range between the inputs usable as merge key");
+        }
+        if(key._pointSide == RIGHT_SIDE) {
+            _points = &_rhs;
+            _ranges = &_lhs;
+        }
+        // rows with a null key or bound can never match, and would disturb the sort order
+        setupJoinKeyInput(*this, _context, *_points, Expressions{ key._point }, Types{ key._type }, true);
+        setupJoinKeyInput(*this, _context, *_ranges, Expressions{ key._lower, key._upper }, Types{ key._type, key._type }, true);
+    }
+
+    void SortMergeJoinOperatorNode::getColumnInfos(SymbolInfos& outputSymbols)
     {
         outputSymbols = _outputSymbols;
     }
 
-    void InnerHashJoinOperatorNode::dump(std::ostream& stream) const
+    void SortMergeJoinOperatorNode::dump(std::ostream& stream) const
     {
-        stream << "InnerHashJoinOperator\n";
+        stream << "SortMergeJoinOperator\n";
         stream << "-->";
-        _lhsInput->dump(stream);
+        _lhs._input->dump(stream);
         stream << "-->";
-        _rhsInput->dump(stream);
+        _rhs._input->dump(stream);
+    }
+
+    uint64_t SortMergeJoinOperatorNode::estimateRowCount()
+    {
+        // like for the hash join, assume that each row of the larger input matches one row of the smaller input
+        const uint64_t lhsRows = _lhs._input->estimateRowCount();
+        const uint64_t rhsRows = _rhs._input->estimateRowCount();
+        if(lhsRows == _unknownRowCount || rhsRows == _unknownRowCount) {
+            return _unknownRowCount;
+        }
+        return std::max(lhsRows, rhsRows);
+    }
+
+    bool SortMergeJoinOperatorNode::hasMergeKeys(const ASTExprNodePtr& exp, const SymbolInfos& lhsSymbols, const SymbolInfos& rhsSymbols)
+    {
+        MergeKey key;
+        return findMergeKey(exp, lhsSymbols, rhsSymbols, key);
     }
 
 
@@ -1145,6 +2174,20 @@ namespace csvsqldb
         _secondInput->dump(stream);
     }
 
+    uint64_t UnionOperatorNode::estimateRowCount()
+    {
+        if(!_firstInput) {
+            // the first input was already consumed
+            return _currentInput->estimateRowCount();
+        }
+        const uint64_t firstRows = _firstInput->estimateRowCount();
+        const uint64_t secondRows = _secondInput->estimateRowCount();
+        if(firstRows == _unknownRowCount || secondRows == _unknownRowCount) {
+            return _unknownRowCount;
+        }
+        return std::min(firstRows, _unknownRowCount - 1 - secondRows) + secondRows;
+    }
+
 
     SelectOperatorNode::SelectOperatorNode(const OperatorContext& context, const SymbolTablePtr& symbolTable, const ASTExprNodePtr& exp)
     : RowOperatorNode(context, symbolTable)
@@ -1210,230 +2253,872 @@ namespace csvsqldb
         _input->dump(stream);
     }
 
+    uint64_t SelectOperatorNode::estimateRowCount()
+    {
+        return _input->estimateRowCount();
+    }
+
+
+    namespace
+    {
+        Value* createNullValue(eType type)
+        {
+            switch(type) {
+                case INT:
+                    return new ValInt();
+                case REAL:
+                    return new ValDouble();
+                case BOOLEAN:
+                    return new ValBool();
+                case DATE:
+                    return new ValDate();
+                case TIME:
+                    return new ValTime();
+                case TIMESTAMP:
+                    return new ValTimestamp();
+                case STRING:
+                    return new ValString();
+                case NONE:
+                    break;
+            }
+            CSVSQLDB_THROW(csvsqldb::Exception, "type not allowed " << typeToString(type));
+        }
+
+        Value* createValueFromVariant(const Variant& value)
+        {
+            if(value.isNull()) {
+                return createNullValue(value.getType());
+            }
+            switch(value.getType()) {
+                case INT:
+                    return ValueCreator<int64_t>::createValue(value.asInt());
+                case REAL:
+                    return ValueCreator<double>::createValue(value.asDouble());
+                case BOOLEAN:
+                    return ValueCreator<bool>::createValue(value.asBool());
+                case DATE:
+                    return ValueCreator<csvsqldb::Date>::createValue(value.asDate());
+                case TIME:
+                    return ValueCreator<csvsqldb::Time>::createValue(value.asTime());
+                case TIMESTAMP:
+                    return ValueCreator<csvsqldb::Timestamp>::createValue(value.asTimestamp());
+                case STRING:
+                    return ValueCreator<std::string>::createValue(std::string(value.asString()));
+                case NONE:
+                    break;
+            }
+            CSVSQLDB_THROW(csvsqldb::Exception, "type not allowed " << typeToString(value.getType()));
+        }
+
+        std::string unescapePartitionValue(const std::string& value)
+        {
+            // partition directories are written with the special characters of their values escaped as %XX
+            std::string unescaped;
+            for(size_t n = 0; n < value.length(); ++n) {
+                if(value[n] == '%' && n + 2 < value.length() && std::isxdigit(value[n + 1]) && std::isxdigit(value[n + 2])) {
+                    unescaped += static_cast<char>(std::stoi(value.substr(n + 1, 2), nullptr, 16));
+                    n += 2;
+                } else {
+                    unescaped += value[n];
+                }
+            }
+            return unescaped;
+        }
+
+        eOperationType mirrorComparison(eOperationType op)
+        {
+            switch(op) {
+                case OP_LT:
+                    return OP_GT;
+                case OP_LE:
+                    return OP_GE;
+                case OP_GT:
+                    return OP_LT;
+                case OP_GE:
+                    return OP_LE;
+                default:
+                    return op;
+            }
+        }
+    }
+
+
+    ColumnPredicate::ColumnPredicate(size_t column, eOperationType op, const ValuePtrs& values, const LikeMatcherPtr& like)
+    : _column(column)
+    , _op(op)
+    , _values(values)
+    , _like(like)
+    {
+        if(_op == OP_IN && _values[0]->getType() != REAL) {
+            // REAL values are compared with an epsilon, so equal values might have different hashes
+            for(const auto& element : _values) {
+                _valueSet.insert(element.get());
+            }
+        }
+    }
+
+    bool ColumnPredicate::matches(const Value& value) const
+    {
+        if(_op == OP_IS) {
+            return value.isNull();
+        } else if(_op == OP_ISNOT) {
+            return !value.isNull();
+        } else if(value.isNull()) {
+            return false;
+        }
+
+        switch(_op) {
+            case OP_EQ:
+                return value == *_values[0];
+            case OP_NEQ:
+                return !(value == *_values[0]);
+            case OP_LT:
+                return value < *_values[0];
+            case OP_LE:
+                return !(*_values[0] < value);
+            case OP_GT:
+                return *_values[0] < value;
+            case OP_GE:
+                return !(value < *_values[0]);
+            case OP_BETWEEN:
+                return !(value < *_values[0]) && !(*_values[1] < value);
+            case OP_IN:
+                if(!_valueSet.empty()) {
+                    return _valueSet.find(&value) != _valueSet.end();
+                }
+                return std::find_if(_values.begin(), _values.end(), [&value](const ValuePtr& element) { return value == *element; })
+                       != _values.end();
+            case OP_LIKE:
+                return _like->match(static_cast<const ValString&>(value).asString());
+            default:
+                break;
+        }
+        return true;
+    }
+
 
     ScanOperatorNode::ScanOperatorNode(const OperatorContext& context, const SymbolTablePtr& symbolTable, const SymbolInfo& tableInfo)
     : RowOperatorNode(context, symbolTable)
     , _tableData(_context._database.getTable(tableInfo._identifier))
     , _tableInfo(tableInfo)
+    , _rowLimit(std::numeric_limits<uint64_t>::max())
     {
         for(size_t n = 0; n < _tableData.columnCount(); ++n) {
+            _columns.push_back(n);
             _types.push_back(_tableData.getColumn(n)._type);
         }
     }
 
-    void ScanOperatorNode::getColumnInfos(SymbolInfos& outputSymbols)
+    void ScanOperatorNode::getColumnInfos(SymbolInfos& outputSymbols)
+    {
+        outputSymbols.clear();
+
+        for(const auto& n : _columns) {
+            if(getSymbolTable().hasSymbolNameForTable(_tableInfo._name, _tableData.getColumn(n)._name)) {
+                const SymbolInfoPtr& info = getSymbolTable().findSymbolNameForTable(_tableInfo._name, _tableData.getColumn(n)._name);
+                outputSymbols.push_back(info);
+            }
+        }
+    }
+
+    void ScanOperatorNode::setReferencedColumns(const StringSet& identifiers)
+    {
+        _columns.clear();
+        _types.clear();
+
+        for(size_t n = 0; n < _tableData.columnCount(); ++n) {
+            const TableData::Column& column = _tableData.getColumn(n);
+            if(identifiers.find(_tableInfo._name + "." + column._name) != identifiers.end()
+               || identifiers.find(column._name) != identifiers.end()) {
+                _columns.push_back(n);
+                _types.push_back(column._type);
+            }
+        }
+        const bool readsCsvColumn = std::any_of(
+          _columns.begin(), _columns.end(), [this](size_t n) { return !_tableData.getColumn(n)._partition; });
+        if(!readsCsvColumn) {
+            // a query like SELECT COUNT(*) still needs rows, so read at least the first column stored in the csv files
+            for(size_t n = 0; n < _tableData.columnCount(); ++n) {
+                if(!_tableData.getColumn(n)._partition) {
+                    auto iter = std::lower_bound(_columns.begin(), _columns.end(), n);
+                    _types.insert(_types.begin() + std::distance(_columns.begin(), iter), _tableData.getColumn(n)._type);
+                    _columns.insert(iter, n);
+                    break;
+                }
+            }
+        }
+    }
+
+    bool ScanOperatorNode::isColumnReferenced(size_t column) const
+    {
+        return std::find(_columns.begin(), _columns.end(), column) != _columns.end();
+    }
+
+    bool ScanOperatorNode::pushDownPredicates(const ASTExprNodePtr& condition)
+    {
+        Expressions conjunctions;
+        collectConjunctions(condition, conjunctions);
+
+        bool allPushed = true;
+        for(const auto& exp : conjunctions) {
+            allPushed = createPredicate(exp) && allPushed;
+        }
+        return allPushed;
+    }
+
+    void ScanOperatorNode::setRowLimit(uint64_t rowLimit)
+    {
+        _rowLimit = rowLimit;
+    }
+
+    bool ScanOperatorNode::findColumn(const ASTExprNodePtr& exp, size_t& column) const
+    {
+        ASTIdentifierPtr identifier = std::dynamic_pointer_cast<ASTIdentifier>(exp);
+        if(!identifier || !identifier->_info || identifier->_info->_symbolType != PLAIN) {
+            return false;
+        }
+        for(const auto& n : _columns) {
+            if(identifier->_info->_qualifiedIdentifier == _tableInfo._name + "." + _tableData.getColumn(n)._name) {
+                column = n;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool ScanOperatorNode::createConstant(const ASTExprNodePtr& exp, size_t column, ColumnPredicate::ValuePtr& value) const
+    {
+        Variant constant;
+        ASTValueNodePtr valueNode = std::dynamic_pointer_cast<ASTValueNode>(exp);
+        ASTUnaryNodePtr unaryNode = std::dynamic_pointer_cast<ASTUnaryNode>(exp);
+        if(valueNode) {
+            constant = typedValueToVariant(valueNode->_value);
+        } else if(unaryNode && (unaryNode->_op == OP_MINUS || unaryNode->_op == OP_PLUS)
+                  && std::dynamic_pointer_cast<ASTValueNode>(unaryNode->_rhs)) {
+            Variant operand = typedValueToVariant(std::dynamic_pointer_cast<ASTValueNode>(unaryNode->_rhs)->_value);
+            if(operand.isNull() || (operand.getType() != INT && operand.getType() != REAL)) {
+                return false;
+            }
+            constant = unaryOperation(unaryNode->_op, operand.getType(), operand);
+        } else {
+            return false;
+        }
+
+        eType columnType = _tableData.getColumn(column)._type;
+        if(constant.isNull()) {
+            return false;
+        } else if(constant.getType() == INT && columnType == REAL) {
+            constant = unaryOperation(OP_CAST, REAL, constant);
+        } else if(constant.getType() != columnType) {
+            // leave comparisons with implicit casts to the select operator
+            return false;
+        }
+        value.reset(createValueFromVariant(constant));
+        return true;
+    }
+
+    bool ScanOperatorNode::createPredicate(const ASTExprNodePtr& exp)
+    {
+        size_t column = 0;
+        ColumnPredicate::ValuePtrs values(1);
+
+        ASTBinaryNodePtr binaryNode = std::dynamic_pointer_cast<ASTBinaryNode>(exp);
+        if(binaryNode) {
+            switch(binaryNode->_op) {
+                case OP_IS:
+                case OP_ISNOT: {
+                    ASTValueNodePtr valueNode = std::dynamic_pointer_cast<ASTValueNode>(binaryNode->_rhs);
+                    if(!valueNode || !typedValueToVariant(valueNode->_value).isNull() || !findColumn(binaryNode->_lhs, column)) {
+                        return false;
+                    }
+                    _predicates.push_back(ColumnPredicate(column, binaryNode->_op, ColumnPredicate::ValuePtrs()));
+                    return true;
+                }
+                case OP_EQ:
+                case OP_NEQ:
+                case OP_LT:
+                case OP_LE:
+                case OP_GT:
+                case OP_GE:
+                    if(findColumn(binaryNode->_lhs, column) && createConstant(binaryNode->_rhs, column, values[0])) {
+                        _predicates.push_back(ColumnPredicate(column, binaryNode->_op, values));
+                        return true;
+                    } else if(findColumn(binaryNode->_rhs, column) && createConstant(binaryNode->_lhs, column, values[0])) {
+                        _predicates.push_back(ColumnPredicate(column, mirrorComparison(binaryNode->_op), values));
+                        return true;
+                    }
+                    return false;
+                default:
+                    return false;
+            }
+        }
+
+        ASTBetweenNodePtr betweenNode = std::dynamic_pointer_cast<ASTBetweenNode>(exp);
+        if(betweenNode) {
+            values.resize(2);
+            if(!findColumn(betweenNode->_lhs, column) || !createConstant(betweenNode->_from, column, values[0])
+               || !createConstant(betweenNode->_to, column, values[1])) {
+                return false;
+            }
+            if(*values[1] < *values[0]) {
+                // BETWEEN is symmetric
+                std::swap(values[0], values[1]);
+            }
+            _predicates.push_back(ColumnPredicate(column, OP_BETWEEN, values));
+            return true;
+        }
+
+        ASTInNodePtr inNode = std::dynamic_pointer_cast<ASTInNode>(exp);
+        if(inNode) {
+            if(!findColumn(inNode->_lhs, column)) {
+                return false;
+            }
+            values.resize(inNode->_expressions.size());
+            for(size_t n = 0; n < inNode->_expressions.size(); ++n) {
+                if(!createConstant(inNode->_expressions[n], column, values[n])) {
+                    return false;
+                }
+            }
+            _predicates.push_back(ColumnPredicate(column, OP_IN, values));
+            return true;
+        }
+
+        ASTLikeNodePtr likeNode = std::dynamic_pointer_cast<ASTLikeNode>(exp);
+        if(likeNode) {
+            if(!findColumn(likeNode->_lhs, column) || _tableData.getColumn(column)._type != STRING) {
+                return false;
+            }
+            _predicates.push_back(
+            ColumnPredicate(column, OP_LIKE, ColumnPredicate::ValuePtrs(), std::make_shared<LikeMatcher>(likeNode->_like)));
+            return true;
+        }
+
+        return false;
+    }
+
+
+    SystemTableScanOperatorNode::SystemTableScanOperatorNode(const OperatorContext& context, const SymbolTablePtr& symbolTable, const SymbolInfo& tableInfo)
+    : ScanOperatorNode(context, symbolTable, tableInfo)
+    , _currentBlock(nullptr)
+    , _nextRow(0)
+    {
+        createRows();
+    }
+
+    void SystemTableScanOperatorNode::createRows()
+    {
+        const std::string& name = _tableData.name();
+        if(name == "SYSTEM_DUAL") {
+            _rows.push_back({ Variant(false) });
+        } else if(name == "SYSTEM_STATISTICS") {
+            for(size_t n = 0; n < metrics::COUNTER_COUNT; ++n) {
+                const metrics::eCounter counter = static_cast<metrics::eCounter>(n);
+                _rows.push_back(
+                { Variant(metrics::Metrics::name(counter)), Variant(static_cast<int64_t>(metrics::Metrics::value(counter))) });
+            }
+            for(size_t n = 0; n < metrics::HISTOGRAM_COUNT; ++n) {
+                const metrics::eHistogram histogram = static_cast<metrics::eHistogram>(n);
+                const metrics::HistogramSnapshot snapshot = metrics::Metrics::snapshot(histogram);
+                const std::string prefix = metrics::Metrics::name(histogram);
+                _rows.push_back({ Variant(prefix + "_count"), Variant(static_cast<int64_t>(snapshot._count)) });
+                _rows.push_back({ Variant(prefix + "_sum"), Variant(static_cast<int64_t>(snapshot._sum)) });
+                _rows.push_back({ Variant(prefix + "_max"), Variant(static_cast<int64_t>(snapshot._max)) });
+                _rows.push_back({ Variant(prefix + "_p50"), Variant(static_cast<int64_t>(snapshot.percentile(0.5))) });
+                _rows.push_back({ Variant(prefix + "_p95"), Variant(static_cast<int64_t>(snapshot.percentile(0.95))) });
+                _rows.push_back({ Variant(prefix + "_p99"), Variant(static_cast<int64_t>(snapshot.percentile(0.99))) });
+            }
+        } else if(name == "SYSTEM_QUERIES") {
+            for(const auto& query : metrics::QueryLog::queries()) {
+                _rows.push_back({ Variant(static_cast<int64_t>(query._id)),
+                                  Variant(query._statement),
+                                  Variant(query._start),
+                                  Variant(static_cast<int64_t>(query._duration)),
+                                  Variant(query._rows),
+                                  Variant(query._success),
+                                  query._success ? Variant(STRING) : Variant(query._error) });
+            }
+        } else {
+            CSVSQLDB_THROW(csvsqldb::Exception, "unknown system table '" << name << "'");
+        }
+    }
+
+    void SystemTableScanOperatorNode::dump(std::ostream& stream) const
+    {
+        stream << "SystemTableScanOperatorNode(" << _tableInfo._identifier << ")\n";
+    }
+
+    uint64_t SystemTableScanOperatorNode::estimateRowCount()
+    {
+        return _rows.size();
+    }
+
+    const Values* SystemTableScanOperatorNode::getNextRow()
+    {
+        if(!_iterator) {
+            _iterator = std::make_shared<BlockIterator>(_types, *this, _context._blockManager);
+        }
+        return _iterator->getNextRow();
+    }
+
+    BlockPtr SystemTableScanOperatorNode::getNextBlock()
+    {
+        if(!_currentBlock) {
+            _currentBlock = _context._blockManager.createBlock();
+        }
+        BlockPtr previousBlock = nullptr;
+
+        while(!previousBlock && _nextRow < _rows.size()) {
+            for(const auto& value : _rows[_nextRow]) {
+                if(!_currentBlock->addValue(value)) {
+                    _currentBlock->markNextBlock();
+                    previousBlock = _currentBlock;
+                    _currentBlock = _context._blockManager.createBlock();
+                    _currentBlock->addValue(value);
+                }
+            }
+            _currentBlock->nextRow();
+            ++_nextRow;
+        }
+        if(previousBlock) {
+            return previousBlock;
+        }
+        _currentBlock->endBlocks();
+
+        return _currentBlock;
+    }
+
+
+    TableScanOperatorNode::TableScanOperatorNode(const OperatorContext& context, const SymbolTablePtr& symbolTable, const SymbolInfo& tableInfo)
+    : ScanOperatorNode(context, symbolTable, tableInfo)
+    , _estimatedRowCount(_unknownRowCount)
+    , _tableFilesListed(false)
+    , _nextFile(0)
+    {
+    }
+
+    TableScanOperatorNode::~TableScanOperatorNode()
+    {
+        // the read threads have to be stopped before the queue and the scan they take the files from are destroyed
+        for(auto& blockReader : _blockReaders) {
+            blockReader->cancel();
+        }
+    }
+
+    const Values* TableScanOperatorNode::getNextRow()
+    {
+        if(!_queue) {
+            initializeBlockReaders();
+        }
+
+        return _iterator->getNextRow();
+    }
+
+
+    BlockQueue::BlockQueue(BlockManager& blockManager, size_t maxQueuedBlocks, size_t producers)
+    : _blockManager(blockManager)
+    , _maxQueuedBlocks(std::max(maxQueuedBlocks, size_t(1)))
+    , _readers(producers)
+    , _producers(producers)
+    , _rows(0)
+    , _continue(true)
+    {
+    }
+
+    BlockQueue::~BlockQueue()
     {
-        outputSymbols.clear();
-
-        for(size_t n = 0; n < _tableData.columnCount(); ++n) {
-            if(getSymbolTable().hasSymbolNameForTable(_tableInfo._name, _tableData.getColumn(n)._name)) {
-                const SymbolInfoPtr& info = getSymbolTable().findSymbolNameForTable(_tableInfo._name, _tableData.getColumn(n)._name);
-                outputSymbols.push_back(info);
-            }
-        }
+        releaseBlocks();
     }
 
-
-    SystemTableScanOperatorNode::SystemTableScanOperatorNode(const OperatorContext& context, const SymbolTablePtr& symbolTable, const SymbolInfo& tableInfo)
-    : ScanOperatorNode(context, symbolTable, tableInfo)
-    , _currentBlock(nullptr)
+    bool BlockQueue::push(BlockPtr block)
     {
+        std::unique_lock<std::mutex> lk(_queueMutex);
+        _spaceCv.wait(lk, [this] { return _blocks.size() < _maxQueuedBlocks || !_continue; });
+        if(!_continue) {
+            return false;
+        }
+        _blocks.push(block);
+        _cv.notify_all();
+        return true;
     }
 
-    void SystemTableScanOperatorNode::dump(std::ostream& stream) const
+    void BlockQueue::finish(BlockPtr block)
     {
-        stream << "SystemTableScanOperatorNode(" << _tableInfo._identifier << ")\n";
+        {
+            std::unique_lock<std::mutex> lk(_queueMutex);
+            --_producers;
+            if(_producers) {
+                block->continueBlocks();
+            }
+            _blocks.push(block);
+        }
+        _cv.notify_all();
     }
 
-    const Values* SystemTableScanOperatorNode::getNextRow()
+    void BlockQueue::fail(const std::exception_ptr& error)
     {
-        if(!_currentBlock) {
-            _iterator = std::make_shared<BlockIterator>(_types, *this, _context._blockManager);
+        {
+            std::unique_lock<std::mutex> lk(_queueMutex);
+            --_producers;
+            if(!_error) {
+                _error = error;
+            }
         }
-        return _iterator->getNextRow();
+        _cv.notify_all();
     }
 
-    BlockPtr SystemTableScanOperatorNode::getNextBlock()
+    BlockPtr BlockQueue::pop()
     {
-        _currentBlock = _context._blockManager.createBlock();
+        CSVSQLDB_TRACE_SCOPE("scan", "consume block");
+        std::unique_lock<std::mutex> lk(_queueMutex);
+        _cv.wait(lk, [this] { return !_blocks.empty() || !_producers || _error; });
+        if(_error) {
+            std::rethrow_exception(_error);
+        }
 
-        _currentBlock->addValue(Variant(false));
-        _currentBlock->nextRow();
-        _currentBlock->endBlocks();
+        BlockPtr block = nullptr;
+        if(!_blocks.empty()) {
+            block = _blocks.front();
+            _blocks.pop();
+        }
+        lk.unlock();
+        _spaceCv.notify_one();
 
-        return _currentBlock;
+        return block;
     }
 
-
-    TableScanOperatorNode::TableScanOperatorNode(const OperatorContext& context, const SymbolTablePtr& symbolTable, const SymbolInfo& tableInfo)
-    : ScanOperatorNode(context, symbolTable, tableInfo)
-    , _blockReader(_context._blockManager)
+    void BlockQueue::cancel()
     {
+        {
+            std::unique_lock<std::mutex> lk(_queueMutex);
+            _continue = false;
+        }
+        _spaceCv.notify_all();
+        releaseBlocks();
     }
 
-    const Values* TableScanOperatorNode::getNextRow()
+    void BlockQueue::releaseBlocks()
     {
-        if(!_blockReader.valid()) {
-            initializeBlockReader();
+        std::unique_lock<std::mutex> lk(_queueMutex);
+        while(!_blocks.empty()) {
+            _blockManager.release(_blocks.front());
+            _blocks.pop();
         }
-
-        return _iterator->getNextRow();
     }
 
 
-    BlockReader::BlockReader(BlockManager& blockManager)
-    : _blockManager(blockManager)
+    BlockReader::BlockReader(BlockManager& blockManager, BlockQueue& queue)
+    : _nextPartitionValue(0)
+    , _blockManager(blockManager)
+    , _queue(queue)
     , _block(_blockManager.createBlock())
-    , _continue(true)
+    , _valuesInRow(0)
+    , _rowStart(0)
+    , _rejected(false)
+    , _rowLimit(std::numeric_limits<uint64_t>::max())
+    , _rowCount(0)
+    , _publishedRows(0)
+    , _keepRowsInBlock(queue.readers() > 1)
+    , _blockStart(0)
     {
     }
 
     BlockReader::~BlockReader()
     {
-        _continue = false;
+        cancel();
+    }
+
+    void BlockReader::cancel()
+    {
+        _queue.cancel();
         if(_readThread.joinable()) {
             _readThread.join();
         }
+        _blockManager.release(_block);
     }
 
-    void BlockReader::initialize(CSVParserPtr csvparser)
+    void BlockReader::initialize(const ParserFactory& parserFactory)
     {
-        _csvparser = csvparser;
+        _parserFactory = parserFactory;
         _readThread = std::thread(std::bind(&BlockReader::readBlocks, this));
     }
 
-    BlockPtr BlockReader::getNextBlock()
+    void BlockReader::setPredicates(const ColumnPredicates& predicates, const IndexVector& columns)
     {
-        std::unique_lock<std::mutex> lk(_queueMutex);
-        if(_blocks.empty() && !_block) {
-            return nullptr;
+        _predicates = predicates;
+        _columnPredicates.clear();
+        if(_predicates.empty()) {
+            return;
         }
-        _cv.wait(lk, [this] { return !_blocks.empty(); });
-
-        BlockPtr block = nullptr;
-        if(!_blocks.empty()) {
-            block = _blocks.front();
-            _blocks.pop();
+        _keepRowsInBlock = true;
+        _columnPredicates.resize(columns.size());
+        for(const auto& predicate : _predicates) {
+            auto iter = std::find(columns.begin(), columns.end(), predicate.column());
+            if(iter == columns.end()) {
+                CSVSQLDB_THROW(csvsqldb::Exception, "predicate column " << predicate.column() << " is not read");
+            }
+            _columnPredicates[std::distance(columns.begin(), iter)].push_back(&predicate);
         }
-
-        return block;
     }
 
     void BlockReader::readBlocks()
     {
+        CSVSQLDB_TRACE_THREAD_NAME("block reader");
+        const int64_t cpuStart = chrono::ThreadCpuClock::now();
+        CSVSQLDB_TRACE_START(_blockStart);
+        uint64_t lines = 0;
+        try {
+            while(!_queue.cancelled() && !rowLimitReached()) {
+                _csvparser = _parserFactory(*this, _stream, _partitionValues);
+                if(!_csvparser) {
+                    break;
+                }
+                _nextPartitionValue = 0;
+                lines += readFile();
+                _csvparser.reset();
+                _stream.reset();
+            }
+        } catch(const std::exception&) {
+            metrics::Metrics::add(metrics::LINES_PARSED, lines);
+            _queue.fail(std::current_exception());
+            return;
+        }
+        metrics::Metrics::add(metrics::LINES_PARSED, lines);
+        metrics::Metrics::add(metrics::READER_CPU_TIME, static_cast<uint64_t>(chrono::ThreadCpuClock::now() - cpuStart));
+        CSVSQLDB_TRACE_END("scan", "produce block", _blockStart);
+        _block->endBlocks();
+        _queue.finish(_block);
+        _block = nullptr;
+    }
+
+    uint64_t BlockReader::readFile()
+    {
+        CSVSQLDB_TRACE_SCOPE("scan", "read file");
         bool moreLines = _csvparser->parseLine();
-        _block->nextRow();
+        endRow();
+        uint64_t lines = 1;
 
-        while(_continue && moreLines) {
+        while(!_queue.cancelled() && moreLines && !rowLimitReached()) {
             moreLines = _csvparser->parseLine();
-            _block->nextRow();
+            endRow();
+            ++lines;
         }
+        return lines;
+    }
+
+    bool BlockReader::rowLimitReached() const
+    {
+        return _queue.rows() + (_rowCount - _publishedRows) >= _rowLimit;
+    }
+
+    void BlockReader::nextBlock()
+    {
+        CSVSQLDB_TRACE_END("scan", "produce block", _blockStart);
+        if(_queue.cancelled()) {
+            dropLine();
+            return;
+        }
+        BlockPtr block = _blockManager.createBlock();
+        if(_keepRowsInBlock) {
+            // a row that might still be rejected or that is interleaved with the rows of other readers has to be kept in
+            // one block, so move the values read so far
+            for(auto& value : _rowValues) {
+                value = block->addValue(*value);
+                if(!value) {
+                    CSVSQLDB_THROW(csvsqldb::Exception, "row does not fit into a block");
+                }
+            }
+            _block->reset();
+            _block->moveOffset(_rowStart);
+            _rowStart = 0;
+        }
+        _block->markNextBlock();
+        _queue.addRows(_rowCount - _publishedRows);
+        _publishedRows = _rowCount;
+        bool pushed = false;
         {
-            std::unique_lock<std::mutex> lk(_queueMutex);
-            _block->endBlocks();
-            _blocks.push(_block);
-            _block = nullptr;
+            CSVSQLDB_TRACE_SCOPE("scan", "wait for queue space");
+            pushed = _queue.push(_block);
+        }
+        if(!pushed) {
+            _blockManager.release(block);
+            dropLine();
+            return;
+        }
+        _block = block;
+        CSVSQLDB_TRACE_START(_blockStart);
+    }
+
+    void BlockReader::dropLine()
+    {
+        // nobody is interested in the rest of the files, so drop the current line and reuse the block
+        _csvparser->rejectLine();
+        _rejected = true;
+        _rowValues.clear();
+        _rowStart = 0;
+        _block->reset();
+    }
+
+    void BlockReader::endRow()
+    {
+        if(!_valuesInRow) {
+            // nothing was parsed, e.g. the end of a file only containing the header line
+            return;
+        }
+        if(!_rejected) {
+            addPartitionValues();
+        }
+        _valuesInRow = 0;
+        _nextPartitionValue = 0;
+        if(!_keepRowsInBlock) {
+            _block->nextRow();
+            ++_rowCount;
+            return;
+        }
+        if(_rejected) {
+            _block->reset();
+            _block->moveOffset(_rowStart);
+            _rejected = false;
+        } else {
+            _block->nextRow();
+            ++_rowCount;
+        }
+        _rowStart = _block->offset();
+        _rowValues.clear();
+    }
+
+    void BlockReader::addPartitionValues()
+    {
+        while(_nextPartitionValue < _partitionValues.size() && _partitionValues[_nextPartitionValue]._position == _valuesInRow) {
+            const Value& partitionValue = *_partitionValues[_nextPartitionValue++]._value;
+            Value* value = _block->addValue(partitionValue);
+            if(!value) {
+                nextBlock();
+                value = _block->addValue(partitionValue);
+            }
+            checkValue(value);
         }
-        _cv.notify_all();
+    }
+
+    void BlockReader::checkValue(const Value* value)
+    {
+        ++_valuesInRow;
+        if(!_keepRowsInBlock) {
+            return;
+        }
+        if(!value) {
+            CSVSQLDB_THROW(csvsqldb::Exception, "value does not fit into a block");
+        }
+        if(!_columnPredicates.empty()) {
+            for(const auto& predicate : _columnPredicates[_rowValues.size()]) {
+                if(!predicate->matches(*value)) {
+                    _rejected = true;
+                    _csvparser->rejectLine();
+                    break;
+                }
+            }
+        }
+        _rowValues.push_back(value);
     }
 
     void BlockReader::onLong(int64_t num, bool isNull)
     {
-        if(!_block->addInt(num, isNull)) {
-            std::unique_lock<std::mutex> lk(_queueMutex);
-            _block->markNextBlock();
-            _blocks.push(_block);
-            _cv.notify_all();
-            _block = _blockManager.createBlock();
-            _block->addInt(num, isNull);
+        addPartitionValues();
+        Value* value = _block->addInt(num, isNull);
+        if(!value) {
+            nextBlock();
+            value = _block->addInt(num, isNull);
         }
+        checkValue(value);
     }
 
     void BlockReader::onDouble(double num, bool isNull)
     {
-        if(!_block->addReal(num, isNull)) {
-            std::unique_lock<std::mutex> lk(_queueMutex);
-            _block->markNextBlock();
-            _blocks.push(_block);
-            _cv.notify_all();
-            _block = _blockManager.createBlock();
-            _block->addReal(num, isNull);
+        addPartitionValues();
+        Value* value = _block->addReal(num, isNull);
+        if(!value) {
+            nextBlock();
+            value = _block->addReal(num, isNull);
         }
+        checkValue(value);
     }
 
     void BlockReader::onString(const char* s, size_t len, bool isNull)
     {
-        if(!_block->addString(s, len, isNull)) {
-            std::unique_lock<std::mutex> lk(_queueMutex);
-            _block->markNextBlock();
-            _blocks.push(_block);
-            _cv.notify_all();
-            _block = _blockManager.createBlock();
-            _block->addString(s, len, isNull);
+        addPartitionValues();
+        Value* value = _block->addString(s, len, isNull);
+        if(!value) {
+            nextBlock();
+            value = _block->addString(s, len, isNull);
         }
+        checkValue(value);
     }
 
     void BlockReader::onDate(const csvsqldb::Date& date, bool isNull)
     {
-        if(!_block->addDate(date, isNull)) {
-            std::unique_lock<std::mutex> lk(_queueMutex);
-            _block->markNextBlock();
-            _blocks.push(_block);
-            _cv.notify_all();
-            _block = _blockManager.createBlock();
-            _block->addDate(date, isNull);
+        addPartitionValues();
+        Value* value = _block->addDate(date, isNull);
+        if(!value) {
+            nextBlock();
+            value = _block->addDate(date, isNull);
         }
+        checkValue(value);
     }
 
     void BlockReader::onTime(const csvsqldb::Time& time, bool isNull)
     {
-        if(!_block->addTime(time, isNull)) {
-            std::unique_lock<std::mutex> lk(_queueMutex);
-            _block->markNextBlock();
-            _blocks.push(_block);
-            _cv.notify_all();
-            _block = _blockManager.createBlock();
-            _block->addTime(time, isNull);
+        addPartitionValues();
+        Value* value = _block->addTime(time, isNull);
+        if(!value) {
+            nextBlock();
+            value = _block->addTime(time, isNull);
         }
+        checkValue(value);
     }
 
     void BlockReader::onTimestamp(const csvsqldb::Timestamp& timestamp, bool isNull)
     {
-        if(!_block->addTimestamp(timestamp, isNull)) {
-            std::unique_lock<std::mutex> lk(_queueMutex);
-            _block->markNextBlock();
-            _blocks.push(_block);
-            _cv.notify_all();
-            _block = _blockManager.createBlock();
-            _block->addTimestamp(timestamp, isNull);
+        addPartitionValues();
+        Value* value = _block->addTimestamp(timestamp, isNull);
+        if(!value) {
+            nextBlock();
+            value = _block->addTimestamp(timestamp, isNull);
         }
+        checkValue(value);
     }
 
     void BlockReader::onBoolean(bool boolean, bool isNull)
     {
-        if(!_block->addBool(boolean, isNull)) {
-            std::unique_lock<std::mutex> lk(_queueMutex);
-            _block->markNextBlock();
-            _blocks.push(_block);
-            _cv.notify_all();
-            _block = _blockManager.createBlock();
-            _block->addBool(boolean, isNull);
+        addPartitionValues();
+        Value* value = _block->addBool(boolean, isNull);
+        if(!value) {
+            nextBlock();
+            value = _block->addBool(boolean, isNull);
         }
+        checkValue(value);
     }
 
 
     BlockPtr TableScanOperatorNode::getNextBlock()
     {
-        return _blockReader.getNextBlock();
+        return _queue->pop();
     }
 
-    void TableScanOperatorNode::initializeBlockReader()
+    void TableScanOperatorNode::initializeBlockReaders()
     {
         _iterator = std::make_shared<BlockIterator>(_types, *this, getBlockManager());
 
-        csvsqldb::csv::Types types;
-        for(auto& type : _types) {
-            switch(type) {
+        csvsqldb::csv::Types& types = _csvTypes;
+        for(size_t n = 0; n < _tableData.columnCount(); ++n) {
+            if(_tableData.getColumn(n)._partition) {
+                // partition columns are not stored in the csv files
+                continue;
+            }
+            if(!isColumnReferenced(n)) {
+                // unreferenced columns are only read over by the parser and never stored in a block
+                types.push_back(csvsqldb::csv::SKIP);
+                continue;
+            }
+            switch(_tableData.getColumn(n)._type) {
                 case INT:
                     types.push_back(csvsqldb::csv::LONG);
                     break;
@@ -1460,38 +3145,367 @@ namespace csvsqldb
             }
         }
 
+        Mapping mapping = _context._database.getMappingForTable(_tableInfo._identifier);
+        if(getTableFiles().empty()) {
+            CSVSQLDB_THROW(MappingException, "no file found for mapping '" << R"(.*)" + mapping._mapping << "'");
+        }
+
+        _csvContext._skipFirstLine = true;
+        _csvContext._delimiter = mapping._delimiter;
+
+        const size_t maxReaders = std::max(_context._maxParallelScans, uint16_t(1));
+        const size_t readers = std::min(_tableFiles.size(), maxReaders);
+        _queue.reset(new BlockQueue(_context._blockManager, _queuedBlocksPerReader * readers, readers));
+        for(size_t n = 0; n < readers; ++n) {
+            _blockReaders.push_back(BlockReaderPtr(new BlockReader(_context._blockManager, *_queue)));
+            _blockReaders.back()->setPredicates(_predicates, _columns);
+            _blockReaders.back()->setRowLimit(_rowLimit);
+        }
+        auto parserFactory = std::bind(
+          &TableScanOperatorNode::openNextFile, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3);
+        for(auto& blockReader : _blockReaders) {
+            blockReader->initialize(parserFactory);
+        }
+    }
+
+    BlockReader::CSVParserPtr TableScanOperatorNode::openNextFile(csvsqldb::csv::CSVParserCallback& callback,
+                                                                  BlockReader::IStreamPtr& stream,
+                                                                  PartitionValues& partitionValues)
+    {
+        const size_t file = _nextFile.fetch_add(1);
+        if(file >= _tableFiles.size()) {
+            return BlockReader::CSVParserPtr();
+        }
+        partitionValues = getPartitionValues(_tableFiles[file]);
+        stream = std::make_shared<ReadAheadStream>(_tableFiles[file], _context._readAhead);
+        return std::make_shared<csvsqldb::csv::CSVParser>(_csvContext, *stream, _csvTypes, callback);
+    }
+
+    StringVector TableScanOperatorNode::findTableFiles() const
+    {
         Mapping mapping = _context._database.getMappingForTable(_tableInfo._identifier);
         std::string filePattern = mapping._mapping;
         filePattern = R"(.*)" + filePattern;
         boost::regex r(filePattern);
 
-        fs::path pathToCsvFile("");
-
+        StringVector files;
         for(const auto& file : _context._files) {
             boost::smatch match;
-            if(regex_match(file, match, r)) {
-                pathToCsvFile = file;
-                break;
+            if(fs::is_directory(file)) {
+                StringVector containedFiles;
+                for(fs::recursive_directory_iterator iter(file), end; iter != end; ++iter) {
+                    const std::string path = iter->path().string();
+                    if(fs::is_directory(iter->status())) {
+                        if(isPrunedPartition(iter->path().filename().string())) {
+                            // do not even list the files of partitions the predicates exclude
+                            iter.no_push();
+                        }
+                    } else if(fs::is_regular_file(iter->status()) && regex_match(path, match, r) && !isPrunedFile(path)) {
+                        containedFiles.push_back(path);
+                    }
+                }
+                std::sort(containedFiles.begin(), containedFiles.end());
+                files.insert(files.end(), containedFiles.begin(), containedFiles.end());
+            } else if(regex_match(file, match, r) && !isPrunedFile(file)) {
+                files.push_back(file);
+            }
+        }
+
+        // a file given on the command line and also contained in a given directory must not be scanned twice
+        StringVector uniqueFiles;
+        std::set<std::string> canonicalPaths;
+        for(const auto& file : files) {
+            boost::system::error_code ec;
+            const fs::path path = fs::canonical(file, ec);
+            if(canonicalPaths.insert(ec ? file : path.string()).second) {
+                uniqueFiles.push_back(file);
+            }
+        }
+        return uniqueFiles;
+    }
+
+    bool
+    TableScanOperatorNode::parsePartition(const std::string& directory, size_t& column, ColumnPredicate::ValuePtr& value) const
+    {
+        const size_t pos = directory.find('=');
+        if(pos == std::string::npos) {
+            return false;
+        }
+        const std::string key = csvsqldb::toupper_copy(directory.substr(0, pos));
+        for(column = 0; column < _tableData.columnCount(); ++column) {
+            const TableData::Column& definition = _tableData.getColumn(column);
+            if(!definition._partition || csvsqldb::toupper_copy(definition._name) != key) {
+                continue;
+            }
+            const std::string partitionValue = unescapePartitionValue(directory.substr(pos + 1));
+            if(partitionValue == "__HIVE_DEFAULT_PARTITION__") {
+                value.reset(createNullValue(definition._type));
+                return true;
+            }
+            try {
+                const TypedValue typedValue = TypedValue::createValue(definition._type, partitionValue);
+                value.reset(createValueFromVariant(typedValueToVariant(typedValue)));
+            } catch(const std::exception&) {
+                CSVSQLDB_THROW(MappingException,
+                               "invalid value '" << partitionValue << "' for partition column " << definition._name << " in '"
+                                                 << directory << "'");
             }
+            return true;
         }
-        if(pathToCsvFile.string().empty()) {
-            CSVSQLDB_THROW(MappingException, "no file found for mapping '" << filePattern << "'");
+        return false;
+    }
+
+    bool TableScanOperatorNode::isPrunedPartition(const std::string& directory) const
+    {
+        size_t column = 0;
+        ColumnPredicate::ValuePtr value;
+        if(_predicates.empty() || !parsePartition(directory, column, value)) {
+            return false;
         }
+        return std::any_of(_predicates.begin(), _predicates.end(), [column, &value](const ColumnPredicate& predicate) {
+            return predicate.column() == column && !predicate.matches(*value);
+        });
+    }
 
-        _stream = std::make_shared<std::fstream>(pathToCsvFile.string());
-        if(!_stream || _stream->fail()) {
-            std::cerr << csvsqldb::errnoText() << std::endl;
-            CSVSQLDB_THROW(csvsqldb::FilesystemException, "could not open file '" << pathToCsvFile << "'");
+    bool TableScanOperatorNode::isPrunedFile(const std::string& path) const
+    {
+        if(_predicates.empty()) {
+            return false;
+        }
+        // also checks the NULL values of partition columns without a directory in the path
+        for(const auto& partitionValue : getPartitionValues(path)) {
+            for(const auto& predicate : _predicates) {
+                if(predicate.column() == _columns[partitionValue._position] && !predicate.matches(*partitionValue._value)) {
+                    return true;
+                }
+            }
         }
+        return false;
+    }
 
-        _csvContext._skipFirstLine = true;
-        _csvContext._delimiter = mapping._delimiter;
-        _csvparser = std::make_shared<csvsqldb::csv::CSVParser>(_csvContext, *_stream, types, _blockReader);
-        _blockReader.initialize(_csvparser);
+    PartitionValues TableScanOperatorNode::getPartitionValues(const std::string& path) const
+    {
+        PartitionValues partitionValues;
+        for(size_t n = 0; n < _columns.size(); ++n) {
+            const TableData::Column& definition = _tableData.getColumn(_columns[n]);
+            if(definition._partition) {
+                partitionValues.push_back({n, ColumnPredicate::ValuePtr(createNullValue(definition._type))});
+            }
+        }
+        if(partitionValues.empty()) {
+            return partitionValues;
+        }
+        for(const auto& directory : fs::path(path).parent_path()) {
+            size_t column = 0;
+            ColumnPredicate::ValuePtr value;
+            if(parsePartition(directory.string(), column, value)) {
+                for(auto& partitionValue : partitionValues) {
+                    if(_columns[partitionValue._position] == column) {
+                        partitionValue._value = value;
+                    }
+                }
+            }
+        }
+        return partitionValues;
     }
 
     void TableScanOperatorNode::dump(std::ostream& stream) const
     {
         stream << "TableScanOperator (" << _tableInfo._identifier << ")\n";
     }
+
+    uint64_t TableScanOperatorNode::estimateRowCount()
+    {
+        if(_estimatedRowCount == _unknownRowCount) {
+            try {
+                const StringVector& files = getTableFiles();
+                if(!files.empty()) {
+                    _estimatedRowCount = estimateFilesRowCount(files);
+                }
+            } catch(const MappingException&) {
+                // the scan itself will report the missing mapping
+            }
+        }
+        return _estimatedRowCount == _unknownRowCount ? _estimatedRowCount : std::min(_estimatedRowCount, _rowLimit);
+    }
+
+    const StringVector& TableScanOperatorNode::getTableFiles()
+    {
+        // the pushed down predicates prune the listed files, so this must not be called before they are pushed down
+        if(!_tableFilesListed) {
+            _tableFiles = findTableFiles();
+            _tableFilesListed = true;
+        }
+        return _tableFiles;
+    }
+
+    uint64_t TableScanOperatorNode::estimateFilesRowCount(const StringVector& files) const
+    {
+        // only a few files spread over the list are opened to sample the average row length, the row count is extrapolated
+        // from the size of all files
+        const size_t sampledFiles = files.size() < _estimationSampleFiles ? files.size() : _estimationSampleFiles;
+        uint64_t headerBytes = 0;
+        uint64_t sampledRows = 0;
+        uint64_t sampledBytes = 0;
+        bool complete = sampledFiles == files.size();
+        for(size_t n = 0; n < sampledFiles; ++n) {
+            const uint64_t rows = sampledRows;
+            if(!sampleFile(files[n * files.size() / sampledFiles], headerBytes, sampledRows, sampledBytes)) {
+                return _unknownRowCount;
+            }
+            complete = complete && sampledRows - rows < _estimationSampleSize;
+        }
+        if(complete || !sampledBytes) {
+            // all files were read completely
+            return sampledRows;
+        }
+
+        uint64_t totalBytes = 0;
+        for(const auto& file : files) {
+            boost::system::error_code ec;
+            const uint64_t fileSize = fs::file_size(file, ec);
+            if(ec) {
+                return _unknownRowCount;
+            }
+            totalBytes += fileSize;
+        }
+        const uint64_t totalHeaderBytes = headerBytes / sampledFiles * files.size();
+        if(totalBytes <= totalHeaderBytes) {
+            return sampledRows;
+        }
+        return (totalBytes - totalHeaderBytes) * sampledRows / sampledBytes;
+    }
+
+    bool TableScanOperatorNode::sampleFile(const std::string& pathToCsvFile, uint64_t& headerBytes, uint64_t& rows, uint64_t& rowBytes) const
+    {
+        std::ifstream stream(pathToCsvFile);
+        if(!stream) {
+            return false;
+        }
+        std::string line;
+        std::getline(stream, line);
+        headerBytes += line.size() + 1;
+
+        for(uint64_t sampledRows = 0; sampledRows < _estimationSampleSize && std::getline(stream, line); ++sampledRows) {
+            ++rows;
+            rowBytes += line.size() + 1;
+        }
+        return true;
+    }
+
+
+    AnalyzingOperatorNode::AnalyzingOperatorNode(const OperatorContext& context,
+                                                 const RowOperatorNodePtr& node,
+                                                 const AnalyzingOperatorNodes& inputs)
+    : RowOperatorNode(context, SymbolTable::createSymbolTable())
+    , _node(node)
+    , _inputs(inputs)
+    , _rows(0)
+    , _wallTime(0)
+    , _cpuTime(0)
+    {
+    }
+
+    const Values* AnalyzingOperatorNode::getNextRow()
+    {
+        const std::chrono::steady_clock::time_point wallStart = std::chrono::steady_clock::now();
+        const int64_t cpuStart = chrono::ThreadCpuClock::now();
+        const Values* row = _node->getNextRow();
+        _cpuTime += chrono::ThreadCpuClock::now() - cpuStart;
+        _wallTime += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - wallStart).count();
+        if(row) {
+            ++_rows;
+        }
+        return row;
+    }
+
+    bool AnalyzingOperatorNode::connect(const RowOperatorNodePtr& input)
+    {
+        return _node->connect(input);
+    }
+
+    void AnalyzingOperatorNode::getColumnInfos(SymbolInfos& outputSymbols)
+    {
+        _node->getColumnInfos(outputSymbols);
+    }
+
+    void AnalyzingOperatorNode::setOutputAlias(const std::string& alias)
+    {
+        _node->setOutputAlias(alias);
+    }
+
+    uint64_t AnalyzingOperatorNode::estimateRowCount()
+    {
+        return _node->estimateRowCount();
+    }
+
+    OperatorCounters AnalyzingOperatorNode::getCounters() const
+    {
+        return _node->getCounters();
+    }
+
+    uint64_t AnalyzingOperatorNode::getInputRowCount() const
+    {
+        uint64_t rows = 0;
+        for(const auto& input : _inputs) {
+            rows += input->getRowCount();
+        }
+        return rows;
+    }
+
+    int64_t AnalyzingOperatorNode::getSelfWallTime() const
+    {
+        int64_t time = _wallTime;
+        for(const auto& input : _inputs) {
+            time -= input->getWallTime();
+        }
+        // inputs read by other threads may overlap with the operator itself
+        return std::max(time, int64_t(0));
+    }
+
+    int64_t AnalyzingOperatorNode::getSelfCpuTime() const
+    {
+        int64_t time = _cpuTime;
+        for(const auto& input : _inputs) {
+            time -= input->getCpuTime();
+        }
+        return std::max(time, int64_t(0));
+    }
+
+    static void nanosecondsToStream(std::ostream& stream, int64_t nanoseconds)
+    {
+        stream << std::fixed << std::setprecision(3) << static_cast<double>(nanoseconds) / 1000000.0 << "ms";
+    }
+
+    void AnalyzingOperatorNode::dump(std::ostream& stream) const
+    {
+        std::stringstream measurements;
+        measurements << " [rows " << _rows;
+        if(!_inputs.empty()) {
+            measurements << ", input rows " << getInputRowCount();
+        }
+        measurements << ", wall ";
+        nanosecondsToStream(measurements, getSelfWallTime());
+        measurements << " self ";
+        nanosecondsToStream(measurements, _wallTime);
+        measurements << " total, cpu ";
+        nanosecondsToStream(measurements, getSelfCpuTime());
+        measurements << " self ";
+        nanosecondsToStream(measurements, _cpuTime);
+        measurements << " total";
+        const OperatorCounters counters = _node->getCounters();
+        if(counters._hashTableEntries) {
+            measurements << ", hash table entries " << counters._hashTableEntries;
+        }
+        if(counters._spilledRows) {
+            measurements << ", spilled " << counters._spilledRows << " rows " << counters._spilledBytes << " bytes";
+        }
+        measurements << "]";
+
+        std::stringstream ss;
+        _node->dump(ss);
+        std::string text = ss.str();
+        text.insert(std::min(text.find('\n'), text.size()), measurements.str());
+        stream << text;
+    }
 }
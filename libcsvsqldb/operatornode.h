@@ -39,19 +39,28 @@
 #include "block.h"
 #include "block_iterator.h"
 #include "file_mapping.h"
+#include "spill_file.h"
 #include "stack_machine.h"
 #include "visitor.h"
 
 #include "base/csv_parser.h"
+#include "base/like_matcher.h"
+#include "base/read_ahead.h"
 #include "base/tribool.h"
 #include "base/types.h"
 
 #include <algorithm>
+#include <atomic>
 #include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
 #include <istream>
+#include <limits>
 #include <mutex>
 #include <queue>
 #include <thread>
+#include <unordered_set>
 
 
 namespace csvsqldb
@@ -64,6 +73,10 @@ namespace csvsqldb
         , _blockManager(blockManager)
         , _files(files)
         , _showHeaderLine(true)
+        , _hashJoinBlockLimit(_defaultHashJoinBlockLimit)
+        , _threadPool(nullptr)
+        , _minRowsForJoinReordering(0)
+        , _maxParallelScans(_defaultMaxParallelScans)
         {
         }
 
@@ -72,6 +85,14 @@ namespace csvsqldb
         BlockManager& _blockManager;
         const csvsqldb::StringVector& _files;
         bool _showHeaderLine;
+        size_t _hashJoinBlockLimit;         //!< maximum number of blocks of a hash join build side before spilling to disk
+        ThreadPool* _threadPool;            //!< thread pool for parallel operators, nullptr to run single threaded
+        uint64_t _minRowsForJoinReordering; //!< joins are only reordered if an input is estimated to have this many rows
+        ReadAheadOptions _readAhead;        //!< how the table scans read the csv files
+        uint16_t _maxParallelScans;         //!< maximum number of files of one table read concurrently
+
+        static const size_t _defaultHashJoinBlockLimit = 250;
+        static const uint16_t _defaultMaxParallelScans = 4;
     };
 
 
@@ -84,6 +105,30 @@ namespace csvsqldb
     class RootOperatorNode;
     typedef std::shared_ptr<RootOperatorNode> RootOperatorNodePtr;
 
+    class ScanOperatorNode;
+    typedef std::shared_ptr<ScanOperatorNode> ScanOperatorNodePtr;
+
+    class AnalyzingOperatorNode;
+    typedef std::shared_ptr<AnalyzingOperatorNode> AnalyzingOperatorNodePtr;
+    typedef std::vector<AnalyzingOperatorNodePtr> AnalyzingOperatorNodes;
+
+
+    /**
+     * Counters about the work of an operator, which are reported by EXPLAIN ANALYZE.
+     */
+    struct CSVSQLDB_EXPORT OperatorCounters {
+        OperatorCounters()
+        : _hashTableEntries(0)
+        , _spilledRows(0)
+        , _spilledBytes(0)
+        {
+        }
+
+        uint64_t _hashTableEntries;  //!< number of entries of all hash tables the operator built
+        uint64_t _spilledRows;       //!< number of rows written to spill files
+        uint64_t _spilledBytes;      //!< number of bytes written to spill files
+    };
+
 
     class CSVSQLDB_EXPORT OperatorBaseNode
     {
@@ -152,6 +197,12 @@ namespace csvsqldb
             }
         }
 
+        /**
+         * Compiles the expression into a stack machine, whose variables are mapped to the columns of rows with the given
+         * symbols.
+         */
+        StackMachineType compileExpression(const ASTExprNodePtr& exp, const SymbolInfos& symbols);
+
         virtual void dump(std::ostream& stream) const = 0;
 
     protected:
@@ -168,11 +219,32 @@ namespace csvsqldb
     class CSVSQLDB_EXPORT RowOperatorNode : public OperatorBaseNode, public RowProvider
     {
     public:
+        /// returned by estimateRowCount(), if an operator cannot estimate the number of its rows
+        static const uint64_t _unknownRowCount = std::numeric_limits<uint64_t>::max();
+
         virtual void setOutputAlias(const std::string& alias)
         {
             _outputAlias = alias;
         }
 
+        /**
+         * Estimates the number of rows the operator will deliver. The estimate is used to choose the build side of hash joins
+         * and the order of joins. Has to be called after the inputs are connected.
+         * @return The estimated number of rows or _unknownRowCount
+         */
+        virtual uint64_t estimateRowCount()
+        {
+            return _unknownRowCount;
+        }
+
+        /**
+         * Returns the counters about the work the operator did so far.
+         */
+        virtual OperatorCounters getCounters() const
+        {
+            return OperatorCounters();
+        }
+
     protected:
         RowOperatorNode(const OperatorContext& context, const SymbolTablePtr& symbolTable)
         : OperatorBaseNode(context, symbolTable)
@@ -239,6 +311,11 @@ namespace csvsqldb
 
         virtual void dump(std::ostream& stream) const;
 
+        virtual uint64_t estimateRowCount();
+
+        /// Number of input rows needed to satisfy the limit including the skipped offset rows
+        uint64_t requiredInputRows() const;
+
     private:
         RowOperatorNodePtr _input;
         SymbolInfos _inputSymbols;
@@ -247,6 +324,38 @@ namespace csvsqldb
     };
 
 
+    /**
+     * Removes duplicate rows. Each row is passed on as soon as it is seen for the first time, so the operator does not
+     * block its consumer. Null values are treated as equal to each other.
+     */
+    class CSVSQLDB_EXPORT DistinctOperatorNode : public RowOperatorNode
+    {
+    public:
+        DistinctOperatorNode(const OperatorContext& context, const SymbolTablePtr& symbolTable);
+
+        virtual const Values* getNextRow();
+
+        virtual bool connect(const RowOperatorNodePtr& input);
+
+        virtual void getColumnInfos(SymbolInfos& outputSymbols);
+
+        virtual void dump(std::ostream& stream) const;
+
+        virtual uint64_t estimateRowCount();
+
+        virtual OperatorCounters getCounters() const;
+
+    private:
+        struct RowEqual {
+            bool operator()(const GroupingElement& lhs, const GroupingElement& rhs) const;
+        };
+        typedef std::unordered_set<GroupingElement, std::hash<GroupingElement>, RowEqual> RowSet;
+
+        RowOperatorNodePtr _input;
+        RowSet _rows;
+    };
+
+
     class CSVSQLDB_EXPORT SortOperatorNode : public RowOperatorNode
     {
     public:
@@ -260,6 +369,8 @@ namespace csvsqldb
 
         virtual void dump(std::ostream& stream) const;
 
+        virtual uint64_t estimateRowCount();
+
     private:
         Types _types;
         Values _row;
@@ -283,6 +394,10 @@ namespace csvsqldb
 
         virtual void dump(std::ostream& stream) const;
 
+        virtual uint64_t estimateRowCount();
+
+        virtual OperatorCounters getCounters() const;
+
     private:
         void addPathThrough(const ASTIdentifierPtr& ident, csvsqldb::IndexVector& groupingIndices, csvsqldb::IndexVector& outputColumns, bool suppress);
 
@@ -316,6 +431,8 @@ namespace csvsqldb
 
         virtual void dump(std::ostream& stream) const;
 
+        virtual uint64_t estimateRowCount();
+
     private:
         SymbolInfos _outputSymbols;
         const Expressions& _nodes;
@@ -346,8 +463,66 @@ namespace csvsqldb
 
         virtual void dump(std::ostream& stream) const;
 
+        virtual uint64_t estimateRowCount();
+
+        /**
+         * Stops reading input rows after the given number of rows. Only valid, if no operator between the projection and
+         * the limit drops rows.
+         * @param rowLimit The maximum number of rows to produce
+         */
+        void setRowLimit(uint64_t rowLimit);
+
     private:
+        struct BatchParameter {
+            size_t _input;     //!< index of the input column or npos for a constant
+            Variant _constant;
+            eType _cast;       //!< type the value has to be converted to or NONE
+        };
+
+        /**
+         * A function call of the select list, whose parameters are input columns or constants. It is not evaluated by a
+         * stack machine for each row, but with Function::callBatch for a batch of rows.
+         */
+        struct BatchCall {
+            Function::Ptr _function;
+            std::vector<BatchParameter> _parameters;
+            Function::Columns _columns;
+            Variants _results;
+        };
+
+        typedef std::vector<BatchCall> BatchCalls;
+
+        /**
+         * Hands out the blocks holding the rows of the current batch without the results of the batch calls.
+         */
+        struct BatchBlockProvider : public BlockProvider {
+            virtual BlockPtr getNextBlock();
+
+            Blocks _blocks;
+            size_t _next;
+        };
+
+        bool compileBatchCall(const ASTExprNodePtr& exp);
+        const Values* getNextInputRow();
         BlockPtr prepareNextBuffer();
+        BlockPtr prepareNextBatchBuffer();
+        BlockPtr addRow(const Values& row, BlockPtr& block);
+        bool readBatch();
+        void releaseBatchBlocks();
+        void addBatchParameters(BatchCall& call, const Values& row);
+
+        template <typename ValueType>
+        void addValue(BlockPtr& block, const ValueType& value, BlockPtr& previousBlock)
+        {
+            if(!block->addValue(value)) {
+                block->markNextBlock();
+                previousBlock = block;
+                block = _context._blockManager.createBlock();
+                block->addValue(value);
+            }
+        }
+
+        static const size_t _batchSize = 1024;
 
         SymbolInfos _inputSymbols;
         SymbolInfos _outputSymbols;
@@ -355,6 +530,17 @@ namespace csvsqldb
         BlockPtr _block;
         StackMachines _sms;
         OutputInputMapping _outputInputMapping;
+        BatchCalls _batchCalls;
+        OutputInputMapping _outputBatchCallMapping; //!< maps a select list expression to its batch call
+        IndexVector _columnBatchCalls;              //!< batch call of each output column or npos
+        Types _batchTypes;                          //!< types of the output columns, that are not batch call results
+        BatchBlockProvider _batchBlocks;
+        BlockIteratorPtr _batchIterator;
+        size_t _batchRowCount;
+        size_t _batchRow;                           //!< next row of the batch to add to the block
+        uint64_t _rowLimit;
+        uint64_t _inputRows;
+        bool _endOfInput;
         RowOperatorNodePtr _input;
         BlockIteratorPtr _iterator;
         Types _types;
@@ -374,6 +560,8 @@ namespace csvsqldb
 
         virtual void dump(std::ostream& stream) const;
 
+        virtual uint64_t estimateRowCount();
+
     protected:
         SymbolInfos _inputLhsSymbols;
         SymbolInfos _inputRhsSymbols;
@@ -407,11 +595,43 @@ namespace csvsqldb
     };
 
 
+    /**
+     * Appends the join key expressions, that are not plain columns of the input, as computed columns to the rows of a join
+     * input. Rows with a null key are skipped, as they will never match in an inner join.
+     */
+    class CSVSQLDB_EXPORT JoinKeyRowProvider : public RowProvider
+    {
+    public:
+        JoinKeyRowProvider(const OperatorContext& context,
+                           RowProvider& input,
+                           const OperatorBaseNode::StackMachines& keyMachines,
+                           const Types& keyTypes,
+                           const IndexVector& keyPositions);
+
+        virtual ~JoinKeyRowProvider();
+
+        virtual const Values* getNextRow();
+
+    private:
+        const OperatorContext& _context;
+        RowProvider& _input;
+        OperatorBaseNode::StackMachines _keyMachines;
+        Types _keyTypes;
+        IndexVector _keyPositions;
+        BlockPtr _block;
+        Values _row;
+    };
+
+    typedef std::shared_ptr<JoinKeyRowProvider> JoinKeyRowProviderPtr;
+
+
     class CSVSQLDB_EXPORT InnerHashJoinOperatorNode : public RowOperatorNode
     {
     public:
         InnerHashJoinOperatorNode(const OperatorContext& context, const SymbolTablePtr& symbolTable, const ASTExprNodePtr& exp);
 
+        virtual ~InnerHashJoinOperatorNode();
+
         virtual const Values* getNextRow();
 
         virtual bool connect(const RowOperatorNodePtr& input);
@@ -420,18 +640,156 @@ namespace csvsqldb
 
         virtual void dump(std::ostream& stream) const;
 
+        virtual uint64_t estimateRowCount();
+
+        virtual OperatorCounters getCounters() const;
+
+        /**
+         * Changes the order of the output columns. Used by the planner to restore the written column order after reordering
+         * joins. Has to be called after both inputs are connected.
+         * @param outputSymbols A permutation of the output symbols of the join
+         */
+        void setOutputOrder(const SymbolInfos& outputSymbols);
+
+        /**
+         * Checks if the join condition can be evaluated by a hash join. This is the case, if at least one of its AND
+         * connected terms is an equality between an expression over the left input columns and an expression over the right
+         * input columns, e.g. 'a.x = b.x' or 'a.id = b.id + 1'. All other terms are evaluated on the matching rows.
+         */
+        static bool hasHashKeys(const ASTExprNodePtr& exp, const SymbolInfos& lhsSymbols, const SymbolInfos& rhsSymbols);
+
     private:
-        SymbolInfos _inputLhsSymbols;
-        SymbolInfos _inputRhsSymbols;
+        struct JoinSide {
+            RowProvider& getInput()
+            {
+                return _keyInput ? static_cast<RowProvider&>(*_keyInput) : static_cast<RowProvider&>(*_input);
+            }
+
+            RowOperatorNodePtr _input;
+            SymbolInfos _symbols;
+            /// types of the input columns followed by the types of the computed key columns
+            Types _types;
+            IndexVector _keyPositions;
+            std::vector<size_t> _outputPositions;
+            JoinKeyRowProviderPtr _keyInput;
+        };
 
+        struct JoinPartition {
+            SpillFilePtr _probe;
+            SpillFilePtr _build;
+            size_t _level;
+        };
+        typedef std::deque<JoinPartition> JoinPartitions;
+
+        struct ProbeMorsel {
+            Blocks _blocks;
+            std::vector<Values> _rows;
+            std::vector<BlockPositions> _matches;
+            size_t _rowCount;
+            size_t _currentRow;
+            size_t _currentMatch;
+            bool _inputExhausted;
+        };
+
+        const Values* getNextParallelRow();
+        void copyToOutput(const JoinSide& side, const Values& values);
+        bool matchesResidual();
+        void setupKeys();
+        void chooseBuildSide();
+        bool buildNextHashTable();
+        void spillPartitions(RowProvider& buildInput, RowProvider& probeInput, size_t level);
+        bool fillProbeMorsel();
+        void probeMorselRows(size_t begin, size_t end);
+        void releaseProbeMorsel();
+
+        /// number of partitions each input is split into, if the build side does not fit into memory
+        static const size_t _partitionCount = 16;
+        /// maximum number of re-partitionings of a partition with skewed keys before building it without block limit
+        static const size_t _maxPartitionLevel = 3;
+        /// number of rows of the probe side that are looked up in parallel
+        static const size_t _probeMorselSize = 4096;
+
+        JoinSide _lhs;
+        JoinSide _rhs;
         Values _row;
-        const Values* _currentLhs;
-        HashingBlockIteratorPtr _rhsIterator;
+        const Values* _currentProbe;
+        HashingBlockIteratorPtr _buildIterator;
         SymbolInfos _outputSymbols;
-        RowOperatorNodePtr _lhsInput;
-        RowOperatorNodePtr _rhsInput;
         ASTExprNodePtr _exp;
-        size_t _hashTableKeyPosition;
+        JoinSide* _build;
+        JoinSide* _probe;
+        bool _buildStarted;
+        RowProvider* _probeInput;
+        JoinPartitions _partitions;
+        JoinPartition _currentPartition;
+        ProbeMorsel _morsel;
+        Values _buildRow;
+        HashKey _probeKey;
+        StackMachines _residuals;
+        OperatorCounters _counters;
+    };
+
+
+    /**
+     * Joins two inputs by sorting them on their join keys and merging them. It performs band joins like
+     * 'a.ts BETWEEN b.start AND b.end', where an expression over one input is bounded from below and above by expressions
+     * over the other input. Equi joins are performed by the InnerHashJoinOperatorNode. The rows of the bounded input are swept in key order, while the rows of the other input are
+     * kept as long as their range can still contain following keys.
+     */
+    class CSVSQLDB_EXPORT SortMergeJoinOperatorNode : public RowOperatorNode
+    {
+    public:
+        SortMergeJoinOperatorNode(const OperatorContext& context, const SymbolTablePtr& symbolTable, const ASTExprNodePtr& exp);
+
+        virtual const Values* getNextRow();
+
+        virtual bool connect(const RowOperatorNodePtr& input);
+
+        virtual void getColumnInfos(SymbolInfos& outputSymbols);
+
+        virtual void dump(std::ostream& stream) const;
+
+        virtual uint64_t estimateRowCount();
+
+        /**
+         * Checks if the join condition contains a range between both inputs, that can be used as merge key.
+         */
+        static bool hasMergeKeys(const ASTExprNodePtr& exp, const SymbolInfos& lhsSymbols, const SymbolInfos& rhsSymbols);
+
+    private:
+        struct MergeSide {
+            RowProvider& getInput()
+            {
+                return _keyInput ? static_cast<RowProvider&>(*_keyInput) : static_cast<RowProvider&>(*_input);
+            }
+
+            RowOperatorNodePtr _input;
+            SymbolInfos _symbols;
+            /// types of the input columns followed by the types of the computed key columns
+            Types _types;
+            IndexVector _keyPositions;
+            std::vector<size_t> _outputPositions;
+            JoinKeyRowProviderPtr _keyInput;
+            SortingBlockIteratorPtr _iterator;
+        };
+
+        void setupKeys();
+        void copyToOutput(const MergeSide& side, const Values& values);
+        bool nextPoint();
+
+        MergeSide _lhs;
+        MergeSide _rhs;
+        MergeSide* _points;
+        MergeSide* _ranges;
+        ASTExprNodePtr _exp;
+        StackMachineType _condition;
+        SymbolInfos _outputSymbols;
+        Values _row;
+        bool _initialized;
+        Values _currentPoint;
+        const Values* _nextRange;
+        std::vector<Values> _activeRanges;
+        size_t _currentRange;
     };
 
 
@@ -448,6 +806,8 @@ namespace csvsqldb
 
         virtual void dump(std::ostream& stream) const;
 
+        virtual uint64_t estimateRowCount();
+
     private:
         SymbolInfos _inputSymbols;
         RowOperatorNodePtr _currentInput;
@@ -469,6 +829,8 @@ namespace csvsqldb
 
         virtual void dump(std::ostream& stream) const;
 
+        virtual uint64_t estimateRowCount();
+
     private:
         SymbolInfos _inputSymbols;
         VariableStore _store;
@@ -480,6 +842,60 @@ namespace csvsqldb
     };
 
 
+    /**
+     * A simple predicate on a single table column, that can be checked as soon as the column value is read. Supports
+     * comparisons with a constant, IS [NOT] NULL, BETWEEN, IN and LIKE.
+     */
+    class CSVSQLDB_EXPORT ColumnPredicate
+    {
+    public:
+        typedef std::shared_ptr<const Value> ValuePtr;
+        typedef std::vector<ValuePtr> ValuePtrs;
+
+        typedef std::shared_ptr<const LikeMatcher> LikeMatcherPtr;
+
+        ColumnPredicate(size_t column, eOperationType op, const ValuePtrs& values, const LikeMatcherPtr& like = LikeMatcherPtr());
+
+        /**
+         * Returns the index of the table column the predicate is checked on.
+         */
+        size_t column() const
+        {
+            return _column;
+        }
+
+        /**
+         * Checks the predicate for the given column value. As in SQL, NULL values only match IS NULL.
+         * @param value The column value to check
+         * @return true if the value satisfies the predicate, otherwise false
+         */
+        bool matches(const Value& value) const;
+
+    private:
+        struct ValueHash {
+            size_t operator()(const Value* value) const
+            {
+                return value->getHash();
+            }
+        };
+        struct ValueEqual {
+            bool operator()(const Value* lhs, const Value* rhs) const
+            {
+                return *lhs == *rhs;
+            }
+        };
+        typedef std::unordered_set<const Value*, ValueHash, ValueEqual> ValueSet;
+
+        size_t _column;
+        eOperationType _op;
+        ValuePtrs _values;
+        ValueSet _valueSet;
+        LikeMatcherPtr _like;
+    };
+
+    typedef std::vector<ColumnPredicate> ColumnPredicates;
+
+
     class CSVSQLDB_EXPORT ScanOperatorNode : public RowOperatorNode
     {
     public:
@@ -490,15 +906,53 @@ namespace csvsqldb
             CSVSQLDB_THROW(csvsqldb::Exception, "connect not allowed");
         }
 
+        /**
+         * Restricts the scan to the table columns referenced by the query. A column is kept if its qualified or its
+         * plain name is contained in the identifiers. At least one column is always kept.
+         * @param identifiers The referenced column identifiers
+         */
+        void setReferencedColumns(const StringSet& identifiers);
+
+        /**
+         * Pushes the simple conjunctive terms of the condition that only refer to columns of this table into the scan.
+         * The scan can use them to reject rows early. As not all terms may be pushed, the condition has still to be
+         * evaluated on the scan output.
+         * @param condition The condition of the query
+         * @return true, if all terms of the condition were pushed into the scan
+         */
+        bool pushDownPredicates(const ASTExprNodePtr& condition);
+
+        /**
+         * Stops the scan after the given number of rows. Only valid, if no operator between the scan and the limit drops
+         * rows.
+         * @param rowLimit The maximum number of rows to produce
+         */
+        void setRowLimit(uint64_t rowLimit);
+
     protected:
         ScanOperatorNode(const OperatorContext& context, const SymbolTablePtr& symbolTable, const SymbolInfo& tableInfo);
 
+        bool isColumnReferenced(size_t column) const;
+        bool findColumn(const ASTExprNodePtr& exp, size_t& column) const;
+        bool createConstant(const ASTExprNodePtr& exp, size_t column, ColumnPredicate::ValuePtr& value) const;
+        bool createPredicate(const ASTExprNodePtr& exp);
+
+        IndexVector _columns;
         Types _types;
+        ColumnPredicates _predicates;
         const TableData& _tableData;
         const SymbolInfo& _tableInfo;
+        uint64_t _rowLimit;
     };
 
 
+    /**
+     * Scans the system tables. The rows are taken as a snapshot of the engine state when the operator is created.
+     *
+     *   - SYSTEM_DUAL: a single row
+     *   - SYSTEM_STATISTICS: the engine counters and the query latency histogram as name value pairs
+     *   - SYSTEM_QUERIES: the most recently executed statements
+     */
     class CSVSQLDB_EXPORT SystemTableScanOperatorNode : public ScanOperatorNode, public BlockProvider
     {
     public:
@@ -506,34 +960,163 @@ namespace csvsqldb
 
         virtual void dump(std::ostream& stream) const;
 
+        virtual uint64_t estimateRowCount();
+
         virtual const Values* getNextRow();
 
         /// BlockProvider interface
         virtual BlockPtr getNextBlock();
 
     private:
+        void createRows();
+
         BlockPtr _currentBlock;
         BlockIteratorPtr _iterator;
+        std::vector<Variants> _rows;
+        size_t _nextRow;
     };
 
+    /**
+     * Queue of the blocks filled by the block readers of a table scan. Each reader fills its blocks with complete rows, so
+     * the blocks of different readers can be consumed in any order. Only the last block of the last reader keeps its end
+     * marker.
+     */
+    class CSVSQLDB_EXPORT BlockQueue
+    {
+    public:
+        /**
+         * @param blockManager The block manager the blocks were allocated from
+         * @param maxQueuedBlocks The maximum number of filled blocks waiting for the consumer. The readers wait if the limit
+         * is reached, so that the scan does not read the files ahead of a slow consumer.
+         * @param producers The number of readers filling the queue
+         */
+        BlockQueue(BlockManager& blockManager, size_t maxQueuedBlocks, size_t producers);
+
+        ~BlockQueue();
+
+        /**
+         * Waits for space in the queue and appends the block.
+         * @return false if the queue was cancelled and the block was not appended
+         */
+        bool push(BlockPtr block);
+
+        /**
+         * Appends the last block of a reader. Its end marker is turned into a next block marker if other readers are still
+         * running. Does not wait for space.
+         */
+        void finish(BlockPtr block);
+
+        /**
+         * Finishes a reader that failed. The error is rethrown to the consumer.
+         */
+        void fail(const std::exception_ptr& error);
+
+        /**
+         * Waits for the next block. Returns nullptr after the last block was fetched.
+         */
+        BlockPtr pop();
+
+        /**
+         * Wakes up all waiting readers and releases the queued blocks.
+         */
+        void cancel();
+
+        bool cancelled() const
+        {
+            return !_continue;
+        }
+
+        size_t readers() const
+        {
+            return _readers;
+        }
+
+        /// Adds rows stored by a reader, so that all readers can stop at a common row limit
+        void addRows(uint64_t rows)
+        {
+            _rows.fetch_add(rows, std::memory_order_relaxed);
+        }
+
+        uint64_t rows() const
+        {
+            return _rows.load(std::memory_order_relaxed);
+        }
+
+    private:
+        void releaseBlocks();
+
+        BlockManager& _blockManager;
+        std::queue<BlockPtr> _blocks;
+        size_t _maxQueuedBlocks;
+        const size_t _readers;
+        size_t _producers;
+        std::exception_ptr _error;
+        std::atomic<uint64_t> _rows;
+        std::condition_variable _cv;
+        std::condition_variable _spaceCv;
+        std::mutex _queueMutex;
+        std::atomic<bool> _continue;
+    };
+
+    /**
+     * Value of a partition column taken from a key=value directory of the path of a csv file.
+     */
+    struct CSVSQLDB_EXPORT PartitionValue {
+        size_t _position;                    //!< position of the column in the rows of the scan
+        std::shared_ptr<const Value> _value; //!< the same for all rows of the file
+    };
+
+    typedef std::vector<PartitionValue> PartitionValues;
+
     class CSVSQLDB_EXPORT BlockReader : public csvsqldb::csv::CSVParserCallback
     {
     public:
+        typedef std::shared_ptr<std::istream> IStreamPtr;
         typedef std::shared_ptr<csvsqldb::csv::CSVParser> CSVParserPtr;
 
-        BlockReader(BlockManager& blockManager);
+        /**
+         * Opens the next file to read and creates its parser with the given callback. Also returns the values of the
+         * partition columns of the file, sorted by position. Returns nullptr if there is no file left. Called from the read
+         * threads, so it has to be thread safe.
+         */
+        typedef std::function<CSVParserPtr(
+          csvsqldb::csv::CSVParserCallback& callback, IStreamPtr& stream, PartitionValues& partitionValues)>
+          ParserFactory;
+
+        /**
+         * Creates a reader that parses the blocks in its own thread.
+         * @param blockManager The block manager to allocate the blocks from
+         * @param queue The queue to append the filled blocks to
+         */
+        BlockReader(BlockManager& blockManager, BlockQueue& queue);
 
         ~BlockReader();
 
-        void initialize(CSVParserPtr csvparser);
-
-        bool valid() const
+        /**
+         * Starts the read thread. It reads the files returned by the factory one after another until no file is left.
+         */
+        void initialize(const ParserFactory& parserFactory);
+
+        /**
+         * Stops the read thread as soon as possible and waits for it to finish. Has to be called before the parsed streams
+         * are destroyed.
+         */
+        void cancel();
+
+        /**
+         * Sets the predicates checked for each line. Lines not satisfying all predicates are rejected as soon as the
+         * first failing column is read and are never stored in a block.
+         * @param predicates The predicates to check
+         * @param columns The table columns read into the blocks in the right order
+         */
+        void setPredicates(const ColumnPredicates& predicates, const IndexVector& columns);
+
+        /// Stops reading after the given number of rows were stored in the blocks of all readers of the queue
+        void setRowLimit(uint64_t rowLimit)
         {
-            return _csvparser.get();
+            _rowLimit = rowLimit;
         }
 
-        BlockPtr getNextBlock();
-
         /// CSVParserCallback interface
         virtual void onLong(int64_t num, bool isNull);
 
@@ -550,46 +1133,162 @@ namespace csvsqldb
         virtual void onBoolean(bool boolean, bool isNull);
 
     private:
-        typedef std::queue<BlockPtr> Blocks;
+        typedef std::vector<std::vector<const ColumnPredicate*>> ColumnPredicateList;
 
         void readBlocks();
-
+        uint64_t readFile();
+        bool rowLimitReached() const;
+        void nextBlock();
+        void dropLine();
+        void endRow();
+        void addPartitionValues();
+        void checkValue(const Value* value);
+
+        ParserFactory _parserFactory;
+        IStreamPtr _stream;
         CSVParserPtr _csvparser;
+        PartitionValues _partitionValues;
+        size_t _nextPartitionValue;
         BlockManager& _blockManager;
-        Blocks _blocks;
+        BlockQueue& _queue;
         BlockPtr _block;
+        ColumnPredicates _predicates;
+        ColumnPredicateList _columnPredicates;
+        Values _rowValues;
+        size_t _valuesInRow;
+        size_t _rowStart;
+        bool _rejected;
+        uint64_t _rowLimit;
+        uint64_t _rowCount;
+        uint64_t _publishedRows;
+        bool _keepRowsInBlock;
+        int64_t _blockStart;
         std::thread _readThread;
-        std::condition_variable _cv;
-        std::mutex _queueMutex;
-        bool _continue;
     };
 
 
+    /**
+     * Scans all files matching the mapping of a table as one table. Directories in the file list are searched recursively.
+     * The files are read concurrently by up to OperatorContext::_maxParallelScans readers, one parser per file. With
+     * more than one file the rows of the files are interleaved in no particular order.
+     *
+     * The values of partition columns are not stored in the csv files, but taken from key=value directories of the file
+     * paths, like sales/dt=2016-10-17/region=eu/part-0001.csv. Files without a directory for a partition column get NULL
+     * values. Directories of partitions that do not satisfy the pushed down predicates are skipped without being listed.
+     */
     class CSVSQLDB_EXPORT TableScanOperatorNode : public ScanOperatorNode, public BlockProvider
     {
     public:
         TableScanOperatorNode(const OperatorContext& context, const SymbolTablePtr& symbolTable, const SymbolInfo& tableInfo);
 
+        ~TableScanOperatorNode();
+
         virtual void dump(std::ostream& stream) const;
 
+        virtual uint64_t estimateRowCount();
+
         virtual const Values* getNextRow();
 
         /// BlockProvider interface
         virtual BlockPtr getNextBlock();
 
     private:
-        typedef std::shared_ptr<std::istream> IStreamPtr;
-        typedef std::shared_ptr<csvsqldb::csv::CSVParser> CSVParserPtr;
-
-        void initializeBlockReader();
-
-        BlockReader _blockReader;
+        typedef std::unique_ptr<BlockReader> BlockReaderPtr;
+
+        void initializeBlockReaders();
+        BlockReader::CSVParserPtr openNextFile(csvsqldb::csv::CSVParserCallback& callback,
+                                               BlockReader::IStreamPtr& stream,
+                                               PartitionValues& partitionValues);
+        StringVector findTableFiles() const;
+        bool parsePartition(const std::string& directory, size_t& column, ColumnPredicate::ValuePtr& value) const;
+        bool isPrunedPartition(const std::string& directory) const;
+        bool isPrunedFile(const std::string& path) const;
+        PartitionValues getPartitionValues(const std::string& path) const;
+        const StringVector& getTableFiles();
+        uint64_t estimateFilesRowCount(const StringVector& files) const;
+        bool sampleFile(const std::string& pathToCsvFile, uint64_t& headerBytes, uint64_t& rows, uint64_t& rowBytes) const;
+
+        /// number of lines read from a file to estimate the average row length
+        static const uint64_t _estimationSampleSize = 100;
+        /// maximum number of files sampled to estimate the row count of a table
+        static const size_t _estimationSampleFiles = 8;
+        /// number of filled blocks per reader, that may wait for the consumer
+        static const size_t _queuedBlocksPerReader = 4;
+
+        std::unique_ptr<BlockQueue> _queue;
+        std::vector<BlockReaderPtr> _blockReaders;
         BlockIteratorPtr _iterator;
+        uint64_t _estimatedRowCount;
 
-        IStreamPtr _stream;
-        CSVParserPtr _csvparser;
+        StringVector _tableFiles; //!< listed once by getTableFiles(), so that the estimation and the scan share it
+        bool _tableFilesListed;
+        std::atomic<size_t> _nextFile;
+        csvsqldb::csv::Types _csvTypes;
         csvsqldb::csv::CSVParserContext _csvContext;
     };
+
+
+    /**
+     * Measures an operator for EXPLAIN ANALYZE. All calls are forwarded to the measured operator, while the returned rows
+     * and the wall and CPU time spent in the operator are recorded. The cumulative times include the times of the inputs,
+     * the self times do not. CPU time is only measured for the calling thread, so work an operator hands off to the
+     * thread pool only shows up in its wall time. The measurements are appended to the first line of the operator dump.
+     */
+    class CSVSQLDB_EXPORT AnalyzingOperatorNode : public RowOperatorNode
+    {
+    public:
+        /**
+         * Constructs a measuring node.
+         * @param node The operator to measure
+         * @param inputs The measuring nodes of the operator inputs
+         */
+        AnalyzingOperatorNode(const OperatorContext& context, const RowOperatorNodePtr& node, const AnalyzingOperatorNodes& inputs);
+
+        virtual const Values* getNextRow();
+
+        virtual bool connect(const RowOperatorNodePtr& input);
+
+        virtual void getColumnInfos(SymbolInfos& outputSymbols);
+
+        virtual void setOutputAlias(const std::string& alias);
+
+        virtual uint64_t estimateRowCount();
+
+        virtual OperatorCounters getCounters() const;
+
+        virtual void dump(std::ostream& stream) const;
+
+        uint64_t getRowCount() const
+        {
+            return _rows;
+        }
+
+        /// sum of the rows returned by the inputs
+        uint64_t getInputRowCount() const;
+
+        /// wall time in nanoseconds including the inputs
+        int64_t getWallTime() const
+        {
+            return _wallTime;
+        }
+
+        /// CPU time in nanoseconds including the inputs
+        int64_t getCpuTime() const
+        {
+            return _cpuTime;
+        }
+
+        int64_t getSelfWallTime() const;
+
+        int64_t getSelfCpuTime() const;
+
+    private:
+        RowOperatorNodePtr _node;
+        AnalyzingOperatorNodes _inputs;
+        uint64_t _rows;
+        int64_t _wallTime;
+        int64_t _cpuTime;
+    };
 }
 
 #endif
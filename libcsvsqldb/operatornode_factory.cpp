@@ -51,6 +51,11 @@ namespace csvsqldb
         return std::make_shared<LimitOperatorNode>(context, symbolTable, limit, offset);
     }
 
+    RowOperatorNodePtr OperatorNodeFactory::createDistinctOperatorNode(OperatorContext& context, const SymbolTablePtr& symbolTable)
+    {
+        return std::make_shared<DistinctOperatorNode>(context, symbolTable);
+    }
+
     RowOperatorNodePtr OperatorNodeFactory::createSortOperatorNode(OperatorContext& context, const SymbolTablePtr& symbolTable, OrderExpressions orderExpressions)
     {
         return std::make_shared<SortOperatorNode>(context, symbolTable, orderExpressions);
@@ -95,6 +100,13 @@ namespace csvsqldb
         return std::make_shared<InnerHashJoinOperatorNode>(context, symbolTable, exp);
     }
 
+    RowOperatorNodePtr OperatorNodeFactory::createSortMergeJoinOperatorNode(OperatorContext& context,
+                                                                            const SymbolTablePtr& symbolTable,
+                                                                            const ASTExprNodePtr& exp)
+    {
+        return std::make_shared<SortMergeJoinOperatorNode>(context, symbolTable, exp);
+    }
+
     RowOperatorNodePtr OperatorNodeFactory::createUnionOperatorNode(OperatorContext& context, const SymbolTablePtr& symbolTable)
     {
         return std::make_shared<UnionOperatorNode>(context, symbolTable);
@@ -53,6 +53,8 @@ namespace csvsqldb
                                                                           const ASTExprNodePtr& limit,
                                                                           const ASTExprNodePtr& offset);
 
+        static CSVSQLDB_EXPORT RowOperatorNodePtr createDistinctOperatorNode(OperatorContext& context, const SymbolTablePtr& symbolTable);
+
         static CSVSQLDB_EXPORT RowOperatorNodePtr createSortOperatorNode(OperatorContext& context,
                                                                          const SymbolTablePtr& symbolTable,
                                                                          OrderExpressions orderExpressions);
@@ -80,6 +82,10 @@ namespace csvsqldb
                                                                                   const SymbolTablePtr& symbolTable,
                                                                                   const ASTExprNodePtr& exp);
 
+        static CSVSQLDB_EXPORT RowOperatorNodePtr createSortMergeJoinOperatorNode(OperatorContext& context,
+                                                                                  const SymbolTablePtr& symbolTable,
+                                                                                  const ASTExprNodePtr& exp);
+
         static CSVSQLDB_EXPORT RowOperatorNodePtr createUnionOperatorNode(OperatorContext& context, const SymbolTablePtr& symbolTable);
 
         static CSVSQLDB_EXPORT RowOperatorNodePtr createSelectOperatorNode(OperatorContext& context,
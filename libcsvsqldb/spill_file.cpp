@@ -0,0 +1,227 @@
+//
+//  spill_file.cpp
+//  csvsqldb
+//
+//  BSD 3-Clause License
+//  Copyright (c) 2015, Lars-Christian Fürstenberg
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification, are permitted
+//  provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or other materials provided
+//  with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors may be used to
+//  endorse or promote products derived from this software without specific prior written
+//  permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+//  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+//  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+//  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "spill_file.h"
+
+#include "libcsvsqldb/base/exception.h"
+
+#include <boost/filesystem.hpp>
+
+namespace fs = boost::filesystem;
+
+
+namespace csvsqldb
+{
+    namespace
+    {
+        template <typename T>
+        void writeRaw(std::fstream& stream, const T& value)
+        {
+            stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        template <typename T>
+        T readRaw(std::fstream& stream)
+        {
+            T value;
+            stream.read(reinterpret_cast<char*>(&value), sizeof(T));
+            return value;
+        }
+    }
+
+
+    SpillFile::SpillFile(const Types& types)
+    : _types(types)
+    , _path((fs::temp_directory_path() / fs::unique_path("csvsqldb-%%%%-%%%%-%%%%-%%%%.spill")).string())
+    , _rowCount(0)
+    , _byteCount(0)
+    , _maxRowSize(0)
+    , _readRows(0)
+    , _reading(false)
+    {
+        _stream.open(_path, std::ios::binary | std::ios::in | std::ios::out | std::ios::trunc);
+        if(!_stream.is_open()) {
+            CSVSQLDB_THROW(FilesystemException, "could not create spill file '" << _path << "'");
+        }
+    }
+
+    SpillFile::~SpillFile()
+    {
+        _stream.close();
+        boost::system::error_code ec;
+        fs::remove(_path, ec);
+    }
+
+    void SpillFile::writeRow(const Values& row)
+    {
+        if(_reading) {
+            CSVSQLDB_THROW(InvalidOperationException, "cannot write to spill file while reading it");
+        }
+
+        size_t rowSize = 0;
+        size_t n = 0;
+        for(const auto& value : row) {
+            const char isNull = value->isNull() ? 1 : 0;
+            writeRaw(_stream, isNull);
+            ++_byteCount;
+            // the value marker of the block has to be taken into account
+            rowSize += value->size() + 1;
+
+            if(!isNull) {
+                switch(_types[n]) {
+                    case INT:
+                        writeRaw(_stream, static_cast<const ValInt*>(value)->asInt());
+                        _byteCount += sizeof(int64_t);
+                        break;
+                    case REAL:
+                        writeRaw(_stream, static_cast<const ValDouble*>(value)->asDouble());
+                        _byteCount += sizeof(double);
+                        break;
+                    case BOOLEAN:
+                        writeRaw(_stream, static_cast<const ValBool*>(value)->asBool());
+                        _byteCount += sizeof(bool);
+                        break;
+                    case DATE:
+                        writeRaw(_stream, static_cast<const ValDate*>(value)->asDate().asJulianDay());
+                        _byteCount += sizeof(uint32_t);
+                        break;
+                    case TIME:
+                        writeRaw(_stream, static_cast<const ValTime*>(value)->asTime().asInteger());
+                        _byteCount += sizeof(int32_t);
+                        break;
+                    case TIMESTAMP:
+                        writeRaw(_stream, static_cast<const ValTimestamp*>(value)->asTimestamp().asInteger());
+                        _byteCount += sizeof(int64_t);
+                        break;
+                    case STRING: {
+                        const ValString* s = static_cast<const ValString*>(value);
+                        const uint64_t len = s->length();
+                        writeRaw(_stream, len);
+                        _stream.write(s->asString(), static_cast<std::streamsize>(len));
+                        _byteCount += sizeof(uint64_t) + len;
+                        break;
+                    }
+                    case NONE:
+                        CSVSQLDB_THROW(csvsqldb::Exception, "cannot spill values of type NONE");
+                }
+            }
+            ++n;
+        }
+        if(!_stream) {
+            CSVSQLDB_THROW(FilesystemException, "could not write to spill file '" << _path << "'");
+        }
+        _maxRowSize = std::max(_maxRowSize, rowSize);
+        ++_rowCount;
+    }
+
+    void SpillFile::rewind()
+    {
+        _stream.flush();
+        _stream.clear();
+        _stream.seekg(0);
+        if(!_stream) {
+            CSVSQLDB_THROW(FilesystemException, "could not rewind spill file '" << _path << "'");
+        }
+        if(!_block) {
+            // the scratch block has to hold the largest row plus the row marker and the safety margin of the block
+            _block.reset(new Block(0, _maxRowSize + 3));
+        }
+        _readRows = 0;
+        _reading = true;
+    }
+
+    const Values* SpillFile::getNextRow()
+    {
+        if(!_reading) {
+            CSVSQLDB_THROW(InvalidOperationException, "spill file has to be rewound before reading");
+        }
+        if(_readRows == _rowCount) {
+            return nullptr;
+        }
+
+        _block->reset();
+        _row.clear();
+        for(const auto& type : _types) {
+            readValue(type);
+        }
+        if(!_stream) {
+            CSVSQLDB_THROW(FilesystemException, "could not read from spill file '" << _path << "'");
+        }
+        ++_readRows;
+        return &_row;
+    }
+
+    void SpillFile::readValue(eType type)
+    {
+        const bool isNull = readRaw<char>(_stream) != 0;
+        Value* value = nullptr;
+
+        switch(type) {
+            case INT:
+                value = _block->addInt(isNull ? 0 : readRaw<int64_t>(_stream), isNull);
+                break;
+            case REAL:
+                value = _block->addReal(isNull ? 0.0 : readRaw<double>(_stream), isNull);
+                break;
+            case BOOLEAN:
+                value = _block->addBool(isNull ? false : readRaw<bool>(_stream), isNull);
+                break;
+            case DATE:
+                value = _block->addDate(isNull ? csvsqldb::Date() : csvsqldb::Date(readRaw<uint32_t>(_stream)), isNull);
+                break;
+            case TIME:
+                value = _block->addTime(isNull ? csvsqldb::Time() : csvsqldb::Time(readRaw<int32_t>(_stream)), isNull);
+                break;
+            case TIMESTAMP:
+                value =
+                  _block->addTimestamp(isNull ? csvsqldb::Timestamp() : csvsqldb::Timestamp(readRaw<int64_t>(_stream)), isNull);
+                break;
+            case STRING:
+                if(isNull) {
+                    value = _block->addString(nullptr, 0, true);
+                } else {
+                    const uint64_t len = readRaw<uint64_t>(_stream);
+                    _stringBuffer.resize(len);
+                    _stream.read(&_stringBuffer[0], static_cast<std::streamsize>(len));
+                    value = _block->addString(_stringBuffer.c_str(), len, false);
+                }
+                break;
+            case NONE:
+                CSVSQLDB_THROW(csvsqldb::Exception, "cannot read values of type NONE from spill file");
+        }
+        if(!value) {
+            CSVSQLDB_THROW(csvsqldb::Exception, "spilled row does not fit into the read block");
+        }
+        _row.push_back(value);
+    }
+}
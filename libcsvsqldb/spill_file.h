@@ -0,0 +1,111 @@
+//
+//  spill_file.h
+//  csvsqldb
+//
+//  BSD 3-Clause License
+//  Copyright (c) 2015, Lars-Christian Fürstenberg
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification, are permitted
+//  provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or other materials provided
+//  with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors may be used to
+//  endorse or promote products derived from this software without specific prior written
+//  permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+//  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+//  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+//  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef csvsqldb_spill_file_h
+#define csvsqldb_spill_file_h
+
+#include "libcsvsqldb/inc.h"
+
+#include "block.h"
+
+#include <fstream>
+#include <memory>
+#include <string>
+
+
+namespace csvsqldb
+{
+
+    class SpillFile;
+    typedef std::shared_ptr<SpillFile> SpillFilePtr;
+    typedef std::vector<SpillFilePtr> SpillFiles;
+
+
+    /**
+     * A temporary file for rows of a fixed type layout. Rows are appended with writeRow() and can be read back in the same
+     * order with getNextRow() after calling rewind(). The file is removed upon destruction. Operators use spill files to page
+     * out intermediate results that do not fit into the blocks they are allowed to use.
+     */
+    class CSVSQLDB_EXPORT SpillFile : public RowProvider
+    {
+    public:
+        /**
+         * Creates a new temporary file in the temp directory of the system.
+         * @param types The types of the row values to store
+         */
+        SpillFile(const Types& types);
+
+        ~SpillFile();
+
+        /**
+         * Appends the row to the file. The values have to match the types given upon construction.
+         * @param row The row to append
+         */
+        void writeRow(const Values& row);
+
+        /**
+         * Switches to reading and positions the file at the first row.
+         */
+        void rewind();
+
+        /// RowProvider interface
+        virtual const Values* getNextRow();
+
+        size_t getRowCount() const
+        {
+            return _rowCount;
+        }
+
+        size_t getByteCount() const
+        {
+            return _byteCount;
+        }
+
+    private:
+        void readValue(eType type);
+
+        Types _types;
+        std::string _path;
+        std::fstream _stream;
+        std::unique_ptr<Block> _block;
+        Values _row;
+        std::string _stringBuffer;
+        size_t _rowCount;
+        size_t _byteCount;
+        size_t _maxRowSize;
+        size_t _readRows;
+        bool _reading;
+    };
+}
+
+#endif
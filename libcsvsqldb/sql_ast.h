@@ -147,6 +147,7 @@ namespace csvsqldb
         , _unique(false)
         , _notNull(false)
         , _length(0)
+        , _partition(false)
         {
         }
 
@@ -158,6 +159,7 @@ namespace csvsqldb
         csvsqldb::Any _defaultValue;
         ASTExprNodePtr _check;
         uint32_t _length;
+        bool _partition;
     };
 
     typedef std::vector<ColumnDefinition> ColumnDefinitions;
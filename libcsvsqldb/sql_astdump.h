@@ -68,6 +68,7 @@ namespace csvsqldb
                 std::cout << (definition._primaryKey ? "Primary Key " : "");
                 std::cout << (definition._notNull ? "Not Null " : "");
                 std::cout << (definition._unique ? "Unique " : "");
+                std::cout << (definition._partition ? "Partition " : "");
                 if(!definition._defaultValue.empty()) {
                     std::cout << printType(definition._type, definition._defaultValue);
                 }
@@ -612,7 +613,7 @@ namespace csvsqldb
 
         virtual void visit(ASTExplainNode& node)
         {
-            _ss << "EXPLAIN AST ";
+            _ss << "EXPLAIN " << descriptionTypeToString(node._descType) << " ";
             node._query->accept(*this);
         }
 
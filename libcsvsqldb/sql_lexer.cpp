@@ -199,6 +199,8 @@ namespace csvsqldb
                 return "CONSTRAINT";
             case TOK_PRIMARY:
                 return "PRIMARY";
+            case TOK_PARTITIONED:
+                return "PARTITIONED";
             case TOK_KEY:
                 return "KEY";
             case TOK_UNIQUE:
@@ -271,6 +273,8 @@ namespace csvsqldb
                 return "MAPPING";
             case TOK_EXEC:
                 return "EXEC";
+            case TOK_ANALYZE:
+                return "ANALYZE";
             case TOK_ARBITRARY:
                 return "ARBITRARY";
         }
@@ -382,6 +386,7 @@ namespace csvsqldb
         _keywords["TIMESTAMP"] = eToken(TOK_TIMESTAMP);
         _keywords["CONSTRAINT"] = eToken(TOK_CONSTRAINT);
         _keywords["PRIMARY"] = eToken(TOK_PRIMARY);
+        _keywords["PARTITIONED"] = eToken(TOK_PARTITIONED);
         _keywords["KEY"] = eToken(TOK_KEY);
         _keywords["UNIQUE"] = eToken(TOK_UNIQUE);
         _keywords["DEFAULT"] = eToken(TOK_DEFAULT);
@@ -412,6 +417,7 @@ namespace csvsqldb
         _keywords["SHOW"] = eToken(TOK_SHOW);
         _keywords["MAPPING"] = eToken(TOK_MAPPING);
         _keywords["EXEC"] = eToken(TOK_EXEC);
+        _keywords["ANALYZE"] = eToken(TOK_ANALYZE);
         _keywords["ARBITRARY"] = eToken(TOK_ARBITRARY);
     }
 
@@ -49,6 +49,7 @@ namespace csvsqldb
         TOK_ADD_KEYWORD,
         TOK_ALL,
         TOK_ALTER,
+        TOK_ANALYZE,
         TOK_AND,
         TOK_ARBITRARY,
         TOK_AS,
@@ -131,6 +132,7 @@ namespace csvsqldb
         TOK_OR,
         TOK_ORDER,
         TOK_OUTER,
+        TOK_PARTITIONED,
         TOK_PRIMARY,
         TOK_QUOTED_IDENTIFIER,
         TOK_REAL,
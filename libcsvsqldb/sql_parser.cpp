@@ -44,6 +44,8 @@ namespace csvsqldb
     SQLParser::SQLParser(const FunctionRegistry& functionRegistry)
     : _lexer("")
     , _functionRegistry(functionRegistry)
+    , _statementStart(0)
+    , _statementEnd(0)
     {
         _currentToken._token = TOK_NONE;
     }
@@ -96,6 +98,9 @@ namespace csvsqldb
     void SQLParser::setInput(const std::string& input)
     {
         _lexer.setInput(input);
+        _input = input;
+        _statementStart = 0;
+        _statementEnd = 0;
         _currentToken = csvsqldb::lexer::Token();
         _currentToken._token = TOK_NONE;
     }
@@ -113,6 +118,8 @@ namespace csvsqldb
         if(_currentToken._token == TOK_NONE) {
             parseNext();
         }
+        _statementStart = _currentToken._position;
+        _statementEnd = std::string::npos;
 
         if(_currentToken._token != csvsqldb::lexer::EOI) {
             if(_currentToken._token == TOK_SELECT || _currentToken._token == TOK_LEFT_PAREN) {
@@ -142,6 +149,7 @@ namespace csvsqldb
             } else {
                 reportUnexpectedToken("unexpected token, found ", _currentToken);
             }
+            _statementEnd = _currentToken._position;
             if(_currentToken._token == TOK_SEMICOLON) {
                 expect(TOK_SEMICOLON);
             } else if(_currentToken._token != csvsqldb::lexer::EOI) {
@@ -153,6 +161,14 @@ namespace csvsqldb
         return astnode;
     }
 
+    std::string SQLParser::statement() const
+    {
+        if(_statementStart >= _input.size()) {
+            return std::string();
+        }
+        return csvsqldb::trim_right(_input.substr(_statementStart, _statementEnd - _statementStart));
+    }
+
     ASTExprNodePtr SQLParser::parseExpression(const std::string& expression)
     {
         setInput(expression);
@@ -168,8 +184,10 @@ namespace csvsqldb
             desc = AST;
         } else if(canExpect(TOK_EXEC)) {
             desc = EXEC;
+        } else if(canExpect(TOK_ANALYZE)) {
+            desc = ANALYZE;
         } else {
-            reportUnexpectedToken("expected 'AST' or 'EXEC', but found ", _currentToken);
+            reportUnexpectedToken("expected 'AST', 'EXEC' or 'ANALYZE', but found ", _currentToken);
         }
         ASTQueryNodePtr query = parseQuery();
 
@@ -256,6 +274,28 @@ namespace csvsqldb
 
         expect(TOK_RIGHT_PAREN);
 
+        if(canExpect(TOK_PARTITIONED)) {
+            // the values of partition columns are taken from the key=value directories of the csv file paths
+            expect(TOK_BY);
+            expect(TOK_LEFT_PAREN);
+            for(const auto& partition : parseColumnList()) {
+                auto iter = std::find_if(columns.begin(), columns.end(), [&partition](const ColumnDefinition& definition) {
+                    return csvsqldb::toupper_copy(definition._name) == csvsqldb::toupper_copy(partition);
+                });
+                if(iter == columns.end()) {
+                    CSVSQLDB_THROW(SqlParserException,
+                                   "partition column '" << partition << "' is not a column of table " << name);
+                }
+                iter->_partition = true;
+            }
+            expect(TOK_RIGHT_PAREN);
+            if(std::all_of(
+                 columns.begin(), columns.end(), [](const ColumnDefinition& definition) { return definition._partition; })) {
+                CSVSQLDB_THROW(SqlParserException,
+                               "table " << name << " needs at least one column that is not a partition column");
+            }
+        }
+
         return std::make_shared<ASTCreateTableNode>(SymbolTable::createSymbolTable(), name, columns, constraints, createIfNotExists);
     }
 
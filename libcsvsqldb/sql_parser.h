@@ -56,6 +56,12 @@ namespace csvsqldb
 
         void setInput(const std::string& input);
 
+        /**
+         * Returns the text of the statement parsed last. If the statement could not be parsed, the rest of the input is
+         * returned.
+         */
+        std::string statement() const;
+
     private:
         void reportUnexpectedToken(const std::string& message, const csvsqldb::lexer::Token& token);
 
@@ -116,6 +122,9 @@ namespace csvsqldb
         SQLLexer _lexer;
         csvsqldb::lexer::Token _currentToken;
         const FunctionRegistry& _functionRegistry;
+        std::string _input;
+        size_t _statementStart;
+        size_t _statementEnd;
     };
 }
 
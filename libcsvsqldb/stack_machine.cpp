@@ -64,6 +64,30 @@ namespace csvsqldb
     }
 
 
+    StackMachine::InSet::InSet(eType type, const Variants& values)
+    : _type(type)
+    , _values(values)
+    {
+        for(auto& value : _values) {
+            value.disconnect();
+            _set.insert(value);
+        }
+    }
+
+    bool StackMachine::isHashableInList(const Variants& values)
+    {
+        if(values.empty()) {
+            return false;
+        }
+        eType type = values[0].getType();
+        if(type == NONE || type == REAL) {
+            // REAL values are compared with an epsilon, so equal values might have different hashes
+            return false;
+        }
+        return std::all_of(values.begin(), values.end(), [type](const Variant& value) { return !value.isNull() && value.getType() == type; });
+    }
+
+
     void StackMachine::addInstruction(const Instruction& instruction)
     {
         _instructions.emplace(_instructions.end(), instruction);
@@ -87,6 +111,26 @@ namespace csvsqldb
         return val;
     }
 
+    void StackMachine::callFunction(const Function& function, const Types& parameterCasts)
+    {
+        // the parameter vector is reused for all calls, so calls of the same arity assign the values in place
+        const size_t arity = parameterCasts.size();
+        _parameter.resize(arity);
+        for(size_t n = 0; n < arity; ++n) {
+            Variant& v = _parameter[n];
+            v = getNextValue();
+            const eType cast = parameterCasts[n];
+            if(cast != NONE && cast != v.getType()) {
+                try {
+                    v = unaryOperation(OP_CAST, cast, v);
+                } catch(const std::exception&) {
+                    CSVSQLDB_THROW(StackMachineException, "calling function '" << function.getName() << "' with wrong parameter");
+                }
+            }
+        }
+        _valueStack.emplace(function.call(_parameter));
+    }
+
     void StackMachine::reset()
     {
         while(!_valueStack.empty()) {
@@ -170,6 +214,9 @@ namespace csvsqldb
                 case IN:
                     stream << "IN" << std::endl;
                     break;
+                case INSET:
+                    stream << "IN SET " << element._set->_values.size() << std::endl;
+                    break;
                 case IS:
                     stream << "IS" << std::endl;
                     break;
@@ -267,30 +314,19 @@ namespace csvsqldb
                         CSVSQLDB_THROW(StackMachineException, "expected a string as variable name");
                     }
 
+                    if(instruction._function) {
+                        callFunction(*instruction._function,
+                                     instruction._parameterCasts.empty() ? instruction._function->getParameterTypes() :
+                                                                           instruction._parameterCasts);
+                        break;
+                    }
+
                     std::string funcname = instruction._value.asString();
                     Function::Ptr func = functions.getFunction(funcname);
                     if(!func) {
                         CSVSQLDB_THROW(StackMachineException, "function '" << funcname << "' not found");
                     }
-                    Variants parameter;
-                    size_t count = func->getParameterTypes().size();
-                    for(const auto& param : func->getParameterTypes()) {
-                        Variant v = getNextValue();
-                        if(param != v.getType()) {
-                            try {
-                                v = unaryOperation(OP_CAST, param, v);
-                            } catch(const std::exception&) {
-                                CSVSQLDB_THROW(StackMachineException,
-                                               "calling function '" << funcname << "' with wrong parameter");
-                            }
-                        }
-                        parameter.emplace(parameter.end(), v);
-                        --count;
-                    }
-                    if(count) {
-                        CSVSQLDB_THROW(StackMachineException, "too much parameters for function '" << funcname << "'");
-                    }
-                    _valueStack.emplace(func->call(parameter));
+                    callFunction(*func, func->getParameterTypes());
                     break;
                 }
                 case CAST: {
@@ -321,20 +357,35 @@ namespace csvsqldb
                     }
                     break;
                 }
+                case INSET: {
+                    const Variant lhs = getNextValue();
+                    const InSet& inSet = *instruction._set;
+                    bool found(false);
+                    if(!lhs.isNull() && lhs.getType() == inSet._type) {
+                        found = inSet._set.find(lhs) != inSet._set.end();
+                    } else {
+                        for(const auto& value : inSet._values) {
+                            if(binaryOperation(OP_EQ, lhs, value).asBool()) {
+                                found = true;
+                                break;
+                            }
+                        }
+                    }
+                    _valueStack.emplace(Variant(found));
+                    break;
+                }
                 case LIKE: {
-                    if(!instruction._r) {
-                        CSVSQLDB_THROW(StackMachineException, "expected a regexp in LIKE expression");
+                    if(!instruction._like) {
+                        CSVSQLDB_THROW(StackMachineException, "expected a pattern in LIKE expression");
                     }
-                    Variant lhs = getTopValue();
+                    // the result replaces the operand, otherwise the operand would be left over on the stack
+                    Variant& lhs = getTopValue();
                     if(lhs.getType() != STRING) {
                         lhs = unaryOperation(OP_CAST, STRING, lhs);
                         CSVSQLDB_THROW(StackMachineException, "can only do like operations on strings");
                     }
-                    if(instruction._r->match(lhs.asString())) {
-                        _valueStack.emplace(Variant(true));
-                    } else {
-                        _valueStack.emplace(Variant(false));
-                    }
+                    const bool matches = instruction._like->match(lhs.asString());
+                    lhs = Variant(matches);
                     break;
                 }
             }
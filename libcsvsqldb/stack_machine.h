@@ -40,9 +40,11 @@
 #include "variant.h"
 
 #include "base/exception.h"
-#include "base/regexp.h"
+#include "base/like_matcher.h"
 
+#include <memory>
 #include <stack>
+#include <unordered_set>
 #include <vector>
 
 
@@ -85,6 +87,7 @@ namespace csvsqldb
             GE,
             GT,
             IN,
+            INSET,
             IS,
             ISNOT,
             LE,
@@ -103,12 +106,32 @@ namespace csvsqldb
             SUB
         };
 
+        /**
+         * The constant values of an IN list. If the value to look for has the same type as the list values, it is found
+         * with a hash lookup, otherwise the values are compared one after the other like a normal IN list.
+         */
+        struct CSVSQLDB_EXPORT InSet {
+            InSet(eType type, const Variants& values);
+
+            eType _type;
+            Variants _values;
+            std::unordered_set<Variant> _set;
+        };
+        typedef std::shared_ptr<const InSet> InSetPtr;
+
+        /**
+         * Checks if an IN list consisting of the given constant values can be evaluated with a hash lookup.
+         * @param values The values of the IN list
+         * @return true, if all values are not null, have the same type and can be compared exactly
+         */
+        static bool isHashableInList(const Variants& values);
+
         struct CSVSQLDB_EXPORT Instruction {
             Instruction(OpCode opCode)
             : _opCode(opCode)
             , _value(NONE)
             , _refCount(nullptr)
-            , _r(nullptr)
+            , _like(nullptr)
             {
             }
 
@@ -116,15 +139,43 @@ namespace csvsqldb
             : _opCode(opCode)
             , _value(value)
             , _refCount(nullptr)
-            , _r(nullptr)
+            , _like(nullptr)
             {
             }
 
-            Instruction(OpCode opCode, csvsqldb::RegExp* r)
+            Instruction(OpCode opCode, csvsqldb::LikeMatcher* like)
             : _opCode(opCode)
             , _value(NONE)
             , _refCount(new RefCount)
-            , _r(r)
+            , _like(like)
+            {
+            }
+
+            Instruction(OpCode opCode, const InSetPtr& set)
+            : _opCode(opCode)
+            , _value(NONE)
+            , _refCount(nullptr)
+            , _like(nullptr)
+            , _set(set)
+            {
+            }
+
+            Instruction(OpCode opCode, const Function::Ptr& function)
+            : _opCode(opCode)
+            , _value(function->getName())
+            , _refCount(nullptr)
+            , _like(nullptr)
+            , _function(function)
+            {
+            }
+
+            Instruction(OpCode opCode, const Function::Ptr& function, const Types& parameterCasts)
+            : _opCode(opCode)
+            , _value(function->getName())
+            , _refCount(nullptr)
+            , _like(nullptr)
+            , _function(function)
+            , _parameterCasts(parameterCasts)
             {
             }
 
@@ -132,7 +183,10 @@ namespace csvsqldb
             : _opCode(rhs._opCode)
             , _value(rhs._value)
             , _refCount(rhs._refCount)
-            , _r(rhs._r)
+            , _like(rhs._like)
+            , _set(rhs._set)
+            , _function(rhs._function)
+            , _parameterCasts(rhs._parameterCasts)
             {
                 if(_refCount) {
                     _refCount->inc();
@@ -143,8 +197,8 @@ namespace csvsqldb
             {
                 if(_refCount) {
                     if(_refCount->dec() == 0) {
-                        delete _r;
-                        _r = nullptr;
+                        delete _like;
+                        _like = nullptr;
                         delete _refCount;
                     }
                 }
@@ -153,7 +207,15 @@ namespace csvsqldb
             OpCode _opCode;
             Variant _value;
             RefCount* _refCount;
-            csvsqldb::RegExp* _r;
+            csvsqldb::LikeMatcher* _like;
+            InSetPtr _set;
+            Function::Ptr _function;
+            /**
+             * The casts of the parameters of a FUNC instruction, resolved when the instruction is built. NONE means the
+             * parameter already has the right type, otherwise the value is converted to the given type if needed. If
+             * empty, the parameter types of the function are checked on each call.
+             */
+            Types _parameterCasts;
         };
 
         void addInstruction(const Instruction& instruction);
@@ -170,6 +232,7 @@ namespace csvsqldb
 
         Variant& getTopValue();
         const Variant getNextValue();
+        void callFunction(const Function& function, const Types& parameterCasts);
         eOperationType mapOpCodeToBinaryOperationType(OpCode code)
         {
             switch(code) {
@@ -212,6 +275,7 @@ namespace csvsqldb
 
         Instructions _instructions;
         ValueStack _valueStack;
+        Variants _parameter;
     };
 }
 
@@ -87,7 +87,8 @@ namespace csvsqldb
                                 definition._notNull,
                                 definition._defaultValue,
                                 definition._check,
-                                definition._length);
+                                definition._length,
+                                definition._partition);
         }
         for(const auto& constraint : _constraints) {
             tabledata.addConstraint(constraint._primaryKeys, constraint._uniqueKeys, constraint._check);
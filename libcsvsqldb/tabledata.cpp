@@ -66,6 +66,11 @@ namespace csvsqldb
         return *iter;
     }
 
+    bool TableData::isPartitioned() const
+    {
+        return std::any_of(_columns.begin(), _columns.end(), [](const Column& col) { return col._partition; });
+    }
+
     const TableData::Column& TableData::getColumn(size_t index) const
     {
         if(index >= _columns.size()) {
@@ -75,8 +80,15 @@ namespace csvsqldb
         return _columns[index];
     }
 
-    void TableData::addColumn(
-    const std::string name, eType type, bool primaryKey, bool unique, bool notNull, csvsqldb::Any defaultValue, const ASTExprNodePtr& check, uint32_t length)
+    void TableData::addColumn(const std::string name,
+                              eType type,
+                              bool primaryKey,
+                              bool unique,
+                              bool notNull,
+                              csvsqldb::Any defaultValue,
+                              const ASTExprNodePtr& check,
+                              uint32_t length,
+                              bool partition)
     {
         Column column;
         column._name = name;
@@ -87,6 +99,7 @@ namespace csvsqldb
         column._defaultValue = defaultValue;
         column._check = check;
         column._length = length;
+        column._partition = partition;
 
         _columns.push_back(column);
     }
@@ -147,6 +160,7 @@ namespace csvsqldb
                 table << "\"\"";
             }
             table << ", \"length\" : " << column._length;
+            table << ", \"partition\" : " << (column._partition ? "true" : "false");
             table << " }";
             ++n;
         }
@@ -225,7 +239,9 @@ namespace csvsqldb
                 check = sqlparser.parseExpression(column["check"].getAsString());
             }
             uint32_t length = static_cast<uint32_t>(column["length"].getAsLong());
-            tabledata.addColumn(name, type, primaryKey, unique, notNull, defaultValue, check, length);
+            // tables written before partitioning was supported have no partition flag
+            bool partition = column.hasMember("partition") && column["partition"].getAsBool();
+            tabledata.addColumn(name, type, primaryKey, unique, notNull, defaultValue, check, length, partition);
         }
         const csvsqldb::json::JsonObject::ObjectArray& constraints = table["constraints"].getArray();
         for(const auto& constraint : constraints) {
@@ -263,7 +279,8 @@ namespace csvsqldb
                                 definition._notNull,
                                 definition._defaultValue,
                                 definition._check,
-                                definition._length);
+                                definition._length,
+                                definition._partition);
         }
         for(const auto& constraint : createNode->_tableConstraints) {
             tabledata.addConstraint(constraint._primaryKeys, constraint._uniqueKeys, constraint._check);
@@ -60,6 +60,7 @@ namespace csvsqldb
             , _unique(false)
             , _notNull(false)
             , _length(0)
+            , _partition(false)
             {
             }
 
@@ -71,11 +72,20 @@ namespace csvsqldb
             csvsqldb::Any _defaultValue;
             ASTExprNodePtr _check;
             uint32_t _length;
+            bool _partition; //!< value is taken from the key=value directories of the file path instead of the csv file
         };
 
         TableData(const std::string& tableName);
 
-        void addColumn(const std::string name, eType type, bool primaryKey, bool unique, bool notNull, csvsqldb::Any defaultValue, const ASTExprNodePtr& check, uint32_t length);
+        void addColumn(const std::string name,
+                       eType type,
+                       bool primaryKey,
+                       bool unique,
+                       bool notNull,
+                       csvsqldb::Any defaultValue,
+                       const ASTExprNodePtr& check,
+                       uint32_t length,
+                       bool partition = false);
         void addConstraint(const csvsqldb::StringVector& primaryKey, const csvsqldb::StringVector& unique, const ASTExprNodePtr& check);
 
         std::string asJson() const;
@@ -94,6 +104,7 @@ namespace csvsqldb
         const Column& getColumn(const std::string& name) const;
         const Column& getColumn(size_t index) const;
         bool hasColumn(const std::string& name) const;
+        bool isPartitioned() const;
 
     private:
         typedef std::vector<Column> Columns;
@@ -44,6 +44,19 @@ namespace csvsqldb
     CSVSQLDB_IMPLEMENT_EXCEPTION(SqlParserException, SqlException);
 
 
+    std::string descriptionTypeToString(eDescriptionType descType)
+    {
+        switch(descType) {
+            case AST:
+                return "AST";
+            case EXEC:
+                return "EXEC";
+            case ANALYZE:
+                return "ANALYZE";
+        }
+        throw std::runtime_error("just to make VC2013 happy");
+    }
+
     std::string orderToString(eOrder order)
     {
         switch(order) {
@@ -53,7 +53,9 @@ namespace csvsqldb
     CSVSQLDB_DECLARE_EXCEPTION(SqlParserException, SqlException);
 
 
-    enum eDescriptionType { AST, EXEC };
+    enum eDescriptionType { AST, EXEC, ANALYZE };
+
+    CSVSQLDB_EXPORT std::string descriptionTypeToString(eDescriptionType descType);
 
     enum eOrder { ASC, DESC };
 
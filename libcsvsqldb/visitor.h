@@ -151,7 +151,7 @@ namespace csvsqldb
         virtual void visit(ASTLikeNode& node)
         {
             node._lhs->accept(*this);
-            _sm.addInstruction(StackMachine::Instruction(StackMachine::LIKE, new csvsqldb::RegExp(node._like.c_str())));
+            _sm.addInstruction(StackMachine::Instruction(StackMachine::LIKE, new csvsqldb::LikeMatcher(node._like)));
         }
 
         virtual void visit(ASTBetweenNode& node)
@@ -164,6 +164,21 @@ namespace csvsqldb
 
         virtual void visit(ASTInNode& node)
         {
+            Variants values;
+            for(const auto& exp : node._expressions) {
+                ASTValueNodePtr valueNode = std::dynamic_pointer_cast<ASTValueNode>(exp);
+                if(!valueNode) {
+                    break;
+                }
+                values.push_back(typedValueToVariant(valueNode->_value));
+            }
+            if(values.size() == node._expressions.size() && StackMachine::isHashableInList(values)) {
+                // lists of constants are looked up in a hash set instead of comparing each value
+                node._lhs->accept(*this);
+                _sm.addInstruction(
+                StackMachine::Instruction(StackMachine::INSET, std::make_shared<StackMachine::InSet>(values[0].getType(), values)));
+                return;
+            }
             for(auto i = node._expressions.rbegin(); i != node._expressions.rend(); ++i) {
                 (*i)->accept(*this);
             }
@@ -173,10 +188,15 @@ namespace csvsqldb
 
         virtual void visit(ASTFunctionNode& node)
         {
+            Variant result;
+            if(foldConstantCall(node, result)) {
+                _sm.addInstruction(StackMachine::Instruction(StackMachine::PUSH, result));
+                return;
+            }
             for(Parameters::reverse_iterator iter = node._parameters.rbegin(); iter != node._parameters.rend(); ++iter) {
                 (*iter)._exp->accept(*this);
             }
-            _sm.addInstruction(StackMachine::Instruction(StackMachine::FUNC, Variant(node._function->getName())));
+            _sm.addInstruction(StackMachine::Instruction(StackMachine::FUNC, node._function, resolveParameterCasts(node)));
         }
 
         virtual void visit(ASTAggregateFunctionNode& node)
@@ -192,6 +212,77 @@ namespace csvsqldb
         }
 
     protected:
+        /**
+         * Evaluates a call of a deterministic function, whose parameters are constants or such calls themselves, once
+         * instead of for every row.
+         * @param node The function call
+         * @param result The result of the call
+         * @return true, if the call was evaluated
+         */
+        static bool foldConstantCall(ASTFunctionNode& node, Variant& result)
+        {
+            if(!node._function->isDeterministic()) {
+                return false;
+            }
+
+            StackMachine sm;
+            for(Parameters::reverse_iterator iter = node._parameters.rbegin(); iter != node._parameters.rend(); ++iter) {
+                Variant value;
+                ASTValueNodePtr valueNode = std::dynamic_pointer_cast<ASTValueNode>((*iter)._exp);
+                ASTFunctionNodePtr functionNode = std::dynamic_pointer_cast<ASTFunctionNode>((*iter)._exp);
+                if(valueNode) {
+                    value = typedValueToVariant(valueNode->_value);
+                } else if(!functionNode || !foldConstantCall(*functionNode, value)) {
+                    return false;
+                }
+                sm.addInstruction(StackMachine::Instruction(StackMachine::PUSH, value));
+            }
+            sm.addInstruction(StackMachine::Instruction(StackMachine::FUNC, node._function));
+
+            try {
+                VariableStore store;
+                FunctionRegistry functions;
+                result = sm.evaluate(store, functions);
+            } catch(const std::exception&) {
+                // errors are reported when the call is evaluated for the rows
+                return false;
+            }
+            return true;
+        }
+
+        /**
+         * Decides for each parameter of a function call, if its value has to be converted to the parameter type of the
+         * function. The type of a parameter is only taken from constants, identifiers, casts and function calls.
+         * @param node The function call
+         * @return The parameter casts for the FUNC instruction, see StackMachine::Instruction::_parameterCasts
+         */
+        static Types resolveParameterCasts(const ASTFunctionNode& node)
+        {
+            const Types& parameterTypes = node._function->getParameterTypes();
+            Types casts;
+            if(parameterTypes.size() != node._parameters.size()) {
+                return casts;
+            }
+            for(size_t n = 0; n < parameterTypes.size(); ++n) {
+                casts.push_back(staticType(*node._parameters[n]._exp) == parameterTypes[n] ? NONE : parameterTypes[n]);
+            }
+            return casts;
+        }
+
+        static eType staticType(const ASTExprNode& exp)
+        {
+            if(const ASTIdentifier* identifier = dynamic_cast<const ASTIdentifier*>(&exp)) {
+                return identifier->_info ? identifier->_info->_type : NONE;
+            }
+            if(const ASTUnaryNode* unary = dynamic_cast<const ASTUnaryNode*>(&exp)) {
+                return unary->_op == OP_CAST ? unary->_castType : NONE;
+            }
+            if(dynamic_cast<const ASTValueNode*>(&exp) || dynamic_cast<const ASTFunctionNode*>(&exp)) {
+                return exp.type();
+            }
+            return NONE;
+        }
+
         size_t getMapping(const std::string& variable)
         {
             StackMachine::VariableMapping::iterator iter =
@@ -212,6 +303,12 @@ namespace csvsqldb
         size_t _index;
     };
 
+    /**
+     * Collects the identifiers an expression needs for its evaluation by a StackMachine. All users build the variable
+     * mapping of their stack machine from it, so every operand has to be visited, including the left side and the list
+     * of an IN expression. Otherwise a column only referenced there, as in 'WHERE id IN (1, 2)', stays unmapped and the
+     * evaluation fails. The parameters of aggregations are not visited, as they are evaluated by the aggregation itself.
+     */
     class ASTExpressionVariableVisitor : public ASTExpressionNodeVisitor
     {
     public:
@@ -249,6 +346,10 @@ namespace csvsqldb
 
         virtual void visit(ASTInNode& node)
         {
+            for(auto iter = node._expressions.rbegin(); iter != node._expressions.rend(); ++iter) {
+                (*iter)->accept(*this);
+            }
+            node._lhs->accept(*this);
         }
 
         virtual void visit(ASTFunctionNode& node)
@@ -270,6 +371,28 @@ namespace csvsqldb
     protected:
         IdentifierSet& _variables;
     };
+
+    /**
+     * Collects all identifiers referenced by an expression, including the ones inside aggregation parameters. Used to find
+     * the columns a query actually needs from a table.
+     */
+    class ASTReferencedVariableVisitor : public ASTExpressionVariableVisitor
+    {
+    public:
+        ASTReferencedVariableVisitor(IdentifierSet& variables)
+        : ASTExpressionVariableVisitor(variables)
+        {
+        }
+
+        using ASTExpressionVariableVisitor::visit;
+
+        virtual void visit(ASTAggregateFunctionNode& node)
+        {
+            for(const auto& param : node._parameters) {
+                param._exp->accept(*this);
+            }
+        }
+    };
 }
 
 #endif
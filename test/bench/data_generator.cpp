@@ -0,0 +1,258 @@
+//
+//  data_generator.cpp
+//  csvsqldb
+//
+//  BSD 3-Clause License
+//  Copyright (c) 2015, Lars-Christian Fürstenberg
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification, are permitted
+//  provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or other materials provided
+//  with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors may be used to
+//  endorse or promote products derived from this software without specific prior written
+//  permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+//  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+//  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+//  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "data_generator.h"
+
+#include "libcsvsqldb/base/date.h"
+#include "libcsvsqldb/base/exception.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace csvsqldb
+{
+    namespace bench
+    {
+        namespace
+        {
+            const uint64_t maxSkewedCardinality = 1 << 24;
+            const uint64_t dateRange = 7300;
+
+            uint64_t mix(uint64_t value)
+            {
+                value += 0x9e3779b97f4a7c15ULL;
+                value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+                value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+                return value ^ (value >> 31);
+            }
+
+            uint64_t hashName(const std::string& name)
+            {
+                uint64_t hash = 14695981039346656037ULL;
+                for(const auto c : name) {
+                    hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+                }
+                return hash;
+            }
+
+            const std::vector<std::string>& dates()
+            {
+                static std::vector<std::string> dates;
+                if(dates.empty()) {
+                    csvsqldb::Date date(2000, csvsqldb::Date::January, 1);
+                    for(uint64_t n = 0; n < dateRange; ++n) {
+                        dates.push_back(date.format("%F"));
+                        date.addDays(1);
+                    }
+                }
+                return dates;
+            }
+
+            void appendTwoDigits(uint64_t value, std::string& line)
+            {
+                line += static_cast<char>('0' + value / 10);
+                line += static_cast<char>('0' + value % 10);
+            }
+
+            void appendTime(uint64_t seconds, std::string& line)
+            {
+                appendTwoDigits(seconds / 3600, line);
+                line += ':';
+                appendTwoDigits((seconds / 60) % 60, line);
+                line += ':';
+                appendTwoDigits(seconds % 60, line);
+            }
+        }
+
+
+        ColumnSpec::ColumnSpec(const std::string& name, eType type, uint64_t cardinality, double skew, double nullRate, size_t stringLength)
+        : _name(name)
+        , _type(type)
+        , _cardinality(cardinality)
+        , _skew(skew)
+        , _nullRate(nullRate)
+        , _stringLength(stringLength)
+        {
+        }
+
+
+        DataGenerator::DataGenerator(uint64_t seed)
+        : _seed(seed)
+        , _state(seed)
+        {
+        }
+
+        uint64_t DataGenerator::next()
+        {
+            _state += 0x9e3779b97f4a7c15ULL;
+            return mix(_state);
+        }
+
+        double DataGenerator::nextDouble()
+        {
+            return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0);
+        }
+
+        uint64_t DataGenerator::drawKey(const ColumnSpec& column, const Distribution& distribution, uint64_t row)
+        {
+            if(!column._cardinality) {
+                return row;
+            }
+            if(distribution.empty()) {
+                return next() % column._cardinality;
+            }
+            Distribution::const_iterator iter = std::lower_bound(distribution.begin(), distribution.end(), nextDouble());
+            if(iter == distribution.end()) {
+                return column._cardinality - 1;
+            }
+            return static_cast<uint64_t>(iter - distribution.begin());
+        }
+
+        void DataGenerator::writeValue(const ColumnSpec& column, uint64_t key, std::string& line)
+        {
+            uint64_t hash = mix(key ^ hashName(column._name));
+
+            switch(column._type) {
+                case BOOLEAN:
+                    line += (hash & 1) ? '1' : '0';
+                    break;
+                case INT:
+                    line += std::to_string(key);
+                    break;
+                case REAL: {
+                    uint64_t cents = hash % 1000000;
+                    line += std::to_string(cents / 100);
+                    line += '.';
+                    appendTwoDigits(cents % 100, line);
+                    break;
+                }
+                case STRING: {
+                    for(size_t n = 0; n < column._stringLength; ++n) {
+                        if(n && n % 12 == 0) {
+                            hash = mix(hash);
+                        }
+                        line += static_cast<char>('a' + ((hash >> ((n % 12) * 5)) & 0x1f) % 26);
+                    }
+                    break;
+                }
+                case DATE:
+                    line += dates()[hash % dateRange];
+                    break;
+                case TIME:
+                    appendTime(hash % 86400, line);
+                    break;
+                case TIMESTAMP:
+                    line += dates()[hash % dateRange];
+                    line += 'T';
+                    appendTime((hash >> 32) % 86400, line);
+                    break;
+                case NONE:
+                    CSVSQLDB_THROW(csvsqldb::InvalidParameterException, "cannot generate values for column '" << column._name << "' without type");
+            }
+        }
+
+        uint64_t DataGenerator::generate(const TableSpec& table, std::ostream& stream)
+        {
+            _state = _seed ^ hashName(table._name);
+
+            std::vector<Distribution> distributions(table._columns.size());
+            for(size_t n = 0; n < table._columns.size(); ++n) {
+                const ColumnSpec& column = table._columns[n];
+                if(!column._cardinality || column._skew <= 0.0) {
+                    continue;
+                }
+                if(column._cardinality > maxSkewedCardinality) {
+                    CSVSQLDB_THROW(csvsqldb::InvalidParameterException,
+                                   "skewed column '" << column._name << "' supports at most " << maxSkewedCardinality << " keys");
+                }
+                Distribution& distribution = distributions[n];
+                distribution.reserve(column._cardinality);
+                double sum = 0.0;
+                for(uint64_t key = 0; key < column._cardinality; ++key) {
+                    sum += 1.0 / std::pow(static_cast<double>(key + 1), column._skew);
+                    distribution.push_back(sum);
+                }
+                for(auto& value : distribution) {
+                    value /= sum;
+                }
+            }
+
+            std::string line;
+            for(const auto& column : table._columns) {
+                if(!line.empty()) {
+                    line += ',';
+                }
+                line += column._name;
+            }
+            line += '\n';
+            stream << line;
+            uint64_t bytes = line.size();
+
+            for(uint64_t row = 0; row < table._rows; ++row) {
+                line.clear();
+                for(size_t n = 0; n < table._columns.size(); ++n) {
+                    const ColumnSpec& column = table._columns[n];
+                    if(n) {
+                        line += ',';
+                    }
+                    uint64_t key = drawKey(column, distributions[n], row);
+                    if(column._nullRate > 0.0 && nextDouble() < column._nullRate) {
+                        continue;
+                    }
+                    writeValue(column, key, line);
+                }
+                line += '\n';
+                stream << line;
+                bytes += line.size();
+            }
+            return bytes;
+        }
+
+        std::string DataGenerator::createTableStatement(const TableSpec& table)
+        {
+            std::string statement = "CREATE TABLE " + table._name + "(";
+            for(size_t n = 0; n < table._columns.size(); ++n) {
+                const ColumnSpec& column = table._columns[n];
+                if(n) {
+                    statement += ", ";
+                }
+                statement += column._name + " " + typeToString(column._type);
+                if(column._type == STRING) {
+                    statement += "(" + std::to_string(column._stringLength) + ")";
+                }
+            }
+            return statement + ")";
+        }
+    }
+}
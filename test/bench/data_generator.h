@@ -0,0 +1,103 @@
+//
+//  data_generator.h
+//  csvsqldb
+//
+//  BSD 3-Clause License
+//  Copyright (c) 2015, Lars-Christian Fürstenberg
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification, are permitted
+//  provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or other materials provided
+//  with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors may be used to
+//  endorse or promote products derived from this software without specific prior written
+//  permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+//  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+//  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+//  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef csvsqldb_bench_data_generator_h
+#define csvsqldb_bench_data_generator_h
+
+#include "libcsvsqldb/types.h"
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+
+namespace csvsqldb
+{
+    namespace bench
+    {
+        /**
+         * Describes how the values of a generated column are drawn.
+         * A cardinality of 0 produces unique values (the row number), otherwise values are keys out of [0, cardinality)
+         * following a zipf distribution with the given skew (0.0 means uniform). Strings derive their characters from the key,
+         * so equal keys give equal strings.
+         */
+        struct ColumnSpec {
+            ColumnSpec(const std::string& name, eType type, uint64_t cardinality = 0, double skew = 0.0, double nullRate = 0.0,
+                       size_t stringLength = 16);
+
+            std::string _name;
+            eType _type;
+            uint64_t _cardinality;
+            double _skew;
+            double _nullRate;
+            size_t _stringLength;
+        };
+
+        struct TableSpec {
+            std::string _name;
+            uint64_t _rows;
+            std::vector<ColumnSpec> _columns;
+        };
+
+        /**
+         * Deterministic generator for large csv datasets. The same seed and table specification always produce the same file
+         * content, independent of platform and standard library.
+         */
+        class DataGenerator
+        {
+        public:
+            DataGenerator(uint64_t seed);
+
+            /**
+             * Writes a csv file with a header line for the given table to the stream.
+             * @return The number of bytes written
+             */
+            uint64_t generate(const TableSpec& table, std::ostream& stream);
+
+            static std::string createTableStatement(const TableSpec& table);
+
+        private:
+            typedef std::vector<double> Distribution;
+
+            uint64_t next();
+            double nextDouble();
+            uint64_t drawKey(const ColumnSpec& column, const Distribution& distribution, uint64_t row);
+            void writeValue(const ColumnSpec& column, uint64_t key, std::string& line);
+
+            uint64_t _seed;
+            uint64_t _state;
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,372 @@
+//
+//  main.cpp
+//  csvsqldb
+//
+//  BSD 3-Clause License
+//  Copyright (c) 2015, Lars-Christian Fürstenberg
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification, are permitted
+//  provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or other materials provided
+//  with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors may be used to
+//  endorse or promote products derived from this software without specific prior written
+//  permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+//  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+//  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+//  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "data_generator.h"
+
+#include "libcsvsqldb/base/application.h"
+#include "libcsvsqldb/base/default_configuration.h"
+#include "libcsvsqldb/base/global_configuration.h"
+#include "libcsvsqldb/base/logging.h"
+#include "libcsvsqldb/base/metrics.h"
+#include "libcsvsqldb/execution_engine.h"
+#include "libcsvsqldb/version.h"
+
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+
+
+namespace po = boost::program_options;
+
+
+namespace
+{
+    /**
+     * Discards the query output but counts the bytes written to it.
+     */
+    class CountingBuffer : public std::streambuf
+    {
+    public:
+        CountingBuffer()
+        : _count(0)
+        {
+        }
+
+        uint64_t count() const
+        {
+            return _count;
+        }
+
+    protected:
+        virtual int_type overflow(int_type c)
+        {
+            ++_count;
+            return traits_type::not_eof(c);
+        }
+
+        virtual std::streamsize xsputn(const char_type*, std::streamsize count)
+        {
+            _count += static_cast<uint64_t>(count);
+            return count;
+        }
+
+    private:
+        uint64_t _count;
+    };
+
+    struct Query {
+        std::string _name;
+        std::string _sql;
+        csvsqldb::StringVector _tables;
+    };
+
+    struct Result {
+        int64_t _rows;
+        uint64_t _outputBytes;
+        std::vector<double> _seconds;
+        size_t _maxUsedBlocks;
+        size_t _maxUsedCapacity;
+        uint64_t _processPeakResidentBytes; //!< of the whole benchmark process up to the end of the query
+    };
+
+    std::string jsonString(const std::string& value)
+    {
+        std::string result("\"");
+        for(const auto c : value) {
+            if(c == '"' || c == '\\') {
+                result += '\\';
+            }
+            result += c;
+        }
+        return result + "\"";
+    }
+}
+
+
+class BenchGlobalConfiguration : public csvsqldb::GlobalConfiguration
+{
+public:
+    virtual void doConfigure(const csvsqldb::Configuration::Ptr&)
+    {
+        if(logging.device == "None") {
+            logging.device = "Console";
+        }
+    }
+};
+
+
+class BenchApp : public csvsqldb::Application
+{
+public:
+    BenchApp(int argc, char** argv)
+    : csvsqldb::Application(argc, argv)
+    , _workDir("./csvsqldb_bench")
+    , _rows(1000000)
+    , _seed(4711)
+    , _keys(10000)
+    , _skew(0.0)
+    , _nullRate(0.0)
+    , _stringLength(16)
+    , _repetitions(3)
+    , _threads(1)
+    {
+        csvsqldb::GlobalConfiguration::create<BenchGlobalConfiguration>();
+        csvsqldb::config<BenchGlobalConfiguration>()->configure(std::make_shared<csvsqldb::DefaultConfiguration>());
+        csvsqldb::Logging::init();
+    }
+
+private:
+    virtual bool setUp(int argc, char** argv)
+    {
+        // clang-format off
+        po::options_description desc("Options");
+        desc.add_options()
+        ("help", "shows this help")
+        ("work-dir,w", po::value<std::string>(&_workDir), "directory for the generated csv files and the database")
+        ("rows,r", po::value<uint64_t>(&_rows), "number of rows of the fact table")
+        ("seed", po::value<uint64_t>(&_seed), "seed of the data generator")
+        ("keys,k", po::value<uint64_t>(&_keys), "number of distinct join and grouping keys")
+        ("skew", po::value<double>(&_skew), "zipf skew of the key columns, 0 means uniform")
+        ("null-rate", po::value<double>(&_nullRate), "fraction of NULL values in the nullable columns")
+        ("string-length", po::value<size_t>(&_stringLength), "length of the generated strings")
+        ("repetitions,n", po::value<size_t>(&_repetitions), "number of measured runs per query")
+        ("threads,t", po::value<uint16_t>(&_threads), "number of threads used by parallel operators")
+        ("query,q", po::value<csvsqldb::StringVector>(&_queryNames)->composing(), "run only the named queries")
+        ("output,o", po::value<std::string>(&_output), "write the json report to this file instead of stdout");
+        // clang-format on
+
+        po::variables_map vm;
+        po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
+        po::notify(vm);
+
+        if(vm.count("help")) {
+            std::cout << "csvsqldb benchmark version " << CSVSQLDB_VERSION_STRING << std::endl;
+            std::cout << desc << std::endl;
+            return false;
+        }
+        if(!_repetitions) {
+            CSVSQLDB_THROW(csvsqldb::BadoptionException, "at least one repetition is needed");
+        }
+        if(_nullRate < 0.0 || _nullRate >= 1.0) {
+            CSVSQLDB_THROW(csvsqldb::BadoptionException, "the null rate has to be in [0, 1)");
+        }
+
+        csvsqldb::initTypeSystem();
+
+        return true;
+    }
+
+    virtual int doRun()
+    {
+        fs::path workDir = fs::absolute(fs::path(_workDir));
+        fs::path dataDir = workDir / "data";
+        fs::path databaseDir = workDir / ".csvdb";
+        fs::remove_all(databaseDir);
+        fs::create_directories(dataDir);
+
+        std::vector<csvsqldb::bench::TableSpec> tables = tableSpecs();
+        csvsqldb::StringVector files;
+        std::map<std::string, uint64_t> tableBytes;
+        std::map<std::string, uint64_t> tableRows;
+        csvsqldb::bench::DataGenerator generator(_seed);
+        for(const auto& table : tables) {
+            fs::path file = dataDir / (table._name + ".csv");
+            std::ofstream stream(file.string());
+            tableBytes[table._name] = generator.generate(table, stream);
+            tableRows[table._name] = table._rows;
+            if(!stream) {
+                CSVSQLDB_THROW(csvsqldb::FilesystemException, "could not write '" << file.string() << "'");
+            }
+            files.push_back(file.string());
+        }
+
+        csvsqldb::Database database(databaseDir, csvsqldb::FileMapping());
+        database.setUp();
+        csvsqldb::ExecutionContext context(database);
+        context._files = files;
+        context._numberOfThreads = _threads;
+
+        for(const auto& table : tables) {
+            execute(context, csvsqldb::bench::DataGenerator::createTableStatement(table));
+            execute(context, "CREATE MAPPING " + table._name + "(\"" + table._name + ".csv\")");
+        }
+
+        std::ofstream file;
+        if(!_output.empty()) {
+            file.open(_output);
+            if(!file) {
+                CSVSQLDB_THROW(csvsqldb::FilesystemException, "could not open '" << _output << "'");
+            }
+        }
+        std::ostream& report = _output.empty() ? std::cout : file;
+
+        report << "{\"version\":" << jsonString(CSVSQLDB_VERSION_STRING) << ",\"seed\":" << _seed << ",\"rows\":" << _rows
+               << ",\"keys\":" << _keys << ",\"skew\":" << _skew << ",\"null_rate\":" << _nullRate << ",\"string_length\":" << _stringLength
+               << ",\"repetitions\":" << _repetitions << ",\"threads\":" << _threads << ",\"queries\":[";
+
+        bool first = true;
+        for(const auto& query : querySuite()) {
+            if(!_queryNames.empty() && std::find(_queryNames.begin(), _queryNames.end(), query._name) == _queryNames.end()) {
+                continue;
+            }
+            Result result = measure(context, query);
+
+            uint64_t inputRows = 0;
+            uint64_t inputBytes = 0;
+            for(const auto& table : query._tables) {
+                inputRows += tableRows[table];
+                inputBytes += tableBytes[table];
+            }
+            std::sort(result._seconds.begin(), result._seconds.end());
+            double best = std::max(result._seconds.front(), 1e-9);
+            double median = result._seconds[result._seconds.size() / 2];
+
+            report << (first ? "" : ",") << "\n{\"name\":" << jsonString(query._name) << ",\"sql\":" << jsonString(query._sql)
+                   << ",\"result_rows\":" << result._rows << ",\"output_bytes\":" << result._outputBytes << ",\"input_rows\":" << inputRows
+                   << ",\"input_bytes\":" << inputBytes << ",\"best_seconds\":" << best << ",\"median_seconds\":" << median
+                   << ",\"rows_per_second\":" << static_cast<uint64_t>(inputRows / best)
+                   << ",\"bytes_per_second\":" << static_cast<uint64_t>(inputBytes / best) << ",\"peak_blocks\":" << result._maxUsedBlocks
+                   << ",\"peak_block_mib\":" << result._maxUsedCapacity
+                   << ",\"process_peak_rss_bytes\":" << result._processPeakResidentBytes << "}";
+            first = false;
+        }
+        report << "\n]}" << std::endl;
+
+        return 0;
+    }
+
+    std::vector<csvsqldb::bench::TableSpec> tableSpecs() const
+    {
+        using csvsqldb::bench::ColumnSpec;
+
+        csvsqldb::bench::TableSpec facts;
+        facts._name = "facts";
+        facts._rows = _rows;
+        facts._columns.push_back(ColumnSpec("id", csvsqldb::INT));
+        facts._columns.push_back(ColumnSpec("dim_key", csvsqldb::INT, _keys, _skew));
+        facts._columns.push_back(ColumnSpec("amount", csvsqldb::REAL, 0, 0.0, _nullRate));
+        facts._columns.push_back(ColumnSpec("name", csvsqldb::STRING, _keys, _skew, 0.0, _stringLength));
+        facts._columns.push_back(ColumnSpec("flag", csvsqldb::BOOLEAN));
+        facts._columns.push_back(ColumnSpec("created", csvsqldb::DATE, 0, 0.0, _nullRate));
+
+        csvsqldb::bench::TableSpec dims;
+        dims._name = "dims";
+        dims._rows = _keys;
+        dims._columns.push_back(ColumnSpec("dim_key", csvsqldb::INT));
+        dims._columns.push_back(ColumnSpec("label", csvsqldb::STRING, 0, 0.0, 0.0, _stringLength));
+
+        return { facts, dims };
+    }
+
+    static std::vector<Query> querySuite()
+    {
+        // clang-format off
+        return {
+            { "scan", "SELECT * FROM facts", { "facts" } },
+            { "filter", "SELECT id,amount FROM facts WHERE amount > 9000.0", { "facts" } },
+            { "projection", "SELECT id,amount * 2.0 AS doubled,upper(name) AS upper_name FROM facts", { "facts" } },
+            { "group_by", "SELECT dim_key,count(*) AS cnt,sum(amount) AS total FROM facts GROUP BY dim_key", { "facts" } },
+            { "sort", "SELECT id,amount FROM facts ORDER BY amount DESC, id", { "facts" } },
+            { "top_n", "SELECT id,amount FROM facts ORDER BY amount DESC, id LIMIT 100", { "facts" } },
+            { "hash_join", "SELECT f.id,d.label FROM facts f INNER JOIN dims d ON f.dim_key = d.dim_key", { "facts", "dims" } },
+            { "union", "SELECT dim_key FROM facts UNION (SELECT dim_key FROM dims)", { "facts", "dims" } }
+        };
+        // clang-format on
+    }
+
+    static int64_t execute(csvsqldb::ExecutionContext& context, const std::string& sql, csvsqldb::ExecutionStatistics& statistics,
+                           std::ostream& stream)
+    {
+        csvsqldb::ExecutionEngine<csvsqldb::OperatorNodeFactory> engine(context);
+        return engine.execute(sql, statistics, stream);
+    }
+
+    static void execute(csvsqldb::ExecutionContext& context, const std::string& sql)
+    {
+        csvsqldb::ExecutionStatistics statistics;
+        CountingBuffer buffer;
+        std::ostream stream(&buffer);
+        execute(context, sql, statistics, stream);
+    }
+
+    Result measure(csvsqldb::ExecutionContext& context, const Query& query) const
+    {
+        Result result;
+        result._maxUsedBlocks = 0;
+        result._maxUsedCapacity = 0;
+
+        // one unmeasured run to warm up the page cache
+        execute(context, query._sql);
+
+        for(size_t n = 0; n < _repetitions; ++n) {
+            csvsqldb::ExecutionStatistics statistics;
+            CountingBuffer buffer;
+            std::ostream stream(&buffer);
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            result._rows = execute(context, query._sql, statistics, stream);
+            result._seconds.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+            result._outputBytes = buffer.count();
+            result._maxUsedBlocks = std::max(result._maxUsedBlocks, statistics._maxUsedBlocks);
+            result._maxUsedCapacity = std::max(result._maxUsedCapacity, statistics._maxUsedCapacity);
+        }
+        result._processPeakResidentBytes = csvsqldb::metrics::peakResidentBytes();
+
+        return result;
+    }
+
+    std::string _workDir;
+    std::string _output;
+    uint64_t _rows;
+    uint64_t _seed;
+    uint64_t _keys;
+    double _skew;
+    double _nullRate;
+    size_t _stringLength;
+    size_t _repetitions;
+    uint16_t _threads;
+    csvsqldb::StringVector _queryNames;
+};
+
+
+int main(int argc, char** argv)
+{
+    BenchApp app(argc, argv);
+    return app.run();
+}
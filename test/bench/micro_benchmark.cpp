@@ -0,0 +1,207 @@
+//
+//  micro_benchmark.cpp
+//  csvsqldb
+//
+//  BSD 3-Clause License
+//  Copyright (c) 2015, Lars-Christian Fürstenberg
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification, are permitted
+//  provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or other materials provided
+//  with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors may be used to
+//  endorse or promote products derived from this software without specific prior written
+//  permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+//  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+//  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+//  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "micro_benchmark.h"
+
+#include "libcsvsqldb/base/exception.h"
+#include "libcsvsqldb/base/json_object.h"
+#include "libcsvsqldb/base/json_parser.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+
+
+namespace csvsqldb
+{
+    namespace bench
+    {
+        namespace
+        {
+            volatile uint64_t sink = 0;
+
+            MicroSummary summarize(const std::string& name, uint64_t operations, std::vector<double> samples)
+            {
+                std::sort(samples.begin(), samples.end());
+
+                MicroSummary summary;
+                summary._name = name;
+                summary._operations = operations;
+                summary._repetitions = samples.size();
+                summary._min = samples.front();
+                summary._median = samples.size() % 2 ? samples[samples.size() / 2]
+                                                     : (samples[samples.size() / 2 - 1] + samples[samples.size() / 2]) / 2.0;
+                double sum = 0.0;
+                for(const auto sample : samples) {
+                    sum += sample;
+                }
+                summary._mean = sum / samples.size();
+                double deviation = 0.0;
+                for(const auto sample : samples) {
+                    deviation += (sample - summary._mean) * (sample - summary._mean);
+                }
+                summary._stddev = samples.size() > 1 ? std::sqrt(deviation / (samples.size() - 1)) : 0.0;
+                return summary;
+            }
+        }
+
+
+        void consume(uint64_t value)
+        {
+            sink = sink + value;
+        }
+
+
+        MicroBenchmark::MicroBenchmark(size_t warmup, size_t repetitions)
+        : _warmup(warmup)
+        , _repetitions(repetitions)
+        {
+            if(!_repetitions) {
+                CSVSQLDB_THROW(csvsqldb::InvalidParameterException, "at least one repetition is needed");
+            }
+        }
+
+        void MicroBenchmark::add(const std::string& name, Kernel kernel, SetUp setUp)
+        {
+            _entries.push_back({ name, kernel, setUp });
+        }
+
+        MicroSummaries MicroBenchmark::run(const std::string& filter) const
+        {
+            MicroSummaries summaries;
+            for(const auto& entry : _entries) {
+                if(entry._name.find(filter) == std::string::npos) {
+                    continue;
+                }
+                for(size_t n = 0; n < _warmup; ++n) {
+                    if(entry._setUp) {
+                        entry._setUp();
+                    }
+                    entry._kernel();
+                }
+
+                uint64_t operations = 0;
+                std::vector<double> samples;
+                for(size_t n = 0; n < _repetitions; ++n) {
+                    if(entry._setUp) {
+                        entry._setUp();
+                    }
+                    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                    operations = entry._kernel();
+                    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+                    samples.push_back(elapsed.count() / std::max<uint64_t>(operations, 1));
+                }
+                summaries.push_back(summarize(entry._name, operations, samples));
+            }
+            return summaries;
+        }
+
+        void writeBaseline(const MicroSummaries& summaries, std::ostream& stream)
+        {
+            stream << "{\"benchmarks\":[";
+            bool first = true;
+            for(const auto& summary : summaries) {
+                stream << (first ? "" : ",") << "\n{\"name\":\"" << summary._name << "\",\"operations\":" << summary._operations
+                       << ",\"repetitions\":" << summary._repetitions << ",\"min_ns\":" << summary._min
+                       << ",\"median_ns\":" << summary._median << ",\"mean_ns\":" << summary._mean << ",\"stddev_ns\":" << summary._stddev
+                       << "}";
+                first = false;
+            }
+            stream << "\n]}" << std::endl;
+        }
+
+        MicroSummaries readBaseline(const std::string& file)
+        {
+            std::ifstream stream(file);
+            if(!stream) {
+                CSVSQLDB_THROW(csvsqldb::FilesystemException, "could not open baseline '" << file << "'");
+            }
+            std::shared_ptr<csvsqldb::json::JsonObjectCallback> callback = std::make_shared<csvsqldb::json::JsonObjectCallback>();
+            csvsqldb::json::Parser parser(stream, callback);
+            if(!parser.parse()) {
+                CSVSQLDB_THROW(csvsqldb::JsonException, "baseline '" << file << "' is not valid json");
+            }
+
+            MicroSummaries summaries;
+            for(const auto& object : callback->getObject()["benchmarks"].getArray()) {
+                MicroSummary summary;
+                summary._name = object["name"].getAsString();
+                summary._operations = static_cast<uint64_t>(object["operations"].getAsDouble());
+                summary._repetitions = static_cast<size_t>(object["repetitions"].getAsDouble());
+                summary._min = object["min_ns"].getAsDouble();
+                summary._median = object["median_ns"].getAsDouble();
+                summary._mean = object["mean_ns"].getAsDouble();
+                summary._stddev = object["stddev_ns"].getAsDouble();
+                summaries.push_back(summary);
+            }
+            return summaries;
+        }
+
+        size_t printSummaries(const MicroSummaries& summaries, const MicroSummaries& baseline, double threshold, std::ostream& stream)
+        {
+            size_t regressions = 0;
+
+            stream << std::left << std::setw(36) << "kernel" << std::right << std::setw(12) << "median ns" << std::setw(12) << "min ns"
+                   << std::setw(12) << "mean ns" << std::setw(10) << "stddev";
+            if(!baseline.empty()) {
+                stream << std::setw(12) << "baseline" << std::setw(10) << "change";
+            }
+            stream << "\n";
+
+            for(const auto& summary : summaries) {
+                stream << std::left << std::setw(36) << summary._name << std::right << std::fixed << std::setprecision(2) << std::setw(12)
+                       << summary._median << std::setw(12) << summary._min << std::setw(12) << summary._mean << std::setw(9)
+                       << (summary._mean > 0.0 ? 100.0 * summary._stddev / summary._mean : 0.0) << "%";
+
+                MicroSummaries::const_iterator iter = std::find_if(baseline.begin(), baseline.end(), [&summary](const MicroSummary& base) {
+                    return base._name == summary._name;
+                });
+                if(iter != baseline.end() && iter->_median > 0.0) {
+                    double change = summary._median / iter->_median - 1.0;
+                    stream << std::setw(12) << iter->_median << std::setw(9) << std::showpos << 100.0 * change << std::noshowpos << "%";
+                    if(change > threshold) {
+                        stream << "  REGRESSION";
+                        ++regressions;
+                    }
+                } else if(!baseline.empty()) {
+                    stream << std::setw(12) << "-" << std::setw(10) << "-";
+                }
+                stream << "\n";
+            }
+            stream << std::defaultfloat;
+            return regressions;
+        }
+    }
+}
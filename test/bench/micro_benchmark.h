@@ -0,0 +1,110 @@
+//
+//  micro_benchmark.h
+//  csvsqldb
+//
+//  BSD 3-Clause License
+//  Copyright (c) 2015, Lars-Christian Fürstenberg
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification, are permitted
+//  provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or other materials provided
+//  with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors may be used to
+//  endorse or promote products derived from this software without specific prior written
+//  permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+//  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+//  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+//  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef csvsqldb_bench_micro_benchmark_h
+#define csvsqldb_bench_micro_benchmark_h
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+
+namespace csvsqldb
+{
+    namespace bench
+    {
+        /**
+         * Statistical summary of the repetitions of one kernel. All times are nanoseconds per operation.
+         */
+        struct MicroSummary {
+            std::string _name;
+            uint64_t _operations;
+            size_t _repetitions;
+            double _min;
+            double _median;
+            double _mean;
+            double _stddev;
+        };
+
+        typedef std::vector<MicroSummary> MicroSummaries;
+
+        /**
+         * Runs registered kernels with warmup and repetitions. A kernel executes one batch of operations and returns how many
+         * operations it executed. The optional set up function prepares the input of the next batch and is not measured.
+         */
+        class MicroBenchmark
+        {
+        public:
+            typedef std::function<uint64_t()> Kernel;
+            typedef std::function<void()> SetUp;
+
+            MicroBenchmark(size_t warmup, size_t repetitions);
+
+            void add(const std::string& name, Kernel kernel, SetUp setUp = SetUp());
+
+            /**
+             * Runs all kernels whose name contains the filter string.
+             */
+            MicroSummaries run(const std::string& filter) const;
+
+        private:
+            struct Entry {
+                std::string _name;
+                Kernel _kernel;
+                SetUp _setUp;
+            };
+
+            std::vector<Entry> _entries;
+            size_t _warmup;
+            size_t _repetitions;
+        };
+
+        /**
+         * Keeps the compiler from optimizing away kernel results.
+         */
+        void consume(uint64_t value);
+
+        void writeBaseline(const MicroSummaries& summaries, std::ostream& stream);
+        MicroSummaries readBaseline(const std::string& file);
+
+        /**
+         * Prints the summaries and compares their medians against the baseline.
+         * @return The number of kernels that got slower than the baseline by more than the threshold
+         */
+        size_t printSummaries(const MicroSummaries& summaries, const MicroSummaries& baseline, double threshold, std::ostream& stream);
+    }
+}
+
+#endif
@@ -0,0 +1,617 @@
+//
+//  micro_main.cpp
+//  csvsqldb
+//
+//  BSD 3-Clause License
+//  Copyright (c) 2015, Lars-Christian Fürstenberg
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification, are permitted
+//  provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or other materials provided
+//  with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors may be used to
+//  endorse or promote products derived from this software without specific prior written
+//  permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+//  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+//  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+//  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "data_generator.h"
+#include "micro_benchmark.h"
+
+#include "libcsvsqldb/base/application.h"
+#include "libcsvsqldb/base/csv_parser.h"
+#include "libcsvsqldb/base/csv_string_parser.h"
+#include "libcsvsqldb/base/default_configuration.h"
+#include "libcsvsqldb/base/global_configuration.h"
+#include "libcsvsqldb/base/logging.h"
+#include "libcsvsqldb/base/regexp.h"
+#include "libcsvsqldb/block_iterator.h"
+#include "libcsvsqldb/buildin_functions.h"
+#include "libcsvsqldb/sql_parser.h"
+#include "libcsvsqldb/stack_machine.h"
+#include "libcsvsqldb/typeoperations.h"
+#include "libcsvsqldb/version.h"
+#include "libcsvsqldb/visitor.h"
+
+#include <boost/program_options.hpp>
+
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <unordered_map>
+
+
+namespace po = boost::program_options;
+
+
+namespace
+{
+    /**
+     * Lets a stream read from a string without copying it for every batch.
+     */
+    class MemoryBuffer : public std::streambuf
+    {
+    public:
+        MemoryBuffer(const std::string& data)
+        {
+            char* start = const_cast<char*>(data.data());
+            setg(start, start, start + data.size());
+        }
+    };
+
+    class CountingCallback : public csvsqldb::csv::CSVParserCallback
+    {
+    public:
+        CountingCallback()
+        : _values(0)
+        , _checksum(0)
+        {
+        }
+
+        virtual void onLong(int64_t num, bool)
+        {
+            ++_values;
+            _checksum += static_cast<uint64_t>(num);
+        }
+        virtual void onDouble(double num, bool)
+        {
+            ++_values;
+            _checksum += num != 0.0 ? 1 : 0;
+        }
+        virtual void onString(const char* s, size_t len, bool)
+        {
+            ++_values;
+            _checksum += len;
+        }
+        virtual void onDate(const csvsqldb::Date& date, bool)
+        {
+            ++_values;
+            _checksum += date.asJulianDay();
+        }
+        virtual void onTime(const csvsqldb::Time&, bool)
+        {
+            ++_values;
+        }
+        virtual void onTimestamp(const csvsqldb::Timestamp&, bool)
+        {
+            ++_values;
+        }
+        virtual void onBoolean(bool boolean, bool)
+        {
+            ++_values;
+            _checksum += boolean ? 1 : 0;
+        }
+
+        uint64_t _values;
+        uint64_t _checksum;
+    };
+
+    class FieldReader
+    {
+    public:
+        FieldReader(const std::string& data)
+        : _data(data)
+        , _pos(0)
+        {
+        }
+
+        char readNextChar(bool ignoreDelimiter)
+        {
+            if(_pos == _data.size()) {
+                return '\0';
+            }
+            if(!ignoreDelimiter && _data[_pos] == ',') {
+                ++_pos;
+                return '\0';
+            }
+            return _data[_pos++];
+        }
+
+        void rewind()
+        {
+            _pos = 0;
+        }
+
+    private:
+        const std::string& _data;
+        size_t _pos;
+    };
+
+    class VectorBlockProvider : public csvsqldb::BlockProvider
+    {
+    public:
+        VectorBlockProvider(const csvsqldb::Blocks& blocks)
+        : _blocks(blocks)
+        , _next(0)
+        {
+        }
+
+        virtual csvsqldb::BlockPtr getNextBlock()
+        {
+            return _next < _blocks.size() ? _blocks[_next++] : nullptr;
+        }
+
+    private:
+        const csvsqldb::Blocks& _blocks;
+        size_t _next;
+    };
+
+    class IteratorRowProvider : public csvsqldb::RowProvider
+    {
+    public:
+        IteratorRowProvider(csvsqldb::BlockIterator& iterator)
+        : _iterator(iterator)
+        {
+        }
+
+        virtual const csvsqldb::Values* getNextRow()
+        {
+            return _iterator.getNextRow();
+        }
+
+    private:
+        csvsqldb::BlockIterator& _iterator;
+    };
+
+    struct Row {
+        int64_t _int;
+        double _real;
+        std::string _string;
+        csvsqldb::Date _date;
+    };
+
+    typedef std::vector<Row> Rows;
+}
+
+
+class MicroBenchGlobalConfiguration : public csvsqldb::GlobalConfiguration
+{
+public:
+    virtual void doConfigure(const csvsqldb::Configuration::Ptr&)
+    {
+        if(logging.device == "None") {
+            logging.device = "Console";
+        }
+    }
+};
+
+
+class MicroBenchApp : public csvsqldb::Application
+{
+public:
+    MicroBenchApp(int argc, char** argv)
+    : csvsqldb::Application(argc, argv)
+    , _warmup(2)
+    , _repetitions(10)
+    , _size(100000)
+    , _seed(4711)
+    , _threshold(0.1)
+    , _blockManager(10000)
+    {
+        csvsqldb::GlobalConfiguration::create<MicroBenchGlobalConfiguration>();
+        csvsqldb::config<MicroBenchGlobalConfiguration>()->configure(std::make_shared<csvsqldb::DefaultConfiguration>());
+        csvsqldb::Logging::init();
+    }
+
+private:
+    virtual bool setUp(int argc, char** argv)
+    {
+        // clang-format off
+        po::options_description desc("Options");
+        desc.add_options()
+        ("help", "shows this help")
+        ("warmup,w", po::value<size_t>(&_warmup), "number of unmeasured runs per kernel")
+        ("repetitions,n", po::value<size_t>(&_repetitions), "number of measured runs per kernel")
+        ("size,s", po::value<size_t>(&_size), "number of operations per run")
+        ("seed", po::value<uint64_t>(&_seed), "seed of the input data")
+        ("filter,f", po::value<std::string>(&_filter), "run only kernels containing this string")
+        ("baseline,b", po::value<std::string>(&_baseline), "compare the results against this baseline file")
+        ("save-baseline", po::value<std::string>(&_saveBaseline), "write the results as new baseline file")
+        ("threshold", po::value<double>(&_threshold), "relative slow down of the median that counts as regression");
+        // clang-format on
+
+        po::variables_map vm;
+        po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
+        po::notify(vm);
+
+        if(vm.count("help")) {
+            std::cout << "csvsqldb micro benchmark version " << CSVSQLDB_VERSION_STRING << std::endl;
+            std::cout << desc << std::endl;
+            return false;
+        }
+
+        csvsqldb::initTypeSystem();
+        csvsqldb::initBuildInFunctions(_functions);
+
+        return true;
+    }
+
+    virtual int doRun()
+    {
+        createRows();
+
+        csvsqldb::bench::MicroBenchmark benchmark(_warmup, _repetitions);
+        addCsvKernels(benchmark);
+        addStackMachineKernels(benchmark);
+        addOperationKernels(benchmark);
+        addBlockKernels(benchmark);
+        addGroupingKernels(benchmark);
+        addRegExpKernels(benchmark);
+
+        csvsqldb::bench::MicroSummaries summaries = benchmark.run(_filter);
+        releaseBlocks();
+
+        csvsqldb::bench::MicroSummaries baseline;
+        if(!_baseline.empty()) {
+            baseline = csvsqldb::bench::readBaseline(_baseline);
+        }
+        size_t regressions = csvsqldb::bench::printSummaries(summaries, baseline, _threshold, std::cout);
+
+        if(!_saveBaseline.empty()) {
+            std::ofstream stream(_saveBaseline);
+            if(!stream) {
+                CSVSQLDB_THROW(csvsqldb::FilesystemException, "could not write baseline '" << _saveBaseline << "'");
+            }
+            csvsqldb::bench::writeBaseline(summaries, stream);
+        }
+        if(regressions) {
+            std::cout << regressions << " kernel(s) regressed by more than " << (_threshold * 100.0) << "%" << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    void createRows()
+    {
+        std::minstd_rand random(static_cast<std::minstd_rand::result_type>(_seed));
+        _rows.resize(_size);
+        for(auto& row : _rows) {
+            row._int = static_cast<int64_t>(random() % 1000);
+            row._real = static_cast<double>(random() % 100000) / 100.0;
+            row._string.clear();
+            size_t length = 4 + random() % 20;
+            for(size_t n = 0; n < length; ++n) {
+                row._string += static_cast<char>('a' + random() % 26);
+            }
+            row._date = csvsqldb::Date(2000, csvsqldb::Date::January, 1);
+            row._date.addDays(static_cast<int16_t>(random() % 7300));
+        }
+    }
+
+    void addCsvKernels(csvsqldb::bench::MicroBenchmark& benchmark)
+    {
+        struct CsvColumn {
+            const char* _name;
+            csvsqldb::eType _type;
+            csvsqldb::csv::CsvTypes _csvType;
+        };
+        const CsvColumn columns[] = { { "int", csvsqldb::INT, csvsqldb::csv::LONG },
+                                      { "real", csvsqldb::REAL, csvsqldb::csv::DOUBLE },
+                                      { "string", csvsqldb::STRING, csvsqldb::csv::STRING },
+                                      { "bool", csvsqldb::BOOLEAN, csvsqldb::csv::BOOLEAN },
+                                      { "date", csvsqldb::DATE, csvsqldb::csv::DATE },
+                                      { "time", csvsqldb::TIME, csvsqldb::csv::TIME },
+                                      { "timestamp", csvsqldb::TIMESTAMP, csvsqldb::csv::TIMESTAMP } };
+
+        csvsqldb::bench::DataGenerator generator(_seed);
+        for(const auto& column : columns) {
+            csvsqldb::bench::TableSpec table;
+            table._name = column._name;
+            table._rows = _size;
+            table._columns.push_back(csvsqldb::bench::ColumnSpec("value", column._type, 1000));
+            std::ostringstream data;
+            generator.generate(table, data);
+            _csvData.push_back(data.str());
+
+            const std::string& input = _csvData.back();
+            csvsqldb::csv::CsvTypes type = column._csvType;
+            benchmark.add(std::string("csv_parser_") + column._name, [&input, type]() {
+                MemoryBuffer buffer(input);
+                std::istream stream(&buffer);
+                csvsqldb::csv::CSVParserContext context;
+                context._skipFirstLine = true;
+                CountingCallback callback;
+                csvsqldb::csv::CSVParser parser(context, stream, { type }, callback);
+                while(parser.parseLine()) {
+                }
+                csvsqldb::bench::consume(callback._checksum);
+                return callback._values;
+            });
+        }
+
+        std::string plain;
+        std::string quoted;
+        for(const auto& row : _rows) {
+            plain += row._string + ",";
+            quoted += "'" + row._string + ", " + row._string + "',";
+        }
+        _csvData.push_back(plain);
+        addStringParserKernel(benchmark, "csv_string_parser_plain", _csvData.back());
+        _csvData.push_back(quoted);
+        addStringParserKernel(benchmark, "csv_string_parser_quoted", _csvData.back());
+    }
+
+    void addStringParserKernel(csvsqldb::bench::MicroBenchmark& benchmark, const std::string& name, const std::string& input)
+    {
+        size_t fields = _size;
+        benchmark.add(name, [&input, fields]() {
+            FieldReader reader(input);
+            csvsqldb::csv::CSVStringParser::BufferType buffer(1024);
+            csvsqldb::csv::CSVStringParser parser(buffer, 1024, std::bind(&FieldReader::readNextChar, std::ref(reader), std::placeholders::_1));
+            uint64_t length = 0;
+            for(size_t n = 0; n < fields; ++n) {
+                length += parser.parseToBuffer();
+            }
+            csvsqldb::bench::consume(length);
+            return fields;
+        });
+    }
+
+    void addStackMachineKernels(csvsqldb::bench::MicroBenchmark& benchmark)
+    {
+        const std::pair<const char*, const char*> expressions[] = { { "arithmetic", "a * 3 + b / 2.0" },
+                                                                     { "comparison", "a > 500 AND b < 500.0" },
+                                                                     { "between", "a BETWEEN 100 AND 200" },
+                                                                     { "in_list", "a IN (1, 5, 17, 42, 99, 512, 777)" },
+                                                                     { "like", "s LIKE 'ab%'" },
+                                                                     { "function", "upper(s)" },
+                                                                     { "date", "d > DATE'2010-01-01'" } };
+
+        csvsqldb::SQLParser parser(_functions);
+        for(const auto& expression : expressions) {
+            std::shared_ptr<csvsqldb::StackMachine> sm = std::make_shared<csvsqldb::StackMachine>();
+            std::shared_ptr<csvsqldb::StackMachine::VariableMapping> mapping = std::make_shared<csvsqldb::StackMachine::VariableMapping>();
+            csvsqldb::ASTInstructionStackVisitor visitor(*sm, *mapping);
+            parser.parseExpression(expression.second)->accept(visitor);
+
+            const Rows& rows = _rows;
+            const csvsqldb::FunctionRegistry& functions = _functions;
+            benchmark.add(std::string("stack_machine_") + expression.first, [sm, mapping, &rows, &functions]() {
+                csvsqldb::VariableStore store;
+                uint64_t result = 0;
+                for(const auto& row : rows) {
+                    for(const auto& variable : *mapping) {
+                        switch(variable.first[0]) {
+                            case 'A':
+                            case 'a':
+                                store.addVariable(variable.second, csvsqldb::Variant(row._int));
+                                break;
+                            case 'B':
+                            case 'b':
+                                store.addVariable(variable.second, csvsqldb::Variant(row._real));
+                                break;
+                            case 'D':
+                            case 'd':
+                                store.addVariable(variable.second, csvsqldb::Variant(row._date));
+                                break;
+                            default:
+                                store.addVariable(variable.second, csvsqldb::Variant(row._string));
+                                break;
+                        }
+                    }
+                    result += sm->evaluate(store, functions).isNull() ? 0 : 1;
+                }
+                csvsqldb::bench::consume(result);
+                return rows.size();
+            });
+        }
+    }
+
+    void addOperationKernels(csvsqldb::bench::MicroBenchmark& benchmark)
+    {
+        std::shared_ptr<csvsqldb::Variants> ints = std::make_shared<csvsqldb::Variants>();
+        std::shared_ptr<csvsqldb::Variants> reals = std::make_shared<csvsqldb::Variants>();
+        std::shared_ptr<csvsqldb::Variants> strings = std::make_shared<csvsqldb::Variants>();
+        std::shared_ptr<csvsqldb::Variants> dates = std::make_shared<csvsqldb::Variants>();
+        for(const auto& row : _rows) {
+            ints->push_back(csvsqldb::Variant(row._int));
+            reals->push_back(csvsqldb::Variant(row._real));
+            strings->push_back(csvsqldb::Variant(row._string));
+            dates->push_back(csvsqldb::Variant(row._date));
+        }
+
+        addOperationKernel(benchmark, "binary_operation_add_int", csvsqldb::OP_ADD, ints, ints);
+        addOperationKernel(benchmark, "binary_operation_add_int_real", csvsqldb::OP_ADD, ints, reals);
+        addOperationKernel(benchmark, "binary_operation_mul_real", csvsqldb::OP_MUL, reals, reals);
+        addOperationKernel(benchmark, "binary_operation_lt_int", csvsqldb::OP_LT, ints, ints);
+        addOperationKernel(benchmark, "binary_operation_eq_string", csvsqldb::OP_EQ, strings, strings);
+        addOperationKernel(benchmark, "binary_operation_lt_date", csvsqldb::OP_LT, dates, dates);
+        addOperationKernel(benchmark, "binary_operation_concat", csvsqldb::OP_CONCAT, strings, strings);
+    }
+
+    void addOperationKernel(csvsqldb::bench::MicroBenchmark& benchmark, const std::string& name, csvsqldb::eOperationType op,
+                            const std::shared_ptr<csvsqldb::Variants>& lhs, const std::shared_ptr<csvsqldb::Variants>& rhs)
+    {
+        benchmark.add(name, [op, lhs, rhs]() {
+            uint64_t result = 0;
+            size_t size = lhs->size();
+            for(size_t n = 0; n < size; ++n) {
+                result += csvsqldb::binaryOperation(op, (*lhs)[n], (*rhs)[size - n - 1]).isNull() ? 0 : 1;
+            }
+            csvsqldb::bench::consume(result);
+            return size;
+        });
+    }
+
+    void fillBlocks()
+    {
+        releaseBlocks();
+        csvsqldb::BlockPtr block = _blockManager.createBlock();
+        _blocks.push_back(block);
+        for(const auto& row : _rows) {
+            for(size_t n = 0; n < 3; ++n) {
+                csvsqldb::Value* value = nullptr;
+                while(!value) {
+                    switch(n) {
+                        case 0:
+                            value = block->addInt(row._int, false);
+                            break;
+                        case 1:
+                            value = block->addReal(row._real, false);
+                            break;
+                        default:
+                            value = block->addString(row._string.c_str(), row._string.size(), false);
+                            break;
+                    }
+                    if(!value) {
+                        block->markNextBlock();
+                        block = _blockManager.createBlock();
+                        _blocks.push_back(block);
+                    }
+                }
+            }
+            block->nextRow();
+        }
+        block->endBlocks();
+    }
+
+    void releaseBlocks()
+    {
+        for(auto& block : _blocks) {
+            _blockManager.release(block);
+        }
+        _blocks.clear();
+    }
+
+    uint64_t iterateBlocks(bool sort, size_t column)
+    {
+        // the iterators release the blocks they consumed
+        csvsqldb::Blocks blocks;
+        blocks.swap(_blocks);
+        VectorBlockProvider provider(blocks);
+        csvsqldb::BlockIterator iterator(_blockTypes, provider, _blockManager);
+
+        uint64_t rows = 0;
+        if(sort) {
+            IteratorRowProvider rowProvider(iterator);
+            csvsqldb::SortingBlockIterator sorter(_blockTypes, { { column, csvsqldb::ASC } }, rowProvider, _blockManager);
+            while(sorter.getNextRow()) {
+                ++rows;
+            }
+        } else {
+            while(iterator.getNextRow()) {
+                ++rows;
+            }
+        }
+        return rows;
+    }
+
+    void addBlockKernels(csvsqldb::bench::MicroBenchmark& benchmark)
+    {
+        _blockTypes = { csvsqldb::INT, csvsqldb::REAL, csvsqldb::STRING };
+
+        benchmark.add("block_add_row", [this]() {
+            fillBlocks();
+            return _rows.size();
+        });
+        benchmark.add("block_iterator_get_next_row", [this]() { return iterateBlocks(false, 0); }, [this]() { fillBlocks(); });
+        benchmark.add("sort_operation_int", [this]() { return iterateBlocks(true, 0); }, [this]() { fillBlocks(); });
+        benchmark.add("sort_operation_real", [this]() { return iterateBlocks(true, 1); }, [this]() { fillBlocks(); });
+        benchmark.add("sort_operation_string", [this]() { return iterateBlocks(true, 2); }, [this]() { fillBlocks(); });
+    }
+
+    void addGroupingKernels(csvsqldb::bench::MicroBenchmark& benchmark)
+    {
+        std::shared_ptr<std::vector<csvsqldb::GroupingElement>> elements = std::make_shared<std::vector<csvsqldb::GroupingElement>>();
+        for(const auto& row : _rows) {
+            elements->push_back(csvsqldb::GroupingElement({ csvsqldb::Variant(row._int), csvsqldb::Variant(row._string.substr(0, 2)) }));
+        }
+
+        benchmark.add("grouping_element_hash", [elements]() {
+            uint64_t hash = 0;
+            for(const auto& element : *elements) {
+                hash += element.getHash();
+            }
+            csvsqldb::bench::consume(hash);
+            return elements->size();
+        });
+        benchmark.add("grouping_element_insert", [elements]() {
+            std::unordered_map<csvsqldb::GroupingElement, uint64_t> groups;
+            for(const auto& element : *elements) {
+                ++groups[element];
+            }
+            csvsqldb::bench::consume(groups.size());
+            return elements->size();
+        });
+    }
+
+    void addRegExpKernels(csvsqldb::bench::MicroBenchmark& benchmark)
+    {
+        const std::pair<const char*, const char*> patterns[] = { { "prefix", "ab.*" },
+                                                                  { "class", "[a-m]+[n-z]*" },
+                                                                  { "alternation", "(abc|def|ghi).*(x|y|z)" } };
+
+        const Rows& rows = _rows;
+        for(const auto& pattern : patterns) {
+            std::shared_ptr<csvsqldb::RegExp> regexp = std::make_shared<csvsqldb::RegExp>(pattern.second);
+            benchmark.add(std::string("regexp_match_") + pattern.first, [regexp, &rows]() {
+                uint64_t matches = 0;
+                for(const auto& row : rows) {
+                    matches += regexp->match(row._string) ? 1 : 0;
+                }
+                csvsqldb::bench::consume(matches);
+                return rows.size();
+            });
+        }
+    }
+
+    size_t _warmup;
+    size_t _repetitions;
+    size_t _size;
+    uint64_t _seed;
+    double _threshold;
+    std::string _filter;
+    std::string _baseline;
+    std::string _saveBaseline;
+    csvsqldb::FunctionRegistry _functions;
+    Rows _rows;
+    std::deque<std::string> _csvData;
+    csvsqldb::BlockManager _blockManager;
+    csvsqldb::Blocks _blocks;
+    csvsqldb::Types _blockTypes;
+};
+
+
+int main(int argc, char** argv)
+{
+    MicroBenchApp app(argc, argv);
+    return app.run();
+}
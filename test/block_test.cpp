@@ -40,8 +40,11 @@
 #include "libcsvsqldb/stack_machine.h"
 #include "libcsvsqldb/visitor.h"
 
+#include "libcsvsqldb/base/thread_pool.h"
 #include "libcsvsqldb/base/tribool.h"
 
+#include <set>
+
 
 class MyBlockProvider : public csvsqldb::BlockProvider
 {
@@ -68,6 +71,24 @@ private:
 };
 
 
+class IteratorRowProvider : public csvsqldb::RowProvider
+{
+public:
+    IteratorRowProvider(csvsqldb::BlockIterator& iterator)
+    : _iterator(iterator)
+    {
+    }
+
+    virtual const csvsqldb::Values* getNextRow()
+    {
+        return _iterator.getNextRow();
+    }
+
+private:
+    csvsqldb::BlockIterator& _iterator;
+};
+
+
 class BlockTestCase
 {
 public:
@@ -220,8 +241,62 @@ public:
             }
         }
     }
+
+    void parallelHashTableTest()
+    {
+        csvsqldb::Types types;
+        types.push_back(csvsqldb::INT);
+        types.push_back(csvsqldb::STRING);
+
+        csvsqldb::BlockManager blockManager;
+        csvsqldb::BlockPtr block = blockManager.createBlock();
+        for(int64_t n = 0; n < 1000; ++n) {
+            block->addValue(csvsqldb::Variant(n % 100));
+            block->addValue(csvsqldb::Variant("employee " + std::to_string(n)));
+            block->nextRow();
+        }
+        block->endBlocks();
+
+        csvsqldb::ThreadPool threadPool(3);
+        threadPool.start();
+
+        // small blocks, so that the rows are hashed in many morsels and some rows span two blocks
+        csvsqldb::BlockManager hashingBlockManager(1000, 100);
+        csvsqldb::IndexVector keyPositions;
+        keyPositions.push_back(0);
+        MyBlockProvider blockProvider(block, blockManager);
+        csvsqldb::BlockIterator iterator(types, blockProvider, blockManager);
+        IteratorRowProvider rowProvider(iterator);
+        csvsqldb::HashingBlockIterator hashingIterator(types, rowProvider, hashingBlockManager, keyPositions,
+                                                       std::numeric_limits<size_t>::max(), &threadPool);
+        MPF_TEST_ASSERT(hashingIterator.buildHashTable());
+        MPF_TEST_ASSERT(hashingBlockManager.getMaxUsedBlocks() > 10);
+        MPF_TEST_ASSERTEQUAL(1000u, hashingIterator.getHashTableSize());
+
+        csvsqldb::Values row;
+        for(int64_t key = 0; key < 100; ++key) {
+            csvsqldb::HashKey hashKey;
+            hashKey._key._groupingValues.push_back(csvsqldb::Variant(key));
+            hashKey.computeHash();
+            csvsqldb::BlockPositions positions;
+            hashingIterator.findKeyValueRows(hashKey, positions);
+            MPF_TEST_ASSERTEQUAL(10u, positions.size());
+
+            std::set<std::string> names;
+            for(const auto& position : positions) {
+                hashingIterator.getRowAt(position, row);
+                MPF_TEST_ASSERTEQUAL(std::to_string(key), row[0]->toString());
+                names.insert(row[1]->toString());
+            }
+            MPF_TEST_ASSERTEQUAL(10u, names.size());
+            MPF_TEST_ASSERT(names.count("employee " + std::to_string(key + 900)) == 1);
+        }
+
+        threadPool.stop();
+    }
 };
 
 MPF_REGISTER_TEST_START("BlockTestSuite", BlockTestCase);
 MPF_REGISTER_TEST(BlockTestCase::rowTest);
+MPF_REGISTER_TEST(BlockTestCase::parallelHashTableTest);
 MPF_REGISTER_TEST_END();
@@ -33,6 +33,8 @@
 
 #include "test.h"
 
+#include "data_test_framework.h"
+
 #include "libcsvsqldb/base/float_helper.h"
 
 #include "libcsvsqldb/buildin_functions.h"
@@ -191,6 +193,123 @@ public:
         MPF_TEST_ASSERT(csvsqldb::compare(100.0, result.asDouble()));
     }
 
+    void batchFunctionsTest()
+    {
+        csvsqldb::Function::Columns columns(1);
+        columns[0].push_back(csvsqldb::Variant("Lars"));
+        columns[0].push_back(csvsqldb::Variant("Han Solo 42"));
+        columns[0].push_back(csvsqldb::Variant(""));
+        csvsqldb::Variants result;
+
+        _registry.getFunction("UPPER")->callBatch(3, columns, result);
+        MPF_TEST_ASSERTEQUAL(3u, result.size());
+        MPF_TEST_ASSERTEQUAL("LARS", result[0]);
+        MPF_TEST_ASSERTEQUAL("HAN SOLO 42", result[1]);
+        MPF_TEST_ASSERTEQUAL("", result[2]);
+
+        _registry.getFunction("LOWER")->callBatch(3, columns, result);
+        MPF_TEST_ASSERTEQUAL(3u, result.size());
+        MPF_TEST_ASSERTEQUAL("lars", result[0]);
+        MPF_TEST_ASSERTEQUAL("han solo 42", result[1]);
+
+        _registry.getFunction("CHAR_LENGTH")->callBatch(3, columns, result);
+        MPF_TEST_ASSERTEQUAL(3u, result.size());
+        MPF_TEST_ASSERTEQUAL(4, result[0]);
+        MPF_TEST_ASSERTEQUAL(11, result[1]);
+        MPF_TEST_ASSERTEQUAL(0, result[2]);
+
+        // only the given rows are computed, rows with a null parameter go through the single call
+        columns[0][2] = csvsqldb::Variant(csvsqldb::STRING);
+        for(const auto& name : { "UPPER", "LOWER", "CHAR_LENGTH" }) {
+            _registry.getFunction(name)->callBatch(2, columns, result);
+            MPF_TEST_ASSERTEQUAL(2u, result.size());
+            MPF_TEST_ASSERTEQUAL(_registry.getFunction(name)->call({ columns[0][1] }), result[1]);
+            MPF_TEST_EXPECTS(_registry.getFunction(name)->call({ columns[0][2] }), csvsqldb::Exception);
+            MPF_TEST_EXPECTS(_registry.getFunction(name)->callBatch(3, columns, result), csvsqldb::Exception);
+        }
+
+        csvsqldb::Function::Columns powColumns(2);
+        powColumns[0] = {csvsqldb::Variant(10.0), csvsqldb::Variant(2.0)};
+        powColumns[1] = {csvsqldb::Variant(2.0), csvsqldb::Variant(3.0)};
+        _registry.getFunction("POW")->callBatch(2, powColumns, result);
+        MPF_TEST_ASSERTEQUAL(2u, result.size());
+        MPF_TEST_ASSERT(csvsqldb::compare(100.0, result[0].asDouble()));
+        MPF_TEST_ASSERT(csvsqldb::compare(8.0, result[1].asDouble()));
+
+        csvsqldb::Function::Columns extractColumns(2);
+        extractColumns[0] = {csvsqldb::Variant(6), csvsqldb::Variant(5)};
+        extractColumns[1] = {csvsqldb::Variant(csvsqldb::Timestamp(1970, csvsqldb::Date::September, 23, 8, 9, 11, 0)),
+                             csvsqldb::Variant(csvsqldb::Timestamp(1970, csvsqldb::Date::September, 23, 8, 9, 11, 0))};
+        _registry.getFunction("EXTRACT")->callBatch(2, extractColumns, result);
+        MPF_TEST_ASSERTEQUAL(2u, result.size());
+        MPF_TEST_ASSERTEQUAL(1970, result[0]);
+        MPF_TEST_ASSERTEQUAL(9, result[1]);
+
+        csvsqldb::Function::Columns formatColumns(2);
+        formatColumns[0] = {csvsqldb::Variant(csvsqldb::Date(1970, csvsqldb::Date::September, 23))};
+        formatColumns[1] = {csvsqldb::Variant("%Y")};
+        _registry.getFunction("DATE_FORMAT")->callBatch(1, formatColumns, result);
+        MPF_TEST_ASSERTEQUAL(1u, result.size());
+        MPF_TEST_ASSERTEQUAL("1970", result[0]);
+
+        result.clear();
+        _registry.getFunction("VERSION")->callBatch(2, csvsqldb::Function::Columns(), result);
+        MPF_TEST_ASSERTEQUAL(2u, result.size());
+        MPF_TEST_ASSERTEQUAL(result[0], result[1]);
+    }
+
+    void projectionBatchTest()
+    {
+        DatabaseTestWrapper dbWrapper;
+        dbWrapper.addTable(TableInitializer("employees", { { "id", csvsqldb::INT }, { "first_name", csvsqldb::STRING } }));
+
+        csvsqldb::ExecutionContext context(dbWrapper.getDatabase());
+        csvsqldb::ExecutionEngine<TestOperatorNodeFactory> engine(context);
+
+        // more rows than fit into one batch of the projection
+        const char* names[] = { "Lars", "Mark", "Angelica", "Han Solo" };
+        TestRowProvider::Rows& employees = TestRowProvider::getRows("employees");
+        employees.clear();
+        for(int64_t n = 0; n < 3000; ++n) {
+            employees.push_back({ n, names[n % 4] });
+        }
+
+        // the calls of the first statement get columns and constants as parameters and are evaluated in batches, the
+        // calls of the second statement are evaluated by the stack machine
+        csvsqldb::ExecutionStatistics statistics;
+        std::stringstream ss;
+        MPF_TEST_ASSERTEQUAL(3000, engine.execute("SELECT id, upper(first_name) AS u, pow(id, 2.0) AS p, first_name, "
+                                                  "char_length(first_name) + 1 AS l FROM employees",
+                                                  statistics,
+                                                  ss));
+        std::stringstream expected;
+        MPF_TEST_ASSERTEQUAL(3000, engine.execute("SELECT id, upper(first_name || '') AS u, pow(id + 0, 2.0) AS p, first_name, "
+                                                  "char_length(first_name) + 1 AS l FROM employees",
+                                                  statistics,
+                                                  expected));
+        MPF_TEST_ASSERTEQUAL(expected.str(), ss.str());
+        MPF_TEST_ASSERT(ss.str().find("\n2999,'HAN SOLO',") != std::string::npos);
+
+        // all output columns are results of batch calls
+        ss.str("");
+        expected.str("");
+        MPF_TEST_ASSERTEQUAL(3000, engine.execute("SELECT upper(first_name) AS u FROM employees", statistics, ss));
+        MPF_TEST_ASSERTEQUAL(3000, engine.execute("SELECT upper(first_name || '') AS u FROM employees", statistics, expected));
+        MPF_TEST_ASSERTEQUAL(expected.str(), ss.str());
+
+        // the batch call results are inserted between the columns of the asterisk
+        ss.str("");
+        expected.str("");
+        MPF_TEST_ASSERTEQUAL(3000, engine.execute("SELECT lower(first_name) AS l, employees.* FROM employees", statistics, ss));
+        MPF_TEST_ASSERTEQUAL(3000, engine.execute("SELECT lower(first_name || '') AS l, employees.* FROM employees", statistics, expected));
+        MPF_TEST_ASSERTEQUAL(expected.str(), ss.str());
+
+        // the projection stops reading at the limit, which is not a multiple of the batch size
+        ss.str("");
+        MPF_TEST_ASSERTEQUAL(3, engine.execute("SELECT id, upper(first_name) AS u FROM employees LIMIT 3 OFFSET 1025", statistics, ss));
+        MPF_TEST_ASSERTEQUAL("#ID,U\n1025,'MARK'\n1026,'ANGELICA'\n1027,'HAN SOLO'\n", ss.str());
+    }
+
     csvsqldb::FunctionRegistry _registry;
 };
 
@@ -198,4 +317,6 @@ MPF_REGISTER_TEST_START("FunctionTestSuite", BuildinFunctionsTestCase);
 MPF_REGISTER_TEST(BuildinFunctionsTestCase::buildinDateFunctionsTest);
 MPF_REGISTER_TEST(BuildinFunctionsTestCase::buildinStringFunctionsTest);
 MPF_REGISTER_TEST(BuildinFunctionsTestCase::buildinMathFunctionsTest);
+MPF_REGISTER_TEST(BuildinFunctionsTestCase::batchFunctionsTest);
+MPF_REGISTER_TEST(BuildinFunctionsTestCase::projectionBatchTest);
 MPF_REGISTER_TEST_END();
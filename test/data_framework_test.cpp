@@ -110,6 +110,19 @@ public:
         "#EMPLOYEES.ID,EMPLOYEES.FIRST_NAME,EMPLOYEES.LAST_NAME,BIRTH_DATE,EMPLOYEES.HIRE_DATE\n4711,'Lars','Fürstenberg',1970-"
         "09-23,2010-02-01\n815,'Mark','Fürstenberg',1969-05-17,2003-04-15\n",
         ss.str());
+
+        // variables only referenced inside IN lists have to be mapped for the evaluation as well
+        ss.str("");
+        ss.clear();
+        rowCount = engine.execute("SELECT first_name FROM employees WHERE id IN (815, 9227)", statistics, ss);
+        MPF_TEST_ASSERTEQUAL(2, rowCount);
+        MPF_TEST_ASSERTEQUAL("#FIRST_NAME\n'Mark'\n'Angelica'\n", ss.str());
+
+        ss.str("");
+        ss.clear();
+        rowCount = engine.execute("SELECT first_name, 4711 IN (id, 815) AS known FROM employees", statistics, ss);
+        MPF_TEST_ASSERTEQUAL(3, rowCount);
+        MPF_TEST_ASSERTEQUAL("#FIRST_NAME,KNOWN\n'Lars',1\n'Mark',0\n'Angelica',0\n", ss.str());
     }
 };
 
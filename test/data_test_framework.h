@@ -117,15 +117,29 @@ public:
 
     void addRow(const std::vector<csvsqldb::Variant>& values)
     {
-        for(const auto& value : values) {
-            _block->addValue(value);
+        size_t rowStart = _block->offset();
+        for(const auto& n : _columns) {
+            const csvsqldb::Value* value = _block->addValue(values[n]);
+            for(const auto& predicate : _predicates) {
+                if(value && predicate.column() == n && !predicate.matches(*value)) {
+                    // rejected rows are removed from the block again like in the table scan
+                    _block->reset();
+                    _block->moveOffset(rowStart);
+                    return;
+                }
+            }
         }
         _block->nextRow();
     }
 
     virtual void dump(std::ostream& stream) const
     {
-        stream << "TestScanOperatorNode\n";
+        stream << "TestScanOperatorNode (" << _tableInfo._identifier << ")\n";
+    }
+
+    virtual uint64_t estimateRowCount()
+    {
+        return TestRowProvider::getRows(_tableInfo._identifier).size();
     }
 
 private:
@@ -193,6 +207,12 @@ public:
         return std::make_shared<csvsqldb::LimitOperatorNode>(context, symbolTable, limit, offset);
     }
 
+    static csvsqldb::RowOperatorNodePtr createDistinctOperatorNode(csvsqldb::OperatorContext& context,
+                                                                   const csvsqldb::SymbolTablePtr& symbolTable)
+    {
+        return std::make_shared<csvsqldb::DistinctOperatorNode>(context, symbolTable);
+    }
+
     static csvsqldb::RowOperatorNodePtr createSortOperatorNode(csvsqldb::OperatorContext& context,
                                                                const csvsqldb::SymbolTablePtr& symbolTable,
                                                                csvsqldb::OrderExpressions orderExpressions)
@@ -241,6 +261,13 @@ public:
         return std::make_shared<csvsqldb::InnerHashJoinOperatorNode>(context, symbolTable, exp);
     }
 
+    static csvsqldb::RowOperatorNodePtr createSortMergeJoinOperatorNode(csvsqldb::OperatorContext& context,
+                                                                        const csvsqldb::SymbolTablePtr& symbolTable,
+                                                                        const csvsqldb::ASTExprNodePtr& exp)
+    {
+        return std::make_shared<csvsqldb::SortMergeJoinOperatorNode>(context, symbolTable, exp);
+    }
+
     static csvsqldb::RowOperatorNodePtr createUnionOperatorNode(csvsqldb::OperatorContext& context, const csvsqldb::SymbolTablePtr& symbolTable)
     {
         return std::make_shared<csvsqldb::UnionOperatorNode>(context, symbolTable);
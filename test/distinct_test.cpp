@@ -0,0 +1,150 @@
+//
+//  csvsqldb test
+//
+//  BSD 3-Clause License
+//  Copyright (c) 2015, Lars-Christian Fürstenberg
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification, are permitted
+//  provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or other materials provided
+//  with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors may be used to
+//  endorse or promote products derived from this software without specific prior written
+//  permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+//  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+//  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+//  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+
+
+#include "test.h"
+
+#include "libcsvsqldb/block.h"
+
+#include "data_test_framework.h"
+
+
+class DistinctTestCase
+{
+public:
+    DistinctTestCase()
+    {
+    }
+
+    void setUp()
+    {
+        _dbWrapper.addTable(TableInitializer("employees",
+                                             { { "id", csvsqldb::INT },
+                                               { "first_name", csvsqldb::STRING },
+                                               { "last_name", csvsqldb::STRING },
+                                               { "birth_date", csvsqldb::DATE } }));
+
+        TestRowProvider::setRows(
+        "employees",
+        { { 815, "Mark", "Fürstenberg", csvsqldb::Date(1969, csvsqldb::Date::May, 17) },
+          { 4711, "Lars", "Fürstenberg", csvsqldb::Date(1970, csvsqldb::Date::September, 23) },
+          { 3467, "Ingo", csvsqldb::Variant(csvsqldb::STRING), csvsqldb::Date(1946, csvsqldb::Date::May, 4) },
+          { 1423, "Tilo", "Bürstenbinder", csvsqldb::Date(1973, csvsqldb::Date::January, 8) },
+          { 815, "Mark", "Fürstenberg", csvsqldb::Date(1969, csvsqldb::Date::May, 17) },
+          { 192, "Mark", csvsqldb::Variant(csvsqldb::STRING), csvsqldb::Date(1956, csvsqldb::Date::August, 5) },
+          { 9227, "Lars", "Fürstenberg", csvsqldb::Date(1963, csvsqldb::Date::March, 6) } });
+    }
+
+    void tearDown()
+    {
+    }
+
+    void distinctTest()
+    {
+        csvsqldb::ExecutionContext context(_dbWrapper.getDatabase());
+        csvsqldb::ExecutionEngine<TestOperatorNodeFactory> engine(context);
+
+        csvsqldb::ExecutionStatistics statistics;
+        std::stringstream ss;
+        int64_t rowCount = engine.execute("SELECT DISTINCT last_name FROM employees", statistics, ss);
+        MPF_TEST_ASSERTEQUAL(3, rowCount);
+
+        std::string expected = R"(#LAST_NAME
+'Fürstenberg'
+NULL
+'Bürstenbinder'
+)";
+        MPF_TEST_ASSERTEQUAL(expected, ss.str());
+
+        ss.str("");
+        rowCount = engine.execute("SELECT DISTINCT first_name,last_name FROM employees ORDER BY first_name,last_name", statistics, ss);
+        MPF_TEST_ASSERTEQUAL(5, rowCount);
+
+        expected = R"(#FIRST_NAME,LAST_NAME
+'Ingo',NULL
+'Lars','Fürstenberg'
+'Mark','Fürstenberg'
+'Mark',NULL
+'Tilo','Bürstenbinder'
+)";
+        MPF_TEST_ASSERTEQUAL(expected, ss.str());
+    }
+
+    void countDistinctTest()
+    {
+        csvsqldb::ExecutionContext context(_dbWrapper.getDatabase());
+        csvsqldb::ExecutionEngine<TestOperatorNodeFactory> engine(context);
+
+        csvsqldb::ExecutionStatistics statistics;
+        std::stringstream ss;
+        int64_t rowCount = engine.execute(
+        "SELECT count(DISTINCT last_name) as names,count(last_name) as all_names,count(DISTINCT id) as ids FROM employees", statistics, ss);
+        MPF_TEST_ASSERTEQUAL(1, rowCount);
+
+        std::string expected = R"(#NAMES,ALL_NAMES,IDS
+2,5,6
+)";
+        MPF_TEST_ASSERTEQUAL(expected, ss.str());
+    }
+
+    void countDistinctGroupByTest()
+    {
+        csvsqldb::ExecutionContext context(_dbWrapper.getDatabase());
+        csvsqldb::ExecutionEngine<TestOperatorNodeFactory> engine(context);
+
+        csvsqldb::ExecutionStatistics statistics;
+        std::stringstream ss;
+        int64_t rowCount =
+        engine.execute("SELECT first_name,count(DISTINCT id) as ids,count(*) as \"rows\" FROM employees GROUP BY first_name ORDER BY first_name",
+                       statistics,
+                       ss);
+        MPF_TEST_ASSERTEQUAL(4, rowCount);
+
+        std::string expected = R"(#FIRST_NAME,IDS,ROWS
+'Ingo',1,1
+'Lars',2,2
+'Mark',2,3
+'Tilo',1,1
+)";
+        MPF_TEST_ASSERTEQUAL(expected, ss.str());
+    }
+
+private:
+    DatabaseTestWrapper _dbWrapper;
+};
+
+MPF_REGISTER_TEST_START("DistinctTestSuite", DistinctTestCase);
+MPF_REGISTER_TEST(DistinctTestCase::distinctTest);
+MPF_REGISTER_TEST(DistinctTestCase::countDistinctTest);
+MPF_REGISTER_TEST(DistinctTestCase::countDistinctGroupByTest);
+MPF_REGISTER_TEST_END();
@@ -38,13 +38,130 @@
 #include "libcsvsqldb/sql_parser.h"
 #include "libcsvsqldb/validation_visitor.h"
 
+#include "libcsvsqldb/base/metrics.h"
+
 #include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
 
 #include <boost/filesystem.hpp>
 
 namespace fs = boost::filesystem;
 
 
+/**
+ * A table mapped to csv files. Queries on it are run with the operators of the engine, so that the tests only have to
+ * provide the data of the files and check the results.
+ */
+class CsvTable
+{
+public:
+    /**
+     * Creates the table described by the CREATE TABLE statement.
+     * @param createTable The CREATE TABLE statement of the table
+     * @param mapping The file mapping of the table, e.g. 'numbers.csv->numbers'
+     * @param files The files and directories the table is read from
+     * @param maxActiveBlocks The maximum number of blocks the queries may use at the same time
+     * @param blockCapacity The capacity of each block
+     */
+    CsvTable(const std::string& createTable, const std::string& mapping, const csvsqldb::StringVector& files,
+             size_t maxActiveBlocks = 100, size_t blockCapacity = 1024 * 1024)
+    : _parser(_functions)
+    , _files(files)
+    , _manager(maxActiveBlocks, blockCapacity)
+    {
+        csvsqldb::ASTCreateTableNodePtr createNode = std::dynamic_pointer_cast<csvsqldb::ASTCreateTableNode>(_parser.parse(createTable));
+        MPF_TEST_ASSERT(createNode);
+        _tableData.reset(new csvsqldb::TableData(csvsqldb::TableData::fromCreateAST(createNode)));
+
+        csvsqldb::FileMapping::Mappings mappings;
+        mappings.push_back({ mapping, ',', false });
+        csvsqldb::FileMapping fileMapping;
+        fileMapping.initialize(mappings);
+
+        _database.reset(new csvsqldb::Database(fs::temp_directory_path().string(), fileMapping));
+        _database->addTable(*_tableData);
+    }
+
+    /**
+     * Executes the query on the table and writes its rows or its plan to the output.
+     * @param sql The query to execute
+     * @param output The stream the output of the query is written to
+     * @param parallelScans The maximum number of files scanned in parallel
+     * @return The number of rows of the query
+     */
+    int64_t execute(const std::string& sql, std::ostream& output, uint16_t parallelScans = 1)
+    {
+        csvsqldb::ASTNodePtr query = _parser.parse(sql);
+        query->typeSymbolTable(*_database);
+        csvsqldb::ExecutionPlan execPlan;
+        csvsqldb::OperatorContext context(*_database, _functions, _manager, _files);
+        context._maxParallelScans = parallelScans;
+        csvsqldb::ASTValidationVisitor validationVisitor(*_database);
+        query->accept(validationVisitor);
+        csvsqldb::ExecutionPlanVisitor<csvsqldb::OperatorNodeFactory> execVisitor(context, execPlan, output);
+        query->accept(execVisitor);
+        return execPlan.execute();
+    }
+
+    /**
+     * Returns the number of rows a scan of the table estimates for the query.
+     * @param sql A query selecting from the table
+     * @param tableName The name of the table in upper case
+     */
+    uint64_t estimateRowCount(const std::string& sql, const std::string& tableName)
+    {
+        csvsqldb::ASTNodePtr query = _parser.parse(sql);
+        query->typeSymbolTable(*_database);
+        csvsqldb::OperatorContext context(*_database, _functions, _manager, _files);
+        csvsqldb::TableScanOperatorNode scan(context, query->symbolTable(), *query->symbolTable()->findTableSymbol(tableName));
+        return scan.estimateRowCount();
+    }
+
+    const csvsqldb::TableData& tableData() const
+    {
+        return *_tableData;
+    }
+
+    csvsqldb::BlockManager& blockManager()
+    {
+        return _manager;
+    }
+
+private:
+    csvsqldb::FunctionRegistry _functions;
+    csvsqldb::SQLParser _parser;
+    csvsqldb::StringVector _files;
+    csvsqldb::BlockManager _manager;
+    std::unique_ptr<csvsqldb::TableData> _tableData;
+    std::unique_ptr<csvsqldb::Database> _database;
+};
+
+/**
+ * Writes the content to the file and truncates it before.
+ */
+static void writeFile(const fs::path& path, const std::string& content)
+{
+    std::fstream dataFile(path.string(), std::ios_base::trunc | std::ios_base::out);
+    MPF_TEST_ASSERT(dataFile);
+    dataFile << content;
+}
+
+/**
+ * Returns a csv file with the header 'id,name' and the given number of rows with the names 'number <id>'.
+ */
+static std::string numberRows(int count)
+{
+    std::ostringstream rows;
+    rows << "id,name\n";
+    for(int n = 0; n < count; ++n) {
+        rows << n << ",number " << n << "\n";
+    }
+    return rows.str();
+}
+
+
 class ExecutionPlanTestCase
 {
 public:
@@ -141,8 +258,303 @@ public:
 
         MPF_TEST_ASSERTEQUAL(expected, output.str());
     }
+
+    void pushedDownPredicatesPlanTest()
+    {
+        fs::path tempDir = fs::temp_directory_path();
+        writeFile(tempDir / "employees.csv", R"(emp_no,birth_date,first_name,last_name,gender,hire_date
+47291,1960-09-09,Ulf,Flexer,M,2000-01-12
+60134,1964-04-21,Seshu,Rathonyi,F,2000-01-02
+72329,1953-02-09,Randi,Luit,F,2000-01-02
+108201,1955-04-14,Mariangiola,Boreale,M,2000-01-01
+205048,1960-09-12,Ennio,Alblas,F,2000-01-06
+222965,1959-08-07,Volkmar,Perko,F,2000-01-13
+226633,1958-06-10,Xuejun,Benzmuller,F,2000-01-04
+227544,1954-11-17,Shahab,Demeyer,M,2000-01-08
+422990,1953-04-09,Jaana,Verspoor,F,
+424445,1953-04-27,Jeong,Boreale,M,2000-01-03
+428377,1957-05-09,Yucai,Gerlach,M,2000-01-23
+463807,1964-06-12,Bikash,Covnot,,2000-01-28
+480001,1961-02-03,Berni,Bauer,F,
+499553,1954-05-06,Hideyuki,Delgrande,F,2000-01-22
+)");
+
+        // use small blocks, so that rows are often started in a block and continued in the next one
+        CsvTable employees("CREATE TABLE employees(emp_no INTEGER,birth_date DATE NOT NULL,first_name VARCHAR(25) NOT NULL,"
+                           "last_name VARCHAR(50) NOT NULL,gender CHAR,hire_date DATE,PRIMARY KEY(emp_no))",
+                           "employees.csv->employees", { (tempDir / "employees.csv").string() }, 100, 512);
+
+        std::stringstream output;
+        MPF_TEST_ASSERTEQUAL(5, employees.execute("SELECT emp_no,last_name FROM employees WHERE gender = 'F' AND hire_date IS NOT NULL AND "
+                                                  "emp_no BETWEEN 500000 AND 60000 AND 'Perko' <> last_name ORDER BY emp_no",
+                                                  output));
+        std::string expected = R"(#EMP_NO,LAST_NAME
+60134,'Rathonyi'
+72329,'Luit'
+205048,'Alblas'
+226633,'Benzmuller'
+499553,'Delgrande'
+)";
+        MPF_TEST_ASSERTEQUAL(expected, output.str());
+
+        output.str("");
+        MPF_TEST_ASSERTEQUAL(2, employees.execute("SELECT emp_no FROM employees WHERE last_name LIKE 'B%' AND emp_no IN (108201, 424445, "
+                                                  "480001, 1) AND birth_date < DATE'1960-01-01' ORDER BY emp_no",
+                                                  output));
+        expected = R"(#EMP_NO
+108201
+424445
+)";
+        MPF_TEST_ASSERTEQUAL(expected, output.str());
+
+        output.str("");
+        MPF_TEST_ASSERTEQUAL(
+          2, employees.execute("SELECT emp_no,first_name FROM employees WHERE hire_date IS NULL AND gender = 'F' ORDER BY emp_no", output));
+        expected = R"(#EMP_NO,FIRST_NAME
+422990,'Jaana'
+480001,'Berni'
+)";
+        MPF_TEST_ASSERTEQUAL(expected, output.str());
+    }
+
+    void projectedPlanTest()
+    {
+        fs::path tempDir = fs::temp_directory_path();
+        writeFile(tempDir / "employees.csv", R"(emp_no,birth_date,first_name,last_name,gender,hire_date
+47291,1960-09-09,Ulf,Flexer,M,2000-01-12
+60134,1964-04-21,"Seshu",Rathonyi,F,2000-01-02
+72329,1953-02-09,Randi,'Luit, Jr.',F,2000-01-02
+108201,1955-04-14,Mariangiola,Boreale,M,
+)");
+
+        CsvTable employees("CREATE TABLE employees(emp_no INTEGER,birth_date DATE NOT NULL,first_name VARCHAR(25) NOT NULL,"
+                           "last_name VARCHAR(50) NOT NULL,gender CHAR,hire_date DATE,PRIMARY KEY(emp_no))",
+                           "employees.csv->employees", { (tempDir / "employees.csv").string() });
+
+        // only first_name, last_name and gender are read from the file, all other fields are skipped by the parser
+        std::stringstream output;
+        MPF_TEST_ASSERTEQUAL(
+          2, employees.execute("SELECT e.first_name,last_name || '!' as name FROM employees e WHERE gender = 'F' ORDER BY name;", output));
+
+        std::string expected = R"(#E.FIRST_NAME,NAME
+'Randi','Luit, Jr.!'
+'Seshu','Rathonyi!'
+)";
+
+        MPF_TEST_ASSERTEQUAL(expected, output.str());
+    }
+
+    void limitedScanPlanTest()
+    {
+        fs::path tempDir = fs::temp_directory_path();
+        writeFile(tempDir / "numbers.csv", numberRows(5000));
+
+        // the file needs far more blocks than allowed, so the scan must not read ahead of the consumer
+        CsvTable numbers("CREATE TABLE numbers(id INTEGER,name VARCHAR(25),PRIMARY KEY(id))", "numbers.csv->numbers",
+                         { (tempDir / "numbers.csv").string() }, 10, 512);
+        csvsqldb::BlockManager& manager = numbers.blockManager();
+
+        std::stringstream output;
+        MPF_TEST_ASSERTEQUAL(3, numbers.execute("SELECT id,name FROM numbers LIMIT 3", output));
+        std::string expected = R"(#ID,NAME
+0,'number 0'
+1,'number 1'
+2,'number 2'
+)";
+        MPF_TEST_ASSERTEQUAL(expected, output.str());
+        // only one block for the scan and one for the projection are needed
+        MPF_TEST_ASSERTEQUAL(2u, manager.getTotalBlocks());
+
+        // the limit is pushed into the scan together with the predicates
+        output.str("");
+        MPF_TEST_ASSERTEQUAL(2, numbers.execute("SELECT id FROM numbers WHERE id >= 100 LIMIT 2 OFFSET 1", output));
+        expected = R"(#ID
+101
+102
+)";
+        MPF_TEST_ASSERTEQUAL(expected, output.str());
+        MPF_TEST_ASSERTEQUAL(4u, manager.getTotalBlocks());
+
+        // the condition cannot be pushed, so the scan has to read on until the select found enough rows
+        output.str("");
+        MPF_TEST_ASSERTEQUAL(2, numbers.execute("SELECT id FROM numbers WHERE id + 1 > 4000 LIMIT 2", output));
+        expected = R"(#ID
+4000
+4001
+)";
+        MPF_TEST_ASSERTEQUAL(expected, output.str());
+        MPF_TEST_ASSERT(manager.getMaxUsedBlocks() <= 10u);
+    }
+
+    void multiFileScanPlanTest()
+    {
+        fs::path tableDir = fs::temp_directory_path() / "multi_file_scan";
+        fs::remove_all(tableDir);
+        fs::create_directories(tableDir / "2016");
+
+        // 4 files with 1000 rows each, a file with only the header line and a file not matching the mapping
+        int id = 0;
+        for(const auto& file : { "readings_1.csv", "readings_2.csv", "2016/readings_3.csv", "2016/readings_4.csv" }) {
+            std::ostringstream rows;
+            rows << "id,sensor\n";
+            for(int n = 0; n < 1000; ++n, ++id) {
+                rows << id << ",sensor " << id % 7 << "\n";
+            }
+            writeFile(tableDir / file, rows.str());
+        }
+        writeFile(tableDir / "readings_5.csv", "id,sensor\n");
+        writeFile(tableDir / "other.csv", "id,sensor\n4711,sensor 1\n");
+
+        // the second file is also contained in the directory, so it must be read only once
+        CsvTable readings("CREATE TABLE readings(id INTEGER,sensor VARCHAR(25),PRIMARY KEY(id))", "readings_.*\\.csv->readings",
+                          { tableDir.string(), (tableDir / "2016" / ".." / "readings_1.csv").string() }, 100, 512);
+
+        for(uint16_t parallelScans : { 1, 3, 8 }) {
+            std::stringstream output;
+            MPF_TEST_ASSERTEQUAL(1, readings.execute("SELECT count(*),sum(id),min(id),max(id) FROM readings", output, parallelScans));
+            MPF_TEST_ASSERTEQUAL("#$alias_1,$alias_2,$alias_3,$alias_4\n4000,7998000,0,3999\n", output.str());
+
+            output.str("");
+            MPF_TEST_ASSERTEQUAL(1, readings.execute("SELECT count(*) FROM readings WHERE sensor = 'sensor 3'", output, parallelScans));
+            MPF_TEST_ASSERTEQUAL("#$alias_1\n571\n", output.str());
+
+            output.str("");
+            MPF_TEST_ASSERTEQUAL(5, readings.execute("SELECT id FROM readings WHERE id >= 3000 LIMIT 5", output, parallelScans));
+            std::string line;
+            std::getline(output, line);
+            while(std::getline(output, line)) {
+                MPF_TEST_ASSERT(std::stoi(line) >= 3000);
+            }
+            MPF_TEST_ASSERT(readings.blockManager().getMaxUsedBlocks() <= 100u);
+        }
+
+        // the row count is extrapolated from the sizes of the files and a sample of their first rows
+        const uint64_t estimatedRows = readings.estimateRowCount("SELECT id FROM readings", "READINGS");
+        MPF_TEST_ASSERT(estimatedRows >= 3600u && estimatedRows <= 4400u);
+
+        fs::remove_all(tableDir);
+    }
+
+    void partitionedScanPlanTest()
+    {
+        fs::path tableDir = fs::temp_directory_path() / "partitioned_scan";
+        fs::remove_all(tableDir);
+
+        // 100 rows per partition, the csv files only contain the columns that are not partition columns
+        const char* partitions[] = { "dt=2016-10-17/region=eu",
+                                     "dt=2016-10-17/region=us",
+                                     "dt=2016-10-18/region=eu",
+                                     "dt=2016-10-18/region=south%20america",
+                                     "dt=__HIVE_DEFAULT_PARTITION__/region=eu",
+                                     "dt=2016-10-19" };
+        int id = 0;
+        for(const auto& partition : partitions) {
+            fs::create_directories(tableDir / partition);
+            std::ostringstream rows;
+            rows << "id,amount\n";
+            for(int n = 0; n < 100; ++n, ++id) {
+                rows << id << ",1.5\n";
+            }
+            writeFile(tableDir / partition / "part-0001.csv", rows.str());
+        }
+        auto fileSize = [&](const std::string& partition) { return fs::file_size(tableDir / partition / "part-0001.csv"); };
+
+        CsvTable sales("CREATE TABLE sales(id INTEGER,dt DATE,amount REAL,region VARCHAR(10),PRIMARY KEY(id)) PARTITIONED BY (dt,region)",
+                       "part-.*\\.csv->sales", { tableDir.string() }, 100, 512);
+        MPF_TEST_ASSERT(sales.tableData().isPartitioned());
+
+        for(uint16_t parallelScans : { 1, 4 }) {
+            std::stringstream output;
+            uint64_t bytesRead = csvsqldb::metrics::Metrics::value(csvsqldb::metrics::BYTES_READ);
+            MPF_TEST_ASSERTEQUAL(1, sales.execute("SELECT count(*),sum(amount),min(dt),max(dt) FROM sales", output, parallelScans));
+            MPF_TEST_ASSERTEQUAL("#$alias_1,$alias_2,$alias_3,$alias_4\n600,900.000000,2016-10-17,2016-10-19\n", output.str());
+            uint64_t allBytes = 0;
+            for(const auto& partition : partitions) {
+                allBytes += fileSize(partition);
+            }
+            MPF_TEST_ASSERTEQUAL(allBytes, csvsqldb::metrics::Metrics::value(csvsqldb::metrics::BYTES_READ) - bytesRead);
+
+            output.str("");
+            bytesRead = csvsqldb::metrics::Metrics::value(csvsqldb::metrics::BYTES_READ);
+            MPF_TEST_ASSERTEQUAL(
+              1, sales.execute("SELECT count(*),min(id),max(id) FROM sales WHERE dt = DATE'2016-10-17'", output, parallelScans));
+            MPF_TEST_ASSERTEQUAL("#$alias_1,$alias_2,$alias_3\n200,0,199\n", output.str());
+            MPF_TEST_ASSERTEQUAL(fileSize(partitions[0]) + fileSize(partitions[1]),
+                                 csvsqldb::metrics::Metrics::value(csvsqldb::metrics::BYTES_READ) - bytesRead);
+
+            output.str("");
+            bytesRead = csvsqldb::metrics::Metrics::value(csvsqldb::metrics::BYTES_READ);
+            MPF_TEST_ASSERTEQUAL(
+              1,
+              sales.execute("SELECT region,count(*) FROM sales WHERE region = 'eu' AND dt >= DATE'2016-10-18' GROUP BY region",
+                            output,
+                            parallelScans));
+            MPF_TEST_ASSERTEQUAL("#REGION,$alias_1\n'eu',100\n", output.str());
+            MPF_TEST_ASSERTEQUAL(fileSize(partitions[2]),
+                                 csvsqldb::metrics::Metrics::value(csvsqldb::metrics::BYTES_READ) - bytesRead);
+
+            std::stringstream rows;
+            MPF_TEST_ASSERTEQUAL(100, sales.execute("SELECT id,dt FROM sales WHERE dt IS NULL", rows, parallelScans));
+            std::string line;
+            std::getline(rows, line);
+            while(std::getline(rows, line)) {
+                MPF_TEST_ASSERT(line.find(",NULL") != std::string::npos);
+            }
+
+            output.str("");
+            MPF_TEST_ASSERTEQUAL(
+              1, sales.execute("SELECT count(*) FROM sales WHERE region IS NULL AND dt = DATE'2016-10-19'", output, parallelScans));
+            MPF_TEST_ASSERTEQUAL("#$alias_1\n100\n", output.str());
+
+            output.str("");
+            MPF_TEST_ASSERTEQUAL(1, sales.execute("SELECT dt,region,id FROM sales WHERE id = 342", output, parallelScans));
+            MPF_TEST_ASSERTEQUAL("#DT,REGION,ID\n2016-10-18,'south america',342\n", output.str());
+        }
+
+        fs::remove_all(tableDir);
+    }
+
+    void analyzePlanTest()
+    {
+        fs::path tempDir = fs::temp_directory_path();
+        writeFile(tempDir / "numbers.csv", numberRows(5000));
+
+        CsvTable numbers("CREATE TABLE numbers(id INTEGER,name VARCHAR(25),PRIMARY KEY(id))", "numbers.csv->numbers",
+                         { (tempDir / "numbers.csv").string() });
+
+        // an earlier query used many blocks, that must not show up as the peak of the analyzed query
+        csvsqldb::Blocks earlierBlocks;
+        for(int n = 0; n < 90; ++n) {
+            earlierBlocks.push_back(numbers.blockManager().createBlock());
+        }
+        for(auto& block : earlierBlocks) {
+            numbers.blockManager().release(block);
+        }
+
+        std::stringstream output;
+        numbers.execute("EXPLAIN ANALYZE SELECT DISTINCT id FROM numbers WHERE id + 1 > 4000 ORDER BY id DESC", output);
+
+        // the rows of the query itself are not output
+        const std::string plan = output.str();
+        MPF_TEST_ASSERT(plan.find("#ID") == std::string::npos);
+        MPF_TEST_ASSERT(plan.find("SortOperator (ID DESC) [rows 1000, input rows 1000, wall ") != std::string::npos);
+        MPF_TEST_ASSERT(plan.find("DistinctOperator [rows 1000, input rows 1000, wall ") != std::string::npos);
+        MPF_TEST_ASSERT(plan.find("hash table entries 1000]") != std::string::npos);
+        MPF_TEST_ASSERT(plan.find("SelectOperator [rows 1000, input rows 5000, wall ") != std::string::npos);
+        MPF_TEST_ASSERT(plan.find("TableScanOperator (NUMBERS) [rows 5000, wall ") != std::string::npos);
+        MPF_TEST_ASSERT(plan.find("1000 rows in ") != std::string::npos);
+        const size_t peak = plan.find(" blocks at peak");
+        MPF_TEST_ASSERT(peak != std::string::npos);
+        MPF_TEST_ASSERT(std::stoi(plan.substr(plan.rfind(' ', peak - 1) + 1)) < 90);
+    }
 };
 
 MPF_REGISTER_TEST_START("ExecutionPlanSuite", ExecutionPlanTestCase);
 MPF_REGISTER_TEST(ExecutionPlanTestCase::planTest);
+MPF_REGISTER_TEST(ExecutionPlanTestCase::projectedPlanTest);
+MPF_REGISTER_TEST(ExecutionPlanTestCase::pushedDownPredicatesPlanTest);
+MPF_REGISTER_TEST(ExecutionPlanTestCase::limitedScanPlanTest);
+MPF_REGISTER_TEST(ExecutionPlanTestCase::analyzePlanTest);
+MPF_REGISTER_TEST(ExecutionPlanTestCase::multiFileScanPlanTest);
+MPF_REGISTER_TEST(ExecutionPlanTestCase::partitionedScanPlanTest);
 MPF_REGISTER_TEST_END();
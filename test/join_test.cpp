@@ -136,6 +136,57 @@ public:
         MPF_TEST_ASSERTEQUAL(expected, ss.str());
     }
 
+    void spillingInnerJoinTest()
+    {
+        DatabaseTestWrapper dbWrapper;
+        setUpEmployeesAndSalaries(dbWrapper);
+
+        csvsqldb::ExecutionContext context(dbWrapper.getDatabase());
+        // force the hash join to partition both inputs to disk
+        context._hashJoinBlockLimit = 0;
+        csvsqldb::ExecutionEngine<TestOperatorNodeFactory> engine(context);
+
+        checkSalaryJoin(engine);
+        checkLastNameSelfJoin(engine);
+    }
+
+    void parallelInnerJoinTest()
+    {
+        DatabaseTestWrapper dbWrapper;
+        setUpEmployeesAndSalaries(dbWrapper);
+
+        csvsqldb::ExecutionContext context(dbWrapper.getDatabase());
+        context._numberOfThreads = 3;
+        csvsqldb::ExecutionEngine<TestOperatorNodeFactory> engine(context);
+
+        checkSalaryJoin(engine);
+
+        // more probe rows than fit into one morsel; the morsels are probed concurrently, but the rows have to come out in
+        // the order of the single threaded join
+        const int64_t ids[] = { 815, 4711, 9227, 9384, 1 };
+        TestRowProvider::Rows& salaries = TestRowProvider::getRows("salaries");
+        salaries.clear();
+        for(int64_t n = 0; n < 10000; ++n) {
+            salaries.push_back({ ids[n % 5], static_cast<double>(n), csvsqldb::Date(2003, csvsqldb::Date::April, 15),
+                                 csvsqldb::Date(2015, csvsqldb::Date::December, 31) });
+        }
+        const std::string sql = "SELECT sal.salary, emp.first_name FROM salaries sal INNER JOIN employees emp ON sal.id = emp.id";
+
+        csvsqldb::ExecutionContext singleThreadedContext(dbWrapper.getDatabase());
+        csvsqldb::ExecutionEngine<TestOperatorNodeFactory> singleThreadedEngine(singleThreadedContext);
+        csvsqldb::ExecutionStatistics statistics;
+        std::stringstream expected;
+        MPF_TEST_ASSERTEQUAL(8000, singleThreadedEngine.execute(sql, statistics, expected));
+
+        std::stringstream ss;
+        MPF_TEST_ASSERTEQUAL(8000, engine.execute(sql, statistics, ss));
+        MPF_TEST_ASSERTEQUAL(expected.str(), ss.str());
+
+        // partitioned joins use the thread pool as well
+        context._hashJoinBlockLimit = 0;
+        checkLastNameSelfJoin(engine);
+    }
+
     void complexInnerJoinTest()
     {
         DatabaseTestWrapper dbWrapper;
@@ -198,6 +249,190 @@ public:
         MPF_TEST_ASSERTEQUAL(expected, ss.str());
     }
 
+    void reorderedInnerJoinTest()
+    {
+        DatabaseTestWrapper dbWrapper;
+        dbWrapper.addTable(TableInitializer("employees", { { "id", csvsqldb::INT }, { "last_name", csvsqldb::STRING } }));
+        dbWrapper.addTable(TableInitializer("dept_emp", { { "emp_id", csvsqldb::INT }, { "dept_no", csvsqldb::STRING } }));
+        dbWrapper.addTable(TableInitializer("departments", { { "dept_no", csvsqldb::STRING }, { "dept_name", csvsqldb::STRING } }));
+
+        csvsqldb::ExecutionContext context(dbWrapper.getDatabase());
+        context._minRowsForJoinReordering = 0;
+        csvsqldb::ExecutionEngine<TestOperatorNodeFactory> engine(context);
+
+        TestRowProvider::setRows("employees", { { 9384, "Doe" }, { 815, "Fürstenberg" }, { 4711, "Fürstenberg" }, { 9227, "Tello de Fürstenberg" } });
+        TestRowProvider::setRows("dept_emp", { { 4711, "d005" }, { 815, "d007" }, { 9227, "d003" } });
+        TestRowProvider::setRows("departments",
+                                 { { "d009", "Customer Service" },
+                                   { "d005", "Development" },
+                                   { "d002", "Finance" },
+                                   { "d003", "Human Resources" },
+                                   { "d001", "Marketing" },
+                                   { "d007", "Sales" } });
+
+        // the smallest input dept_emp is joined first, but the columns keep the written order
+        std::string plan = explainPlan(
+        engine,
+        "SELECT * FROM employees JOIN dept_emp ON employees.id = dept_emp.emp_id JOIN departments ON dept_emp.dept_no = "
+        "departments.dept_no ORDER BY employees.id");
+        MPF_TEST_ASSERT(plan.find(R"(-->InnerHashJoinOperator (build side: left)
+-->InnerHashJoinOperator (build side: left)
+-->TestScanOperatorNode (DEPT_EMP)
+-->TestScanOperatorNode (EMPLOYEES)
+-->TestScanOperatorNode (DEPARTMENTS)
+)") != std::string::npos);
+        csvsqldb::ExecutionStatistics statistics;
+        std::stringstream ss;
+        int64_t rowCount = engine.execute(
+        "SELECT * FROM employees JOIN dept_emp ON employees.id = dept_emp.emp_id JOIN departments ON dept_emp.dept_no = "
+        "departments.dept_no ORDER BY employees.id",
+        statistics,
+        ss);
+        MPF_TEST_ASSERTEQUAL(3, rowCount);
+        std::string expected = R"(#EMPLOYEES.ID,EMPLOYEES.LAST_NAME,DEPT_EMP.EMP_ID,DEPT_EMP.DEPT_NO,DEPARTMENTS.DEPT_NO,DEPARTMENTS.DEPT_NAME
+815,'Fürstenberg',815,'d007','d007','Sales'
+4711,'Fürstenberg',4711,'d005','d005','Development'
+9227,'Tello de Fürstenberg',9227,'d003','d003','Human Resources'
+)";
+        MPF_TEST_ASSERTEQUAL(expected, ss.str());
+
+        // composite and computed keys are hash joined as well, so they are reordered the same way
+        const std::string computedKeys =
+        "SELECT * FROM employees JOIN dept_emp ON employees.id = dept_emp.emp_id + 0 AND employees.last_name <> 'Doe' JOIN "
+        "departments ON upper(dept_emp.dept_no) = upper(departments.dept_no) ORDER BY employees.id";
+        plan = explainPlan(engine, computedKeys);
+        MPF_TEST_ASSERT(plan.find(R"(-->InnerHashJoinOperator (build side: left)
+-->InnerHashJoinOperator (build side: left)
+-->TestScanOperatorNode (DEPT_EMP)
+-->TestScanOperatorNode (EMPLOYEES)
+-->TestScanOperatorNode (DEPARTMENTS)
+)") != std::string::npos);
+        ss.str("");
+        MPF_TEST_ASSERTEQUAL(3, engine.execute(computedKeys, statistics, ss));
+        MPF_TEST_ASSERTEQUAL(expected, ss.str());
+
+        // the smaller left input is used as build side
+        plan = explainPlan(engine, "SELECT * FROM dept_emp JOIN departments ON dept_emp.dept_no = departments.dept_no ORDER BY dept_emp.emp_id");
+        MPF_TEST_ASSERT(plan.find(R"(-->InnerHashJoinOperator (build side: left)
+-->TestScanOperatorNode (DEPT_EMP)
+-->TestScanOperatorNode (DEPARTMENTS)
+)") != std::string::npos);
+        ss.str("");
+        rowCount = engine.execute("SELECT * FROM dept_emp JOIN departments ON dept_emp.dept_no = departments.dept_no ORDER BY dept_emp.emp_id",
+                                  statistics,
+                                  ss);
+        MPF_TEST_ASSERTEQUAL(3, rowCount);
+        expected = R"(#DEPT_EMP.EMP_ID,DEPT_EMP.DEPT_NO,DEPARTMENTS.DEPT_NO,DEPARTMENTS.DEPT_NAME
+815,'d007','d007','Sales'
+4711,'d005','d005','Development'
+9227,'d003','d003','Human Resources'
+)";
+        MPF_TEST_ASSERTEQUAL(expected, ss.str());
+    }
+
+    void compositeKeyInnerJoinTest()
+    {
+        DatabaseTestWrapper dbWrapper;
+        dbWrapper.addTable(TableInitializer("orders", { { "region", csvsqldb::STRING }, { "nr", csvsqldb::INT }, { "amount", csvsqldb::REAL } }));
+        dbWrapper.addTable(
+        TableInitializer("deliveries", { { "region", csvsqldb::STRING }, { "order_nr", csvsqldb::INT }, { "weight", csvsqldb::INT } }));
+
+        csvsqldb::ExecutionContext context(dbWrapper.getDatabase());
+        csvsqldb::ExecutionEngine<TestOperatorNodeFactory> engine(context);
+
+        TestRowProvider::setRows("orders", { { "north", 1, 10.5 }, { "south", 1, 20.0 }, { "north", 2, 5.25 }, { "south", 3, 7.0 } });
+        TestRowProvider::setRows("deliveries",
+                                 { { "south", 1, 100 }, { "north", 2, 20 }, { "north", 1, 50 }, { "north", 3, 70 }, { "south", 2, 1 } });
+
+        csvsqldb::ExecutionStatistics statistics;
+        std::stringstream ss;
+        int64_t rowCount = engine.execute(
+        "SELECT orders.region,orders.nr,deliveries.weight FROM orders JOIN deliveries ON orders.region = deliveries.region AND "
+        "deliveries.order_nr = orders.nr ORDER BY orders.region,orders.nr",
+        statistics,
+        ss);
+        MPF_TEST_ASSERTEQUAL(3, rowCount);
+        std::string expected = R"(#ORDERS.REGION,ORDERS.NR,DELIVERIES.WEIGHT
+'north',1,50
+'north',2,20
+'south',1,100
+)";
+        MPF_TEST_ASSERTEQUAL(expected, ss.str());
+
+        // computed key and a residual predicate
+        ss.str("");
+        rowCount = engine.execute(
+        "SELECT orders.region,orders.nr,deliveries.order_nr FROM orders JOIN deliveries ON orders.region = deliveries.region AND "
+        "orders.nr + 1 = deliveries.order_nr AND deliveries.weight > orders.amount ORDER BY orders.region,orders.nr",
+        statistics,
+        ss);
+        MPF_TEST_ASSERTEQUAL(2, rowCount);
+        expected = R"(#ORDERS.REGION,ORDERS.NR,DELIVERIES.ORDER_NR
+'north',1,2
+'north',2,3
+)";
+        MPF_TEST_ASSERTEQUAL(expected, ss.str());
+
+        // keys of different types are converted to a common type
+        ss.str("");
+        rowCount = engine.execute(
+        "SELECT orders.nr,deliveries.region FROM orders JOIN deliveries ON orders.amount = deliveries.weight / 5 ORDER BY orders.nr",
+        statistics,
+        ss);
+        MPF_TEST_ASSERTEQUAL(1, rowCount);
+        expected = R"(#ORDERS.NR,DELIVERIES.REGION
+1,'south'
+)";
+        MPF_TEST_ASSERTEQUAL(expected, ss.str());
+    }
+
+    void bandJoinTest()
+    {
+        DatabaseTestWrapper dbWrapper;
+        dbWrapper.addTable(TableInitializer("events", { { "id", csvsqldb::INT }, { "ts", csvsqldb::INT } }));
+        dbWrapper.addTable(TableInitializer("sessions", { { "name", csvsqldb::STRING }, { "start_ts", csvsqldb::INT }, { "end_ts", csvsqldb::INT } }));
+
+        csvsqldb::ExecutionContext context(dbWrapper.getDatabase());
+        csvsqldb::ExecutionEngine<TestOperatorNodeFactory> engine(context);
+
+        TestRowProvider::setRows("events", { { 1, 15 }, { 2, 3 }, { 3, 42 }, { 4, 20 }, { 5, csvsqldb::Variant(csvsqldb::INT) }, { 6, 100 } });
+        TestRowProvider::setRows("sessions",
+                                 { { "b", 10, 20 }, { "a", 0, 5 }, { "c", 18, 45 }, { "d", 50, csvsqldb::Variant(csvsqldb::INT) } });
+
+        csvsqldb::ExecutionStatistics statistics;
+        std::stringstream ss;
+        int64_t rowCount = engine.execute(
+        "SELECT events.id,sessions.name FROM events JOIN sessions ON events.ts BETWEEN sessions.start_ts AND sessions.end_ts ORDER "
+        "BY events.id,sessions.name",
+        statistics,
+        ss);
+        MPF_TEST_ASSERTEQUAL(5, rowCount);
+        std::string expected = R"(#EVENTS.ID,SESSIONS.NAME
+1,'b'
+2,'a'
+3,'c'
+4,'b'
+4,'c'
+)";
+        MPF_TEST_ASSERTEQUAL(expected, ss.str());
+
+        // the bounded input on the right side, strict bounds and computed bounds
+        ss.str("");
+        rowCount = engine.execute(
+        "SELECT sessions.name,events.id FROM sessions JOIN events ON sessions.start_ts < events.ts AND events.ts <= "
+        "sessions.end_ts - 2 ORDER BY sessions.name,events.id",
+        statistics,
+        ss);
+        MPF_TEST_ASSERTEQUAL(4, rowCount);
+        expected = R"(#SESSIONS.NAME,EVENTS.ID
+'a',2
+'b',1
+'c',3
+'c',4
+)";
+        MPF_TEST_ASSERTEQUAL(expected, ss.str());
+    }
+
     void selfJoinTest()
     {
         DatabaseTestWrapper dbWrapper;
@@ -258,11 +493,93 @@ public:
             MPF_TEST_ASSERTEQUAL(expected, ss.str());
         }
     }
+
+private:
+    std::string explainPlan(csvsqldb::ExecutionEngine<TestOperatorNodeFactory>& engine, const std::string& sql)
+    {
+        csvsqldb::ExecutionStatistics statistics;
+        std::stringstream plan;
+        engine.execute("EXPLAIN EXEC " + sql, statistics, plan);
+        return plan.str();
+    }
+
+    void setUpEmployeesAndSalaries(DatabaseTestWrapper& dbWrapper)
+    {
+        dbWrapper.addTable(TableInitializer("employees",
+                                            { { "id", csvsqldb::INT },
+                                              { "first_name", csvsqldb::STRING },
+                                              { "last_name", csvsqldb::STRING },
+                                              { "birth_date", csvsqldb::DATE },
+                                              { "hire_date", csvsqldb::DATE } }));
+        dbWrapper.addTable(TableInitializer(
+        "salaries", { { "id", csvsqldb::INT }, { "salary", csvsqldb::REAL }, { "from_date", csvsqldb::DATE }, { "to_date", csvsqldb::DATE } }));
+
+        TestRowProvider::setRows(
+        "employees",
+        { { 9384, "John", "Doe", csvsqldb::Date(1965, csvsqldb::Date::August, 8), csvsqldb::Date(9999, csvsqldb::Date::December, 31) },
+          { 815, "Mark", "Fürstenberg", csvsqldb::Date(1969, csvsqldb::Date::May, 17), csvsqldb::Date(2003, csvsqldb::Date::April, 15) },
+          { 4711, "Lars", "Fürstenberg", csvsqldb::Date(1970, csvsqldb::Date::September, 23), csvsqldb::Date(2010, csvsqldb::Date::February, 1) },
+          { 9227, "Angelica", "Tello de Fürstenberg", csvsqldb::Date(1963, csvsqldb::Date::March, 6), csvsqldb::Date(2003, csvsqldb::Date::June, 15) } });
+
+        TestRowProvider::setRows(
+        "salaries",
+        { { 815, 5000.00, csvsqldb::Date(2003, csvsqldb::Date::April, 15), csvsqldb::Date(2015, csvsqldb::Date::December, 31) },
+          { 4711, 12000.00, csvsqldb::Date(2010, csvsqldb::Date::February, 1), csvsqldb::Date(2015, csvsqldb::Date::December, 31) },
+          { 815, 5500.00, csvsqldb::Date(2016, csvsqldb::Date::January, 1), csvsqldb::Date(9999, csvsqldb::Date::December, 31) },
+          { 9227, 450.00, csvsqldb::Date(2003, csvsqldb::Date::June, 15), csvsqldb::Date(2015, csvsqldb::Date::December, 31) } });
+    }
+
+    void checkSalaryJoin(csvsqldb::ExecutionEngine<TestOperatorNodeFactory>& engine)
+    {
+        csvsqldb::ExecutionStatistics statistics;
+        std::stringstream ss;
+        int64_t rowCount = engine.execute(
+        "SELECT * FROM employees emp INNER JOIN salaries sal ON emp.id = sal.id ORDER BY emp.id, sal.salary", statistics, ss);
+        MPF_TEST_ASSERTEQUAL(4, rowCount);
+        std::string expected = R"(#EMP.ID,EMP.FIRST_NAME,EMP.LAST_NAME,EMP.BIRTH_DATE,EMP.HIRE_DATE,SAL.ID,SAL.SALARY,SAL.FROM_DATE,SAL.TO_DATE
+815,'Mark','Fürstenberg',1969-05-17,2003-04-15,815,5000.000000,2003-04-15,2015-12-31
+815,'Mark','Fürstenberg',1969-05-17,2003-04-15,815,5500.000000,2016-01-01,9999-12-31
+4711,'Lars','Fürstenberg',1970-09-23,2010-02-01,4711,12000.000000,2010-02-01,2015-12-31
+9227,'Angelica','Tello de Fürstenberg',1963-03-06,2003-06-15,9227,450.000000,2003-06-15,2015-12-31
+)";
+        MPF_TEST_ASSERTEQUAL(expected, ss.str());
+    }
+
+    void checkLastNameSelfJoin(csvsqldb::ExecutionEngine<TestOperatorNodeFactory>& engine)
+    {
+        TestRowProvider::setRows("employees", { { 815, "Mark", "Fürstenberg", csvsqldb::Date(1969, csvsqldb::Date::May, 17),
+                                                  csvsqldb::Date(2003, csvsqldb::Date::April, 15) },
+                                                { 4711, "Lars", "Fürstenberg", csvsqldb::Date(1970, csvsqldb::Date::September, 23),
+                                                  csvsqldb::Date(2010, csvsqldb::Date::February, 1) },
+                                                { 9384, "John", "Doe", csvsqldb::Date(1965, csvsqldb::Date::August, 8),
+                                                  csvsqldb::Date(9999, csvsqldb::Date::December, 31) } });
+
+        csvsqldb::ExecutionStatistics statistics;
+        std::stringstream ss;
+        int64_t rowCount = engine.execute(
+        "SELECT emp.first_name, other.first_name FROM employees emp INNER JOIN employees other ON emp.last_name = other.last_name "
+        "ORDER BY emp.first_name, other.first_name",
+        statistics, ss);
+        MPF_TEST_ASSERTEQUAL(5, rowCount);
+        std::string expected = R"(#EMP.FIRST_NAME,OTHER.FIRST_NAME
+'John','John'
+'Lars','Lars'
+'Lars','Mark'
+'Mark','Lars'
+'Mark','Mark'
+)";
+        MPF_TEST_ASSERTEQUAL(expected, ss.str());
+    }
 };
 
 MPF_REGISTER_TEST_START("JoinTestSuite", JoinTestCase);
 MPF_REGISTER_TEST(JoinTestCase::simpleCrossJoinTest);
 MPF_REGISTER_TEST(JoinTestCase::simpleInnerJoinTest);
+MPF_REGISTER_TEST(JoinTestCase::spillingInnerJoinTest);
+MPF_REGISTER_TEST(JoinTestCase::parallelInnerJoinTest);
 MPF_REGISTER_TEST(JoinTestCase::complexInnerJoinTest);
+MPF_REGISTER_TEST(JoinTestCase::reorderedInnerJoinTest);
+MPF_REGISTER_TEST(JoinTestCase::compositeKeyInnerJoinTest);
+MPF_REGISTER_TEST(JoinTestCase::bandJoinTest);
 MPF_REGISTER_TEST(JoinTestCase::selfJoinTest);
 MPF_REGISTER_TEST_END();
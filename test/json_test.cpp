@@ -208,6 +208,7 @@ static std::string goodJson1 = "{ \"Test\" : [  ] }";
 static std::string goodJson2 = "{  }";
 static std::string goodJson3 = "[ 123.12e-34 ]";
 static std::string goodJson4 = "{ \"length\" : 0 }";
+static std::string goodJson5 = "{ \"values\" : [ 0.5, -0.25, 0e2 ] }";
 
 class JsonTestCase
 {
@@ -270,6 +271,13 @@ public:
 
         csvsqldb::json::Parser parser4(goodJson4, JsonCallback::Ptr());
         MPF_TEST_ASSERT(parser4.parse());
+
+        std::shared_ptr<csvsqldb::json::JsonObjectCallback> callback = std::make_shared<csvsqldb::json::JsonObjectCallback>();
+        csvsqldb::json::Parser parser5(goodJson5, callback);
+        MPF_TEST_ASSERT(parser5.parse());
+        MPF_TEST_ASSERTEQUAL(0.5, callback->getObject()["values"].getArray()[0].getAsDouble());
+        MPF_TEST_ASSERTEQUAL(-0.25, callback->getObject()["values"].getArray()[1].getAsDouble());
+        MPF_TEST_ASSERTEQUAL(0.0, callback->getObject()["values"].getArray()[2].getAsDouble());
     }
 
     void parseErrors()
@@ -0,0 +1,103 @@
+//
+//  csvsqldb test
+//  csvsqldb
+//
+//  BSD 3-Clause License
+//  Copyright (c) 2015, Lars-Christian Fürstenberg
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification, are permitted
+//  provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or other materials provided
+//  with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors may be used to
+//  endorse or promote products derived from this software without specific prior written
+//  permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+//  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+//  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+//  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+
+#include "test.h"
+
+#include "libcsvsqldb/base/like_matcher.h"
+
+
+class LikeMatcherTestCase
+{
+public:
+    void setUp()
+    {
+    }
+
+    void tearDown()
+    {
+    }
+
+    void classification()
+    {
+        MPF_TEST_ASSERTEQUAL(csvsqldb::LikeMatcher("Fürstenberg").type(), csvsqldb::LikeMatcher::EXACT);
+        MPF_TEST_ASSERTEQUAL(csvsqldb::LikeMatcher("Für.*").type(), csvsqldb::LikeMatcher::PREFIX);
+        MPF_TEST_ASSERTEQUAL(csvsqldb::LikeMatcher(".*berg").type(), csvsqldb::LikeMatcher::SUFFIX);
+        MPF_TEST_ASSERTEQUAL(csvsqldb::LikeMatcher(".*sten.*").type(), csvsqldb::LikeMatcher::SUBSTRING);
+        MPF_TEST_ASSERTEQUAL(csvsqldb::LikeMatcher("a.c.*").type(), csvsqldb::LikeMatcher::REGEXP);
+        MPF_TEST_ASSERTEQUAL(csvsqldb::LikeMatcher("a.*c").type(), csvsqldb::LikeMatcher::REGEXP);
+        MPF_TEST_ASSERTEQUAL(csvsqldb::LikeMatcher("100\\.0.*").type(), csvsqldb::LikeMatcher::PREFIX);
+        MPF_TEST_ASSERTEQUAL(csvsqldb::LikeMatcher("100\\.0.*").literal(), "100.0");
+    }
+
+    void matching()
+    {
+        csvsqldb::LikeMatcher exact("Fürstenberg");
+        MPF_TEST_ASSERT(exact.match("Fürstenberg"));
+        MPF_TEST_ASSERT(!exact.match("Fürstenberger"));
+
+        csvsqldb::LikeMatcher prefix("Für.*");
+        MPF_TEST_ASSERT(prefix.match("Fürstenberg"));
+        MPF_TEST_ASSERT(prefix.match("Für"));
+        MPF_TEST_ASSERT(!prefix.match("Fu"));
+
+        csvsqldb::LikeMatcher suffix(".*berg");
+        MPF_TEST_ASSERT(suffix.match("Fürstenberg"));
+        MPF_TEST_ASSERT(suffix.match("berg"));
+        MPF_TEST_ASSERT(!suffix.match("erg"));
+        MPF_TEST_ASSERT(!suffix.match("bergen"));
+
+        csvsqldb::LikeMatcher substring(".*sten.*");
+        MPF_TEST_ASSERT(substring.match("Fürstenberg"));
+        MPF_TEST_ASSERT(substring.match("sten"));
+        MPF_TEST_ASSERT(!substring.match("Stein"));
+
+        csvsqldb::LikeMatcher any(".*");
+        MPF_TEST_ASSERT(any.match(""));
+        MPF_TEST_ASSERT(any.match("Fürstenberg"));
+
+        csvsqldb::LikeMatcher regexp("a.c.*");
+        MPF_TEST_ASSERT(regexp.match("abc"));
+        MPF_TEST_ASSERT(regexp.match("abcdef"));
+        MPF_TEST_ASSERT(!regexp.match("ac"));
+
+        csvsqldb::LikeMatcher escaped("100\\.0.*");
+        MPF_TEST_ASSERT(escaped.match("100.05"));
+        MPF_TEST_ASSERT(!escaped.match("100005"));
+    }
+};
+
+MPF_REGISTER_TEST_START("LikeMatcherTestSuite", LikeMatcherTestCase);
+MPF_REGISTER_TEST(LikeMatcherTestCase::classification);
+MPF_REGISTER_TEST(LikeMatcherTestCase::matching);
+MPF_REGISTER_TEST_END();
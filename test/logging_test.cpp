@@ -35,9 +35,13 @@
 #include "test_helper.h"
 
 #include "libcsvsqldb/base/configuration.h"
+#include "libcsvsqldb/base/log_devices.h"
 #include "libcsvsqldb/base/logging.h"
+#include "libcsvsqldb/base/metrics.h"
 
+#include <condition_variable>
 #include <fstream>
+#include <thread>
 
 
 class StaticConfiguration : public csvsqldb::Configuration
@@ -104,6 +108,90 @@ private:
     }
 };
 
+class CollectingLogDevice : public csvsqldb::LogDevice
+{
+public:
+    CollectingLogDevice()
+    : _batches(0)
+    , _blocked(false)
+    , _entered(false)
+    {
+    }
+
+    virtual const std::string& name() const
+    {
+        static std::string name("CollectingLogDevice");
+        return name;
+    }
+
+    csvsqldb::StringVector lines()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        return _lines;
+    }
+
+    size_t batches()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        return _batches;
+    }
+
+    void block()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _blocked = true;
+    }
+
+    void waitUntilEntered()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _condition.wait(lock, [this]() { return _entered; });
+    }
+
+    void release()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _blocked = false;
+        _condition.notify_all();
+    }
+
+private:
+    virtual void doLog(std::ostringstream& stream)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _entered = true;
+        _condition.notify_all();
+        _condition.wait(lock, [this]() { return !_blocked; });
+
+        std::istringstream batch(stream.str());
+        std::string line;
+        while(std::getline(batch, line)) {
+            _lines.push_back(line);
+        }
+        ++_batches;
+    }
+
+    virtual bool doOpen()
+    {
+        return true;
+    }
+
+    virtual void doClose()
+    {
+    }
+
+    virtual void doFlush()
+    {
+    }
+
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    csvsqldb::StringVector _lines;
+    size_t _batches;
+    bool _blocked;
+    bool _entered;
+};
+
 class TestClass1
 {
 };
@@ -169,8 +257,168 @@ public:
         }
         log.close();
     }
+
+    void asyncDevice()
+    {
+        csvsqldb::GlobalConfiguration::create<csvsqldb::GlobalConfiguration>();
+        csvsqldb::config<csvsqldb::GlobalConfiguration>()->configure(std::make_shared<StaticConfiguration>());
+
+        std::shared_ptr<CollectingLogDevice> target = std::make_shared<CollectingLogDevice>();
+        {
+            csvsqldb::AsyncLogDevice device(target, 10000);
+            MPF_TEST_ASSERT(device.isConcurrent());
+
+            std::vector<std::thread> producers;
+            for(int t = 0; t < 4; ++t) {
+                producers.push_back(std::thread([&device, t]() {
+                    for(int n = 0; n < 1000; ++n) {
+                        csvsqldb::LogEvent event;
+                        event._time = std::chrono::system_clock::now();
+                        event._categorie = "INFO";
+                        event._tid = std::this_thread::get_id();
+                        event._message = "producer " + std::to_string(t) + " event " + std::to_string(n);
+                        device.log(event);
+                    }
+                }));
+            }
+            for(auto& producer : producers) {
+                producer.join();
+            }
+            device.flush();
+
+            MPF_TEST_ASSERTEQUAL(4000u, target->lines().size());
+            MPF_TEST_ASSERT(target->batches() < 4000u);
+            MPF_TEST_ASSERTEQUAL(0u, device.dropped());
+        }
+
+        std::vector<int> next(4, 0);
+        for(const auto& line : target->lines()) {
+            // the events of one producer keep their order
+            size_t pos = line.find("producer ");
+            MPF_TEST_ASSERT(pos != std::string::npos);
+            int producer = line[pos + 9] - '0';
+            std::string expected = "producer " + std::to_string(producer) + " event " + std::to_string(next[producer]);
+            MPF_TEST_ASSERTEQUAL(expected, line.substr(pos));
+            ++next[producer];
+        }
+    }
+
+    void asyncDeviceDrops()
+    {
+        csvsqldb::GlobalConfiguration::create<csvsqldb::GlobalConfiguration>();
+        csvsqldb::config<csvsqldb::GlobalConfiguration>()->configure(std::make_shared<StaticConfiguration>());
+
+        uint64_t droppedBefore = csvsqldb::metrics::Metrics::value(csvsqldb::metrics::DROPPED_LOG_EVENTS);
+        std::shared_ptr<CollectingLogDevice> target = std::make_shared<CollectingLogDevice>();
+        csvsqldb::AsyncLogDevice device(target, 4, std::chrono::milliseconds(1));
+
+        csvsqldb::LogEvent event;
+        event._time = std::chrono::system_clock::now();
+        event._categorie = "INFO";
+        event._tid = std::this_thread::get_id();
+        event._message = "first";
+
+        // block the writer in the first batch, so the queue cannot drain
+        target->block();
+        device.log(event);
+        target->waitUntilEntered();
+
+        for(int n = 0; n < 10; ++n) {
+            event._message = "event " + std::to_string(n);
+            device.log(event);
+        }
+        MPF_TEST_ASSERTEQUAL(6u, device.dropped());
+        MPF_TEST_ASSERTEQUAL(6u, csvsqldb::metrics::Metrics::value(csvsqldb::metrics::DROPPED_LOG_EVENTS) - droppedBefore);
+
+        target->release();
+        device.flush();
+        csvsqldb::StringVector lines = target->lines();
+        MPF_TEST_ASSERTEQUAL(5u, lines.size());
+        MPF_TEST_ASSERT(lines[0].find("first") != std::string::npos);
+        MPF_TEST_ASSERT(lines[4].find("event 3") != std::string::npos);
+    }
+
+    void asyncDeviceWakesUpEarly()
+    {
+        csvsqldb::GlobalConfiguration::create<csvsqldb::GlobalConfiguration>();
+        csvsqldb::config<csvsqldb::GlobalConfiguration>()->configure(std::make_shared<StaticConfiguration>());
+
+        std::shared_ptr<CollectingLogDevice> target = std::make_shared<CollectingLogDevice>();
+        csvsqldb::AsyncLogDevice device(target, 100, std::chrono::hours(1));
+
+        csvsqldb::LogEvent event;
+        event._time = std::chrono::system_clock::now();
+        event._categorie = "INFO";
+        event._tid = std::this_thread::get_id();
+
+        // more events than fit into the queue; the writer has to be woken up by the half full queue, as the flush interval
+        // never elapses
+        for(size_t round = 1; round <= 3; ++round) {
+            for(int n = 0; n < 50; ++n) {
+                event._message = "event " + std::to_string(n);
+                device.log(event);
+            }
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+            while(target->lines().size() < 50 * round && std::chrono::steady_clock::now() < deadline) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            MPF_TEST_ASSERTEQUAL(50 * round, target->lines().size());
+        }
+        MPF_TEST_ASSERTEQUAL(0u, device.dropped());
+    }
+
+    void rateLimiter()
+    {
+        csvsqldb::LogRateLimiter limiter(2, std::chrono::milliseconds(50));
+        uint64_t suppressed = 0;
+        MPF_TEST_ASSERT(limiter.admit(suppressed));
+        MPF_TEST_ASSERT(limiter.admit(suppressed));
+        MPF_TEST_ASSERTEQUAL(0u, suppressed);
+        MPF_TEST_ASSERT(!limiter.admit(suppressed));
+        MPF_TEST_ASSERT(!limiter.admit(suppressed));
+        MPF_TEST_ASSERT(!limiter.admit(suppressed));
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(80));
+        MPF_TEST_ASSERT(limiter.admit(suppressed));
+        MPF_TEST_ASSERTEQUAL(3u, suppressed);
+        MPF_TEST_ASSERT(limiter.admit(suppressed));
+        MPF_TEST_ASSERTEQUAL(0u, suppressed);
+        MPF_TEST_ASSERT(!limiter.admit(suppressed));
+        MPF_TEST_ASSERTEQUAL(1u, limiter.takeSuppressed());
+        MPF_TEST_ASSERTEQUAL(0u, limiter.takeSuppressed());
+    }
+
+    void rateLimitedLog()
+    {
+        csvsqldb::GlobalConfiguration::create<csvsqldb::GlobalConfiguration>();
+        csvsqldb::config<csvsqldb::GlobalConfiguration>()->configure(std::make_shared<StaticConfiguration>());
+        csvsqldb::Logging::init();
+
+        {
+            RedirectStdErr red;
+            for(int n = 0; n < 100; ++n) {
+                CSVSQLDB_RATELIMITED_ERRORLOG(3, 60000, "repeated error " << n);
+            }
+            csvsqldb::Logging::flush();
+        }
+
+        std::ifstream log((CSVSQLDB_TEST_PATH + std::string("/stderr.txt")));
+        MPF_TEST_ASSERTEQUAL(true, log.good());
+        std::string line;
+        int line_count(0);
+        while(std::getline(log, line).good()) {
+            MPF_TEST_ASSERT(line.find("repeated error " + std::to_string(line_count)) != std::string::npos);
+            ++line_count;
+        }
+        MPF_TEST_ASSERTEQUAL(3, line_count);
+    }
 };
 
 MPF_REGISTER_TEST_START("ApplicationTestSuite", LoggingTestCase);
 MPF_REGISTER_TEST(LoggingTestCase::logIni);
+MPF_REGISTER_TEST(LoggingTestCase::asyncDevice);
+MPF_REGISTER_TEST(LoggingTestCase::asyncDeviceDrops);
+MPF_REGISTER_TEST(LoggingTestCase::asyncDeviceWakesUpEarly);
+MPF_REGISTER_TEST(LoggingTestCase::rateLimiter);
+MPF_REGISTER_TEST(LoggingTestCase::rateLimitedLog);
 MPF_REGISTER_TEST_END();
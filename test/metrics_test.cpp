@@ -0,0 +1,217 @@
+//
+//  csvsqldb test
+//  csvsqldb
+//
+//  BSD 3-Clause License
+//  Copyright (c) 2015, Lars-Christian Fürstenberg
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification, are permitted
+//  provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or other materials provided
+//  with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors may be used to
+//  endorse or promote products derived from this software without specific prior written
+//  permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+//  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+//  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+//  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "test.h"
+
+#include "libcsvsqldb/base/json_object.h"
+#include "libcsvsqldb/base/json_parser.h"
+#include "libcsvsqldb/base/metrics.h"
+
+#include "data_test_framework.h"
+
+#include <thread>
+
+
+class MetricsTestCase
+{
+public:
+    MetricsTestCase()
+    {
+    }
+
+    void setUp()
+    {
+        _databasePath = fs::temp_directory_path() / fs::unique_path("csvsqldb-metrics-%%%%-%%%%");
+    }
+
+    void tearDown()
+    {
+        csvsqldb::metrics::QueryLog::setCapacity(csvsqldb::metrics::QueryLog::DefaultCapacity);
+        fs::remove_all(_databasePath);
+    }
+
+    void counterTest()
+    {
+        const uint64_t before = csvsqldb::metrics::Metrics::value(csvsqldb::metrics::HASH_PROBES);
+
+        csvsqldb::metrics::Metrics::add(csvsqldb::metrics::HASH_PROBES, 5);
+        std::vector<std::thread> threads;
+        for(size_t n = 0; n < 4; ++n) {
+            threads.push_back(std::thread([]() {
+                for(size_t m = 0; m < 10; ++m) {
+                    csvsqldb::metrics::Metrics::add(csvsqldb::metrics::HASH_PROBES);
+                }
+            }));
+        }
+        for(auto& thread : threads) {
+            thread.join();
+        }
+
+        // the counts of the finished threads have to be kept
+        MPF_TEST_ASSERTEQUAL(before + 45, csvsqldb::metrics::Metrics::value(csvsqldb::metrics::HASH_PROBES));
+        MPF_TEST_ASSERTEQUAL(std::string("hash_probes"),
+                             std::string(csvsqldb::metrics::Metrics::name(csvsqldb::metrics::HASH_PROBES)));
+    }
+
+    void histogramTest()
+    {
+        const uint64_t before = csvsqldb::metrics::Metrics::snapshot(csvsqldb::metrics::QUERY_LATENCY)._count;
+        csvsqldb::metrics::Metrics::record(csvsqldb::metrics::QUERY_LATENCY, 10);
+        std::thread thread([]() { csvsqldb::metrics::Metrics::record(csvsqldb::metrics::QUERY_LATENCY, 20); });
+        thread.join();
+        MPF_TEST_ASSERTEQUAL(before + 2, csvsqldb::metrics::Metrics::snapshot(csvsqldb::metrics::QUERY_LATENCY)._count);
+
+        csvsqldb::metrics::HistogramSnapshot snapshot;
+        MPF_TEST_ASSERTEQUAL(0u, snapshot.percentile(0.5));
+
+        // the values 0, 1, 3 and 100
+        snapshot._count = 4;
+        snapshot._sum = 104;
+        snapshot._max = 100;
+        snapshot._buckets[0] = 1;
+        snapshot._buckets[1] = 1;
+        snapshot._buckets[2] = 1;
+        snapshot._buckets[7] = 1;
+        MPF_TEST_ASSERTEQUAL(0u, snapshot.percentile(0.25));
+        MPF_TEST_ASSERTEQUAL(1u, snapshot.percentile(0.5));
+        MPF_TEST_ASSERTEQUAL(3u, snapshot.percentile(0.75));
+        MPF_TEST_ASSERTEQUAL(100u, snapshot.percentile(0.99));
+    }
+
+    void queryLogTest()
+    {
+        csvsqldb::metrics::QueryLog::setCapacity(2);
+        for(const auto& statement : { "first", "second", "third" }) {
+            csvsqldb::metrics::QueryInfo info;
+            info._statement = statement;
+            csvsqldb::metrics::QueryLog::add(info);
+        }
+
+        csvsqldb::metrics::QueryLog::QueryInfos queries = csvsqldb::metrics::QueryLog::queries();
+        MPF_TEST_ASSERTEQUAL(2u, queries.size());
+        MPF_TEST_ASSERTEQUAL(std::string("second"), queries[0]._statement);
+        MPF_TEST_ASSERTEQUAL(std::string("third"), queries[1]._statement);
+        MPF_TEST_ASSERTEQUAL(queries[0]._id + 1, queries[1]._id);
+    }
+
+    void systemTablesTest()
+    {
+        // the system tables are added by the database setup
+        csvsqldb::Database database(_databasePath, csvsqldb::FileMapping());
+        database.setUp();
+        database.addTable(TableInitializer("employees", { { "id", csvsqldb::INT }, { "name", csvsqldb::STRING } }).getTable());
+
+        csvsqldb::ExecutionContext context(database);
+        csvsqldb::ExecutionEngine<TestOperatorNodeFactory> engine(context);
+
+        TestRowProvider::setRows("employees", { { 815, "Mark" }, { 4711, "Lars" }, { 3467, "Ingo" } });
+
+        const uint64_t queries = csvsqldb::metrics::Metrics::value(csvsqldb::metrics::QUERIES);
+        const uint64_t failedQueries = csvsqldb::metrics::Metrics::value(csvsqldb::metrics::FAILED_QUERIES);
+
+        csvsqldb::ExecutionStatistics statistics;
+        std::stringstream ss;
+        MPF_TEST_ASSERTEQUAL(3, engine.execute("SELECT id FROM employees ORDER BY id DESC", statistics, ss));
+        MPF_TEST_EXPECTS(engine.execute("SELECT id FROM metrics_unknown", statistics, ss), csvsqldb::Exception);
+        MPF_TEST_ASSERTEQUAL(queries + 2, csvsqldb::metrics::Metrics::value(csvsqldb::metrics::QUERIES));
+        MPF_TEST_ASSERTEQUAL(failedQueries + 1, csvsqldb::metrics::Metrics::value(csvsqldb::metrics::FAILED_QUERIES));
+
+        ss.str("");
+        MPF_TEST_ASSERTEQUAL(2, engine.execute("SELECT statement, row_count, success, error FROM system_queries WHERE statement "
+                                               "LIKE '%employees ORDER BY id DESC' OR statement LIKE '%metrics_unknown'",
+                                               statistics,
+                                               ss));
+        std::string expected = R"(#STATEMENT,ROW_COUNT,SUCCESS,ERROR
+'SELECT id FROM employees ORDER BY id DESC',3,1,NULL
+'SELECT id FROM metrics_unknown',0,0,'table 'METRICS_UNKNOWN' not found'
+)";
+        MPF_TEST_ASSERTEQUAL(expected, ss.str());
+
+        ss.str("");
+        MPF_TEST_ASSERTEQUAL(1, engine.execute("SELECT name FROM system_statistics WHERE name = 'sort_comparisons' AND value > 0",
+                                               statistics,
+                                               ss));
+        ss.str("");
+        MPF_TEST_ASSERTEQUAL(21, engine.execute("SELECT * FROM system_statistics", statistics, ss));
+    }
+
+    void executionStatisticsTest()
+    {
+        csvsqldb::Database database(_databasePath, csvsqldb::FileMapping());
+        database.setUp();
+        database.addTable(TableInitializer("employees", { { "id", csvsqldb::INT }, { "name", csvsqldb::STRING } }).getTable());
+
+        csvsqldb::ExecutionContext context(database);
+        csvsqldb::ExecutionEngine<TestOperatorNodeFactory> engine(context);
+
+        TestRowProvider::setRows("employees", { { 815, "Mark" }, { 4711, "Lars" }, { 3467, "Ingo" } });
+
+        csvsqldb::ExecutionStatistics statistics;
+        MPF_TEST_ASSERTEQUAL(0.0, statistics.rowsPerSecond());
+        std::stringstream ss;
+        MPF_TEST_ASSERTEQUAL(3, engine.execute("SELECT id FROM employees ORDER BY id", statistics, ss));
+        MPF_TEST_ASSERT(statistics._wallTime > 0);
+        MPF_TEST_ASSERT(statistics._mainCpuTime >= 0);
+        MPF_TEST_ASSERTEQUAL(3, statistics._outputRows);
+        MPF_TEST_ASSERT(statistics._processPeakResidentBytes > 0);
+
+        statistics._inputBytes = 2 * 1024 * 1024;
+        statistics._inputRows = 1000;
+        statistics._wallTime = 500000000;
+        MPF_TEST_ASSERTEQUAL(4.0 * 1024 * 1024, statistics.bytesPerSecond());
+        MPF_TEST_ASSERTEQUAL(2000.0, statistics.rowsPerSecond());
+
+        const std::string json = statistics.asJson();
+        MPF_TEST_ASSERT(json.find('\n') == std::string::npos);
+        std::shared_ptr<csvsqldb::json::JsonObjectCallback> callback = std::make_shared<csvsqldb::json::JsonObjectCallback>();
+        csvsqldb::json::Parser parser(json, callback);
+        MPF_TEST_ASSERT(parser.parse());
+        const csvsqldb::json::JsonObject& object = callback->getObject();
+        MPF_TEST_ASSERTEQUAL(500.0, object["wall_ms"].getAsDouble());
+        MPF_TEST_ASSERTEQUAL(4.0, object["mb_per_s"].getAsDouble());
+        MPF_TEST_ASSERTEQUAL(2000.0, object["rows_per_s"].getAsDouble());
+        MPF_TEST_ASSERTEQUAL(3, object["output_rows"].getAsLong());
+        MPF_TEST_ASSERT(object["thread_cpu_ms"]["main"].getAsDouble() >= 0.0);
+    }
+
+private:
+    fs::path _databasePath;
+};
+
+MPF_REGISTER_TEST_START("ApplicationTestSuite", MetricsTestCase);
+MPF_REGISTER_TEST(MetricsTestCase::counterTest);
+MPF_REGISTER_TEST(MetricsTestCase::histogramTest);
+MPF_REGISTER_TEST(MetricsTestCase::queryLogTest);
+MPF_REGISTER_TEST(MetricsTestCase::systemTablesTest);
+MPF_REGISTER_TEST(MetricsTestCase::executionStatisticsTest);
+MPF_REGISTER_TEST_END();
@@ -0,0 +1,288 @@
+//
+//  csvsqldb test
+//  csvsqldb
+//
+//  BSD 3-Clause License
+//  Copyright (c) 2015, Lars-Christian Fürstenberg
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification, are permitted
+//  provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or other materials provided
+//  with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors may be used to
+//  endorse or promote products derived from this software without specific prior written
+//  permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+//  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+//  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+//  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+
+#include "test.h"
+
+#include "libcsvsqldb/base/csv_parser.h"
+#include "libcsvsqldb/base/exception.h"
+#include "libcsvsqldb/base/read_ahead.h"
+
+#include <boost/filesystem.hpp>
+
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+namespace fs = boost::filesystem;
+
+
+namespace
+{
+    class SumCallback : public csvsqldb::csv::CSVParserCallback
+    {
+    public:
+        SumCallback()
+        : _sum(0)
+        , _strings(0)
+        {
+        }
+
+        virtual void onLong(int64_t num, bool isNull)
+        {
+            _sum += num;
+        }
+
+        virtual void onDouble(double num, bool isNull)
+        {
+        }
+
+        virtual void onString(const char* s, size_t len, bool isNull)
+        {
+            if(std::string(s, len) == "line") {
+                ++_strings;
+            }
+        }
+
+        virtual void onDate(const csvsqldb::Date& date, bool isNull)
+        {
+        }
+
+        virtual void onTime(const csvsqldb::Time& time, bool isNull)
+        {
+        }
+
+        virtual void onTimestamp(const csvsqldb::Timestamp& timestamp, bool isNull)
+        {
+        }
+
+        virtual void onBoolean(bool boolean, bool isNull)
+        {
+        }
+
+        int64_t _sum;
+        int _strings;
+    };
+}
+
+
+class ReadAheadTestCase
+{
+public:
+    void setUp()
+    {
+        _path = fs::temp_directory_path() / fs::unique_path("csvsqldb-read-ahead-%%%%-%%%%");
+    }
+
+    void tearDown()
+    {
+        fs::remove(_path);
+    }
+
+    std::string writeFile(size_t size)
+    {
+        std::string content;
+        for(size_t n = 0; n < size; ++n) {
+            content += static_cast<char>('a' + (n * 7 + n / 4096) % 26);
+        }
+        std::ofstream stream(_path.string(), std::ios::binary);
+        stream << content;
+        return content;
+    }
+
+    std::string readFile(const csvsqldb::ReadAheadOptions& options)
+    {
+        csvsqldb::ReadAheadStream stream(_path.string(), options);
+        MPF_TEST_ASSERT(std::string(stream.engine()) != "");
+        std::string content;
+        char buffer[1000];
+        while(stream.read(buffer, sizeof(buffer)) || stream.gcount() > 0) {
+            content.append(buffer, static_cast<size_t>(stream.gcount()));
+        }
+        return content;
+    }
+
+    void readTest()
+    {
+        csvsqldb::ReadAheadOptions options;
+        options._blockSize = 4096;
+        options._depth = 3;
+
+        std::string content = writeFile(100000);
+        MPF_TEST_ASSERT(content == readFile(options));
+
+        // the last block is completely filled
+        content = writeFile(10 * 4096);
+        MPF_TEST_ASSERT(content == readFile(options));
+
+        // fewer blocks than the read ahead depth
+        content = writeFile(5000);
+        MPF_TEST_ASSERT(content == readFile(options));
+
+        content = writeFile(0);
+        MPF_TEST_ASSERT(readFile(options).empty());
+    }
+
+    void lineTest()
+    {
+        csvsqldb::ReadAheadOptions options;
+        options._blockSize = 4096;
+        options._depth = 2;
+
+        {
+            std::ofstream stream(_path.string());
+            for(int n = 0; n < 10000; ++n) {
+                stream << n << ",line " << n << "\n";
+            }
+        }
+
+        csvsqldb::ReadAheadStream stream(_path.string(), options);
+        std::string line;
+        int count = 0;
+        while(std::getline(stream, line)) {
+            MPF_TEST_ASSERTEQUAL(std::to_string(count) + ",line " + std::to_string(count), line);
+            ++count;
+        }
+        MPF_TEST_ASSERTEQUAL(10000, count);
+    }
+
+    void blockTest()
+    {
+        csvsqldb::ReadAheadOptions options;
+        options._blockSize = 4096;
+        options._depth = 3;
+
+        std::string content = writeFile(100000);
+        csvsqldb::ReadAheadStream stream(_path.string(), options);
+        csvsqldb::ReadAheadStreamBuf* buffer = dynamic_cast<csvsqldb::ReadAheadStreamBuf*>(stream.rdbuf());
+        MPF_TEST_ASSERT(buffer);
+
+        // the blocks continue where the stream interface stopped
+        char start[100];
+        MPF_TEST_ASSERT(stream.read(start, sizeof(start)));
+        std::string read(start, sizeof(start));
+        for(std::pair<const char*, size_t> block = buffer->nextBlock(); block.second; block = buffer->nextBlock()) {
+            read.append(block.first, block.second);
+        }
+        MPF_TEST_ASSERT(content == read);
+    }
+
+    void parseBlocksTest()
+    {
+        csvsqldb::ReadAheadOptions options;
+        options._blockSize = 4096;
+        options._depth = 2;
+
+        int64_t sum = 0;
+        {
+            // the spaces after the delimiters are skipped by the parser, also across block boundaries
+            std::ofstream stream(_path.string());
+            stream << "id,name\n";
+            for(int n = 0; n < 10000; ++n) {
+                stream << n << ",   line\n";
+                sum += n;
+            }
+        }
+
+        csvsqldb::ReadAheadStream stream(_path.string(), options);
+        csvsqldb::csv::CSVParserContext context;
+        context._skipFirstLine = true;
+        SumCallback callback;
+        csvsqldb::csv::CSVParser parser(context, stream, { csvsqldb::csv::LONG, csvsqldb::csv::STRING }, callback);
+        while(parser.parseLine()) {
+        }
+        MPF_TEST_ASSERTEQUAL(sum, callback._sum);
+        MPF_TEST_ASSERTEQUAL(10000, callback._strings);
+    }
+
+    void directIOTest()
+    {
+        csvsqldb::ReadAheadOptions options;
+        options._blockSize = 64 * 1024;
+        options._directIO = true;
+
+        // file systems without direct I/O are read through the page cache
+        std::string content = writeFile(300000);
+        MPF_TEST_ASSERT(content == readFile(options));
+    }
+
+    void shortReadDirectIOTest()
+    {
+        csvsqldb::ReadAheadOptions options;
+        options._blockSize = 64 * 1024;
+        options._depth = 2;
+        options._directIO = true;
+
+        // the file shrinks to a size, which is not a multiple of the block size, after the reader determined its size,
+        // so the fourth block is read short. As the file grows again before the block is consumed, the remainder of the
+        // block is read with a second request, which has to be aligned for direct I/O.
+        std::string content = writeFile(300000);
+        csvsqldb::ReadAheadStream stream(_path.string(), options);
+        csvsqldb::ReadAheadStreamBuf* buffer = dynamic_cast<csvsqldb::ReadAheadStreamBuf*>(stream.rdbuf());
+        MPF_TEST_ASSERT(buffer);
+        fs::resize_file(_path, 200123);
+
+        std::string read;
+        for(int n = 0; n < 3; ++n) {
+            std::pair<const char*, size_t> block = buffer->nextBlock();
+            read.append(block.first, block.second);
+        }
+        // the read of the fourth block was submitted with the third block
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        fs::resize_file(_path, 300000);
+        for(std::pair<const char*, size_t> block = buffer->nextBlock(); block.second; block = buffer->nextBlock()) {
+            read.append(block.first, block.second);
+        }
+        MPF_TEST_ASSERT(content.substr(0, 200123) + std::string(300000 - 200123, '\0') == read);
+    }
+
+    void errorTest()
+    {
+        csvsqldb::ReadAheadOptions options;
+        MPF_TEST_EXPECTS(csvsqldb::ReadAheadStream(_path.string(), options), csvsqldb::FilesystemException);
+    }
+
+private:
+    fs::path _path;
+};
+
+MPF_REGISTER_TEST_START("ReadAheadTestSuite", ReadAheadTestCase);
+MPF_REGISTER_TEST(ReadAheadTestCase::readTest);
+MPF_REGISTER_TEST(ReadAheadTestCase::lineTest);
+MPF_REGISTER_TEST(ReadAheadTestCase::blockTest);
+MPF_REGISTER_TEST(ReadAheadTestCase::parseBlocksTest);
+MPF_REGISTER_TEST(ReadAheadTestCase::directIOTest);
+MPF_REGISTER_TEST(ReadAheadTestCase::shortReadDirectIOTest);
+MPF_REGISTER_TEST(ReadAheadTestCase::errorTest);
+MPF_REGISTER_TEST_END();
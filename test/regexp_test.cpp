@@ -35,6 +35,10 @@
 
 #include "libcsvsqldb/base/regexp.h"
 
+#include <atomic>
+#include <thread>
+#include <vector>
+
 
 class RegExpTestCase
 {
@@ -288,6 +292,71 @@ public:
         MPF_TEST_EXPECTS(r = "[0-9-+", std::runtime_error);
         MPF_TEST_EXPECTS(r = "[0-9\\", std::runtime_error);
     }
+
+    void literalPrefix()
+    {
+        csvsqldb::RegExp r("abc(d|e)*");
+        MPF_TEST_ASSERT(r.match("abc"));
+        MPF_TEST_ASSERT(r.match("abcdede"));
+        MPF_TEST_ASSERT(!r.match("ab"));
+        MPF_TEST_ASSERT(!r.match("abd"));
+        MPF_TEST_ASSERT(!r.match(""));
+
+        r = "(ab)+";
+        MPF_TEST_ASSERT(r.match("ab"));
+        MPF_TEST_ASSERT(r.match("abab"));
+        MPF_TEST_ASSERT(!r.match("aba"));
+    }
+
+    void nonAsciiInput()
+    {
+        csvsqldb::RegExp r("F.rsten.*");
+        MPF_TEST_ASSERT(r.match("F\xfcrstenberg"));
+        MPF_TEST_ASSERT(!r.match("F\xc3\xbcrstenberg"));
+
+        r = "[^a-z]+";
+        MPF_TEST_ASSERT(r.match("\xc3\xbc\xc3\xa4"));
+        MPF_TEST_ASSERT(!r.match("\xc3\xbc" "a"));
+    }
+
+    void stateCacheOverflow()
+    {
+        // needs 2^10 DFA states to recognize the character ten positions from the end
+        csvsqldb::RegExp r("(a|b)*a(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)");
+        for(size_t n = 0; n < 4096; ++n) {
+            std::string s;
+            for(size_t bit = 0; bit < 12; ++bit) {
+                s += (n & (size_t(1) << bit)) ? 'a' : 'b';
+            }
+            MPF_TEST_ASSERTEQUAL(r.match(s), s[s.size() - 10] == 'a');
+        }
+    }
+
+    void concurrentMatching()
+    {
+        // all threads build and follow the states of the same DFA
+        csvsqldb::RegExp r("(a|b)*a(a|b)(a|b)(a|b)");
+        std::atomic<size_t> mismatches(0);
+        std::vector<std::thread> threads;
+        for(size_t t = 0; t < 4; ++t) {
+            threads.emplace_back([&r, &mismatches, t]() {
+                for(size_t n = 0; n < 4096; ++n) {
+                    std::string s;
+                    const size_t bits = (n + t * 1024) % 4096;
+                    for(size_t bit = 0; bit < 12; ++bit) {
+                        s += (bits & (size_t(1) << bit)) ? 'a' : 'b';
+                    }
+                    if(r.match(s) != (s[s.size() - 4] == 'a')) {
+                        ++mismatches;
+                    }
+                }
+            });
+        }
+        for(auto& thread : threads) {
+            thread.join();
+        }
+        MPF_TEST_ASSERTEQUAL(0u, mismatches.load());
+    }
 };
 
 MPF_REGISTER_TEST_START("RegExpTestSuite", RegExpTestCase);
@@ -299,4 +368,8 @@ MPF_REGISTER_TEST(RegExpTestCase::quest);
 MPF_REGISTER_TEST(RegExpTestCase::complex);
 MPF_REGISTER_TEST(RegExpTestCase::characterClasses);
 MPF_REGISTER_TEST(RegExpTestCase::characterSets);
+MPF_REGISTER_TEST(RegExpTestCase::literalPrefix);
+MPF_REGISTER_TEST(RegExpTestCase::nonAsciiInput);
+MPF_REGISTER_TEST(RegExpTestCase::stateCacheOverflow);
+MPF_REGISTER_TEST(RegExpTestCase::concurrentMatching);
 MPF_REGISTER_TEST_END();
@@ -308,6 +308,14 @@ public:
         node = parser.parse(visitor.toString());
         MPF_TEST_ASSERT(node);
         MPF_TEST_ASSERT(std::dynamic_pointer_cast<csvsqldb::ASTExplainNode>(node));
+
+        node = parser.parse("explain analyze select a from Test");
+        csvsqldb::ASTDescribeNodePtr explainNode = std::dynamic_pointer_cast<csvsqldb::ASTExplainNode>(node);
+        MPF_TEST_ASSERT(explainNode);
+        MPF_TEST_ASSERTEQUAL(csvsqldb::ANALYZE, explainNode->_descType);
+        visitor.reset();
+        node->accept(visitor);
+        MPF_TEST_ASSERTEQUAL("EXPLAIN ANALYZE SELECT A FROM TEST", visitor.toString());
     }
 
     void parseSelectFail()
@@ -634,6 +642,15 @@ public:
         "18), constraint pk primary key (id,name),check (id > 4711 AND name = 'Lars'))");
         MPF_TEST_ASSERT(node);
         MPF_TEST_ASSERT(std::dynamic_pointer_cast<csvsqldb::ASTCreateTableNode>(node));
+
+        //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+        node = parser.parse("CREATE TABLE sales(id INTEGER, dt DATE, amount FLOAT, region VARCHAR(10)) PARTITIONED BY (DT, region)");
+        csvsqldb::ASTCreateTableNodePtr createNode = std::dynamic_pointer_cast<csvsqldb::ASTCreateTableNode>(node);
+        MPF_TEST_ASSERT(createNode);
+        MPF_TEST_ASSERT(!createNode->_columnDefinitions[0]._partition);
+        MPF_TEST_ASSERT(createNode->_columnDefinitions[1]._partition);
+        MPF_TEST_ASSERT(!createNode->_columnDefinitions[2]._partition);
+        MPF_TEST_ASSERT(createNode->_columnDefinitions[3]._partition);
     }
 
     void parseCreateTableFail()
@@ -648,6 +665,10 @@ public:
         MPF_TEST_EXPECTS(parser.parse(
                          "CREATE TABLE Test(id INTEGER PRIMARY KEY, adult, loan FLOAT NOT NULL CHECK(loan > 100.0))"),
                          csvsqldb::SqlParserException);
+
+        //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+        MPF_TEST_EXPECTS(parser.parse("CREATE TABLE sales(id INTEGER, dt DATE) PARTITIONED BY (day)"), csvsqldb::SqlParserException);
+        MPF_TEST_EXPECTS(parser.parse("CREATE TABLE sales(id INTEGER, dt DATE) PARTITIONED BY (id, dt)"), csvsqldb::SqlParserException);
     }
 
     void parseAlterTable()
@@ -41,6 +41,8 @@
 #include "libcsvsqldb/stack_machine.h"
 #include "libcsvsqldb/visitor.h"
 
+#include <sstream>
+
 
 class MyCurrentDateFunction : public csvsqldb::Function
 {
@@ -426,6 +428,53 @@ public:
             exp->accept(visitor);
             MPF_TEST_ASSERTEQUAL(true, sm.evaluate(store, functions).asBool());
         }
+
+        {
+            // large constant lists are evaluated with a hash lookup
+            std::stringstream ss;
+            ss << "4711 IN(";
+            for(int n = 0; n < 10000; ++n) {
+                ss << (n ? "," : "") << n * 3;
+            }
+            ss << ")";
+            csvsqldb::ASTExprNodePtr exp = parser.parseExpression(ss.str());
+            csvsqldb::StackMachine::VariableMapping mapping;
+            csvsqldb::StackMachine sm;
+            csvsqldb::ASTInstructionStackVisitor visitor(sm, mapping);
+            exp->accept(visitor);
+            std::stringstream dump;
+            sm.dump(dump);
+            MPF_TEST_ASSERTEQUAL("PUSH 4711\nIN SET 10000\n", dump.str());
+            MPF_TEST_ASSERTEQUAL(false, sm.evaluate(store, functions).asBool());
+        }
+
+        {
+            csvsqldb::ASTExprNodePtr exp = parser.parseExpression("'Lars' IN('Mark','Lars','Ingo')");
+            csvsqldb::StackMachine::VariableMapping mapping;
+            csvsqldb::StackMachine sm;
+            csvsqldb::ASTInstructionStackVisitor visitor(sm, mapping);
+            exp->accept(visitor);
+            MPF_TEST_ASSERTEQUAL(true, sm.evaluate(store, functions).asBool());
+        }
+
+        {
+            // values of a different type are compared like before
+            csvsqldb::ASTExprNodePtr exp = parser.parseExpression("8.0 IN(1,2,3,8)");
+            csvsqldb::StackMachine::VariableMapping mapping;
+            csvsqldb::StackMachine sm;
+            csvsqldb::ASTInstructionStackVisitor visitor(sm, mapping);
+            exp->accept(visitor);
+            MPF_TEST_ASSERTEQUAL(true, sm.evaluate(store, functions).asBool());
+        }
+
+        {
+            csvsqldb::ASTExprNodePtr exp = parser.parseExpression("NULL IN(1,2,3,8)");
+            csvsqldb::StackMachine::VariableMapping mapping;
+            csvsqldb::StackMachine sm;
+            csvsqldb::ASTInstructionStackVisitor visitor(sm, mapping);
+            exp->accept(visitor);
+            MPF_TEST_EXPECTS(sm.evaluate(store, functions), std::runtime_error);
+        }
     }
 
     void expressionWithVariableTest()
@@ -899,6 +948,118 @@ public:
             exp->accept(visitor);
             MPF_TEST_ASSERTEQUAL(true, sm.evaluate(store, functions).asBool());
         }
+
+        {
+            csvsqldb::ASTExprNodePtr exp = parser.parseExpression("'Darth Vader' like '%an So%' or 'Han Solo' like '%Vader'");
+            csvsqldb::StackMachine::VariableMapping mapping;
+            csvsqldb::StackMachine sm;
+            csvsqldb::ASTInstructionStackVisitor visitor(sm, mapping);
+            exp->accept(visitor);
+            MPF_TEST_ASSERTEQUAL(false, sm.evaluate(store, functions).asBool());
+        }
+    }
+
+    void functionFoldingTest()
+    {
+        csvsqldb::FunctionRegistry functions;
+        initBuildInFunctions(functions);
+        csvsqldb::SQLParser parser(functions);
+
+        {
+            csvsqldb::VariableStore store;
+            csvsqldb::ASTExprNodePtr exp = parser.parseExpression("upper(lower('Han Solo')) || char_length('Luke')");
+            csvsqldb::StackMachine::VariableMapping mapping;
+            csvsqldb::StackMachine sm;
+            csvsqldb::ASTInstructionStackVisitor visitor(sm, mapping);
+            exp->accept(visitor);
+            std::stringstream ss;
+            sm.dump(ss);
+            MPF_TEST_ASSERTEQUAL(std::string::npos, ss.str().find("FUNC"));
+            MPF_TEST_ASSERTEQUAL(std::string("HAN SOLO4"), sm.evaluate(store, functions).asString());
+        }
+
+        {
+            csvsqldb::VariableStore store;
+            csvsqldb::ASTExprNodePtr exp = parser.parseExpression("CURRENT_DATE");
+            csvsqldb::StackMachine::VariableMapping mapping;
+            csvsqldb::StackMachine sm;
+            csvsqldb::ASTInstructionStackVisitor visitor(sm, mapping);
+            exp->accept(visitor);
+            std::stringstream ss;
+            sm.dump(ss);
+            MPF_TEST_ASSERT(ss.str().find("FUNC") != std::string::npos);
+        }
+
+        {
+            csvsqldb::ASTExprNodePtr exp = parser.parseExpression("upper(name) || lower('DARTH')");
+            csvsqldb::StackMachine::VariableMapping mapping;
+            csvsqldb::StackMachine sm;
+            csvsqldb::ASTInstructionStackVisitor visitor(sm, mapping);
+            exp->accept(visitor);
+            std::stringstream ss;
+            sm.dump(ss);
+            MPF_TEST_ASSERT(ss.str().find("FUNC") != std::string::npos);
+
+            csvsqldb::VariableStore store;
+            store.addVariable(0, csvsqldb::Variant("Vader"));
+            MPF_TEST_ASSERTEQUAL(std::string("VADERdarth"), sm.evaluate(store, functions).asString());
+            csvsqldb::VariableStore store2;
+            store2.addVariable(0, csvsqldb::Variant("Solo"));
+            MPF_TEST_ASSERTEQUAL(std::string("SOLOdarth"), sm.evaluate(store2, functions).asString());
+        }
+
+        {
+            csvsqldb::VariableStore store;
+            csvsqldb::ASTExprNodePtr exp = parser.parseExpression("upper(42)");
+            csvsqldb::StackMachine::VariableMapping mapping;
+            csvsqldb::StackMachine sm;
+            csvsqldb::ASTInstructionStackVisitor visitor(sm, mapping);
+            exp->accept(visitor);
+            // the failed cast is not folded, but reported when evaluating
+            MPF_TEST_EXPECTS(sm.evaluate(store, functions), csvsqldb::StackMachineException);
+        }
+    }
+
+    void functionParameterCastTest()
+    {
+        csvsqldb::FunctionRegistry functions;
+        initBuildInFunctions(functions);
+        csvsqldb::SQLParser parser(functions);
+        csvsqldb::VariableStore store;
+        csvsqldb::Function::Ptr pow = functions.getFunction("POW");
+
+        {
+            // the casts are taken from the instruction, the integer is only converted because it is marked for a cast
+            csvsqldb::StackMachine sm;
+            sm.addInstruction(csvsqldb::StackMachine::Instruction(csvsqldb::StackMachine::PUSH, csvsqldb::Variant(2.0)));
+            sm.addInstruction(csvsqldb::StackMachine::Instruction(csvsqldb::StackMachine::PUSH, csvsqldb::Variant(3)));
+            sm.addInstruction(
+            csvsqldb::StackMachine::Instruction(csvsqldb::StackMachine::FUNC, pow, csvsqldb::Types({csvsqldb::REAL, csvsqldb::NONE})));
+            MPF_TEST_ASSERT(csvsqldb::compare(9.0, sm.evaluate(store, functions).asDouble()));
+        }
+
+        {
+            csvsqldb::StackMachine sm;
+            sm.addInstruction(csvsqldb::StackMachine::Instruction(csvsqldb::StackMachine::PUSH, csvsqldb::Variant(csvsqldb::Date::now())));
+            sm.addInstruction(csvsqldb::StackMachine::Instruction(csvsqldb::StackMachine::PUSH, csvsqldb::Variant(csvsqldb::Date::now())));
+            sm.addInstruction(
+            csvsqldb::StackMachine::Instruction(csvsqldb::StackMachine::FUNC, pow, csvsqldb::Types({csvsqldb::REAL, csvsqldb::REAL})));
+            MPF_TEST_EXPECTS(sm.evaluate(store, functions), csvsqldb::StackMachineException);
+        }
+
+        {
+            csvsqldb::ASTExprNodePtr exp = parser.parseExpression("pow(CAST(b AS REAL), 2) + pow(b, 2.0)");
+            csvsqldb::StackMachine::VariableMapping mapping;
+            csvsqldb::StackMachine sm;
+            csvsqldb::ASTInstructionStackVisitor visitor(sm, mapping);
+            exp->accept(visitor);
+            for(int64_t b = 1; b < 4; ++b) {
+                csvsqldb::VariableStore rowStore;
+                rowStore.addVariable(0, csvsqldb::Variant(b));
+                MPF_TEST_ASSERT(
+                csvsqldb::compare(static_cast<double>(2 * b * b), sm.evaluate(rowStore, functions).asDouble()));
+            }
+        }
     }
 };
 
@@ -914,4 +1075,6 @@ MPF_REGISTER_TEST(StackmachineTestCase::nullFunctionsTest);
 MPF_REGISTER_TEST(StackmachineTestCase::nullOperationsTest);
 MPF_REGISTER_TEST(StackmachineTestCase::nopTest);
 MPF_REGISTER_TEST(StackmachineTestCase::likeTest);
+MPF_REGISTER_TEST(StackmachineTestCase::functionFoldingTest);
+MPF_REGISTER_TEST(StackmachineTestCase::functionParameterCastTest);
 MPF_REGISTER_TEST_END();
@@ -64,6 +64,8 @@ public:
         tabledata.addColumn("name", csvsqldb::STRING, false, false, false, defaultValue, check, 25);
         check = parser.parseExpression("age >= 18");
         tabledata.addColumn("age", csvsqldb::INT, false, false, false, csvsqldb::Any(), check, 0);
+        check = csvsqldb::ASTExprNodePtr();
+        tabledata.addColumn("region", csvsqldb::STRING, false, false, false, csvsqldb::Any(), check, 10, true);
 
         check = csvsqldb::ASTExprNodePtr();
         csvsqldb::StringVector primaryKeys = { "id", "name" };
@@ -77,6 +79,9 @@ public:
         std::stringstream ss(json);
         csvsqldb::TableData decoded = csvsqldb::TableData::fromJson(ss);
         MPF_TEST_ASSERTEQUAL(json, decoded.asJson());
+        MPF_TEST_ASSERT(decoded.isPartitioned());
+        MPF_TEST_ASSERT(!decoded.getColumn(0)._partition);
+        MPF_TEST_ASSERT(decoded.getColumn(3)._partition);
     }
 };
 
@@ -118,10 +118,32 @@ public:
 
         MPF_TEST_EXPECTS(tp.enqueueTask(std::bind(&CallObject::testit, o, std::ref(count))), csvsqldb::InvalidOperationException);
     }
+
+    void executeTasksTest()
+    {
+        csvsqldb::ThreadPool tp(3);
+        tp.start();
+        MPF_TEST_ASSERTEQUAL(3, tp.numberOfThreads());
+
+        std::atomic<int> count(0);
+        std::vector<csvsqldb::ThreadPool::Callback> tasks;
+        for(int n = 0; n < 10; ++n) {
+            tasks.push_back([&count]() { ++count; });
+        }
+        tp.executeTasks(tasks);
+        MPF_TEST_ASSERTEQUAL(10, count.load());
+
+        tasks.push_back([]() { throw csvsqldb::Exception("task failed"); });
+        MPF_TEST_EXPECTS(tp.executeTasks(tasks), csvsqldb::Exception);
+        MPF_TEST_ASSERTEQUAL(20, count.load());
+
+        tp.stop();
+    }
 };
 
 MPF_REGISTER_TEST_START("ThreadPoolTestSuite", ThreadPoolTestCase);
 MPF_REGISTER_TEST(ThreadPoolTestCase::threadpoolTest);
 MPF_REGISTER_TEST(ThreadPoolTestCase::alreadyStartedTest);
 MPF_REGISTER_TEST(ThreadPoolTestCase::enqueueWithStopTest);
+MPF_REGISTER_TEST(ThreadPoolTestCase::executeTasksTest);
 MPF_REGISTER_TEST_END();
@@ -0,0 +1,177 @@
+//
+//  csvsqldb test
+//  csvsqldb
+//
+//  BSD 3-Clause License
+//  Copyright (c) 2015, Lars-Christian Fürstenberg
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification, are permitted
+//  provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice, this list of
+//  conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice, this list of
+//  conditions and the following disclaimer in the documentation and/or other materials provided
+//  with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors may be used to
+//  endorse or promote products derived from this software without specific prior written
+//  permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+//  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+//  AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+//  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+//  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+//  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+//  OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "test.h"
+
+#include "libcsvsqldb/base/json_object.h"
+#include "libcsvsqldb/base/json_parser.h"
+#include "libcsvsqldb/base/trace.h"
+
+#include <sstream>
+#include <thread>
+
+
+namespace
+{
+    std::shared_ptr<csvsqldb::json::JsonObjectCallback> parseTrace()
+    {
+        std::ostringstream trace;
+        csvsqldb::trace::Tracer::writeChromeTrace(trace);
+        std::shared_ptr<csvsqldb::json::JsonObjectCallback> callback = std::make_shared<csvsqldb::json::JsonObjectCallback>();
+        csvsqldb::json::Parser parser(trace.str(), callback);
+        MPF_TEST_ASSERT(parser.parse());
+        return callback;
+    }
+
+    size_t countEvents(const csvsqldb::json::JsonObject::ObjectArray& events, const std::string& name)
+    {
+        size_t count = 0;
+        for(const auto& event : events) {
+            if(event["name"].getAsString() == name) {
+                ++count;
+            }
+        }
+        return count;
+    }
+}
+
+
+class TraceTestCase
+{
+public:
+    TraceTestCase()
+    {
+    }
+
+    void setUp()
+    {
+    }
+
+    void tearDown()
+    {
+        csvsqldb::trace::Tracer::enable(false);
+        csvsqldb::trace::Tracer::setBufferCapacity(65536);
+        csvsqldb::trace::Tracer::clear();
+    }
+
+    void disabledTest()
+    {
+        csvsqldb::trace::Tracer::enable(false);
+        csvsqldb::trace::Tracer::clear();
+        MPF_TEST_ASSERT(!csvsqldb::trace::Tracer::isEnabled());
+        MPF_TEST_ASSERTEQUAL(0, csvsqldb::trace::Tracer::startEvent());
+        {
+            csvsqldb::trace::ScopedEvent event("test", "disabled");
+        }
+
+        std::shared_ptr<csvsqldb::json::JsonObjectCallback> callback = parseTrace();
+        MPF_TEST_ASSERTEQUAL(0u, countEvents(callback->getObject()["traceEvents"].getArray(), "disabled"));
+    }
+
+    void eventsTest()
+    {
+        csvsqldb::trace::Tracer::enable(true);
+        {
+            csvsqldb::trace::ScopedEvent event("test", "outer");
+            csvsqldb::trace::ScopedEvent inner("test", "inner");
+        }
+        std::thread thread([]() {
+            csvsqldb::trace::Tracer::setThreadName("worker");
+            csvsqldb::trace::ScopedEvent event("test", "threaded");
+        });
+        thread.join();
+        csvsqldb::trace::Tracer::enable(false);
+
+        std::shared_ptr<csvsqldb::json::JsonObjectCallback> callback = parseTrace();
+        const csvsqldb::json::JsonObject::ObjectArray& events = callback->getObject()["traceEvents"].getArray();
+        MPF_TEST_ASSERTEQUAL(1u, countEvents(events, "outer"));
+        MPF_TEST_ASSERTEQUAL(1u, countEvents(events, "inner"));
+        MPF_TEST_ASSERTEQUAL(1u, countEvents(events, "threaded"));
+
+        long mainThread = 0;
+        long workerThread = 0;
+        bool workerNamed = false;
+        for(const auto& event : events) {
+            if(event["name"].getAsString() == "outer") {
+                MPF_TEST_ASSERTEQUAL(std::string("X"), event["ph"].getAsString());
+                MPF_TEST_ASSERTEQUAL(std::string("test"), event["cat"].getAsString());
+                MPF_TEST_ASSERT(event["dur"].getAsDouble() >= 0.0);
+                mainThread = event["tid"].getAsLong();
+            } else if(event["name"].getAsString() == "threaded") {
+                workerThread = event["tid"].getAsLong();
+            } else if(event["name"].getAsString() == "thread_name") {
+                workerNamed |= event["args"]["name"].getAsString() == "worker";
+            }
+        }
+        MPF_TEST_ASSERT(mainThread != workerThread);
+        MPF_TEST_ASSERT(workerNamed);
+    }
+
+    void ringBufferTest()
+    {
+        static const char* names[] = { "e0", "e1", "e2", "e3", "e4", "e5", "e6", "e7", "e8", "e9" };
+
+        csvsqldb::trace::Tracer::setBufferCapacity(4);
+        csvsqldb::trace::Tracer::enable(true);
+        std::thread thread([]() {
+            for(const auto name : names) {
+                csvsqldb::trace::ScopedEvent event("test", name);
+            }
+        });
+        thread.join();
+        csvsqldb::trace::Tracer::enable(false);
+
+        std::shared_ptr<csvsqldb::json::JsonObjectCallback> callback = parseTrace();
+        const csvsqldb::json::JsonObject::ObjectArray& events = callback->getObject()["traceEvents"].getArray();
+        MPF_TEST_ASSERTEQUAL(0u, countEvents(events, "e5"));
+        MPF_TEST_ASSERTEQUAL(1u, countEvents(events, "e6"));
+        MPF_TEST_ASSERTEQUAL(1u, countEvents(events, "e9"));
+
+        // the oldest kept event comes first
+        std::vector<std::string> order;
+        for(const auto& event : events) {
+            if(event["name"].getAsString()[0] == 'e') {
+                order.push_back(event["name"].getAsString());
+            }
+        }
+        MPF_TEST_ASSERTEQUAL(4u, order.size());
+        MPF_TEST_ASSERTEQUAL(std::string("e6"), order.front());
+        MPF_TEST_ASSERTEQUAL(std::string("e9"), order.back());
+    }
+};
+
+MPF_REGISTER_TEST_START("ApplicationTestSuite", TraceTestCase);
+MPF_REGISTER_TEST(TraceTestCase::disabledTest);
+MPF_REGISTER_TEST(TraceTestCase::eventsTest);
+MPF_REGISTER_TEST(TraceTestCase::ringBufferTest);
+MPF_REGISTER_TEST_END();